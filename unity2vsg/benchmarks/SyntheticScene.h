@@ -0,0 +1,146 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/unity2vsg.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace unity2vsg
+{
+    //
+    // A synthetic scene for the headless benchmarks, a grid of transforms each drawing one of a handful of
+    // small meshes, similar in shape to the graphs the Unity exporter produces for a level full of props.
+    // Pipelines and textures are left out so the numbers aren't dominated by shader compilation.
+    //
+
+    struct SyntheticMesh
+    {
+        std::vector<vsg::vec3> vertices;
+        std::vector<vsg::vec3> normals;
+        std::vector<vsg::vec2> uvs;
+        std::vector<uint32_t> indices;
+    };
+
+    struct SyntheticScene
+    {
+        std::vector<SyntheticMesh> meshes;
+        std::vector<float> matrices; // 16 floats per instance
+        size_t instanceCount = 0;
+    };
+
+    // a segments x segments grid on a sphere, offset so each mesh has different data
+    inline SyntheticMesh createSyntheticMesh(uint32_t segments, float offset)
+    {
+        SyntheticMesh mesh;
+        const float pi = 3.14159265f;
+        for (uint32_t y = 0; y <= segments; y++)
+        {
+            for (uint32_t x = 0; x <= segments; x++)
+            {
+                float u = static_cast<float>(x) / segments;
+                float v = static_cast<float>(y) / segments;
+                vsg::vec3 n(std::cos(u * 2.0f * pi) * std::sin(v * pi), std::sin(u * 2.0f * pi) * std::sin(v * pi), std::cos(v * pi));
+                mesh.vertices.push_back(vsg::vec3(n.x + offset, n.y, n.z));
+                mesh.normals.push_back(n);
+                mesh.uvs.push_back(vsg::vec2(u, v));
+            }
+        }
+        for (uint32_t y = 0; y < segments; y++)
+        {
+            for (uint32_t x = 0; x < segments; x++)
+            {
+                uint32_t i = y * (segments + 1) + x;
+                uint32_t quad[6] = {i, i + 1, i + segments + 1, i + 1, i + segments + 2, i + segments + 1};
+                mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+            }
+        }
+        return mesh;
+    }
+
+    inline SyntheticScene createSyntheticScene(size_t instanceCount, size_t meshCount, uint32_t segments)
+    {
+        SyntheticScene scene;
+        for (size_t i = 0; i < meshCount; i++) scene.meshes.push_back(createSyntheticMesh(segments, static_cast<float>(i) * 0.01f));
+
+        size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+        scene.instanceCount = instanceCount;
+        scene.matrices.reserve(instanceCount * 16);
+        for (size_t i = 0; i < instanceCount; i++)
+        {
+            float matrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+                                static_cast<float>(i % side) * 4.0f, 0.0f, static_cast<float>(i / side) * 4.0f, 1.0f};
+            scene.matrices.insert(scene.matrices.end(), matrix, matrix + 16);
+        }
+        return scene;
+    }
+
+    // replay the scene into anything with the CommandStreamEncoder add functions, the data structs reference the
+    // scenes arrays so the scene must outlive the export. Draws are cached natively by mesh id so, as with committed
+    // mesh arrays, only the first draw of each mesh passes its arrays
+    template<class Sink>
+    void addSyntheticScene(Sink& sink, SyntheticScene& scene)
+    {
+        std::vector<bool> added(scene.meshes.size(), false);
+
+        sink.addGroupNode();
+        for (size_t i = 0; i < scene.instanceCount; i++)
+        {
+            TransformData transform = {};
+            transform.matrix.data = &scene.matrices[i * 16];
+            transform.matrix.length = 16;
+            sink.addTransformNode(transform);
+
+            size_t meshIndex = i % scene.meshes.size();
+            SyntheticMesh& mesh = scene.meshes[meshIndex];
+
+            VertexIndexDrawData draw = {};
+            draw.id = static_cast<int>(meshIndex) + 1;
+            draw.use32BitIndicies = 0;
+            if (!added[meshIndex])
+            {
+                draw.verticies.data = mesh.vertices.data();
+                draw.verticies.length = static_cast<int>(mesh.vertices.size());
+                draw.normals.data = mesh.normals.data();
+                draw.normals.length = static_cast<int>(mesh.normals.size());
+                draw.uv0.data = mesh.uvs.data();
+                draw.uv0.length = static_cast<int>(mesh.uvs.size());
+                draw.triangles.data = mesh.indices.data();
+                draw.triangles.length = static_cast<int>(mesh.indices.size());
+                added[meshIndex] = true;
+            }
+            sink.addVertexIndexDrawNode(draw);
+            sink.endNode(); // vertex index draw
+
+            sink.endNode(); // transform
+        }
+        sink.endNode();
+    }
+
+    // forwards the add functions to the global export C API
+    struct DirectCalls
+    {
+        void addGroupNode() { unity2vsg_AddGroupNode(); }
+        void addTransformNode(const TransformData& transform) { unity2vsg_AddTransformNode(transform); }
+        void addVertexIndexDrawNode(const VertexIndexDrawData& mesh) { unity2vsg_AddVertexIndexDrawNode(mesh); }
+        void endNode() { unity2vsg_EndNode(); }
+    };
+
+    inline double elapsedMilliseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+} // namespace unity2vsg
@@ -0,0 +1,83 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "SyntheticScene.h"
+
+#include <unity2vsg/CommandStream.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace unity2vsg;
+
+//
+// Times building the same synthetic export through a command stream and through one C API call per op.
+// Encoding is timed separately from submitting, submitting covers decoding the stream and building the graph.
+//
+// usage: unity2vsg_commandstream_benchmark [instances] [repeats] [output file]
+//
+
+int main(int argc, char** argv)
+{
+    size_t instanceCount = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 100000;
+    int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+    std::string outputFile = argc > 3 ? argv[3] : "unity2vsg_benchmark.vsgb";
+
+    SyntheticScene scene = createSyntheticScene(instanceCount, 64, 16);
+
+    double bestEncode = 0.0;
+    double bestSubmit = 0.0;
+    double bestDirect = 0.0;
+    size_t streamBytes = 0;
+    uint32_t streamOps = 0;
+
+    for (int r = 0; r < repeats; r++)
+    {
+        // stream
+        auto start = std::chrono::steady_clock::now();
+        CommandStreamEncoder encoder;
+        addSyntheticScene(encoder, scene);
+        double encode = elapsedMilliseconds(start);
+        streamBytes = encoder.size();
+        streamOps = encoder.opCount();
+
+        unity2vsg_BeginExport();
+        start = std::chrono::steady_clock::now();
+        if (unity2vsg_SubmitCommandBuffer(encoder.data(), encoder.size()) != 1)
+        {
+            std::printf("command stream was rejected\n");
+            return 1;
+        }
+        double submit = elapsedMilliseconds(start);
+        unity2vsg_EndExport(outputFile.c_str());
+
+        // direct calls
+        DirectCalls direct;
+        unity2vsg_BeginExport();
+        start = std::chrono::steady_clock::now();
+        addSyntheticScene(direct, scene);
+        double calls = elapsedMilliseconds(start);
+        unity2vsg_EndExport(outputFile.c_str());
+
+        bestEncode = r == 0 ? encode : std::min(bestEncode, encode);
+        bestSubmit = r == 0 ? submit : std::min(bestSubmit, submit);
+        bestDirect = r == 0 ? calls : std::min(bestDirect, calls);
+    }
+
+    std::printf("instances %zu, ops %u, stream %.2f MB\n", instanceCount, streamOps, static_cast<double>(streamBytes) / (1024.0 * 1024.0));
+    std::printf("encode       %8.2f ms  %6.1f M ops/s\n", bestEncode, streamOps / (bestEncode * 1000.0));
+    std::printf("submit       %8.2f ms  %6.1f M ops/s\n", bestSubmit, streamOps / (bestSubmit * 1000.0));
+    std::printf("direct calls %8.2f ms  %6.1f M ops/s\n", bestDirect, streamOps / (bestDirect * 1000.0));
+    return 0;
+}
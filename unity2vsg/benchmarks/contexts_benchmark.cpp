@@ -0,0 +1,103 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "SyntheticScene.h"
+
+#include <unity2vsg/CommandStream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace unity2vsg;
+
+//
+// Runs the same batch of independent exports on 1, 2, 4 ... threads, each export using its own context, and
+// reports how the throughput scales. Each export encodes the synthetic scene, submits it and writes it to file
+// with mesh optimization and flattening enabled so the native passes do a realistic share of the work.
+//
+// usage: unity2vsg_contexts_benchmark [exports] [instances per export] [max threads]
+//
+
+namespace
+{
+    bool runExport(SyntheticScene& scene, size_t index)
+    {
+        // the graph references the arrays in the stream so each export encodes its own, the scene is only read
+        CommandStreamEncoder encoder;
+        addSyntheticScene(encoder, scene);
+
+        ExportSettingsData settings = {};
+        settings.optimizeMeshes = 1;
+        settings.flattenGraph = 1;
+
+        ExportContext* context = unity2vsg_CreateExportContext();
+        unity2vsg_Context_SetExportSettings(context, settings);
+        bool result = unity2vsg_Context_SubmitCommandBuffer(context, encoder.data(), encoder.size()) == 1;
+
+        std::string fileName = "unity2vsg_contexts_benchmark_" + std::to_string(index) + ".vsgb";
+        result = unity2vsg_Context_EndExport(context, fileName.c_str()) == 1 && result;
+        unity2vsg_DestroyExportContext(context);
+        std::remove(fileName.c_str());
+        return result;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t exportCount = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 32;
+    size_t instanceCount = argc > 2 ? static_cast<size_t>(std::max(1, std::atoi(argv[2]))) : 5000;
+    unsigned maxThreads = argc > 3 ? static_cast<unsigned>(std::max(1, std::atoi(argv[3]))) : std::max(1u, std::thread::hardware_concurrency());
+
+    SyntheticScene scene = createSyntheticScene(instanceCount, 64, 16);
+
+    std::printf("%zu exports of %zu instances\n", exportCount, instanceCount);
+    std::printf("threads  time ms  exports/s  speedup\n");
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned threadCount = 1; threadCount < maxThreads; threadCount *= 2) threadCounts.push_back(threadCount);
+    threadCounts.push_back(maxThreads);
+
+    double singleThreaded = 0.0;
+    for (unsigned threadCount : threadCounts)
+    {
+        std::atomic<size_t> next(0);
+        std::atomic<size_t> failed(0);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&]() {
+                for (size_t i = next++; i < exportCount; i = next++)
+                {
+                    if (!runExport(scene, i)) failed++;
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        double elapsed = elapsedMilliseconds(start);
+
+        if (failed > 0)
+        {
+            std::printf("%zu exports failed\n", failed.load());
+            return 1;
+        }
+
+        if (threadCount == 1) singleThreaded = elapsed;
+        std::printf("%7u %8.1f %10.2f %8.2fx\n", threadCount, elapsed, exportCount * 1000.0 / elapsed, singleThreaded / elapsed);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "SyntheticScene.h"
+
+#include <unity2vsg/CommandStream.h>
+#include <unity2vsg/Flattener.h>
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace unity2vsg;
+
+//
+// Exports the synthetic scene with and without graph flattening, reads each file back and times a traversal of
+// the loaded graph, a headless stand in for the walk a viewer makes each frame. The export itself only reports
+// node counts, timing traversals there would add about a million node visits to every export.
+//
+// usage: unity2vsg_flatten_benchmark [instances]
+//
+
+namespace
+{
+    vsg::ref_ptr<vsg::Node> exportAndRead(SyntheticScene& scene, bool flatten)
+    {
+        CommandStreamEncoder encoder;
+        addSyntheticScene(encoder, scene);
+
+        ExportSettingsData settings = {};
+        settings.flattenGraph = flatten ? 1 : 0;
+
+        std::string fileName = flatten ? "unity2vsg_flatten_benchmark_flat.vsgb" : "unity2vsg_flatten_benchmark.vsgb";
+
+        ExportContext* context = unity2vsg_CreateExportContext();
+        unity2vsg_Context_SetExportSettings(context, settings);
+        bool result = unity2vsg_Context_SubmitCommandBuffer(context, encoder.data(), encoder.size()) == 1;
+        result = unity2vsg_Context_EndExport(context, fileName.c_str()) == 1 && result;
+        unity2vsg_DestroyExportContext(context);
+
+        vsg::ref_ptr<vsg::Node> node;
+        if (result)
+        {
+            vsg::vsgReaderWriter io;
+            node = io.read<vsg::Node>(fileName);
+        }
+        std::remove(fileName.c_str());
+        return node;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t instanceCount = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 20000;
+
+    SyntheticScene scene = createSyntheticScene(instanceCount, 64, 16);
+
+    vsg::ref_ptr<vsg::Node> original = exportAndRead(scene, false);
+    vsg::ref_ptr<vsg::Node> flattened = exportAndRead(scene, true);
+    if (!original.valid() || !flattened.valid())
+    {
+        std::printf("export failed\n");
+        return 1;
+    }
+
+    // enough traversals for about a million node visits gives a stable time
+    size_t nodesBefore = countNodes(original.get());
+    size_t iterations = std::max<size_t>(1, 1000000 / std::max<size_t>(nodesBefore, 1));
+
+    std::printf("%zu instances, %zu traversals\n", instanceCount, iterations);
+    std::printf("graph      nodes  traversal ms\n");
+    std::printf("original %7zu %13.3f\n", nodesBefore, timeTraversal(original.get(), iterations));
+    std::printf("flattened %6zu %13.3f\n", countNodes(flattened.get()), timeTraversal(flattened.get(), iterations));
+    return 0;
+}
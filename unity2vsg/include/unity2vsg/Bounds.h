@@ -0,0 +1,52 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <cstddef>
+
+namespace unity2vsg
+{
+    //
+    // Bounding volumes of exported vertex positions. The spheres Unity gives us are built around renderer boxes so
+    // are looser than they need to be, these work from the vertices themselves.
+    //
+
+    // box of count positions, uses SSE2 when available. If count is 0 minimum ends up larger than maximum
+    extern UNITY2VSG_EXPORT void vertexBounds(const vsg::vec3* positions, size_t count, vsg::vec3& minimum, vsg::vec3& maximum);
+
+    struct OrientedBox
+    {
+        vsg::vec3 center;
+        vsg::vec3 axes[3]; // unit length and orthogonal
+        vsg::vec3 halfExtents;
+    };
+
+    // box aligned to the principal axes of the positions
+    extern UNITY2VSG_EXPORT OrientedBox orientedBounds(const vsg::vec3* positions, size_t count);
+
+    // A tight sphere around count positions. Ritter's sphere is refined by shrinking and regrowing it a few times then
+    // compared against spheres about the box and oriented box centres, the smallest wins so it's never larger than the
+    // sphere around the box. The radius of that box sphere is returned in boxRadius for comparison.
+    extern UNITY2VSG_EXPORT vsg::sphere boundingSphere(const vsg::vec3* positions, size_t count, float* boxRadius = nullptr);
+
+    // grow bound to enclose other, a negative radius is an empty sphere
+    extern UNITY2VSG_EXPORT void expandBy(vsg::sphere& bound, const vsg::sphere& other);
+
+    // a sphere enclosing bound once transformed by matrix
+    extern UNITY2VSG_EXPORT vsg::sphere transformSphere(const vsg::mat4& matrix, const vsg::sphere& bound);
+
+} // namespace unity2vsg
@@ -0,0 +1,182 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/NativeUtils.h>
+
+#include <vector>
+
+namespace unity2vsg
+{
+    //
+    // Command stream binary layout
+    //
+    // A stream starts with a CommandStreamHeader followed by a packed list of ops. Each op is a CommandStreamOp
+    // followed by size bytes of payload, payloads are padded so every op starts on a 4 byte boundary.
+    // All values are written in host byte order. Arrays are written as a uint32 element count followed by the
+    // raw elements, strings as a uint32 length followed by the characters and a null terminator.
+    //
+
+    const uint32_t COMMAND_STREAM_MAGIC = 0x53563255; // 'U2VS'
+    const uint16_t COMMAND_STREAM_VERSION = 6;
+
+    struct CommandStreamHeader
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t headerSize;
+        uint32_t opCount;
+        uint32_t reserved;
+    };
+
+    struct CommandStreamOp
+    {
+        uint16_t code;
+        uint16_t flags;
+        uint32_t size; // size of the payload in bytes, including padding
+    };
+
+    enum CommandStreamOpCode : uint16_t
+    {
+        OP_ADD_GROUP_NODE = 1,
+        OP_ADD_TRANSFORM_NODE,
+        OP_ADD_CULL_NODE,
+        OP_ADD_CULL_GROUP_NODE,
+        OP_ADD_LOD_NODE,
+        OP_ADD_LOD_CHILD,
+        OP_ADD_STATE_GROUP_NODE,
+        OP_ADD_COMMANDS_NODE,
+        OP_ADD_VERTEX_INDEX_DRAW_NODE,
+        OP_ADD_STRING_VALUE,
+        OP_ADD_BIND_GRAPHICS_PIPELINE_COMMAND,
+        OP_ADD_BIND_INDEX_BUFFER_COMMAND,
+        OP_ADD_BIND_VERTEX_BUFFERS_COMMAND,
+        OP_ADD_DRAW_INDEXED_COMMAND,
+        OP_CREATE_BIND_DESCRIPTOR_SET_COMMAND,
+        OP_ADD_DESCRIPTOR_IMAGE,
+        OP_ADD_DESCRIPTOR_BUFFER_FLOAT,
+        OP_ADD_DESCRIPTOR_BUFFER_FLOAT_ARRAY,
+        OP_ADD_DESCRIPTOR_BUFFER_VECTOR,
+        OP_ADD_DESCRIPTOR_BUFFER_VECTOR_ARRAY,
+        OP_END_NODE,
+        OP_COUNT
+    };
+
+    //
+    // Encoder, packs calls matching the unity2vsg_Add* functions into a command stream
+    //
+
+    class UNITY2VSG_EXPORT CommandStreamEncoder
+    {
+    public:
+        CommandStreamEncoder();
+
+        // add nodes
+        void addGroupNode();
+        void addTransformNode(const TransformData& transform);
+        void addCullNode(const CullData& cull);
+        void addCullGroupNode(const CullData& cull);
+        void addLODNode(const CullData& cull);
+        void addLODChild(const LODChildData& lodChildData);
+        void addStateGroupNode();
+        void addCommandsNode();
+        void addVertexIndexDrawNode(const VertexIndexDrawData& mesh);
+
+        // add meta data to nodes
+        void addStringValue(const char* name, const char* value);
+
+        // commands
+        void addBindGraphicsPipelineCommand(const PipelineData& pipeline, uint32_t addToStateGroup);
+        void addBindIndexBufferCommand(const IndexBufferData& data);
+        void addBindVertexBuffersCommand(const VertexBuffersData& data);
+        void addDrawIndexedCommand(const DrawIndexedData& data);
+        void createBindDescriptorSetCommand(uint32_t addToStateGroup);
+
+        // descriptors
+        void addDescriptorImage(const DescriptorImageData& texture);
+        void addDescriptorBufferFloat(const DescriptorFloatUniformData& data);
+        void addDescriptorBufferFloatArray(const DescriptorFloatArrayUniformData& data);
+        void addDescriptorBufferVector(const DescriptorVectorUniformData& data);
+        void addDescriptorBufferVectorArray(const DescriptorVectorArrayUniformData& data);
+
+        void endNode();
+
+        // reset to an empty stream containing only the header
+        void clear();
+
+        const void* data() const { return _buffer.data(); }
+        size_t size() const { return _buffer.size(); }
+        uint32_t opCount() const { return _opCount; }
+
+    protected:
+        void beginOp(CommandStreamOpCode code);
+        void endOp();
+
+        void write(const void* ptr, size_t size);
+        void writeUInt(uint32_t value);
+        void writeInt(int32_t value);
+        void writeFloat(float value);
+        void writeString(const char* str);
+        void writeArray(const void* ptr, int length, size_t elementSize);
+        void pad();
+
+        std::vector<uint8_t> _buffer;
+        size_t _opStart;
+        uint32_t _opCount;
+    };
+
+    //
+    // Handler, receives the decoded ops of a command stream, the data passed to each call points into the stream buffer
+    //
+
+    class UNITY2VSG_EXPORT CommandStreamHandler
+    {
+    public:
+        virtual ~CommandStreamHandler() {}
+
+        virtual void addGroupNode() = 0;
+        virtual void addTransformNode(const TransformData& transform) = 0;
+        virtual void addCullNode(const CullData& cull) = 0;
+        virtual void addCullGroupNode(const CullData& cull) = 0;
+        virtual void addLODNode(const CullData& cull) = 0;
+        virtual void addLODChild(const LODChildData& lodChildData) = 0;
+        virtual void addStateGroupNode() = 0;
+        virtual void addCommandsNode() = 0;
+        virtual void addVertexIndexDrawNode(const VertexIndexDrawData& mesh) = 0;
+
+        virtual void addStringValue(const char* name, const char* value) = 0;
+
+        virtual bool addBindGraphicsPipelineCommand(const PipelineData& pipeline, uint32_t addToStateGroup) = 0;
+        virtual void addBindIndexBufferCommand(const IndexBufferData& data) = 0;
+        virtual void addBindVertexBuffersCommand(const VertexBuffersData& data) = 0;
+        virtual void addDrawIndexedCommand(const DrawIndexedData& data) = 0;
+        virtual void createBindDescriptorSetCommand(uint32_t addToStateGroup) = 0;
+
+        virtual void addDescriptorImage(const DescriptorImageData& texture) = 0;
+        virtual void addDescriptorBufferFloat(const DescriptorFloatUniformData& data) = 0;
+        virtual void addDescriptorBufferFloatArray(const DescriptorFloatArrayUniformData& data) = 0;
+        virtual void addDescriptorBufferVector(const DescriptorVectorUniformData& data) = 0;
+        virtual void addDescriptorBufferVectorArray(const DescriptorVectorArrayUniformData& data) = 0;
+
+        virtual void endNode() = 0;
+    };
+
+    // decode a command stream and replay it into handler, returns false if the stream is malformed.
+    // The whole stream is checked before any op is dispatched so a malformed stream is never partially applied.
+    // As with the managed side, if a bind graphics pipeline op fails the following ops are skipped until the
+    // end node op that closes the node the pipeline was added to.
+    // Array data is not copied so the stream buffer must stay valid for as long as the handler references it.
+    extern UNITY2VSG_EXPORT bool readCommandStream(const void* ops, size_t bytes, CommandStreamHandler& handler);
+
+} // namespace unity2vsg
@@ -0,0 +1,81 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace unity2vsg
+{
+    //
+    // CullHierarchyVisitor
+    //
+    // Regroups the children of groups with many children into a bounding volume hierarchy of CullGroups. Culling can
+    // then reject whole regions at once instead of testing every child. Children move below new CullGroups under the
+    // same parent, so the state they inherit doesn't change. The children of an LOD are left alone, as are children
+    // whose bounds can't be worked out. Groups with a blended pipeline bound anywhere below them are left alone so blended
+    // draws keep their order. Large hierarchies are built in parallel, using at most about one thread per hardware thread.
+    //
+
+    class UNITY2VSG_EXPORT CullHierarchyVisitor : public vsg::Visitor
+    {
+    public:
+        enum Split
+        {
+            MEDIAN_SPLIT = 1, // halve the children along the longest axis of their centers
+            SAH_SPLIT = 2 // split where the surface area heuristic estimates the fewest bound tests
+        };
+
+        CullHierarchyVisitor(Split split, size_t minChildren);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::Group& group) override;
+        void apply(vsg::LOD& lod) override;
+
+        size_t regroupedCount() const { return _regroupedCount; }
+        size_t blendedCount() const { return _blendedCount; } // groups left alone as they draw blended
+        size_t cullGroupCount() const { return _cullGroupCount; }
+
+        // bound tests per frame for the regrouped children, before as every child is tested and after as expected when the
+        // chance of reaching a CullGroup's children is its surface area relative to the root of its hierarchy
+        double testsBefore() const { return _testsBefore; }
+        double testsAfter() const { return _testsAfter; }
+
+        // leaves of the hierarchy hold at most this many children
+        static const size_t MAX_LEAF_CHILDREN = 4;
+
+    protected:
+        void regroup(vsg::Group& group);
+
+        Split _split;
+        size_t _minChildren;
+
+        std::set<const vsg::Node*> _visited;
+
+        // boxes of the vertex arrays drawn, shared by the threads working out the children's bounds
+        std::map<const vsg::Data*, std::pair<vsg::vec3, vsg::vec3>> _arrayBounds;
+        std::mutex _arrayBoundsMutex;
+
+        size_t _regroupedCount;
+        size_t _blendedCount;
+        size_t _cullGroupCount;
+        double _testsBefore;
+        double _testsAfter;
+    };
+
+} // namespace unity2vsg
@@ -0,0 +1,77 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/core/Data.h>
+
+#include <unordered_map>
+
+namespace unity2vsg
+{
+    // fast non cryptographic 64 bit hash of a block of memory
+    extern UNITY2VSG_EXPORT uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+    // hash of a Data objects type, dimensions, format, layout and contents
+    extern UNITY2VSG_EXPORT uint64_t hashData(const vsg::Data* data);
+
+    // true if both Data objects are the same type, dimensions, format and layout and their contents are byte for byte equal
+    extern UNITY2VSG_EXPORT bool compareData(const vsg::Data* lhs, const vsg::Data* rhs);
+
+    //
+    // DataCache
+    //
+    // Shares Data objects with identical contents. Pass every newly created Data through share, the first instance
+    // seen is returned for any later duplicates so they're only written to file once. Shared data may be referenced
+    // from several places in the graph so must not be modified in place after it's been added. The optional salt keeps
+    // data used in different roles apart, e.g. positions and normals that happen to be identical.
+    //
+
+    class UNITY2VSG_EXPORT DataCache
+    {
+    public:
+        DataCache();
+
+        vsg::ref_ptr<vsg::Data> share(vsg::ref_ptr<vsg::Data> data, uint64_t salt = 0);
+
+        template<class T>
+        vsg::ref_ptr<T> shareAs(vsg::ref_ptr<T> data, uint64_t salt = 0)
+        {
+            vsg::ref_ptr<vsg::Data> shared = share(vsg::ref_ptr<vsg::Data>(data), salt);
+            return vsg::ref_ptr<T>(static_cast<T*>(shared.get()));
+        }
+
+        void clear();
+
+        size_t uniqueCount() const { return _uniqueCount; }
+        size_t duplicateCount() const { return _duplicateCount; }
+        size_t bytesSaved() const { return _bytesSaved; }
+        size_t hashCollisions() const { return _hashCollisions; }
+
+    protected:
+        struct Entry
+        {
+            uint64_t salt;
+            vsg::ref_ptr<vsg::Data> data;
+        };
+
+        std::unordered_multimap<uint64_t, Entry> _entries;
+
+        size_t _uniqueCount;
+        size_t _duplicateCount;
+        size_t _bytesSaved;
+        size_t _hashCollisions;
+    };
+
+} // namespace unity2vsg
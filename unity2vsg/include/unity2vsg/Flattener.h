@@ -0,0 +1,93 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/VertexFormat.h>
+
+#include <vsg/all.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    //
+    // FlattenVisitor
+    //
+    // Removes structure that does nothing at draw time. Empty groups are removed. Plain Groups and identity
+    // MatrixTransforms are replaced by their children. A MatrixTransform whose only child is another MatrixTransform is
+    // merged with it. Nodes with more than one parent are left in place, as are the children of an LOD.
+    // If bakeMaxVertices isn't 0, transforms above meshes with at most that many vertices are baked into copies of the
+    // vertex data so the transform can go too. Only subtrees of StateGroups, CullGroups, Groups and VertexIndexDraws
+    // can be baked. Call flatten with the root, the root itself is kept.
+    //
+
+    class UNITY2VSG_EXPORT FlattenVisitor : public vsg::Visitor
+    {
+    public:
+        FlattenVisitor(size_t bakeMaxVertices, const VertexArrayAttributes& attributes);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::Group& group) override;
+        void apply(vsg::MatrixTransform& transform) override;
+        void apply(vsg::LOD& lod) override;
+
+        void flatten(vsg::Group& root);
+
+        size_t removedGroupCount() const { return _removedGroupCount; }
+        size_t mergedTransformCount() const { return _mergedTransformCount; }
+        size_t bakedMeshCount() const { return _bakedMeshCount; }
+
+        // the arrays created for baked meshes and the attribute each holds
+        const VertexArrayAttributes& bakedArrays() const { return _bakedArrays; }
+
+    protected:
+        struct Baked
+        {
+            size_t vertexCount = 0;
+            size_t meshCount = 0;
+            std::map<const vsg::Data*, const vsg::Data*> arrays;
+        };
+
+        void flattenChildren(vsg::Group& group);
+        bool isRedundant(const vsg::Node* node) const;
+        size_t parentCount(const vsg::Node* node) const;
+
+        vsg::ref_ptr<vsg::Node> bakeTransform(vsg::MatrixTransform& transform);
+        vsg::ref_ptr<vsg::Node> bakeNode(vsg::Node* node, const vsg::mat4& matrix, Baked& baked);
+
+        size_t _bakeMaxVertices;
+        VertexArrayAttributes _attributes;
+
+        std::map<const vsg::Node*, size_t> _parentCounts;
+        std::set<const vsg::Node*> _flattened;
+
+        size_t _removedGroupCount;
+        size_t _mergedTransformCount;
+        size_t _bakedMeshCount;
+        VertexArrayAttributes _bakedArrays;
+    };
+
+    // how many parents each node below root has, root itself is counted once
+    extern UNITY2VSG_EXPORT std::map<const vsg::Node*, size_t> countParents(vsg::Node* root);
+
+    // nodes visited by a traversal from node, shared nodes are counted each time they are reached
+    extern UNITY2VSG_EXPORT size_t countNodes(vsg::Node* node);
+
+    // average time in milliseconds of a traversal visiting every node below node, a headless stand in for the walk a
+    // viewer makes each frame
+    extern UNITY2VSG_EXPORT double timeTraversal(vsg::Node* node, size_t iterations);
+
+} // namespace unity2vsg
@@ -0,0 +1,69 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/core/Data.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace unity2vsg
+{
+    //
+    // Index conversion, converts int32 source indices to the output width and returns the largest index in the same
+    // pass. Uses AVX2 or SSE2 when available and falls back to scalar code otherwise. Indices are compared as uint32 so
+    // a negative source index counts as a huge one. The uint16 version is only correct if the largest index returned is
+    // less than 65536 once rebased by subtracting base.
+    //
+
+    extern UNITY2VSG_EXPORT uint32_t convertIndices(const int32_t* src, size_t count, uint16_t* dst, int32_t base = 0);
+    extern UNITY2VSG_EXPORT uint32_t convertIndices(const int32_t* src, size_t count, uint32_t* dst);
+
+    // largest and smallest index in the array as uint32, if count is 0 min is UINT32_MAX and max is 0
+    extern UNITY2VSG_EXPORT void indexRange(const int32_t* src, size_t count, uint32_t& minIndex, uint32_t& maxIndex);
+
+    const uint32_t MAX_16BIT_INDEX = 0xffff;
+
+    //
+    // Splitting large triangle lists into ranges that can be drawn with 16 bit indices and a vertex offset
+    //
+
+    struct IndexRange
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        int32_t vertexOffset; // smallest index in the range, subtracted from the indices so they fit in 16 bits
+    };
+
+    using IndexRanges = std::vector<IndexRange>;
+
+    // greedily split a triangle list into consecutive ranges whose indices each span no more than 65536 vertices
+    extern UNITY2VSG_EXPORT IndexRanges split16BitIndexRanges(const int32_t* src, size_t count);
+
+    // true if drawing the ranges with 16 bit indices is worth the extra draw calls compared to one 32 bit draw
+    extern UNITY2VSG_EXPORT bool isSplitProfitable(const IndexRanges& ranges, size_t indexCount);
+
+    //
+    // Reading and writing ranges of exported ushort or uint index arrays as uint32
+    //
+
+    // copy a range of the index array to indices, false if the range is out of bounds or the array isn't ushort or uint
+    extern UNITY2VSG_EXPORT bool readIndices(const vsg::Data* data, uint32_t firstIndex, uint32_t indexCount, std::vector<uint32_t>& indices);
+
+    // copy indices back into the array starting at firstIndex, narrowing to ushort if that is what the array holds
+    extern UNITY2VSG_EXPORT void writeIndices(vsg::Data* data, uint32_t firstIndex, const std::vector<uint32_t>& indices);
+
+} // namespace unity2vsg
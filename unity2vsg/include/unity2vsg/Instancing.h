@@ -0,0 +1,94 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/VertexFormat.h>
+
+#include <vsg/all.h>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    //
+    // InstancingVisitor
+    //
+    // Finds meshes drawn with the same pipeline and descriptor set below different transforms and replaces them with a
+    // single instanced draw. Each instance's transform goes in a per instance vertex stream, just a translation when
+    // every instance shares the same rotation and scale, otherwise the full matrix. The instanced draw needs a pipeline
+    // variant with the per instance input, which the caller builds. Draws below an LOD are left alone.
+    //
+
+    class UNITY2VSG_EXPORT InstancingVisitor : public vsg::Visitor
+    {
+    public:
+        // returns pipeline rebuilt with a per instance input for instanceAttribute, TRANSLATE or INSTANCE_MATRIX, or null if its shaders can't take one
+        using CreateInstancedPipeline = std::function<vsg::ref_ptr<vsg::BindGraphicsPipeline>(const vsg::BindGraphicsPipeline* pipeline, uint32_t instanceAttribute)>;
+
+        explicit InstancingVisitor(size_t minInstances);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::Group& group) override;
+        void apply(vsg::MatrixTransform& transform) override;
+        void apply(vsg::LOD& lod) override;
+
+        // collect the draws below root, its own matrix isn't applied as the instanced draws are added to it
+        void collect(vsg::Group& root);
+
+        // replace meshes drawn at least minInstances times with instanced draws
+        void instance(CreateInstancedPipeline createPipeline);
+
+        size_t instancedMeshCount() const { return _instancedMeshCount; }
+        size_t instanceCount() const { return _instanceCount; }
+
+        // the per instance arrays created and the attribute each holds
+        const VertexArrayAttributes& instanceArrays() const { return _instanceArrays; }
+
+    protected:
+        struct Instance
+        {
+            vsg::ref_ptr<vsg::Group> parent;
+            vsg::ref_ptr<vsg::StateGroup> stategroup;
+            vsg::mat4 matrix;
+        };
+
+        struct Key
+        {
+            const vsg::Node* mesh;
+            const vsg::BindGraphicsPipeline* pipeline;
+            const vsg::StateCommand* descriptorSet;
+
+            bool operator<(const Key& rhs) const;
+        };
+
+        bool addInstance(vsg::Group& parent, vsg::StateGroup& stategroup);
+        vsg::ref_ptr<vsg::Node> createInstancedMesh(vsg::Node* mesh, vsg::ref_ptr<vsg::Data> instanceArray, uint32_t instanceCount);
+
+        size_t _minInstances;
+
+        vsg::ref_ptr<vsg::Group> _root;
+        std::vector<vsg::mat4> _matrixStack;
+        std::vector<Key> _keys;
+        std::map<Key, std::vector<Instance>> _instances;
+        std::set<const vsg::StateGroup*> _collected;
+
+        VertexArrayAttributes _instanceArrays;
+        size_t _instancedMeshCount;
+        size_t _instanceCount;
+    };
+
+} // namespace unity2vsg
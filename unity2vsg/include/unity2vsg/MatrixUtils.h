@@ -0,0 +1,87 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace unity2vsg
+{
+    //
+    // Column major matrix helpers for baking transforms into exported data, the vsg maths of the version we build
+    // against doesn't cover all of these
+    //
+
+    inline vsg::mat4 identityMatrix()
+    {
+        return vsg::mat4(1.0f, 0.0f, 0.0f, 0.0f,
+                         0.0f, 1.0f, 0.0f, 0.0f,
+                         0.0f, 0.0f, 1.0f, 0.0f,
+                         0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    inline bool isIdentity(const vsg::mat4& m)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                if (m[c][r] != (c == r ? 1.0f : 0.0f)) return false;
+            }
+        }
+        return true;
+    }
+
+    // product of a and b, b is applied first
+    inline vsg::mat4 multiply(const vsg::mat4& a, const vsg::mat4& b)
+    {
+        vsg::mat4 result;
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                result[c][r] = a[0][r] * b[c][0] + a[1][r] * b[c][1] + a[2][r] * b[c][2] + a[3][r] * b[c][3];
+            }
+        }
+        return result;
+    }
+
+    inline vsg::vec3 transformPoint(const vsg::mat4& m, const vsg::vec3& p)
+    {
+        return vsg::vec3(m[0][0] * p.x + m[1][0] * p.y + m[2][0] * p.z + m[3][0],
+                         m[0][1] * p.x + m[1][1] * p.y + m[2][1] * p.z + m[3][1],
+                         m[0][2] * p.x + m[1][2] * p.y + m[2][2] * p.z + m[3][2]);
+    }
+
+    // upper 3x3 only
+    inline vsg::vec3 transformVector(const vsg::mat4& m, const vsg::vec3& v)
+    {
+        return vsg::vec3(m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z,
+                         m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z,
+                         m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z);
+    }
+
+    // largest scale the upper 3x3 applies along any of its axes
+    inline float maxScale(const vsg::mat4& m)
+    {
+        float scale = 0.0f;
+        for (int c = 0; c < 3; ++c)
+        {
+            scale = std::max(scale, std::sqrt(m[c][0] * m[c][0] + m[c][1] * m[c][1] + m[c][2] * m[c][2]));
+        }
+        return scale;
+    }
+
+} // namespace unity2vsg
@@ -0,0 +1,141 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    // fifo cache size used when optimizing and measuring, a conservative match for current gpus
+    const uint32_t VERTEX_CACHE_SIZE = 16;
+
+    // post transform cache efficiency of an index list, acmr is misses per triangle and atvr misses per vertex used
+    struct VertexCacheStats
+    {
+        size_t triangles = 0;
+        size_t vertices = 0;
+        size_t misses = 0;
+
+        float acmr() const { return triangles > 0 ? static_cast<float>(misses) / static_cast<float>(triangles) : 0.0f; }
+        float atvr() const { return vertices > 0 ? static_cast<float>(misses) / static_cast<float>(vertices) : 0.0f; }
+
+        void add(const VertexCacheStats& stats)
+        {
+            triangles += stats.triangles;
+            vertices += stats.vertices;
+            misses += stats.misses;
+        }
+    };
+
+    extern UNITY2VSG_EXPORT VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // reorder triangles in place for vertex cache reuse using Tipsify, returns the first triangle of each cluster the
+    // ordering had to restart at, these are the points triangles can be moved between without hurting the cache
+    extern UNITY2VSG_EXPORT std::vector<uint32_t> optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // reorder the clusters from optimizeVertexCache so those facing out from the mesh centre are drawn first
+    extern UNITY2VSG_EXPORT void optimizeOverdraw(uint32_t* indices, size_t indexCount, const vsg::vec3* positions, size_t vertexCount, const std::vector<uint32_t>& clusters);
+
+    // renumber vertices in the order they're first used, returns the old to new index map, unused vertices map to ~0u
+    extern UNITY2VSG_EXPORT std::vector<uint32_t> optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t& usedVertexCount);
+
+    // create a copy of a vertex array in the order given by optimizeVertexFetch, returns null for unsupported array types
+    extern UNITY2VSG_EXPORT vsg::ref_ptr<vsg::Data> remapVertexArray(const vsg::Data* array, const std::vector<uint32_t>& remap, size_t usedVertexCount);
+
+    //
+    // MeshOptimizeVisitor
+    //
+    // Collects the index buffers of every VertexIndexDraw and DrawIndexed in a graph then reorders their triangles
+    // for the vertex cache and optionally overdraw. Triangles are only reordered within each draw so index data is
+    // changed in place. Index buffers are shared between meshes with the same topology, so a range drawn with more
+    // than one set of positions is only ordered for the vertex cache and a range partly overlapping another is left
+    // alone. Meshes whose vertex arrays aren't used by any other index buffer are also given new arrays in fetch order.
+    //
+
+    class UNITY2VSG_EXPORT MeshOptimizeVisitor : public vsg::Visitor
+    {
+    public:
+        MeshOptimizeVisitor(bool overdraw);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::StateGroup& stategroup) override;
+        void apply(vsg::Commands& commands) override;
+        void apply(vsg::VertexIndexDraw& vid) override;
+
+        // optimize everything collected
+        void optimize();
+
+        const VertexCacheStats& statsBefore() const { return _before; }
+        const VertexCacheStats& statsAfter() const { return _after; }
+        size_t optimizedCount() const { return _optimizedCount; }
+        size_t remappedCount() const { return _remappedCount; }
+        size_t overlappingCount() const { return _overlappingCount; }
+
+        // new vertex arrays created for fetch order mapped to the arrays they replaced
+        const std::map<const vsg::Data*, const vsg::Data*>& remappedArrays() const { return _remappedArrays; }
+
+    protected:
+        struct DrawRange
+        {
+            vsg::ref_ptr<vsg::Data> indices;
+            vsg::ref_ptr<vsg::Data> positions;
+            uint32_t firstIndex;
+            uint32_t indexCount;
+            int32_t vertexOffset;
+
+            // ranges of the same buffer are adjacent and ordered by where they start
+            bool operator<(const DrawRange& rhs) const
+            {
+                if (indices.get() != rhs.indices.get()) return indices.get() < rhs.indices.get();
+                if (firstIndex != rhs.firstIndex) return firstIndex < rhs.firstIndex;
+                if (indexCount != rhs.indexCount) return indexCount < rhs.indexCount;
+                if (positions.get() != rhs.positions.get()) return positions.get() < rhs.positions.get();
+                return vertexOffset < rhs.vertexOffset;
+            }
+
+            bool sameIndices(const DrawRange& rhs) const { return indices.get() == rhs.indices.get() && firstIndex == rhs.firstIndex && indexCount == rhs.indexCount; }
+            uint32_t endIndex() const { return firstIndex + indexCount; }
+        };
+
+        void addRange(const vsg::DataList& arrays, vsg::ref_ptr<vsg::Data> indices, uint32_t firstIndex, uint32_t indexCount, int32_t vertexOffset);
+        void optimizeRange(const DrawRange& range, bool overdraw);
+        void remapVertexIndexDraws();
+
+        bool _overdraw;
+
+        // buffers bound by state commands above the current node
+        vsg::DataList _boundVertexArrays;
+        vsg::ref_ptr<vsg::Data> _boundIndices;
+
+        std::set<DrawRange> _ranges;
+        std::vector<vsg::ref_ptr<vsg::VertexIndexDraw>> _vertexIndexDraws;
+
+        // arrays bound with BindVertexBuffers may be drawn with several index buffers so are never remapped
+        std::set<const vsg::Data*> _boundArrays;
+
+        std::map<const vsg::Data*, const vsg::Data*> _remappedArrays;
+
+        VertexCacheStats _before;
+        VertexCacheStats _after;
+        size_t _optimizedCount;
+        size_t _remappedCount;
+        size_t _overlappingCount;
+    };
+
+} // namespace unity2vsg
@@ -0,0 +1,100 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/IndexUtils.h>
+
+#include <vsg/all.h>
+
+#include <map>
+#include <vector>
+
+namespace unity2vsg
+{
+    // Simplify a triangle list with quadric error edge collapses towards targetIndexCount. Vertices are only ever
+    // collapsed onto existing vertices so the result indexes the same vertex arrays. Vertices sharing a position but
+    // split by other attributes (uv borders, hard normals) are treated as seams that can only collapse along the seam,
+    // open borders only collapse along the border and anything more complex stays put. maxError is relative to the
+    // mesh extent and stops simplification early, the error reached is returned in resultError.
+    extern UNITY2VSG_EXPORT std::vector<uint32_t> simplifyMesh(const uint32_t* indices, size_t indexCount, const vsg::vec3* positions, size_t vertexCount, size_t targetIndexCount,
+                                                                float maxError, float* resultError = nullptr);
+
+    //
+    // LODGenerateVisitor
+    //
+    // Wraps the meshes of a graph in generated vsg::LOD nodes. Each simplified level reuses the original vertex arrays
+    // with a new index buffer. Meshes already below an LOD are left alone, as are meshes too small to be worth it.
+    // Call generate once the visitor has been accepted, meshes are simplified in parallel.
+    //
+
+    class UNITY2VSG_EXPORT LODGenerateVisitor : public vsg::Visitor
+    {
+    public:
+        struct Level
+        {
+            float triangleRatio; // fraction of the original triangles to keep
+            float minimumScreenHeightRatio;
+        };
+
+        LODGenerateVisitor(float fullDetailScreenHeightRatio, const std::vector<Level>& levels, float maxError);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::Group& group) override;
+        void apply(vsg::LOD& lod) override;
+
+        void generate();
+
+        size_t lodCount() const { return _lodCount; }
+        const std::vector<size_t>& levelTriangles() const { return _levelTriangles; }
+
+        // meshes with fewer triangles than this don't get LODs
+        static const size_t MIN_TRIANGLES = 256;
+
+    protected:
+        struct Mesh
+        {
+            vsg::ref_ptr<vsg::Node> node;
+            vsg::ref_ptr<vsg::Data> positions;
+            vsg::ref_ptr<vsg::Data> indices;
+            IndexRanges ranges;
+
+            vsg::ref_ptr<vsg::Node> lod;
+            std::vector<size_t> levelTriangles;
+        };
+
+        bool addMesh(vsg::ref_ptr<vsg::Node> node);
+        void generateLOD(Mesh& mesh);
+        vsg::ref_ptr<vsg::Node> createLevelNode(Mesh& mesh, vsg::ref_ptr<vsg::Data> indices, const IndexRanges& ranges);
+
+        float _fullDetailScreenHeightRatio;
+        std::vector<Level> _levels;
+        float _maxError;
+
+        std::vector<Mesh> _meshes;
+        std::map<const vsg::Node*, size_t> _meshIndices;
+
+        // children to replace with the lod of a mesh once generated
+        struct Slot
+        {
+            vsg::ref_ptr<vsg::Group> group;
+            size_t child;
+            size_t mesh;
+        };
+        std::vector<Slot> _slots;
+
+        size_t _lodCount;
+        std::vector<size_t> _levelTriangles;
+    };
+
+} // namespace unity2vsg
@@ -0,0 +1,144 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/IndexUtils.h>
+#include <unity2vsg/VertexFormat.h>
+
+#include <vsg/all.h>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    // the view textures are trimmed for, anything closer or sharper than this may sample the removed levels
+    struct MipTrimOptions
+    {
+        uint32_t screenHeight = 1080; // pixels
+        float fieldOfView = 60.0f; // vertical, in degrees
+        float nearDistance = 1.0f; // closest the camera gets to any surface
+    };
+
+    // Uv units per world unit across a triangle along its least stretched direction, or 1/16th of the most stretched
+    // if that's more as anisotropic filtering would then pick a coarser level anyway. -1 if the triangle has no area.
+    extern UNITY2VSG_EXPORT float uvDensity(const vsg::vec3& p0, const vsg::vec3& p1, const vsg::vec3& p2, const vsg::vec2& uv0, const vsg::vec2& uv1, const vsg::vec2& uv2);
+
+    // a copy of an 8 bit or block compressed 2D array starting at level, null for other data or if it has too few levels
+    extern UNITY2VSG_EXPORT vsg::ref_ptr<vsg::Data> trimMipmaps(const vsg::Data* data, uint32_t level);
+
+    // levels vsg uploads for a texture, it stops the chain once the width and height are down to 1
+    extern UNITY2VSG_EXPORT uint32_t textureLevels(const vsg::Data* data);
+
+    // bytes of every level of a 2D texture or of each layer of a texture array
+    extern UNITY2VSG_EXPORT size_t textureBytes(const vsg::Data* data);
+
+    //
+    // MipTrimVisitor
+    //
+    // Measures how many uv units a pixel can cover at most for every texture in a graph, from the uv density of the
+    // draws using it, their transforms and how close the camera can get. That's the near distance, or further for the
+    // lower levels of an LOD as the levels before them are drawn until the bound shrinks below their screen height
+    // ratio. Levels finer than any draw can sample are then dropped from the texture's data. The distance is taken
+    // along the view axis for a surface facing the camera, which is where the finest level is needed. Data shared
+    // by textures that can't be measured, because their shader scales the uvs or a draw using them can't be read, is
+    // left alone. Along the way it totals the world space area and number of draws each texture's data is drawn with
+    // by the first level of any LOD, for planTextureBudget.
+    //
+
+    class UNITY2VSG_EXPORT MipTrimVisitor : public vsg::Visitor
+    {
+    public:
+        // the descriptors bound by a BindDescriptorSet, returns false if they aren't known
+        using GetDescriptors = std::function<bool(const vsg::BindDescriptorSet* bind, vsg::Descriptors& descriptors)>;
+
+        // textures whose shader samples them at the first uvs as they are, the only ones that can be measured
+        using IsMeasurable = std::function<bool(const vsg::DescriptorImage* texture)>;
+
+        MipTrimVisitor(const MipTrimOptions& options, const VertexArrayAttributes& attributes);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::MatrixTransform& transform) override;
+        void apply(vsg::LOD& lod) override;
+        void apply(vsg::StateGroup& stategroup) override;
+        void apply(vsg::Geometry& geometry) override;
+        void apply(vsg::VertexIndexDraw& vid) override;
+        void apply(vsg::Commands& commands) override;
+
+        void collect(vsg::Group& root, GetDescriptors getDescriptors, IsMeasurable isMeasurable);
+
+        // replace the data of textures that are never sampled at their first levels
+        void trim();
+
+        // how a texture's data is used
+        struct Usage
+        {
+            vsg::ref_ptr<vsg::Data> data; // the trimmed data once trimmed
+            std::set<vsg::DescriptorImage*> textures;
+            float finest; // fewest uv units a pixel covers
+            bool measurable = true;
+            double area = 0.0; // world space area drawn by the first levels of LODs, instances included
+            double draws = 0.0; // draws by the first levels of LODs, counting each instance
+        };
+
+        // keyed by the data the textures held when collected
+        const std::map<const vsg::Data*, Usage>& usages() const { return _usages; }
+
+        struct Trimmed
+        {
+            const vsg::Data* original;
+            vsg::ref_ptr<vsg::Data> data;
+            uint32_t levels; // levels removed
+            size_t bytesRemoved;
+        };
+
+        const std::vector<Trimmed>& trimmed() const { return _trimmed; }
+        size_t measuredCount() const { return _measuredCount; } // data only used by textures that could be measured
+        size_t bytesRemoved() const { return _bytesRemoved; }
+
+        // anisotropic filtering the samplers can use at most, see uvDensity
+        static const uint32_t MAX_ANISOTROPY = 16;
+
+    protected:
+        const std::vector<vsg::DescriptorImage*>* boundTextures(const vsg::BindDescriptorSet* bind);
+
+        // smallest uv density of the triangles in world space, -1 if the draw can't be read. area is the world space area
+        // of every instance of the triangles, 0 if they can't be read
+        float measure(const vsg::DataList& arrays, const vsg::Data* indices, const IndexRanges& ranges, uint32_t instanceCount, double& area) const;
+
+        void addDraw(const vsg::BindDescriptorSet* bind, const vsg::DataList& arrays, const vsg::Data* indices, const IndexRanges& ranges, uint32_t instanceCount);
+
+        MipTrimOptions _options;
+        const VertexArrayAttributes& _attributes;
+        GetDescriptors _getDescriptors;
+        IsMeasurable _isMeasurable;
+        float _tanHalfFov;
+        float _pixelSize; // world units a pixel covers per unit of distance
+
+        std::vector<vsg::mat4> _matrixStack;
+        std::vector<float> _distanceStack; // closest the camera gets to what's below
+        size_t _lowerLevels; // depth of LOD levels after the first above the draws
+        std::vector<const vsg::BindDescriptorSet*> _bindStack;
+
+        std::map<const vsg::BindDescriptorSet*, std::vector<vsg::DescriptorImage*>> _boundTextures;
+        std::map<const vsg::Data*, Usage> _usages;
+
+        std::vector<Trimmed> _trimmed;
+        size_t _measuredCount;
+        size_t _bytesRemoved;
+    };
+
+} // namespace unity2vsg
@@ -0,0 +1,52 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace unity2vsg
+{
+    // how the levels of a generated mip chain are filtered, passed in ImageData::mipmapFilter
+    enum MipmapFilter : int32_t
+    {
+        MIPMAP_FILTER_COLOR = 0, // box filtered, in linear space for srgb formats
+        MIPMAP_FILTER_NORMAL = 1 // tangent space normals, renormalized after filtering. Two component maps hold x and y
+    };
+
+    // levels in a full chain halving down to 1x1
+    extern UNITY2VSG_EXPORT uint32_t fullMipmapCount(uint32_t width, uint32_t height);
+
+    // texels in the first mipmapCount levels of a chain, levels are stored one after the other from the largest
+    extern UNITY2VSG_EXPORT size_t mipmapChainSize(uint32_t width, uint32_t height, uint32_t mipmapCount);
+
+    struct MipmapOptions
+    {
+        uint32_t components = 4; // 8 bit components per texel, 1 to 4
+        bool srgb = false; // color components are srgb encoded, alpha never is
+        MipmapFilter filter = MIPMAP_FILTER_COLOR;
+        float alphaCutoff = 0.0f; // alpha test threshold, when above 0 each level keeps the alpha coverage of the first
+    };
+
+    //
+    // Fill in levels 1 to mipmapCount - 1 of an 8 bit per component mip chain whose first level is already filled. Each
+    // level is box filtered from the one above in floating point, rows are spread across threads for large levels and
+    // four component textures use SSE2 when available. Odd sizes round down and the last texel of a row or column
+    // averages the three source texels it covers so no source texels are dropped.
+    //
+
+    extern UNITY2VSG_EXPORT void generateMipmaps(uint8_t* chain, uint32_t width, uint32_t height, uint32_t mipmapCount, const MipmapOptions& options);
+
+} // namespace unity2vsg
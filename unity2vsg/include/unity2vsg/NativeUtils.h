@@ -142,6 +142,8 @@ namespace unity2vsg
         VkSamplerMipmapMode mipmapMode;
         int mipmapCount;
         float mipmapBias;
+        int mipmapFilter; // MipmapFilter used if the mip chain is generated on export
+        float alphaCutoff; // alpha test threshold generated mips keep the coverage of, 0 for none
     };
 
     //
@@ -154,6 +156,10 @@ namespace unity2vsg
         int binding;
         ImageData* images;
         int descriptorCount;
+        int packLayers; // pack the images into the layers of one 2D array image bound as a single descriptor
+        int packChannels; // pack the first component of each image into the components of one image bound as a single descriptor
+        int firstComponentOnly; // the shader only reads the first component so the rest can be dropped
+        int sampledAtFirstUvs; // the shader samples the images at the first uvs unscaled so their texel density can be measured
     };
 
     struct DescriptorFloatUniformData
@@ -253,6 +259,44 @@ namespace unity2vsg
         float farZ;
     };
 
+    //
+    // Export settings, options applied to the whole export
+    //
+
+    const int MAX_LOD_LEVELS = 4;
+
+    struct ExportSettingsData
+    {
+        int interleaveVertexArrays; // pack all of a meshes vertex attributes into a single array and pipeline binding
+        int normalEncoding; // VertexEncoding for normals, float32, snorm16 or octahedral16
+        int tangentEncoding; // VertexEncoding for tangents, float32, snorm16 or octahedral16
+        int uvEncoding; // VertexEncoding for uvs, float32, float16 or unorm16
+        int colorEncoding; // VertexEncoding for colors, float32 or unorm8
+        int optimizeMeshes; // 0 off, 1 reorder for the vertex cache and vertex fetch, 2 also reorder for overdraw
+        int lodLevelCount; // simplified levels to generate for each mesh, 0 off, up to MAX_LOD_LEVELS
+        float lodTriangleRatios[MAX_LOD_LEVELS]; // fraction of the original triangles kept by each level
+        float lodScreenHeightRatios[MAX_LOD_LEVELS + 1]; // minimum screen height ratio of the full detail mesh followed by each level
+        float lodMaxError; // largest simplification error as a fraction of the mesh size
+        int staticBatching; // merge draws sharing a pipeline and descriptor set into pre-transformed batches
+        float staticBatchCellSize; // world space size of the grid cells draws are batched within, 0 for no limit
+        int instancingMinCount; // draw meshes repeated at least this many times with one instanced draw, 0 off
+        int flattenGraph; // remove redundant groups and merge chained transforms before writing
+        int bakeTransformsMaxVertices; // when flattening, bake transforms into meshes with up to this many vertices, 0 off
+        int sortState; // order siblings by pipeline and descriptor set and hoist shared binds into parent StateGroups
+        int cullHierarchy; // regroup children into a hierarchy of CullGroups, 0 off, 1 median split, 2 surface area heuristic
+        int cullHierarchyMinChildren; // only groups with at least this many children are regrouped
+        int generateMipmaps; // build a full mip chain for 8 bit textures that only have their first level
+        int textureCompression; // CompressionQuality to block compress 8 bit textures with, 0 off
+        int textureAtlasMaxSize; // pack textures up to this size into shared atlas pages, 0 off
+        int textureAtlasPageSize; // width and height atlas pages are packed into
+        float textureDuplicateTolerance; // rms difference per 8 bit component textures can share data within, 0 for exact duplicates only
+        int analyzeTextures; // shrink constant textures, unread components and opaque alpha
+        int trimMipmapsScreenHeight; // drop mipmaps finer than a screen this many pixels high can sample, 0 off
+        float trimMipmapsFieldOfView; // vertical field of view in degrees of the camera the mipmaps are trimmed for
+        float trimMipmapsNearDistance; // closest the camera gets to any surface
+        int textureMemoryBudget; // megabytes all textures are downsampled to fit in, 0 off
+    };
+
     // create a vsg Array from a pointer and length, by default the ownership of the memory will be external to vsg still
     // so be sure to call Array dataRelease before the ref_ptr tries to delete the memory
 
@@ -262,7 +306,7 @@ namespace unity2vsg
         return vsg::ref_ptr<vsg::Array<T>>(new vsg::Array<T>(static_cast<size_t>(length), ptr));
     }
 
-    VkSamplerCreateInfo vkSamplerCreateInfoForTextureData(const ImageData& data)
+    inline VkSamplerCreateInfo vkSamplerCreateInfoForTextureData(const ImageData& data)
     {
         bool mipmappingRequired = data.mipmapCount > 1;
 
@@ -279,10 +323,12 @@ namespace unity2vsg
         samplerInfo.anisotropyEnable = data.anisoLevel > 1.0f ? VK_TRUE : VK_FALSE;
         samplerInfo.maxAnisotropy = static_cast<float>(data.anisoLevel);
 
+        // the image's level count already clamps the lod, leaving maxLod unclamped lets textures with different
+        // chain lengths share a sampler
         if (mipmappingRequired)
         {
             samplerInfo.minLod = 0;
-            samplerInfo.maxLod = static_cast<float>(data.mipmapCount);
+            samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
             samplerInfo.mipLodBias = 0;
         }
         else
@@ -306,7 +352,7 @@ namespace unity2vsg
         uint32_t blockSize; //bit size of block
     };
 
-    VkFormatSizeInfo GetSizeInfoForFormat(VkFormat format)
+    inline VkFormatSizeInfo GetSizeInfoForFormat(VkFormat format)
     {
         VkFormatSizeInfo sizeInfo;
         sizeInfo.layout.maxNumMipmaps = 1; // sensible default
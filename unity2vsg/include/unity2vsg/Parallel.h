@@ -0,0 +1,44 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace unity2vsg
+{
+    // call func(i) for every i in [0, count) spread across the hardware threads, calls for different i must be independent
+    template<typename F>
+    void parallelFor(size_t count, F func)
+    {
+        size_t threadCount = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+        if (threadCount <= 1)
+        {
+            for (size_t i = 0; i < count; ++i) func(i);
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < count; i = next++) func(i);
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads) thread.join();
+    }
+
+} // namespace unity2vsg
@@ -20,6 +20,10 @@ namespace unity2vsg
         TEXCOORD2 = 512,
         TRANSLATE = 1024,
         TRANSLATE_OVERALL = 2048,
+        NORMAL_OCTAHEDRAL = 4096, // normals are packed into two components with an octahedral mapping
+        TANGENT_OCTAHEDRAL = 8192, // as above with the bitangent sign folded into the second component
+        INSTANCE_MATRIX = 16384, // per instance mat4 at locations 6 to 9, TRANSLATE is a per instance vec3 at location 6
+        INSTANCE_ATTS = TRANSLATE | INSTANCE_MATRIX,
         STANDARD_ATTS = VERTEX | NORMAL | TANGENT | COLOR | TEXCOORD0,
         ALL_ATTS = VERTEX | NORMAL | NORMAL_OVERALL | TANGENT | TANGENT_OVERALL | COLOR | COLOR_OVERALL | TEXCOORD0 | TEXCOORD1 | TEXCOORD2 | TRANSLATE | TRANSLATE_OVERALL
     };
@@ -43,6 +47,9 @@ namespace unity2vsg
     // read a glsl file and inject defines based on shadermode mask and geometryattributes
     extern std::string readGLSLShader(const std::string& filename, const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines);
 
+    // does a glsl file list define in its import_defines pragma, an empty filename means the built in fbx shaders which import all of ours
+    extern bool shaderImportsDefine(const std::string& filename, const std::string& define);
+
     // create standard shader and inject defines based on shadermode mask and geometryattributes
     extern std::string createFbxVertexSource(const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines);
     extern std::string createFbxFragmentSource(const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines);
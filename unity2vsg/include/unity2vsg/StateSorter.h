@@ -0,0 +1,84 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <map>
+#include <set>
+
+namespace unity2vsg
+{
+    //
+    // StateSortVisitor
+    //
+    // Orders the children of each group by the pipeline and then the descriptor set they bind. Runs of children
+    // binding the same pipeline are moved below a new StateGroup that binds it once for all of them. The descriptor
+    // set is hoisted too if the whole run shares it. The children's own StateGroups lose the hoisted commands and are
+    // removed once empty. A child's state can come from a StateGroup below a chain of single child groups, as a
+    // CullGroup wrapping each mesh would give. Shared nodes and the order of LOD levels are left alone. Children that
+    // draw with a blended pipeline stay in place and only the children between them are sorted, neighbouring children
+    // binding the same blended pipeline still share a hoisted bind. Groups are worked on bottom up, so hoisted state keeps
+    // moving up while siblings agree.
+    //
+
+    class UNITY2VSG_EXPORT StateSortVisitor : public vsg::Visitor
+    {
+    public:
+        StateSortVisitor();
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::Group& group) override;
+
+        void sort(vsg::Group& root);
+
+        size_t hoistedCount() const { return _hoistedCount; }
+
+    protected:
+        // the StateGroup a child's state comes from, held by parent
+        struct Carrier
+        {
+            vsg::Group* parent = nullptr;
+            vsg::StateGroup* stategroup = nullptr;
+            vsg::StateCommand* pipeline = nullptr;
+            vsg::StateCommand* descriptorSet = nullptr;
+        };
+
+        bool findCarrier(vsg::Group& group, vsg::Node* child, Carrier& carrier) const;
+        void removeState(const Carrier& carrier, vsg::Group::Children& children, const vsg::ref_ptr<vsg::Node>& child, bool removeDescriptorSet);
+        void sortChildren(vsg::Group& group);
+
+        std::map<const vsg::Node*, size_t> _parentCounts;
+        std::set<const vsg::Node*> _visited;
+        bool _anyBlended; // set by sort, skips looking for blended draws below each child when the graph has none
+        size_t _hoistedCount;
+    };
+
+    struct BindCounts
+    {
+        size_t pipelines = 0;
+        size_t descriptorSets = 0;
+    };
+
+    // the pipeline and descriptor set binds recorded by a traversal of every node below node
+    extern UNITY2VSG_EXPORT BindCounts countBinds(vsg::Node* node);
+
+    // is command a BindGraphicsPipeline whose pipeline blends into any of its color attachments
+    extern UNITY2VSG_EXPORT bool isBlendedPipeline(vsg::Object* command);
+
+    // does anything below node bind a blended pipeline, blended draws have to be drawn in the order they were exported
+    extern UNITY2VSG_EXPORT bool drawsBlended(vsg::Node* node);
+
+} // namespace unity2vsg
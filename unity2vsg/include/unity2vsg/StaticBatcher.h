@@ -0,0 +1,119 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/IndexUtils.h>
+#include <unity2vsg/VertexFormat.h>
+
+#include <vsg/all.h>
+
+#include <array>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    //
+    // Pre-transforming vertex arrays
+    //
+
+    // true if every array holds one float vec2, vec3 or vec4 per vertex with a known attribute, the first being the
+    // positions, arrayAttributes is filled with the attribute of each array
+    extern UNITY2VSG_EXPORT bool transformableVertexArrays(const vsg::DataList& arrays, const VertexArrayAttributes& attributes, std::vector<uint32_t>& arrayAttributes);
+
+    // arrays with the same value types as arrays, vertexCount long
+    extern UNITY2VSG_EXPORT vsg::DataList createTransformedVertexArrays(const vsg::DataList& arrays, size_t vertexCount);
+
+    // write arrays transformed by matrix into output starting at baseVertex. Normals use the cofactor matrix, tangents keep
+    // their handedness. Returns true if the matrix mirrors, in which case the caller has to reverse the triangle winding
+    extern UNITY2VSG_EXPORT bool transformVertexArrays(const vsg::mat4& matrix, const vsg::DataList& arrays, const std::vector<uint32_t>& arrayAttributes, vsg::DataList& output, size_t baseVertex);
+
+    //
+    // StaticBatchVisitor
+    //
+    // Merges the draws of a graph that share a pipeline and descriptor set into one VertexIndexDraw per batch. The
+    // vertices of each draw are pre-transformed by the MatrixTransforms above it so the batch can sit directly below
+    // the root. Draws are only batched with others whose bound center falls in the same cell of a world space grid,
+    // each batch gets a CullGroup so culling still works on the merged draws. Draws below an LOD are left alone.
+    //
+
+    class UNITY2VSG_EXPORT StaticBatchVisitor : public vsg::Visitor
+    {
+    public:
+        StaticBatchVisitor(float cellSize, const VertexArrayAttributes& attributes);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::Group& group) override;
+        void apply(vsg::MatrixTransform& transform) override;
+        void apply(vsg::LOD& lod) override;
+
+        // collect the draws below root, its own matrix isn't applied as the batches are added to it
+        void collect(vsg::Group& root);
+
+        // replace the collected draws with batches, draws with nothing to batch with are left where they are
+        void batch();
+
+        size_t collectedCount() const { return _collectedCount; }
+        size_t batchedCount() const { return _batchedCount; }
+        size_t batchCount() const { return _batchCount; }
+
+        // arrays created for the batches mapped to one of the arrays they were built from, they hold the same attribute
+        const std::map<const vsg::Data*, const vsg::Data*>& batchedArrays() const { return _batchedArrays; }
+
+        // batches are drawn with 16 bit indices so are limited to this many vertices
+        static const size_t MAX_BATCH_VERTICES = 65536;
+
+    protected:
+        // a StateGroup holding a pipeline and descriptor set bind with a single mesh below it
+        struct Draw
+        {
+            vsg::ref_ptr<vsg::Group> parent;
+            vsg::ref_ptr<vsg::StateGroup> stategroup;
+            vsg::mat4 matrix;
+            vsg::DataList arrays;
+            std::vector<uint32_t> attributes;
+            vsg::ref_ptr<vsg::Data> indices;
+            IndexRanges ranges;
+        };
+
+        struct Key
+        {
+            const vsg::StateCommand* pipeline;
+            const vsg::StateCommand* descriptorSet;
+            std::vector<uint32_t> layout; // attribute and value size of each array
+            std::array<int64_t, 3> cell;
+
+            bool operator<(const Key& rhs) const;
+        };
+
+        bool addDraw(vsg::Group& parent, vsg::StateGroup& stategroup);
+        void createBatch(const std::vector<Draw*>& draws);
+
+        float _cellSize;
+        const VertexArrayAttributes& _attributes;
+
+        vsg::ref_ptr<vsg::Group> _root;
+        std::vector<vsg::mat4> _matrixStack;
+        std::vector<std::vector<Draw>> _draws;
+        std::map<Key, size_t> _keyIndices;
+        std::set<const vsg::StateGroup*> _collected;
+
+        std::map<const vsg::Data*, const vsg::Data*> _batchedArrays;
+        size_t _collectedCount;
+        size_t _batchedCount;
+        size_t _batchCount;
+    };
+
+} // namespace unity2vsg
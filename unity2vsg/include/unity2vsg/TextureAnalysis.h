@@ -0,0 +1,78 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/NativeUtils.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace unity2vsg
+{
+    enum TextureContent : uint32_t
+    {
+        CONTENT_CONSTANT = 1, // every texel is the same
+        CONTENT_OPAQUE = 2, // there's no alpha or every alpha is 255
+        CONTENT_GRAYSCALE = 4 // a single component, or three color components that are equal in every texel
+    };
+
+    struct TextureAnalysis
+    {
+        uint32_t content = 0; // TextureContent bits
+        uint8_t texel[4] = {0, 0, 0, 255}; // the first texel, the color of every texel when constant
+    };
+
+    // Classify the texels of an 8 bit texture with 1 to 4 components. Blocks of texels are spread across threads and
+    // compared 16 bytes at a time with SSE2 when available, stopping early once nothing is left to find.
+    extern UNITY2VSG_EXPORT TextureAnalysis analyzeTexture(const uint8_t* texels, size_t texelCount, uint32_t components);
+
+    struct ReduceOptions
+    {
+        bool firstComponentOnly = false; // the shader only reads the first component so the rest can be dropped
+        bool compress = false; // the texture will be block compressed if its size allows
+    };
+
+    enum TextureReduction : uint32_t
+    {
+        REDUCED_CONSTANT = 1, // shrunk to a single texel
+        REDUCED_FIRST_COMPONENT = 2, // components the shader doesn't read were dropped
+        REDUCED_ALPHA = 4 // an opaque alpha was dropped
+    };
+
+    struct ReducedTexture
+    {
+        uint32_t reductions = 0; // TextureReduction bits
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipmapCount = 1;
+        std::vector<uint8_t> pixels;
+        std::string reason; // what was found and what was done about it, for the log
+    };
+
+    //
+    // Analyze the first level of an 8 bit 2D texture and store it in less memory if its contents allow, without changing
+    // how it samples. Constant textures shrink to a single texel, textures only read through their first component drop
+    // the rest, and opaque rgba textures that will be block compressed drop their alpha so they compress as BC1, or as
+    // BC7 without alpha at high quality. Uncompressed textures keep their alpha, as three component formats are rarely
+    // supported for sampling. The block compressor can't be given single channel srgb data, so compressed srgb textures
+    // are stored linear when reduced to one component. Textures sampled as color keep their color components, as the
+    // image layout has no swizzle to read grayscale back out of one. Returns false if the texture was left as it is.
+    //
+
+    extern UNITY2VSG_EXPORT bool reduceTexture(const ImageData& image, const ReduceOptions& options, ReducedTexture& reduced);
+
+} // namespace unity2vsg
@@ -0,0 +1,71 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/NativeUtils.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace unity2vsg
+{
+    // Decode the first level of an 8 bit or BC1 to BC5 2D image to rgba, missing components are 0 and missing alpha is
+    // 255. Returns false for other formats or if the image has fewer pixels than its size.
+    extern UNITY2VSG_EXPORT bool readImageRGBA8(const ImageData& image, std::vector<uint8_t>& rgba, bool& srgb);
+
+    // Resample an rgba image with a tent filter, bilinear when enlarging and widened to cover every source texel when
+    // shrinking. srgb images are filtered in linear space.
+    extern UNITY2VSG_EXPORT void resizeRGBA8(const uint8_t* source, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* destination, uint32_t width, uint32_t height, bool srgb);
+
+    struct PackedTextureArray
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t layers = 0;
+        uint32_t mipmapCount = 1;
+        bool srgb = false;
+        std::vector<uint8_t> chain; // rgba levels one after the other, each level holding every layer in order
+        uint32_t converted = 0; // layers that had to be resized or changed color space to fit the array
+        std::vector<uint32_t> unreadable; // layers that couldn't be read and were filled with white
+    };
+
+    //
+    // Pack the first level of each image into the layers of one rgba array. Layers are resized to the largest width and
+    // height and converted to the color space of the first readable image. A full mip chain is generated per layer when
+    // createMipmaps is set or any image came with mipmaps of its own.
+    //
+
+    extern UNITY2VSG_EXPORT bool packTextureArray(const ImageData* images, uint32_t count, bool createMipmaps, PackedTextureArray& packed);
+
+    struct PackedTextureChannels
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipmapCount = 1;
+        uint32_t components = 0; // 1, 2 or 4, three images are padded out to four components
+        std::vector<uint8_t> chain; // unorm levels one after the other
+        uint32_t converted = 0; // images that had to be resized or decoded from srgb to fit
+        std::vector<uint32_t> unreadable; // images that couldn't be read, their channel is filled with 255
+    };
+
+    //
+    // Pack the first component of each of up to four images into the components of one unorm image, in order from red.
+    // Images are resized to the largest width and height and srgb images are decoded to linear so each component samples
+    // as its image did. Components without an image are 255. Mipmaps are generated as for packTextureArray, each component
+    // filtered on its own.
+    //
+
+    extern UNITY2VSG_EXPORT bool packTextureChannels(const ImageData* images, uint32_t count, bool createMipmaps, PackedTextureChannels& packed);
+
+} // namespace unity2vsg
@@ -0,0 +1,162 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/NativeUtils.h>
+#include <unity2vsg/TextureCompressor.h>
+#include <unity2vsg/VertexFormat.h>
+
+#include <vsg/all.h>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    struct AtlasRect
+    {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    //
+    // SkylinePacker
+    //
+    // Bottom left skyline rectangle packer for a fixed size page. Each rectangle goes where its top edge ends up
+    // lowest, ties going to the narrowest skyline segment so gaps are filled before wide flat areas.
+    //
+
+    class UNITY2VSG_EXPORT SkylinePacker
+    {
+    public:
+        SkylinePacker(uint32_t width, uint32_t height);
+
+        // find a place for a width x height rectangle, returns false if it doesn't fit
+        bool insert(uint32_t width, uint32_t height, AtlasRect& rect);
+
+        uint64_t usedArea() const { return _usedArea; }
+
+    protected:
+        struct Segment
+        {
+            uint32_t x;
+            uint32_t y;
+            uint32_t width;
+        };
+
+        bool fits(size_t index, uint32_t width, uint32_t height, uint32_t& y) const;
+
+        uint32_t _width;
+        uint32_t _height;
+        uint64_t _usedArea;
+        std::vector<Segment> _skyline;
+    };
+
+    struct TextureAtlasOptions
+    {
+        uint32_t maxTextureSize = 256; // textures wider or taller than this keep their own descriptor set
+        uint32_t pageSize = 2048;
+        bool generateMipmaps = true;
+        CompressionQuality quality = COMPRESSION_NONE;
+    };
+
+    //
+    // TextureAtlasVisitor
+    //
+    // Packs the small textures of materials that only differ by their texture into shared atlas pages, so the draws
+    // using them end up with one descriptor set and can be batched. Only StateGroups binding a pipeline and descriptor
+    // set above plain VertexIndexDraws whose first uvs stay within 0 to 1 are changed, their uvs are rewritten to the
+    // texture's place in the page. Textures are padded by repeating their edges so the first PADDING_LEVELS mips don't
+    // bleed into their neighbours, pages stop at that many levels.
+    //
+
+    class UNITY2VSG_EXPORT TextureAtlasVisitor : public vsg::Visitor
+    {
+    public:
+        // the texture of a material that could be atlased
+        struct Material
+        {
+            vsg::ref_ptr<vsg::DescriptorImage> texture; // the material's only image descriptor, holding a single image
+            ImageData sampler; // sampler state the texture was created with, the pixels aren't used
+            uint64_t key = 0; // pipeline and other descriptors, materials are only atlased with others with the same key
+        };
+
+        // fill in the material bound by a BindDescriptorSet, returns false if it can't be atlased
+        using GetMaterial = std::function<bool(const vsg::BindDescriptorSet* bind, Material& material)>;
+
+        // bind the same descriptors as original with its texture replaced by page sampled with sampler
+        using CreateDescriptorSet = std::function<vsg::ref_ptr<vsg::BindDescriptorSet>(const vsg::BindDescriptorSet* original, vsg::ref_ptr<vsg::Data> page, const ImageData& sampler)>;
+
+        TextureAtlasVisitor(const TextureAtlasOptions& options, const VertexArrayAttributes& attributes);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::StateGroup& stategroup) override;
+
+        void collect(vsg::Group& root, GetMaterial getMaterial);
+
+        // pack the collected textures and switch their draws over to the pages
+        void atlas(CreateDescriptorSet createDescriptorSet);
+
+        size_t atlasedCount() const { return _atlasedCount; }
+        size_t pageCount() const { return _pageCount; }
+        size_t textureBytes() const { return _textureBytes; } // first levels of the atlased textures
+        size_t pageBytes() const { return _pageBytes; } // first levels of the pages
+
+        // uv arrays created for the draws mapped to the arrays they were made from
+        const std::map<const vsg::Data*, const vsg::Data*>& atlasedArrays() const { return _atlasedArrays; }
+
+        static const uint32_t PADDING = 8;
+        static const uint32_t PADDING_LEVELS = 4; // levels keeping at least a texel of padding
+
+    protected:
+        struct Entry
+        {
+            Material material;
+            const vsg::BindDescriptorSet* bind = nullptr;
+            std::vector<vsg::StateGroup*> stategroups;
+        };
+
+        // a material that made it into a page
+        struct Placed
+        {
+            Entry* entry;
+            std::vector<uint8_t> rgba;
+            uint32_t width;
+            uint32_t height;
+            AtlasRect rect;
+        };
+
+        bool addStateGroup(vsg::StateGroup& stategroup);
+        void createPage(std::vector<Placed>& placed, bool srgb, const CreateDescriptorSet& createDescriptorSet);
+
+        TextureAtlasOptions _options;
+        const VertexArrayAttributes& _attributes;
+        GetMaterial _getMaterial;
+
+        std::map<const vsg::BindDescriptorSet*, Entry> _entries;
+        std::set<const vsg::BindDescriptorSet*> _rejected;
+        std::set<const vsg::StateGroup*> _visited;
+
+        std::map<const vsg::Data*, const vsg::Data*> _atlasedArrays;
+        size_t _atlasedCount;
+        size_t _pageCount;
+        size_t _textureBytes;
+        size_t _pageBytes;
+    };
+
+} // namespace unity2vsg
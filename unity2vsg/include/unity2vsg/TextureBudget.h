@@ -0,0 +1,72 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace unity2vsg
+{
+    // what a texture is sampled for, losing detail in color shows more than in normals and masks
+    enum TextureRole : int32_t
+    {
+        TEXTURE_ROLE_COLOR = 0,
+        TEXTURE_ROLE_NORMAL = 1,
+        TEXTURE_ROLE_MASK = 2 // single channel maps such as occlusion, metallic or smoothness
+    };
+
+    extern UNITY2VSG_EXPORT float textureRoleWeight(TextureRole role);
+
+    struct BudgetTexture
+    {
+        vsg::ref_ptr<vsg::Data> data;
+        TextureRole role = TEXTURE_ROLE_COLOR;
+        double area = 0.0; // world space area drawn with the texture
+        double draws = 0.0; // number of draws using the texture
+
+        // filled in by planTextureBudget
+        float importance = 0.0f;
+        uint32_t levels = 0; // levels to drop, each halves the width and height
+        size_t bytesBefore = 0;
+        size_t bytesAfter = 0;
+    };
+
+    struct TextureBudgetOptions
+    {
+        size_t budget = 0; // bytes
+        uint32_t minimumSize = 32; // textures aren't downsampled below this many texels on their shorter side
+    };
+
+    // Bytes of a texture once levels are dropped, or 0 if it can't be downsampled that far. Textures with a mip chain drop
+    // their first levels, uncompressed 8 bit textures without one can be resampled, texture arrays are left alone.
+    extern UNITY2VSG_EXPORT size_t downsampledBytes(const vsg::Data* data, uint32_t levels, uint32_t minimumSize);
+
+    //
+    // Decide how many levels to drop from each texture to fit them all in the budget. A texture's importance is the share
+    // of the total area and draws it's used for, weighted by its role. Levels are dropped one at a time from whichever
+    // texture loses the least importance per byte saved, the loss doubling with each level a texture has already lost,
+    // until the total is within the budget or nothing is left that can be downsampled. Returns the total bytes.
+    //
+
+    extern UNITY2VSG_EXPORT size_t planTextureBudget(std::vector<BudgetTexture>& textures, const TextureBudgetOptions& options);
+
+    // A copy of the texture with its first levels dropped, or resampled with the mipmap generator's filters if it has no
+    // chain to drop them from. Null if it can't be downsampled, see downsampledBytes.
+    extern UNITY2VSG_EXPORT vsg::ref_ptr<vsg::Data> downsampleTexture(const vsg::Data* data, uint32_t levels, TextureRole role);
+
+} // namespace unity2vsg
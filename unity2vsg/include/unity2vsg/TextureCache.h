@@ -0,0 +1,98 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/NativeUtils.h>
+
+#include <vsg/core/Data.h>
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace unity2vsg
+{
+    // hash of an images format, size, mipmap settings and pixels
+    extern UNITY2VSG_EXPORT uint64_t hashImage(const ImageData& image);
+
+    // rms and largest per tile rms difference per 8 bit component between the first levels of two images of the same
+    // size, returns false if either can't be read, see readImageRGBA8
+    extern UNITY2VSG_EXPORT bool measureImageDifference(const ImageData& lhs, const ImageData& rhs, float& rms, float& tileRms);
+
+    //
+    // TextureCache
+    //
+    // Shares the Data created for textures with the same contents, so a texture imported twice or converted to the same
+    // pixels as another is only mipmapped, compressed and written once. Images match exactly when their format, size,
+    // mipmap settings and pixels are identical. With a tolerance above 0 images that read as rgba are also matched to an
+    // earlier one of the same format, size and settings when their rms difference is within it, catching copies that
+    // were resaved or recompressed. Pixels of images that have been shared must stay valid until the cache is cleared.
+    //
+
+    class UNITY2VSG_EXPORT TextureCache
+    {
+    public:
+        using CreateData = std::function<vsg::ref_ptr<vsg::Data>(const ImageData&)>;
+
+        TextureCache();
+
+        // tolerance is the largest rms difference per 8 bit component, 0 for exact matches only
+        void setTolerance(float tolerance) { _tolerance = tolerance; }
+        float getTolerance() const { return _tolerance; }
+
+        // the Data of an earlier matching image, otherwise the Data returned by createData which later images can match.
+        // The optional salt keeps images that createData treats differently apart.
+        vsg::ref_ptr<vsg::Data> share(const ImageData& image, const CreateData& createData, uint64_t salt = 0);
+
+        void clear();
+
+        size_t uniqueCount() const { return _uniqueCount; }
+        size_t exactCount() const { return _exactCount; }
+        size_t nearCount() const { return _nearCount; }
+        size_t bytesSaved() const { return _bytesSaved; }
+
+        // an images first level reduced to FINGERPRINT_SIZE squared rgba texels
+        static const uint32_t FINGERPRINT_SIZE = 16;
+
+        // tiles the full resolution difference is also measured over, so a small changed region isn't averaged away
+        static const uint32_t TILE_SIZE = 16;
+
+        // how much the rms difference of any one tile may exceed the tolerance
+        static constexpr float TILE_TOLERANCE_SCALE = 4.0f;
+
+    protected:
+        struct Entry
+        {
+            uint64_t salt;
+            ImageData image;
+            vsg::ref_ptr<vsg::Data> data;
+            std::vector<uint8_t> fingerprint; // empty until needed, or if the image can't be read
+            bool fingerprinted = false;
+        };
+
+        const std::vector<uint8_t>& fingerprint(Entry& entry);
+
+        float _tolerance;
+
+        std::vector<Entry> _entries;
+        std::unordered_multimap<uint64_t, size_t> _exactEntries; // hashImage to entry
+        std::unordered_multimap<uint64_t, size_t> _similarEntries; // hash of the format, size and settings to entry
+
+        size_t _uniqueCount;
+        size_t _exactCount;
+        size_t _nearCount;
+        size_t _bytesSaved;
+    };
+
+} // namespace unity2vsg
@@ -0,0 +1,71 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace unity2vsg
+{
+    // speed against quality of the block encoder, passed in ExportSettingsData::textureCompression
+    enum CompressionQuality : int32_t
+    {
+        COMPRESSION_NONE = 0,
+        COMPRESSION_FAST = 1, // endpoints from the box of the block's colors
+        COMPRESSION_NORMAL = 2, // endpoints along the principal axis, refit once by least squares
+        COMPRESSION_HIGH = 3 // several refits, color textures use BC7
+    };
+
+    enum BlockCompression : int32_t
+    {
+        BLOCK_BC1 = 0, // opaque rgb, 8 bytes per block
+        BLOCK_BC3 = 1, // rgb with interpolated alpha, 16 bytes per block
+        BLOCK_BC4 = 2, // single channel, 8 bytes per block
+        BLOCK_BC5 = 3, // two channels, 16 bytes per block
+        BLOCK_BC7 = 4 // rgba using mode 6 only, 16 bytes per block
+    };
+
+    extern UNITY2VSG_EXPORT uint32_t blockBytes(BlockCompression compression);
+
+    // BC4 for one component, BC5 for two, BC7 at high quality otherwise BC1 unless the first level has any alpha below 255
+    extern UNITY2VSG_EXPORT BlockCompression chooseBlockCompression(const uint8_t* texels, size_t texelCount, uint32_t components, CompressionQuality quality);
+
+    // Levels of a mip chain that can be compressed, 0 if width or height aren't multiples of 4. vsg halves the size of
+    // each level in blocks so the chain stops where rounding the texel size up to whole blocks would disagree.
+    extern UNITY2VSG_EXPORT uint32_t compressibleMipmapCount(uint32_t width, uint32_t height, uint32_t mipmapCount);
+
+    // bytes of the first mipmapCount levels once compressed
+    extern UNITY2VSG_EXPORT size_t compressedChainSize(uint32_t width, uint32_t height, uint32_t mipmapCount, BlockCompression compression);
+
+    struct CompressOptions
+    {
+        uint32_t components = 4; // 8 bit components per texel, 1 to 4
+        bool swapRedBlue = false; // texels are bgr(a), blocks are always written as rgb(a)
+        CompressionQuality quality = COMPRESSION_NORMAL;
+    };
+
+    //
+    // Compress the first mipmapCount levels of an 8 bit per component mip chain laid out one level after the other.
+    // Levels smaller than a block repeat their last row and column. Block rows of every level are spread across
+    // threads together so the small levels don't wait on the large ones.
+    //
+
+    extern UNITY2VSG_EXPORT void compressTexture(const uint8_t* chain, uint32_t width, uint32_t height, uint32_t mipmapCount, BlockCompression compression, const CompressOptions& options, uint8_t* blocks);
+
+    // Decode the first level of a BC1, BC3, BC4 or BC5 texture to rgba, returns false for BC7. Missing components read as
+    // they would in a shader, 0 for green and blue and 255 for alpha. punchThroughAlpha decodes BC1 as its rgba variant.
+    extern UNITY2VSG_EXPORT bool decompressTexture(const uint8_t* blocks, uint32_t width, uint32_t height, BlockCompression compression, bool punchThroughAlpha, uint8_t* rgba);
+
+} // namespace unity2vsg
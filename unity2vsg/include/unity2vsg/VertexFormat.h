@@ -0,0 +1,113 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    // how a vertex attribute is stored, float32 leaves the array as exported from Unity
+    enum VertexEncoding : uint32_t
+    {
+        ENCODING_FLOAT32 = 0,
+        ENCODING_SNORM16 = 1, // normals and tangents, padded to 4 components
+        ENCODING_OCTAHEDRAL16 = 2, // normals and tangents, 2 snorm16 components, needs shader support
+        ENCODING_FLOAT16 = 3, // uvs
+        ENCODING_UNORM16 = 4, // uvs in the 0-1 range, values outside are clamped
+        ENCODING_UNORM8 = 5 // colors
+    };
+
+    // the encoding used for each attribute that can be compressed
+    struct VertexEncodings
+    {
+        uint32_t normal = ENCODING_FLOAT32;
+        uint32_t tangent = ENCODING_FLOAT32;
+        uint32_t uv = ENCODING_FLOAT32;
+        uint32_t color = ENCODING_FLOAT32;
+
+        uint32_t encodingFor(uint32_t attribute) const;
+        bool isFloat32() const { return normal == ENCODING_FLOAT32 && tangent == ENCODING_FLOAT32 && uv == ENCODING_FLOAT32 && color == ENCODING_FLOAT32; }
+        uint32_t key() const { return normal | (tangent << 8) | (uv << 16) | (color << 24); }
+    };
+
+    // the GeometryAttributes each vertex array represents, an array only ever has one role
+    using VertexArrayAttributes = std::map<const vsg::Data*, uint32_t>;
+
+    // the encodings each pipeline was built with, draws take the encodings of the pipeline bound above them
+    using PipelineVertexEncodings = std::map<const vsg::BindGraphicsPipeline*, VertexEncodings>;
+
+    // is the encoding usable for the GeometryAttributes bit
+    extern UNITY2VSG_EXPORT bool isEncodingSupported(uint32_t attribute, uint32_t encoding);
+
+    // vertex input format of an attribute stored with the encoding
+    extern UNITY2VSG_EXPORT VkFormat encodedFormat(uint32_t attribute, uint32_t encoding);
+
+    // convert a float32 attribute array to the encoding, returns the source array if there's nothing to do
+    extern UNITY2VSG_EXPORT vsg::ref_ptr<vsg::Data> encodeVertexArray(vsg::ref_ptr<vsg::Data> array, uint32_t attribute, uint32_t encoding);
+
+    // single value conversions used by encodeVertexArray
+    extern UNITY2VSG_EXPORT uint16_t floatToHalf(float value);
+    extern UNITY2VSG_EXPORT void octahedralEncode(const float* normal, float* result);
+
+    // interleave per attribute arrays of equal length into a single array, each vertex holds its attributes in list order
+    extern UNITY2VSG_EXPORT vsg::ref_ptr<vsg::Data> interleaveArrays(const vsg::DataList& arrays);
+
+    //
+    // VertexFormatVisitor
+    //
+    // Converts the vertex arrays of every VertexIndexDraw and BindVertexBuffers in a graph into the encodings and
+    // layout the pipelines were built with. Runs once the graph is complete, arrays shared between draws are only
+    // converted once.
+    //
+
+    class UNITY2VSG_EXPORT VertexFormatVisitor : public vsg::Visitor
+    {
+    public:
+        VertexFormatVisitor(bool interleave, const VertexArrayAttributes& attributes, const PipelineVertexEncodings& pipelineEncodings);
+
+        void apply(vsg::Object& object) override;
+        void apply(vsg::StateGroup& stategroup) override;
+        void apply(vsg::VertexIndexDraw& vid) override;
+        void apply(vsg::BindVertexBuffers& bvb) override;
+
+        vsg::DataList convert(const vsg::DataList& arrays);
+
+        size_t convertedCount() const { return _converted.size(); }
+        size_t encodedCount() const { return _encoded.size(); }
+        size_t sourceBytes() const { return _sourceBytes; }
+        size_t encodedBytes() const { return _encodedBytes; }
+
+    protected:
+        vsg::ref_ptr<vsg::Data> encode(vsg::ref_ptr<vsg::Data> array, uint32_t attribute);
+
+        bool _interleave;
+        const VertexArrayAttributes& _attributes;
+        const PipelineVertexEncodings& _pipelineEncodings;
+        VertexEncodings _encodings;
+
+        using ConvertKey = std::pair<std::vector<const vsg::Data*>, uint32_t>;
+        std::map<ConvertKey, vsg::DataList> _converted;
+        std::map<std::pair<const vsg::Data*, uint32_t>, vsg::ref_ptr<vsg::Data>> _encoded;
+        std::set<std::vector<const vsg::Data*>> _outputs;
+
+        size_t _sourceBytes;
+        size_t _encodedBytes;
+    };
+
+} // namespace unity2vsg
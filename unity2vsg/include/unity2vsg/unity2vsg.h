@@ -15,11 +15,21 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <unity2vsg/Export.h>
 #include <unity2vsg/NativeUtils.h>
 
+namespace unity2vsg
+{
+    // opaque handle to an independent export, each context owns its own graph and caches so
+    // separate contexts can be driven from separate threads
+    struct ExportContext;
+} // namespace unity2vsg
+
 extern "C"
 {
     UNITY2VSG_EXPORT void unity2vsg_BeginExport();
     UNITY2VSG_EXPORT void unity2vsg_EndExport(const char* saveFileName);
 
+    // must be called straight after BeginExport, before any nodes are added
+    UNITY2VSG_EXPORT void unity2vsg_SetExportSettings(unity2vsg::ExportSettingsData settings);
+
     // add nodes
     UNITY2VSG_EXPORT void unity2vsg_AddGroupNode();
     UNITY2VSG_EXPORT void unity2vsg_AddTransformNode(unity2vsg::TransformData transform);
@@ -34,6 +44,19 @@ extern "C"
     // add meta data to nodes
     UNITY2VSG_EXPORT void unity2vsg_AddStringValue(const char* name, const char* value);
 
+    //
+    // Native mesh arrays, allocated and owned by the native side and filled in place by the caller. Once committed any
+    // Add call for the same mesh id uses them instead of the arrays in its data struct, which can then be left empty
+    //
+
+    // attribute is one of the GeometryAttributes VERTEX, NORMAL, TANGENT, COLOR, TEXCOORD0 or TEXCOORD1, returns a pointer to count vec2/3/4 floats
+    UNITY2VSG_EXPORT void* unity2vsg_AllocateVertexArray(int meshId, uint32_t attribute, uint32_t count);
+    // returns a pointer to count uint16 or uint32 indices
+    UNITY2VSG_EXPORT void* unity2vsg_AllocateIndexArray(int meshId, uint32_t count, uint32_t use32BitIndicies);
+    UNITY2VSG_EXPORT int unity2vsg_CommitMeshArrays(int meshId);
+    // copies bytes from src into an allocated array, for callers that can't write through a pointer themselves
+    UNITY2VSG_EXPORT void unity2vsg_CopyToNativeArray(void* dst, const void* src, uint32_t bytes);
+
     // add command to commands node if one is current head or last stategroup node
     UNITY2VSG_EXPORT int unity2vsg_AddBindGraphicsPipelineCommand(unity2vsg::PipelineData pipeline, uint32_t addToStateGroup);
     UNITY2VSG_EXPORT void unity2vsg_AddBindIndexBufferCommand(unity2vsg::IndexBufferData data);
@@ -52,5 +75,51 @@ extern "C"
 
     UNITY2VSG_EXPORT void unity2vsg_EndNode();
 
+    // replay a command stream built with CommandStreamEncoder into the current export, returns 1 on success.
+    // array data in the stream is not copied so the buffer must stay valid until unity2vsg_EndExport
+    UNITY2VSG_EXPORT int unity2vsg_SubmitCommandBuffer(const void* ops, size_t bytes);
+
+    //
+    // Export contexts, same as the calls above but acting on the passed context rather than the single global export
+    //
+
+    UNITY2VSG_EXPORT unity2vsg::ExportContext* unity2vsg_CreateExportContext();
+    UNITY2VSG_EXPORT void unity2vsg_DestroyExportContext(unity2vsg::ExportContext* context);
+    // write the contexts graph to file, the context can't be added to afterwards but must still be destroyed
+    UNITY2VSG_EXPORT int unity2vsg_Context_EndExport(unity2vsg::ExportContext* context, const char* saveFileName);
+    UNITY2VSG_EXPORT void unity2vsg_Context_SetExportSettings(unity2vsg::ExportContext* context, unity2vsg::ExportSettingsData settings);
+
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddGroupNode(unity2vsg::ExportContext* context);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddTransformNode(unity2vsg::ExportContext* context, unity2vsg::TransformData transform);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddCullNode(unity2vsg::ExportContext* context, unity2vsg::CullData cull);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddCullGroupNode(unity2vsg::ExportContext* context, unity2vsg::CullData cull);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddLODNode(unity2vsg::ExportContext* context, unity2vsg::CullData cull);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddLODChild(unity2vsg::ExportContext* context, unity2vsg::LODChildData lodChildData);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddStateGroupNode(unity2vsg::ExportContext* context);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddCommandsNode(unity2vsg::ExportContext* context);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddVertexIndexDrawNode(unity2vsg::ExportContext* context, unity2vsg::VertexIndexDrawData mesh);
+
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddStringValue(unity2vsg::ExportContext* context, const char* name, const char* value);
+
+    UNITY2VSG_EXPORT void* unity2vsg_Context_AllocateVertexArray(unity2vsg::ExportContext* context, int meshId, uint32_t attribute, uint32_t count);
+    UNITY2VSG_EXPORT void* unity2vsg_Context_AllocateIndexArray(unity2vsg::ExportContext* context, int meshId, uint32_t count, uint32_t use32BitIndicies);
+    UNITY2VSG_EXPORT int unity2vsg_Context_CommitMeshArrays(unity2vsg::ExportContext* context, int meshId);
+
+    UNITY2VSG_EXPORT int unity2vsg_Context_AddBindGraphicsPipelineCommand(unity2vsg::ExportContext* context, unity2vsg::PipelineData pipeline, uint32_t addToStateGroup);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddBindIndexBufferCommand(unity2vsg::ExportContext* context, unity2vsg::IndexBufferData data);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddBindVertexBuffersCommand(unity2vsg::ExportContext* context, unity2vsg::VertexBuffersData data);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddDrawIndexedCommand(unity2vsg::ExportContext* context, unity2vsg::DrawIndexedData data);
+    UNITY2VSG_EXPORT void unity2vsg_Context_CreateBindDescriptorSetCommand(unity2vsg::ExportContext* context, uint32_t addToStateGroup);
+
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddDescriptorImage(unity2vsg::ExportContext* context, unity2vsg::DescriptorImageData texture);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddDescriptorBufferFloat(unity2vsg::ExportContext* context, unity2vsg::DescriptorFloatUniformData data);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddDescriptorBufferFloatArray(unity2vsg::ExportContext* context, unity2vsg::DescriptorFloatArrayUniformData data);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddDescriptorBufferVector(unity2vsg::ExportContext* context, unity2vsg::DescriptorVectorUniformData data);
+    UNITY2VSG_EXPORT void unity2vsg_Context_AddDescriptorBufferVectorArray(unity2vsg::ExportContext* context, unity2vsg::DescriptorVectorArrayUniformData data);
+
+    UNITY2VSG_EXPORT void unity2vsg_Context_EndNode(unity2vsg::ExportContext* context);
+
+    UNITY2VSG_EXPORT int unity2vsg_Context_SubmitCommandBuffer(unity2vsg::ExportContext* context, const void* ops, size_t bytes);
+
     UNITY2VSG_EXPORT void unity2vsg_LaunchViewer(const char* filename, uint32_t useCamData, unity2vsg::CameraData camdata);
 }
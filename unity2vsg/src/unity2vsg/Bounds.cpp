@@ -0,0 +1,312 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Bounds.h>
+
+#include <unity2vsg/MatrixUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define UNITY2VSG_BOUNDS_SSE2
+#    include <emmintrin.h>
+#endif
+
+using namespace unity2vsg;
+
+namespace
+{
+    inline float distance2(const vsg::vec3& a, const vsg::vec3& b)
+    {
+        float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // grow the sphere just enough to reach p, keeping the far side where it is
+    inline void grow(vsg::sphere& bound, const vsg::vec3& p)
+    {
+        float d2 = distance2(p, bound.center);
+        if (d2 <= bound.radius * bound.radius) return;
+
+        float d = std::sqrt(d2);
+        float radius = (bound.radius + d) * 0.5f;
+        float t = (radius - bound.radius) / d;
+        bound.center = vsg::vec3(bound.center.x + (p.x - bound.center.x) * t, bound.center.y + (p.y - bound.center.y) * t, bound.center.z + (p.z - bound.center.z) * t);
+        bound.radius = radius;
+    }
+
+    // smallest radius about center that reaches every position
+    float enclosingRadius(const vsg::vec3* positions, size_t count, const vsg::vec3& center)
+    {
+        float maxDistance2 = 0.0f;
+        for (size_t i = 0; i < count; ++i) maxDistance2 = std::max(maxDistance2, distance2(positions[i], center));
+        return std::sqrt(maxDistance2);
+    }
+
+    // Ritter, An Efficient Bounding Sphere, 1990. Starts from the most separated pair of axis extremes then grows over the points
+    vsg::sphere ritterSphere(const vsg::vec3* positions, size_t count)
+    {
+        size_t minimum[3] = {0, 0, 0};
+        size_t maximum[3] = {0, 0, 0};
+        for (size_t i = 1; i < count; ++i)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                if (positions[i][k] < positions[minimum[k]][k]) minimum[k] = i;
+                if (positions[i][k] > positions[maximum[k]][k]) maximum[k] = i;
+            }
+        }
+
+        int axis = 0;
+        for (int k = 1; k < 3; ++k)
+        {
+            if (distance2(positions[minimum[k]], positions[maximum[k]]) > distance2(positions[minimum[axis]], positions[maximum[axis]])) axis = k;
+        }
+
+        const vsg::vec3& a = positions[minimum[axis]];
+        const vsg::vec3& b = positions[maximum[axis]];
+        vsg::sphere bound(vsg::vec3((a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f), std::sqrt(distance2(a, b)) * 0.5f);
+        for (size_t i = 0; i < count; ++i) grow(bound, positions[i]);
+        return bound;
+    }
+
+    // eigenvectors of a symmetric 3x3 matrix by cyclic Jacobi rotations, returned as the columns of vectors
+    void symmetricEigenvectors(double a[3][3], double vectors[3][3])
+    {
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c) vectors[r][c] = r == c ? 1.0 : 0.0;
+        }
+
+        for (int sweep = 0; sweep < 16; ++sweep)
+        {
+            double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+            if (offDiagonal < 1e-20) break;
+
+            for (int p = 0; p < 2; ++p)
+            {
+                for (int q = p + 1; q < 3; ++q)
+                {
+                    if (std::abs(a[p][q]) < 1e-20) continue;
+
+                    double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                    double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                    double c = 1.0 / std::sqrt(t * t + 1.0);
+                    double s = t * c;
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double akp = a[k][p], akq = a[k][q];
+                        a[k][p] = c * akp - s * akq;
+                        a[k][q] = s * akp + c * akq;
+                    }
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double apk = a[p][k], aqk = a[q][k];
+                        a[p][k] = c * apk - s * aqk;
+                        a[q][k] = s * apk + c * aqk;
+                    }
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double vkp = vectors[k][p], vkq = vectors[k][q];
+                        vectors[k][p] = c * vkp - s * vkq;
+                        vectors[k][q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+    }
+} // namespace
+
+void unity2vsg::vertexBounds(const vsg::vec3* positions, size_t count, vsg::vec3& minimum, vsg::vec3& maximum)
+{
+    float lo[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float hi[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    size_t i = 0;
+
+#if defined(UNITY2VSG_BOUNDS_SSE2)
+    // four packed vec3 fill three registers, float n of the twelve always holds component n % 3
+    if (count >= 4)
+    {
+        const float* src = &positions[0].x;
+        __m128 minA = _mm_loadu_ps(src), minB = _mm_loadu_ps(src + 4), minC = _mm_loadu_ps(src + 8);
+        __m128 maxA = minA, maxB = minB, maxC = minC;
+        for (i = 4; i + 4 <= count; i += 4)
+        {
+            const float* values = src + i * 3;
+            __m128 a = _mm_loadu_ps(values);
+            __m128 b = _mm_loadu_ps(values + 4);
+            __m128 c = _mm_loadu_ps(values + 8);
+            minA = _mm_min_ps(minA, a);
+            minB = _mm_min_ps(minB, b);
+            minC = _mm_min_ps(minC, c);
+            maxA = _mm_max_ps(maxA, a);
+            maxB = _mm_max_ps(maxB, b);
+            maxC = _mm_max_ps(maxC, c);
+        }
+
+        float packedMin[12], packedMax[12];
+        _mm_storeu_ps(packedMin, minA);
+        _mm_storeu_ps(packedMin + 4, minB);
+        _mm_storeu_ps(packedMin + 8, minC);
+        _mm_storeu_ps(packedMax, maxA);
+        _mm_storeu_ps(packedMax + 4, maxB);
+        _mm_storeu_ps(packedMax + 8, maxC);
+        for (int n = 0; n < 12; ++n)
+        {
+            lo[n % 3] = std::min(lo[n % 3], packedMin[n]);
+            hi[n % 3] = std::max(hi[n % 3], packedMax[n]);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            lo[k] = std::min(lo[k], positions[i][k]);
+            hi[k] = std::max(hi[k], positions[i][k]);
+        }
+    }
+
+    minimum = vsg::vec3(lo[0], lo[1], lo[2]);
+    maximum = vsg::vec3(hi[0], hi[1], hi[2]);
+}
+
+OrientedBox unity2vsg::orientedBounds(const vsg::vec3* positions, size_t count)
+{
+    OrientedBox box;
+    box.center = vsg::vec3(0.0f, 0.0f, 0.0f);
+    box.axes[0] = vsg::vec3(1.0f, 0.0f, 0.0f);
+    box.axes[1] = vsg::vec3(0.0f, 1.0f, 0.0f);
+    box.axes[2] = vsg::vec3(0.0f, 0.0f, 1.0f);
+    box.halfExtents = vsg::vec3(0.0f, 0.0f, 0.0f);
+    if (count == 0) return box;
+
+    double mean[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int k = 0; k < 3; ++k) mean[k] += positions[i][k];
+    }
+    for (int k = 0; k < 3; ++k) mean[k] /= static_cast<double>(count);
+
+    double covariance[3][3] = {};
+    for (size_t i = 0; i < count; ++i)
+    {
+        double d[3] = {positions[i].x - mean[0], positions[i].y - mean[1], positions[i].z - mean[2]};
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = r; c < 3; ++c) covariance[r][c] += d[r] * d[c];
+        }
+    }
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < r; ++c) covariance[r][c] = covariance[c][r];
+    }
+
+    double vectors[3][3];
+    symmetricEigenvectors(covariance, vectors);
+    for (int a = 0; a < 3; ++a)
+    {
+        box.axes[a] = vsg::vec3(static_cast<float>(vectors[0][a]), static_cast<float>(vectors[1][a]), static_cast<float>(vectors[2][a]));
+    }
+
+    float lo[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float hi[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            float projected = positions[i].x * box.axes[a].x + positions[i].y * box.axes[a].y + positions[i].z * box.axes[a].z;
+            lo[a] = std::min(lo[a], projected);
+            hi[a] = std::max(hi[a], projected);
+        }
+    }
+
+    for (int a = 0; a < 3; ++a)
+    {
+        float middle = (lo[a] + hi[a]) * 0.5f;
+        box.center = vsg::vec3(box.center.x + box.axes[a].x * middle, box.center.y + box.axes[a].y * middle, box.center.z + box.axes[a].z * middle);
+        box.halfExtents[a] = (hi[a] - lo[a]) * 0.5f;
+    }
+    return box;
+}
+
+vsg::sphere unity2vsg::boundingSphere(const vsg::vec3* positions, size_t count, float* boxRadius)
+{
+    if (count == 0)
+    {
+        if (boxRadius) *boxRadius = -1.0f;
+        return vsg::sphere(vsg::vec3(0.0f, 0.0f, 0.0f), -1.0f);
+    }
+
+    vsg::vec3 minimum, maximum;
+    vertexBounds(positions, count, minimum, maximum);
+    if (boxRadius) *boxRadius = std::sqrt(distance2(minimum, maximum)) * 0.5f;
+
+    // Ericson, Real-Time Collision Detection 4.3.4, shrink the best sphere a little and regrow it over the points
+    // starting somewhere else each time, keeping it if it came out smaller
+    const int refinements = 4;
+    vsg::sphere best = ritterSphere(positions, count);
+    for (int pass = 1; pass <= refinements; ++pass)
+    {
+        vsg::sphere bound(best.center, best.radius * 0.95f);
+        size_t start = count * pass / (refinements + 1);
+        for (size_t i = start; i < count; ++i) grow(bound, positions[i]);
+        for (size_t i = 0; i < start; ++i) grow(bound, positions[i]);
+        if (bound.radius < best.radius) best = bound;
+    }
+
+    // growing in float can leave points a hair outside so every candidate gets its exact radius
+    OrientedBox orientedBox = orientedBounds(positions, count);
+    vsg::vec3 centers[3] = {best.center, vsg::vec3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f), orientedBox.center};
+
+    vsg::sphere result(centers[0], enclosingRadius(positions, count, centers[0]));
+    for (int c = 1; c < 3; ++c)
+    {
+        float radius = enclosingRadius(positions, count, centers[c]);
+        if (radius < result.radius) result = vsg::sphere(centers[c], radius);
+    }
+    return result;
+}
+
+void unity2vsg::expandBy(vsg::sphere& bound, const vsg::sphere& other)
+{
+    if (other.radius < 0.0f) return;
+    if (bound.radius < 0.0f)
+    {
+        bound = other;
+        return;
+    }
+
+    float d = std::sqrt(distance2(bound.center, other.center));
+    if (d + other.radius <= bound.radius) return;
+    if (d + bound.radius <= other.radius)
+    {
+        bound = other;
+        return;
+    }
+
+    float radius = (d + bound.radius + other.radius) * 0.5f;
+    float t = (radius - bound.radius) / d;
+    bound.center = vsg::vec3(bound.center.x + (other.center.x - bound.center.x) * t, bound.center.y + (other.center.y - bound.center.y) * t,
+                             bound.center.z + (other.center.z - bound.center.z) * t);
+    bound.radius = radius;
+}
+
+vsg::sphere unity2vsg::transformSphere(const vsg::mat4& matrix, const vsg::sphere& bound)
+{
+    if (bound.radius < 0.0f) return bound;
+    return vsg::sphere(transformPoint(matrix, bound.center), bound.radius * maxScale(matrix));
+}
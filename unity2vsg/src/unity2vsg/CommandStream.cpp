@@ -0,0 +1,808 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/CommandStream.h>
+
+#include <cstring>
+
+using namespace unity2vsg;
+
+//
+// CommandStreamEncoder
+//
+
+CommandStreamEncoder::CommandStreamEncoder() :
+    _opStart(0),
+    _opCount(0)
+{
+    clear();
+}
+
+void CommandStreamEncoder::clear()
+{
+    CommandStreamHeader header = {};
+    header.magic = COMMAND_STREAM_MAGIC;
+    header.version = COMMAND_STREAM_VERSION;
+    header.headerSize = static_cast<uint16_t>(sizeof(CommandStreamHeader));
+
+    _buffer.clear();
+    write(&header, sizeof(CommandStreamHeader));
+    _opStart = 0;
+    _opCount = 0;
+}
+
+void CommandStreamEncoder::beginOp(CommandStreamOpCode code)
+{
+    CommandStreamOp op = {};
+    op.code = code;
+    _opStart = _buffer.size();
+    write(&op, sizeof(CommandStreamOp));
+}
+
+void CommandStreamEncoder::endOp()
+{
+    pad();
+
+    uint32_t payloadSize = static_cast<uint32_t>(_buffer.size() - _opStart - sizeof(CommandStreamOp));
+    std::memcpy(_buffer.data() + _opStart + offsetof(CommandStreamOp, size), &payloadSize, sizeof(uint32_t));
+
+    _opCount++;
+    std::memcpy(_buffer.data() + offsetof(CommandStreamHeader, opCount), &_opCount, sizeof(uint32_t));
+}
+
+void CommandStreamEncoder::write(const void* ptr, size_t size)
+{
+    if (size == 0) return;
+    const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+    _buffer.insert(_buffer.end(), bytes, bytes + size);
+}
+
+void CommandStreamEncoder::writeUInt(uint32_t value)
+{
+    write(&value, sizeof(uint32_t));
+}
+
+void CommandStreamEncoder::writeInt(int32_t value)
+{
+    write(&value, sizeof(int32_t));
+}
+
+void CommandStreamEncoder::writeFloat(float value)
+{
+    write(&value, sizeof(float));
+}
+
+void CommandStreamEncoder::writeString(const char* str)
+{
+    uint32_t length = str != nullptr ? static_cast<uint32_t>(std::strlen(str)) : 0;
+    writeUInt(length);
+    write(str, length);
+    _buffer.push_back(0);
+    pad();
+}
+
+void CommandStreamEncoder::writeArray(const void* ptr, int length, size_t elementSize)
+{
+    uint32_t count = (ptr != nullptr && length > 0) ? static_cast<uint32_t>(length) : 0;
+    writeUInt(count);
+    write(ptr, count * elementSize);
+    pad();
+}
+
+void CommandStreamEncoder::pad()
+{
+    while (_buffer.size() % 4 != 0) _buffer.push_back(0);
+}
+
+// nodes
+
+void CommandStreamEncoder::addGroupNode()
+{
+    beginOp(OP_ADD_GROUP_NODE);
+    endOp();
+}
+
+void CommandStreamEncoder::addTransformNode(const TransformData& transform)
+{
+    beginOp(OP_ADD_TRANSFORM_NODE);
+    writeArray(transform.matrix.data, transform.matrix.length, sizeof(float));
+    endOp();
+}
+
+void CommandStreamEncoder::addCullNode(const CullData& cull)
+{
+    beginOp(OP_ADD_CULL_NODE);
+    write(&cull, sizeof(CullData));
+    endOp();
+}
+
+void CommandStreamEncoder::addCullGroupNode(const CullData& cull)
+{
+    beginOp(OP_ADD_CULL_GROUP_NODE);
+    write(&cull, sizeof(CullData));
+    endOp();
+}
+
+void CommandStreamEncoder::addLODNode(const CullData& cull)
+{
+    beginOp(OP_ADD_LOD_NODE);
+    write(&cull, sizeof(CullData));
+    endOp();
+}
+
+void CommandStreamEncoder::addLODChild(const LODChildData& lodChildData)
+{
+    beginOp(OP_ADD_LOD_CHILD);
+    writeFloat(lodChildData.minimumScreenHeightRatio);
+    endOp();
+}
+
+void CommandStreamEncoder::addStateGroupNode()
+{
+    beginOp(OP_ADD_STATE_GROUP_NODE);
+    endOp();
+}
+
+void CommandStreamEncoder::addCommandsNode()
+{
+    beginOp(OP_ADD_COMMANDS_NODE);
+    endOp();
+}
+
+void CommandStreamEncoder::addVertexIndexDrawNode(const VertexIndexDrawData& mesh)
+{
+    beginOp(OP_ADD_VERTEX_INDEX_DRAW_NODE);
+    writeInt(mesh.id);
+    writeArray(mesh.verticies.data, mesh.verticies.length, sizeof(vsg::vec3));
+    writeArray(mesh.triangles.data, mesh.triangles.length, sizeof(uint32_t));
+    writeArray(mesh.normals.data, mesh.normals.length, sizeof(vsg::vec3));
+    writeArray(mesh.tangents.data, mesh.tangents.length, sizeof(vsg::vec4));
+    writeArray(mesh.colors.data, mesh.colors.length, sizeof(vsg::vec4));
+    writeArray(mesh.uv0.data, mesh.uv0.length, sizeof(vsg::vec2));
+    writeArray(mesh.uv1.data, mesh.uv1.length, sizeof(vsg::vec2));
+    writeInt(mesh.use32BitIndicies);
+    endOp();
+}
+
+// meta data
+
+void CommandStreamEncoder::addStringValue(const char* name, const char* value)
+{
+    beginOp(OP_ADD_STRING_VALUE);
+    writeString(name);
+    writeString(value);
+    endOp();
+}
+
+// commands
+
+void CommandStreamEncoder::addBindGraphicsPipelineCommand(const PipelineData& pipeline, uint32_t addToStateGroup)
+{
+    beginOp(OP_ADD_BIND_GRAPHICS_PIPELINE_COMMAND);
+    writeString(pipeline.id);
+    writeInt(pipeline.hasNormals);
+    writeInt(pipeline.hasTangents);
+    writeInt(pipeline.hasColors);
+    writeInt(pipeline.uvChannelCount);
+    writeInt(pipeline.useAlpha);
+
+    // write the bindings field by field, pImmutableSamplers can't be passed through the stream
+    uint32_t bindingCount = pipeline.descriptorBindings.data != nullptr && pipeline.descriptorBindings.length > 0 ? static_cast<uint32_t>(pipeline.descriptorBindings.length) : 0;
+    writeUInt(bindingCount);
+    for (uint32_t i = 0; i < bindingCount; i++)
+    {
+        const VkDescriptorSetLayoutBinding& binding = pipeline.descriptorBindings.data[i];
+        writeUInt(binding.binding);
+        writeUInt(static_cast<uint32_t>(binding.descriptorType));
+        writeUInt(binding.descriptorCount);
+        writeUInt(binding.stageFlags);
+    }
+
+    writeInt(pipeline.shaderStages.id);
+    uint32_t stageCount = pipeline.shaderStages.stages != nullptr && pipeline.shaderStages.stagesCount > 0 ? static_cast<uint32_t>(pipeline.shaderStages.stagesCount) : 0;
+    writeUInt(stageCount);
+    for (uint32_t i = 0; i < stageCount; i++)
+    {
+        const ShaderStageData& stage = pipeline.shaderStages.stages[i];
+        writeInt(stage.id);
+        writeUInt(static_cast<uint32_t>(stage.stages));
+        writeArray(stage.specializationData.data, stage.specializationData.length, sizeof(uint32_t));
+        writeString(stage.customDefines);
+        writeString(stage.source);
+    }
+
+    writeUInt(addToStateGroup);
+    endOp();
+}
+
+void CommandStreamEncoder::addBindIndexBufferCommand(const IndexBufferData& data)
+{
+    beginOp(OP_ADD_BIND_INDEX_BUFFER_COMMAND);
+    writeInt(data.id);
+    writeArray(data.triangles.data, data.triangles.length, sizeof(uint32_t));
+    writeInt(data.use32BitIndicies);
+    endOp();
+}
+
+void CommandStreamEncoder::addBindVertexBuffersCommand(const VertexBuffersData& data)
+{
+    beginOp(OP_ADD_BIND_VERTEX_BUFFERS_COMMAND);
+    writeInt(data.id);
+    writeArray(data.verticies.data, data.verticies.length, sizeof(vsg::vec3));
+    writeArray(data.normals.data, data.normals.length, sizeof(vsg::vec3));
+    writeArray(data.tangents.data, data.tangents.length, sizeof(vsg::vec4));
+    writeArray(data.colors.data, data.colors.length, sizeof(vsg::vec4));
+    writeArray(data.uv0.data, data.uv0.length, sizeof(vsg::vec2));
+    writeArray(data.uv1.data, data.uv1.length, sizeof(vsg::vec2));
+    endOp();
+}
+
+void CommandStreamEncoder::addDrawIndexedCommand(const DrawIndexedData& data)
+{
+    beginOp(OP_ADD_DRAW_INDEXED_COMMAND);
+    writeInt(data.id);
+    writeUInt(data.indexCount);
+    writeUInt(data.firstIndex);
+    writeUInt(data.vertexOffset);
+    writeUInt(data.instanceCount);
+    writeUInt(data.firstInstance);
+    endOp();
+}
+
+void CommandStreamEncoder::createBindDescriptorSetCommand(uint32_t addToStateGroup)
+{
+    beginOp(OP_CREATE_BIND_DESCRIPTOR_SET_COMMAND);
+    writeUInt(addToStateGroup);
+    endOp();
+}
+
+// descriptors
+
+void CommandStreamEncoder::addDescriptorImage(const DescriptorImageData& texture)
+{
+    beginOp(OP_ADD_DESCRIPTOR_IMAGE);
+    writeInt(texture.id);
+    writeInt(texture.binding);
+    writeInt(texture.packLayers);
+    writeInt(texture.packChannels);
+    writeInt(texture.firstComponentOnly);
+    writeInt(texture.sampledAtFirstUvs);
+
+    uint32_t imageCount = texture.images != nullptr && texture.descriptorCount > 0 ? static_cast<uint32_t>(texture.descriptorCount) : 0;
+    writeUInt(imageCount);
+    for (uint32_t i = 0; i < imageCount; i++)
+    {
+        const ImageData& image = texture.images[i];
+        writeInt(image.id);
+        writeArray(image.pixels.data, image.pixels.length, sizeof(uint8_t));
+        writeUInt(static_cast<uint32_t>(image.format));
+        writeInt(image.width);
+        writeInt(image.height);
+        writeInt(image.depth);
+        writeInt(image.anisoLevel);
+        writeUInt(static_cast<uint32_t>(image.wrapMode));
+        writeUInt(static_cast<uint32_t>(image.filterMode));
+        writeUInt(static_cast<uint32_t>(image.mipmapMode));
+        writeInt(image.mipmapCount);
+        writeFloat(image.mipmapBias);
+        writeInt(image.mipmapFilter);
+        writeFloat(image.alphaCutoff);
+    }
+    endOp();
+}
+
+void CommandStreamEncoder::addDescriptorBufferFloat(const DescriptorFloatUniformData& data)
+{
+    beginOp(OP_ADD_DESCRIPTOR_BUFFER_FLOAT);
+    writeInt(data.id);
+    writeInt(data.binding);
+    writeFloat(data.value);
+    endOp();
+}
+
+void CommandStreamEncoder::addDescriptorBufferFloatArray(const DescriptorFloatArrayUniformData& data)
+{
+    beginOp(OP_ADD_DESCRIPTOR_BUFFER_FLOAT_ARRAY);
+    writeInt(data.id);
+    writeInt(data.binding);
+    writeArray(data.value.data, data.value.length, sizeof(float));
+    endOp();
+}
+
+void CommandStreamEncoder::addDescriptorBufferVector(const DescriptorVectorUniformData& data)
+{
+    beginOp(OP_ADD_DESCRIPTOR_BUFFER_VECTOR);
+    writeInt(data.id);
+    writeInt(data.binding);
+    write(&data.value, sizeof(vsg::vec4));
+    endOp();
+}
+
+void CommandStreamEncoder::addDescriptorBufferVectorArray(const DescriptorVectorArrayUniformData& data)
+{
+    beginOp(OP_ADD_DESCRIPTOR_BUFFER_VECTOR_ARRAY);
+    writeInt(data.id);
+    writeInt(data.binding);
+    writeArray(data.value.data, data.value.length, sizeof(vsg::vec4));
+    endOp();
+}
+
+void CommandStreamEncoder::endNode()
+{
+    beginOp(OP_END_NODE);
+    endOp();
+}
+
+//
+// Decoding
+//
+
+namespace
+{
+    // reads values from a single op payload, any read past the end of the payload marks the reader as failed
+    class PayloadReader
+    {
+    public:
+        PayloadReader(const uint8_t* ptr, uint32_t size) :
+            _ptr(ptr),
+            _end(ptr + size),
+            _failed(false)
+        {
+        }
+
+        bool failed() const { return _failed; }
+
+        const uint8_t* read(size_t size)
+        {
+            if (_failed || size > static_cast<size_t>(_end - _ptr))
+            {
+                _failed = true;
+                return nullptr;
+            }
+            const uint8_t* result = _ptr;
+            _ptr += size;
+            return result;
+        }
+
+        template<typename T>
+        T readValue()
+        {
+            T value = {};
+            const uint8_t* ptr = read(sizeof(T));
+            if (ptr != nullptr) std::memcpy(&value, ptr, sizeof(T));
+            return value;
+        }
+
+        uint32_t readUInt() { return readValue<uint32_t>(); }
+        int32_t readInt() { return readValue<int32_t>(); }
+        float readFloat() { return readValue<float>(); }
+
+        const char* readString()
+        {
+            // checked against what's left before adding the terminator, so a length of 0xffffffff can't wrap around
+            uint32_t length = readUInt();
+            if (_failed || length >= static_cast<size_t>(_end - _ptr))
+            {
+                _failed = true;
+                return nullptr;
+            }
+            const uint8_t* chars = read(static_cast<size_t>(length) + 1);
+            skipPadding();
+            if (chars == nullptr || chars[length] != 0)
+            {
+                _failed = true;
+                return nullptr;
+            }
+            return reinterpret_cast<const char*>(chars);
+        }
+
+        template<typename A, typename T>
+        A readArray()
+        {
+            A result = {};
+            uint32_t count = readUInt();
+            if (count > static_cast<size_t>(_end - _ptr) / sizeof(T))
+            {
+                _failed = true;
+                return result;
+            }
+            const uint8_t* ptr = read(count * sizeof(T));
+            skipPadding();
+            result.data = count > 0 ? reinterpret_cast<T*>(const_cast<uint8_t*>(ptr)) : nullptr;
+            result.length = static_cast<int>(count);
+            return result;
+        }
+
+        void skipPadding()
+        {
+            size_t offset = reinterpret_cast<uintptr_t>(_ptr) % 4;
+            if (offset != 0) read(4 - offset);
+        }
+
+    protected:
+        const uint8_t* _ptr;
+        const uint8_t* _end;
+        bool _failed;
+    };
+
+    bool isNodeOp(uint16_t code)
+    {
+        switch (code)
+        {
+        case OP_ADD_GROUP_NODE:
+        case OP_ADD_TRANSFORM_NODE:
+        case OP_ADD_CULL_NODE:
+        case OP_ADD_CULL_GROUP_NODE:
+        case OP_ADD_LOD_NODE:
+        case OP_ADD_LOD_CHILD:
+        case OP_ADD_STATE_GROUP_NODE:
+        case OP_ADD_COMMANDS_NODE:
+        case OP_ADD_VERTEX_INDEX_DRAW_NODE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // accepts every op, used to decode a whole stream before any of it reaches the real handler
+    class ValidatingHandler : public CommandStreamHandler
+    {
+    public:
+        void addGroupNode() override {}
+        void addTransformNode(const TransformData&) override {}
+        void addCullNode(const CullData&) override {}
+        void addCullGroupNode(const CullData&) override {}
+        void addLODNode(const CullData&) override {}
+        void addLODChild(const LODChildData&) override {}
+        void addStateGroupNode() override {}
+        void addCommandsNode() override {}
+        void addVertexIndexDrawNode(const VertexIndexDrawData&) override {}
+
+        void addStringValue(const char*, const char*) override {}
+
+        bool addBindGraphicsPipelineCommand(const PipelineData&, uint32_t) override { return true; }
+        void addBindIndexBufferCommand(const IndexBufferData&) override {}
+        void addBindVertexBuffersCommand(const VertexBuffersData&) override {}
+        void addDrawIndexedCommand(const DrawIndexedData&) override {}
+        void createBindDescriptorSetCommand(uint32_t) override {}
+
+        void addDescriptorImage(const DescriptorImageData&) override {}
+        void addDescriptorBufferFloat(const DescriptorFloatUniformData&) override {}
+        void addDescriptorBufferFloatArray(const DescriptorFloatArrayUniformData&) override {}
+        void addDescriptorBufferVector(const DescriptorVectorUniformData&) override {}
+        void addDescriptorBufferVectorArray(const DescriptorVectorArrayUniformData&) override {}
+
+        void endNode() override {}
+    };
+
+    bool decodeCommandStream(const void* ops, size_t bytes, CommandStreamHandler& handler)
+    {
+        if (ops == nullptr || bytes < sizeof(CommandStreamHeader)) return false;
+
+        // arrays are handed to the handler in place so the buffer has to be suitably aligned
+        if (reinterpret_cast<uintptr_t>(ops) % 4 != 0) return false;
+
+        const uint8_t* ptr = static_cast<const uint8_t*>(ops);
+        const uint8_t* end = ptr + bytes;
+
+        CommandStreamHeader header;
+        std::memcpy(&header, ptr, sizeof(CommandStreamHeader));
+        if (header.magic != COMMAND_STREAM_MAGIC || header.version != COMMAND_STREAM_VERSION) return false;
+        if (header.headerSize < sizeof(CommandStreamHeader) || header.headerSize > bytes || header.headerSize % 4 != 0) return false;
+
+        ptr += header.headerSize;
+
+        // storage for the nested arrays of the op currently being decoded
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        std::vector<ShaderStageData> stages;
+        std::vector<ImageData> images;
+
+        // when a pipeline fails to bind we skip ops until the node it was added to is closed
+        bool skipping = false;
+        uint32_t skipDepth = 0;
+
+        for (uint32_t opIndex = 0; opIndex < header.opCount; opIndex++)
+        {
+            if (static_cast<size_t>(end - ptr) < sizeof(CommandStreamOp)) return false;
+
+            CommandStreamOp op;
+            std::memcpy(&op, ptr, sizeof(CommandStreamOp));
+            ptr += sizeof(CommandStreamOp);
+
+            if (op.size > static_cast<size_t>(end - ptr) || op.size % 4 != 0) return false;
+
+            PayloadReader reader(ptr, op.size);
+            ptr += op.size;
+
+            if (skipping)
+            {
+                if (isNodeOp(op.code))
+                {
+                    skipDepth++;
+                    continue;
+                }
+                if (op.code != OP_END_NODE) continue;
+                if (skipDepth > 0)
+                {
+                    skipDepth--;
+                    continue;
+                }
+                skipping = false;
+            }
+
+            switch (op.code)
+            {
+            case OP_ADD_GROUP_NODE:
+            {
+                handler.addGroupNode();
+                break;
+            }
+            case OP_ADD_TRANSFORM_NODE:
+            {
+                TransformData transform;
+                transform.matrix = reader.readArray<FloatArray, float>();
+                if (reader.failed() || transform.matrix.length != 16) return false;
+                handler.addTransformNode(transform);
+                break;
+            }
+            case OP_ADD_CULL_NODE:
+            case OP_ADD_CULL_GROUP_NODE:
+            case OP_ADD_LOD_NODE:
+            {
+                CullData cull = reader.readValue<CullData>();
+                if (reader.failed()) return false;
+                if (op.code == OP_ADD_CULL_NODE)
+                    handler.addCullNode(cull);
+                else if (op.code == OP_ADD_CULL_GROUP_NODE)
+                    handler.addCullGroupNode(cull);
+                else
+                    handler.addLODNode(cull);
+                break;
+            }
+            case OP_ADD_LOD_CHILD:
+            {
+                LODChildData lodChild;
+                lodChild.minimumScreenHeightRatio = reader.readFloat();
+                if (reader.failed()) return false;
+                handler.addLODChild(lodChild);
+                break;
+            }
+            case OP_ADD_STATE_GROUP_NODE:
+            {
+                handler.addStateGroupNode();
+                break;
+            }
+            case OP_ADD_COMMANDS_NODE:
+            {
+                handler.addCommandsNode();
+                break;
+            }
+            case OP_ADD_VERTEX_INDEX_DRAW_NODE:
+            {
+                VertexIndexDrawData mesh;
+                mesh.id = reader.readInt();
+                mesh.verticies = reader.readArray<Vec3Array, vsg::vec3>();
+                mesh.triangles = reader.readArray<IntArray, uint32_t>();
+                mesh.normals = reader.readArray<Vec3Array, vsg::vec3>();
+                mesh.tangents = reader.readArray<Vec4Array, vsg::vec4>();
+                mesh.colors = reader.readArray<ColorArray, vsg::vec4>();
+                mesh.uv0 = reader.readArray<Vec2Array, vsg::vec2>();
+                mesh.uv1 = reader.readArray<Vec2Array, vsg::vec2>();
+                mesh.use32BitIndicies = reader.readInt();
+                if (reader.failed()) return false;
+                handler.addVertexIndexDrawNode(mesh);
+                break;
+            }
+            case OP_ADD_STRING_VALUE:
+            {
+                const char* name = reader.readString();
+                const char* value = reader.readString();
+                if (reader.failed()) return false;
+                handler.addStringValue(name, value);
+                break;
+            }
+            case OP_ADD_BIND_GRAPHICS_PIPELINE_COMMAND:
+            {
+                PipelineData pipeline;
+                pipeline.id = reader.readString();
+                pipeline.hasNormals = reader.readInt();
+                pipeline.hasTangents = reader.readInt();
+                pipeline.hasColors = reader.readInt();
+                pipeline.uvChannelCount = reader.readInt();
+                pipeline.useAlpha = reader.readInt();
+
+                uint32_t bindingCount = reader.readUInt();
+                if (reader.failed() || bindingCount > op.size / (4 * sizeof(uint32_t))) return false;
+                bindings.resize(bindingCount);
+                for (auto& binding : bindings)
+                {
+                    binding.binding = reader.readUInt();
+                    binding.descriptorType = static_cast<VkDescriptorType>(reader.readUInt());
+                    binding.descriptorCount = reader.readUInt();
+                    binding.stageFlags = reader.readUInt();
+                    binding.pImmutableSamplers = nullptr;
+                }
+                pipeline.descriptorBindings.data = bindings.data();
+                pipeline.descriptorBindings.length = static_cast<int>(bindingCount);
+
+                pipeline.shaderStages.id = reader.readInt();
+                uint32_t stageCount = reader.readUInt();
+                // each stage is at least its id, stages, specialization count and two empty strings of a length and padded terminator
+                if (reader.failed() || stageCount > op.size / (7 * sizeof(uint32_t))) return false;
+                stages.resize(stageCount);
+                for (auto& stage : stages)
+                {
+                    stage.id = reader.readInt();
+                    stage.stages = static_cast<VkShaderStageFlagBits>(reader.readUInt());
+                    stage.specializationData = reader.readArray<UIntArray, uint32_t>();
+                    stage.customDefines = reader.readString();
+                    stage.source = reader.readString();
+                }
+                pipeline.shaderStages.stages = stages.data();
+                pipeline.shaderStages.stagesCount = static_cast<int>(stageCount);
+
+                uint32_t addToStateGroup = reader.readUInt();
+                if (reader.failed()) return false;
+
+                if (!handler.addBindGraphicsPipelineCommand(pipeline, addToStateGroup))
+                {
+                    skipping = true;
+                    skipDepth = 0;
+                }
+                break;
+            }
+            case OP_ADD_BIND_INDEX_BUFFER_COMMAND:
+            {
+                IndexBufferData data;
+                data.id = reader.readInt();
+                data.triangles = reader.readArray<IntArray, uint32_t>();
+                data.use32BitIndicies = reader.readInt();
+                if (reader.failed()) return false;
+                handler.addBindIndexBufferCommand(data);
+                break;
+            }
+            case OP_ADD_BIND_VERTEX_BUFFERS_COMMAND:
+            {
+                VertexBuffersData data;
+                data.id = reader.readInt();
+                data.verticies = reader.readArray<Vec3Array, vsg::vec3>();
+                data.normals = reader.readArray<Vec3Array, vsg::vec3>();
+                data.tangents = reader.readArray<Vec4Array, vsg::vec4>();
+                data.colors = reader.readArray<ColorArray, vsg::vec4>();
+                data.uv0 = reader.readArray<Vec2Array, vsg::vec2>();
+                data.uv1 = reader.readArray<Vec2Array, vsg::vec2>();
+                if (reader.failed()) return false;
+                handler.addBindVertexBuffersCommand(data);
+                break;
+            }
+            case OP_ADD_DRAW_INDEXED_COMMAND:
+            {
+                DrawIndexedData data;
+                data.id = reader.readInt();
+                data.indexCount = reader.readUInt();
+                data.firstIndex = reader.readUInt();
+                data.vertexOffset = reader.readUInt();
+                data.instanceCount = reader.readUInt();
+                data.firstInstance = reader.readUInt();
+                if (reader.failed()) return false;
+                handler.addDrawIndexedCommand(data);
+                break;
+            }
+            case OP_CREATE_BIND_DESCRIPTOR_SET_COMMAND:
+            {
+                uint32_t addToStateGroup = reader.readUInt();
+                if (reader.failed()) return false;
+                handler.createBindDescriptorSetCommand(addToStateGroup);
+                break;
+            }
+            case OP_ADD_DESCRIPTOR_IMAGE:
+            {
+                DescriptorImageData texture;
+                texture.id = reader.readInt();
+                texture.binding = reader.readInt();
+                texture.packLayers = reader.readInt();
+                texture.packChannels = reader.readInt();
+                texture.firstComponentOnly = reader.readInt();
+                texture.sampledAtFirstUvs = reader.readInt();
+
+                uint32_t imageCount = reader.readUInt();
+                // each image is at least fourteen 4 byte values, with an empty pixel array
+                if (reader.failed() || imageCount > op.size / (14 * sizeof(uint32_t))) return false;
+                images.resize(imageCount);
+                for (auto& image : images)
+                {
+                    image.id = reader.readInt();
+                    image.pixels = reader.readArray<ByteArray, uint8_t>();
+                    image.format = static_cast<VkFormat>(reader.readUInt());
+                    image.width = reader.readInt();
+                    image.height = reader.readInt();
+                    image.depth = reader.readInt();
+                    image.anisoLevel = reader.readInt();
+                    image.wrapMode = static_cast<VkSamplerAddressMode>(reader.readUInt());
+                    image.filterMode = static_cast<VkFilter>(reader.readUInt());
+                    image.mipmapMode = static_cast<VkSamplerMipmapMode>(reader.readUInt());
+                    image.mipmapCount = reader.readInt();
+                    image.mipmapBias = reader.readFloat();
+                    image.mipmapFilter = reader.readInt();
+                    image.alphaCutoff = reader.readFloat();
+                }
+                if (reader.failed()) return false;
+
+                texture.images = images.data();
+                texture.descriptorCount = static_cast<int>(imageCount);
+                handler.addDescriptorImage(texture);
+                break;
+            }
+            case OP_ADD_DESCRIPTOR_BUFFER_FLOAT:
+            {
+                DescriptorFloatUniformData data;
+                data.id = reader.readInt();
+                data.binding = reader.readInt();
+                data.value = reader.readFloat();
+                if (reader.failed()) return false;
+                handler.addDescriptorBufferFloat(data);
+                break;
+            }
+            case OP_ADD_DESCRIPTOR_BUFFER_FLOAT_ARRAY:
+            {
+                DescriptorFloatArrayUniformData data;
+                data.id = reader.readInt();
+                data.binding = reader.readInt();
+                data.value = reader.readArray<FloatArray, float>();
+                if (reader.failed()) return false;
+                handler.addDescriptorBufferFloatArray(data);
+                break;
+            }
+            case OP_ADD_DESCRIPTOR_BUFFER_VECTOR:
+            {
+                DescriptorVectorUniformData data;
+                data.id = reader.readInt();
+                data.binding = reader.readInt();
+                data.value = reader.readValue<vsg::vec4>();
+                if (reader.failed()) return false;
+                handler.addDescriptorBufferVector(data);
+                break;
+            }
+            case OP_ADD_DESCRIPTOR_BUFFER_VECTOR_ARRAY:
+            {
+                DescriptorVectorArrayUniformData data;
+                data.id = reader.readInt();
+                data.binding = reader.readInt();
+                data.value = reader.readArray<Vec4Array, vsg::vec4>();
+                if (reader.failed()) return false;
+                handler.addDescriptorBufferVectorArray(data);
+                break;
+            }
+            case OP_END_NODE:
+            {
+                handler.endNode();
+                break;
+            }
+            default:
+                // unknown op, the version check should prevent this
+                return false;
+            }
+        }
+
+        return true;
+    }
+} // namespace
+
+bool unity2vsg::readCommandStream(const void* ops, size_t bytes, CommandStreamHandler& handler)
+{
+    // check every op and payload first so a truncated or malformed stream is rejected before any of it is applied.
+    // Nothing is skipped while checking, so ops after a pipeline that fails to bind are checked too
+    ValidatingHandler validator;
+    if (!decodeCommandStream(ops, bytes, validator)) return false;
+
+    return decodeCommandStream(ops, bytes, handler);
+}
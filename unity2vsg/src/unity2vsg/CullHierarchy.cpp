@@ -0,0 +1,396 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/CullHierarchy.h>
+
+#include <unity2vsg/Bounds.h>
+#include <unity2vsg/MatrixUtils.h>
+#include <unity2vsg/Parallel.h>
+#include <unity2vsg/StateSorter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    struct Box
+    {
+        vsg::vec3 minimum = vsg::vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        vsg::vec3 maximum = vsg::vec3(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+
+        bool valid() const { return minimum.x <= maximum.x; }
+
+        void expand(const vsg::vec3& p)
+        {
+            minimum = vsg::vec3(std::min(minimum.x, p.x), std::min(minimum.y, p.y), std::min(minimum.z, p.z));
+            maximum = vsg::vec3(std::max(maximum.x, p.x), std::max(maximum.y, p.y), std::max(maximum.z, p.z));
+        }
+
+        void expand(const Box& box)
+        {
+            if (!box.valid()) return;
+            expand(box.minimum);
+            expand(box.maximum);
+        }
+
+        // the box of this box's corners transformed by matrix
+        void expand(const Box& box, const vsg::mat4& matrix)
+        {
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                expand(transformPoint(matrix, vsg::vec3((corner & 1) ? box.maximum.x : box.minimum.x, (corner & 2) ? box.maximum.y : box.minimum.y,
+                                                        (corner & 4) ? box.maximum.z : box.minimum.z)));
+            }
+        }
+
+        vsg::vec3 center() const { return vsg::vec3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f); }
+
+        double area() const
+        {
+            if (!valid()) return 0.0;
+            double dx = maximum.x - minimum.x, dy = maximum.y - minimum.y, dz = maximum.z - minimum.z;
+            return 2.0 * (dx * dy + dy * dz + dz * dx);
+        }
+
+        vsg::sphere sphere() const
+        {
+            vsg::vec3 c = center();
+            vsg::vec3 extent(maximum.x - c.x, maximum.y - c.y, maximum.z - c.z);
+            return vsg::sphere(c, std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z));
+        }
+    };
+
+    Box sphereBox(const vsg::sphere& bound)
+    {
+        Box box;
+        box.minimum = vsg::vec3(bound.center.x - bound.radius, bound.center.y - bound.radius, bound.center.z - bound.radius);
+        box.maximum = vsg::vec3(bound.center.x + bound.radius, bound.center.y + bound.radius, bound.center.z + bound.radius);
+        return box;
+    }
+
+    // the box of a subgraph in the coordinates of its parent, culling nodes are trusted to bound what's below them
+    class BoundsVisitor : public vsg::Visitor
+    {
+    public:
+        using ArrayBounds = std::map<const vsg::Data*, std::pair<vsg::vec3, vsg::vec3>>;
+
+        BoundsVisitor(ArrayBounds& arrayBounds, std::mutex& mutex) :
+            _arrayBounds(arrayBounds),
+            _mutex(mutex)
+        {
+            _matrixStack.push_back(identityMatrix());
+        }
+
+        Box box;
+        bool bounded = true; // false if something drawn below couldn't be bounded
+
+        void apply(vsg::Object& object) override
+        {
+            object.traverse(*this);
+        }
+
+        void apply(vsg::MatrixTransform& transform) override
+        {
+            _matrixStack.push_back(multiply(_matrixStack.back(), transform.getMatrix()));
+            transform.traverse(*this);
+            _matrixStack.pop_back();
+        }
+
+        void apply(vsg::CullGroup& cullGroup) override { box.expand(sphereBox(cullGroup.getBound()), _matrixStack.back()); }
+        void apply(vsg::CullNode& cullNode) override { box.expand(sphereBox(cullNode.getBound()), _matrixStack.back()); }
+        void apply(vsg::LOD& lod) override { box.expand(sphereBox(lod.getBound()), _matrixStack.back()); }
+
+        void apply(vsg::VertexIndexDraw& vid) override
+        {
+            if (vid.instanceCount != 1 || vid._arrays.empty())
+                bounded = false;
+            else
+                addPositions(vid._arrays[0].get());
+        }
+
+        void apply(vsg::Commands& commands) override
+        {
+            for (auto& command : commands.getChildren())
+            {
+                auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get());
+                auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get());
+                if (bvb && !bvb->getArrays().empty())
+                    addPositions(bvb->getArrays()[0].get());
+                else if (drawIndexed && drawIndexed->instanceCount != 1)
+                    bounded = false;
+            }
+        }
+
+    protected:
+        void addPositions(const vsg::Data* array)
+        {
+            auto positions = dynamic_cast<const vsg::vec3Array*>(array);
+            if (!positions || positions->valueCount() == 0)
+            {
+                bounded = false;
+                return;
+            }
+
+            Box arrayBox;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto itr = _arrayBounds.find(array);
+                if (itr != _arrayBounds.end())
+                {
+                    arrayBox.minimum = itr->second.first;
+                    arrayBox.maximum = itr->second.second;
+                }
+            }
+
+            if (!arrayBox.valid())
+            {
+                vertexBounds(static_cast<const vsg::vec3*>(positions->dataPointer()), positions->valueCount(), arrayBox.minimum, arrayBox.maximum);
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                _arrayBounds[array] = std::make_pair(arrayBox.minimum, arrayBox.maximum);
+            }
+
+            box.expand(arrayBox, _matrixStack.back());
+        }
+
+        ArrayBounds& _arrayBounds;
+        std::mutex& _mutex;
+        std::vector<vsg::mat4> _matrixStack;
+    };
+
+    struct Item
+    {
+        vsg::ref_ptr<vsg::Node> node;
+        Box box;
+        vsg::vec3 center;
+    };
+
+    struct Subtree
+    {
+        vsg::ref_ptr<vsg::Node> node;
+        Box box;
+        double weightedTests = 0.0; // sum of surface area times children over the CullGroups created
+        size_t cullGroupCount = 0;
+    };
+
+    const size_t SAH_BINS = 16;
+
+    // subsets at least this big have one half built on another thread, while fewer than parallelDepth splits lie above them
+    const size_t PARALLEL_MIN_ITEMS = 4096;
+
+    // how many times the items can be split in two before there are as many halves being built as hardware threads
+    size_t parallelDepth()
+    {
+        size_t depth = 0;
+        for (size_t threads = std::max(1u, std::thread::hardware_concurrency()); threads > 1; threads = (threads + 1) / 2) depth++;
+        return depth;
+    }
+
+    size_t splitItems(std::vector<Item>& items, size_t first, size_t last, CullHierarchyVisitor::Split split)
+    {
+        Box centers;
+        for (size_t i = first; i < last; ++i) centers.expand(items[i].center);
+
+        vsg::vec3 extent(centers.maximum.x - centers.minimum.x, centers.maximum.y - centers.minimum.y, centers.maximum.z - centers.minimum.z);
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        size_t middle = first + (last - first) / 2;
+        if (extent[axis] <= 0.0f) return middle;
+
+        if (split == CullHierarchyVisitor::SAH_SPLIT)
+        {
+            // bin the centers along the axis and pick the boundary with the lowest area weighted child count
+            auto binOf = [&](const Item& item) {
+                size_t bin = static_cast<size_t>((item.center[axis] - centers.minimum[axis]) / extent[axis] * SAH_BINS);
+                return std::min(bin, SAH_BINS - 1);
+            };
+
+            Box binBoxes[SAH_BINS];
+            size_t binCounts[SAH_BINS] = {};
+            for (size_t i = first; i < last; ++i)
+            {
+                size_t bin = binOf(items[i]);
+                binBoxes[bin].expand(items[i].box);
+                binCounts[bin]++;
+            }
+
+            double rightCosts[SAH_BINS] = {};
+            Box right;
+            size_t rightCount = 0;
+            for (size_t b = SAH_BINS - 1; b > 0; --b)
+            {
+                right.expand(binBoxes[b]);
+                rightCount += binCounts[b];
+                rightCosts[b] = right.area() * rightCount;
+            }
+
+            Box left;
+            size_t leftCount = 0;
+            size_t bestBin = 0;
+            double bestCost = std::numeric_limits<double>::max();
+            for (size_t b = 1; b < SAH_BINS; ++b)
+            {
+                left.expand(binBoxes[b - 1]);
+                leftCount += binCounts[b - 1];
+                if (leftCount == 0 || leftCount == last - first) continue;
+
+                double cost = left.area() * leftCount + rightCosts[b];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestBin = b;
+                }
+            }
+
+            if (bestBin > 0)
+            {
+                auto itr = std::partition(items.begin() + first, items.begin() + last, [&](const Item& item) { return binOf(item) < bestBin; });
+                return static_cast<size_t>(itr - items.begin());
+            }
+        }
+
+        std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + last,
+                         [axis](const Item& lhs, const Item& rhs) { return lhs.center[axis] < rhs.center[axis]; });
+        return middle;
+    }
+
+    Subtree buildSubtree(std::vector<Item>& items, size_t first, size_t last, CullHierarchyVisitor::Split split, size_t parallelDepth)
+    {
+        Subtree subtree;
+        size_t count = last - first;
+        if (count == 1)
+        {
+            subtree.node = items[first].node;
+            subtree.box = items[first].box;
+            return subtree;
+        }
+
+        for (size_t i = first; i < last; ++i) subtree.box.expand(items[i].box);
+        auto cullGroup = vsg::CullGroup::create(subtree.box.sphere());
+        subtree.node = cullGroup;
+        subtree.cullGroupCount = 1;
+
+        if (count <= CullHierarchyVisitor::MAX_LEAF_CHILDREN)
+        {
+            for (size_t i = first; i < last; ++i) cullGroup->addChild(items[i].node);
+            subtree.weightedTests = subtree.box.area() * count;
+            return subtree;
+        }
+
+        size_t middle = splitItems(items, first, last, split);
+
+        // the halves work on separate ranges of items so can be built at the same time, an exception building the left
+        // half is rethrown by get and the future waits for it to finish if building the right half throws
+        Subtree left, right;
+        if (parallelDepth > 0 && count >= PARALLEL_MIN_ITEMS)
+        {
+            auto future = std::async(std::launch::async, [&items, first, middle, split, parallelDepth]() { return buildSubtree(items, first, middle, split, parallelDepth - 1); });
+            right = buildSubtree(items, middle, last, split, parallelDepth - 1);
+            left = future.get();
+        }
+        else
+        {
+            left = buildSubtree(items, first, middle, split, parallelDepth);
+            right = buildSubtree(items, middle, last, split, parallelDepth);
+        }
+
+        cullGroup->addChild(left.node);
+        cullGroup->addChild(right.node);
+        subtree.weightedTests = subtree.box.area() * 2.0 + left.weightedTests + right.weightedTests;
+        subtree.cullGroupCount += left.cullGroupCount + right.cullGroupCount;
+        return subtree;
+    }
+} // namespace
+
+CullHierarchyVisitor::CullHierarchyVisitor(Split split, size_t minChildren) :
+    _split(split),
+    _minChildren(std::max<size_t>(minChildren, MAX_LEAF_CHILDREN + 1)),
+    _regroupedCount(0),
+    _blendedCount(0),
+    _cullGroupCount(0),
+    _testsBefore(0.0),
+    _testsAfter(0.0)
+{
+}
+
+void CullHierarchyVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void CullHierarchyVisitor::apply(vsg::Group& group)
+{
+    if (!_visited.insert(&group).second) return;
+
+    for (auto& child : group.getChildren()) child->accept(*this);
+    if (group.getChildren().size() >= _minChildren) regroup(group);
+}
+
+void CullHierarchyVisitor::apply(vsg::LOD& lod)
+{
+    // the levels are selected by the lod so can't be moved, what's below them can still be regrouped
+    if (!_visited.insert(&lod).second) return;
+    lod.traverse(*this);
+}
+
+void CullHierarchyVisitor::regroup(vsg::Group& group)
+{
+    // blended draws have to be drawn in the order they were exported, moving children by position would change it
+    if (drawsBlended(&group))
+    {
+        _blendedCount++;
+        return;
+    }
+
+    auto& children = group.getChildren();
+
+    std::vector<Item> bounded(children.size());
+    std::vector<uint8_t> isBounded(children.size(), 0);
+    parallelFor(children.size(), [&](size_t i) {
+        BoundsVisitor bounds(_arrayBounds, _arrayBoundsMutex);
+        children[i]->accept(bounds);
+        if (!bounds.bounded || !bounds.box.valid()) return;
+
+        bounded[i].node = children[i];
+        bounded[i].box = bounds.box;
+        bounded[i].center = bounds.box.center();
+        isBounded[i] = 1;
+    });
+
+    vsg::Group::Children unbounded;
+    std::vector<Item> items;
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        if (isBounded[i])
+            items.push_back(bounded[i]);
+        else
+            unbounded.push_back(children[i]);
+    }
+    if (items.size() < _minChildren) return;
+
+    Subtree root = buildSubtree(items, 0, items.size(), _split, parallelDepth());
+
+    children = unbounded;
+    children.push_back(root.node);
+
+    // the root CullGroup is always tested, the children of each CullGroup are tested when it's in view
+    double rootArea = root.box.area();
+    _testsBefore += static_cast<double>(items.size());
+    _testsAfter += rootArea > 0.0 ? 1.0 + root.weightedTests / rootArea : static_cast<double>(items.size());
+    _cullGroupCount += root.cullGroupCount;
+    _regroupedCount++;
+}
@@ -0,0 +1,236 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/DataCache.h>
+
+#include <cstring>
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+//
+// Hashing, a 64 bit multiply/rotate hash in the style of xxHash64, consuming 32 bytes per round
+//
+
+namespace
+{
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    inline uint64_t read64(const uint8_t* p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t round(uint64_t acc, uint64_t input)
+    {
+        acc += input * PRIME2;
+        acc = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    inline uint64_t mergeRound(uint64_t acc, uint64_t val)
+    {
+        acc ^= round(0, val);
+        return acc * PRIME1 + PRIME4;
+    }
+} // namespace
+
+uint64_t unity2vsg::hashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    if (size >= 32)
+    {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+
+        const uint8_t* limit = end - 32;
+        do
+        {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else
+    {
+        h = seed + PRIME5;
+    }
+
+    h += static_cast<uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        h ^= (*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+    }
+
+    // final avalanche
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+//
+// Data comparison
+//
+
+namespace
+{
+    // everything other than the contents that has to match for two Data objects to be interchangeable
+    struct DataDescription
+    {
+        size_t typeHash;
+        uint64_t valueSize;
+        uint64_t valueCount;
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        uint32_t format;
+        uint32_t maxNumMipmaps;
+        uint32_t blockWidth;
+        uint32_t blockHeight;
+        uint32_t blockDepth;
+    };
+
+    DataDescription describe(const vsg::Data* data)
+    {
+        DataDescription desc = {};
+        desc.typeHash = typeid(*data).hash_code();
+        desc.valueSize = data->valueSize();
+        desc.valueCount = data->valueCount();
+        desc.width = data->width();
+        desc.height = data->height();
+        desc.depth = data->depth();
+        desc.format = static_cast<uint32_t>(data->getFormat());
+
+        vsg::Data::Layout layout = data->getLayout();
+        desc.maxNumMipmaps = layout.maxNumMipmaps;
+        desc.blockWidth = layout.blockWidth;
+        desc.blockHeight = layout.blockHeight;
+        desc.blockDepth = layout.blockDepth;
+        return desc;
+    }
+
+    bool operator==(const DataDescription& lhs, const DataDescription& rhs)
+    {
+        return lhs.typeHash == rhs.typeHash && lhs.valueSize == rhs.valueSize && lhs.valueCount == rhs.valueCount &&
+               lhs.width == rhs.width && lhs.height == rhs.height && lhs.depth == rhs.depth && lhs.format == rhs.format &&
+               lhs.maxNumMipmaps == rhs.maxNumMipmaps && lhs.blockWidth == rhs.blockWidth && lhs.blockHeight == rhs.blockHeight &&
+               lhs.blockDepth == rhs.blockDepth;
+    }
+} // namespace
+
+uint64_t unity2vsg::hashData(const vsg::Data* data)
+{
+    DataDescription desc = describe(data);
+    uint64_t seed = hashBytes(&desc, sizeof(DataDescription));
+    return hashBytes(data->dataPointer(), data->dataSize(), seed);
+}
+
+bool unity2vsg::compareData(const vsg::Data* lhs, const vsg::Data* rhs)
+{
+    if (lhs == rhs) return true;
+    if (!(describe(lhs) == describe(rhs))) return false;
+    if (lhs->dataSize() != rhs->dataSize()) return false;
+    if (lhs->dataSize() == 0) return true;
+    return std::memcmp(lhs->dataPointer(), rhs->dataPointer(), lhs->dataSize()) == 0;
+}
+
+//
+// DataCache
+//
+
+DataCache::DataCache() :
+    _uniqueCount(0),
+    _duplicateCount(0),
+    _bytesSaved(0),
+    _hashCollisions(0)
+{
+}
+
+vsg::ref_ptr<vsg::Data> DataCache::share(vsg::ref_ptr<vsg::Data> data, uint64_t salt)
+{
+    if (!data.valid() || data->dataPointer() == nullptr) return data;
+
+    uint64_t key = hashData(data.get()) ^ (salt * PRIME1);
+
+    auto range = _entries.equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr)
+    {
+        Entry& entry = itr->second;
+        if (entry.salt != salt) continue;
+        if (entry.data == data) return data;
+
+        if (compareData(entry.data.get(), data.get()))
+        {
+            _duplicateCount++;
+            _bytesSaved += data->dataSize();
+            return entry.data;
+        }
+        _hashCollisions++;
+    }
+
+    _entries.emplace(key, Entry{salt, data});
+    _uniqueCount++;
+    return data;
+}
+
+void DataCache::clear()
+{
+    _entries.clear();
+    _uniqueCount = 0;
+    _duplicateCount = 0;
+    _bytesSaved = 0;
+    _hashCollisions = 0;
+}
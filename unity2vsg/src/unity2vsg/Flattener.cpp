@@ -0,0 +1,321 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Flattener.h>
+
+#include <unity2vsg/IndexUtils.h>
+#include <unity2vsg/MatrixUtils.h>
+#include <unity2vsg/ShaderUtils.h>
+#include <unity2vsg/StaticBatcher.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // counts how often each node is reached, which is the number of parents a node below the root has
+    class ParentCountVisitor : public vsg::Visitor
+    {
+    public:
+        std::map<const vsg::Node*, size_t> counts;
+
+        void apply(vsg::Object& object) override
+        {
+            if (auto node = dynamic_cast<vsg::Node*>(&object))
+            {
+                if (counts[node]++ > 0) return;
+            }
+            object.traverse(*this);
+        }
+    };
+
+    class NodeCountVisitor : public vsg::Visitor
+    {
+    public:
+        size_t count = 0;
+
+        void apply(vsg::Object& object) override
+        {
+            if (dynamic_cast<vsg::Node*>(&object)) count++;
+            object.traverse(*this);
+        }
+    };
+} // namespace
+
+std::map<const vsg::Node*, size_t> unity2vsg::countParents(vsg::Node* root)
+{
+    ParentCountVisitor parentCount;
+    root->accept(parentCount);
+    return parentCount.counts;
+}
+
+size_t unity2vsg::countNodes(vsg::Node* node)
+{
+    NodeCountVisitor nodeCount;
+    node->accept(nodeCount);
+    return nodeCount.count;
+}
+
+double unity2vsg::timeTraversal(vsg::Node* node, size_t iterations)
+{
+    if (iterations == 0) return 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        NodeCountVisitor nodeCount;
+        node->accept(nodeCount);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(iterations);
+}
+
+//
+// FlattenVisitor
+//
+
+FlattenVisitor::FlattenVisitor(size_t bakeMaxVertices, const VertexArrayAttributes& attributes) :
+    _bakeMaxVertices(bakeMaxVertices),
+    _attributes(attributes),
+    _removedGroupCount(0),
+    _mergedTransformCount(0),
+    _bakedMeshCount(0)
+{
+}
+
+void FlattenVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void FlattenVisitor::apply(vsg::Group& group)
+{
+    if (!_flattened.insert(&group).second) return;
+    flattenChildren(group);
+}
+
+void FlattenVisitor::apply(vsg::MatrixTransform& transform)
+{
+    if (!_flattened.insert(&transform).second) return;
+    flattenChildren(transform);
+
+    // the child's children are already flattened so merging is all that is left to do
+    while (transform.getChildren().size() == 1)
+    {
+        vsg::ref_ptr<vsg::Node> child = transform.getChildren()[0];
+        auto childTransform = dynamic_cast<vsg::MatrixTransform*>(child.get());
+        if (!childTransform || typeid(*childTransform) != typeid(vsg::MatrixTransform) || parentCount(childTransform) > 1) break;
+
+        transform.setMatrix(multiply(transform.getMatrix(), childTransform->getMatrix()));
+        transform.getChildren() = childTransform->getChildren();
+        _mergedTransformCount++;
+    }
+}
+
+void FlattenVisitor::apply(vsg::LOD& lod)
+{
+    if (!_flattened.insert(&lod).second) return;
+
+    // the levels themselves have to stay but a redundant group holding a level can be skipped
+    for (auto& lodChild : lod.getChildren())
+    {
+        if (!lodChild.child) continue;
+        lodChild.child->accept(*this);
+
+        auto group = dynamic_cast<vsg::Group*>(lodChild.child.get());
+        if (group && group->getChildren().size() == 1 && isRedundant(group) && parentCount(group) <= 1)
+        {
+            lodChild.child = group->getChildren()[0];
+            _removedGroupCount++;
+        }
+    }
+}
+
+void FlattenVisitor::flatten(vsg::Group& root)
+{
+    _parentCounts = countParents(&root);
+
+    root.accept(*this);
+
+    _parentCounts.clear();
+    _flattened.clear();
+}
+
+void FlattenVisitor::flattenChildren(vsg::Group& group)
+{
+    vsg::Group::Children children;
+    for (auto& child : group.getChildren())
+    {
+        child->accept(*this);
+
+        vsg::ref_ptr<vsg::Node> node = child;
+        if (_bakeMaxVertices > 0 && parentCount(node.get()) <= 1)
+        {
+            auto transform = dynamic_cast<vsg::MatrixTransform*>(node.get());
+            vsg::ref_ptr<vsg::Node> baked = transform ? bakeTransform(*transform) : vsg::ref_ptr<vsg::Node>();
+            if (baked)
+            {
+                node = baked;
+                node->accept(*this);
+            }
+        }
+
+        // empty groups draw nothing wherever they are
+        auto childGroup = dynamic_cast<vsg::Group*>(node.get());
+        if (childGroup && childGroup->getChildren().empty())
+        {
+            _removedGroupCount++;
+            continue;
+        }
+
+        if (childGroup && isRedundant(childGroup) && parentCount(childGroup) <= 1)
+        {
+            children.insert(children.end(), childGroup->getChildren().begin(), childGroup->getChildren().end());
+            _removedGroupCount++;
+            continue;
+        }
+
+        children.push_back(node);
+    }
+    group.getChildren() = children;
+}
+
+bool FlattenVisitor::isRedundant(const vsg::Node* node) const
+{
+    if (typeid(*node) == typeid(vsg::Group)) return true;
+    if (typeid(*node) == typeid(vsg::MatrixTransform)) return isIdentity(static_cast<const vsg::MatrixTransform*>(node)->getMatrix());
+    return false;
+}
+
+size_t FlattenVisitor::parentCount(const vsg::Node* node) const
+{
+    auto itr = _parentCounts.find(node);
+    return itr != _parentCounts.end() ? itr->second : 0;
+}
+
+vsg::ref_ptr<vsg::Node> FlattenVisitor::bakeTransform(vsg::MatrixTransform& transform)
+{
+    Baked baked;
+    auto group = vsg::Group::create();
+    for (auto& child : transform.getChildren())
+    {
+        vsg::ref_ptr<vsg::Node> node = bakeNode(child.get(), transform.getMatrix(), baked);
+        if (!node) return vsg::ref_ptr<vsg::Node>();
+        group->addChild(node);
+    }
+    if (baked.meshCount == 0) return vsg::ref_ptr<vsg::Node>();
+
+    // a mesh baked by a transform further down is baked again, only the final arrays are kept
+    for (auto& array : baked.arrays)
+    {
+        uint32_t attribute = _attributes[array.second];
+        _attributes[array.first] = attribute;
+        _bakedArrays[array.first] = attribute;
+
+        if (_bakedArrays.erase(array.second) > 0)
+        {
+            _attributes.erase(array.second);
+            if (attribute == VERTEX) baked.meshCount--;
+        }
+    }
+
+    _bakedMeshCount += baked.meshCount;
+    _mergedTransformCount++;
+    return group;
+}
+
+vsg::ref_ptr<vsg::Node> FlattenVisitor::bakeNode(vsg::Node* node, const vsg::mat4& matrix, Baked& baked)
+{
+    // copies are made of everything below the transform as the originals may be shared with unbaked parts of the graph
+    if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(node))
+    {
+        std::vector<uint32_t> arrayAttributes;
+        if (vid->instanceCount != 1 || !vid->_indices.valid() || !transformableVertexArrays(vid->_arrays, _attributes, arrayAttributes)) return vsg::ref_ptr<vsg::Node>();
+
+        size_t vertexCount = vid->_arrays[0]->valueCount();
+        if (baked.vertexCount + vertexCount > _bakeMaxVertices) return vsg::ref_ptr<vsg::Node>();
+
+        vsg::DataList arrays = createTransformedVertexArrays(vid->_arrays, vertexCount);
+        bool mirrored = transformVertexArrays(matrix, vid->_arrays, arrayAttributes, arrays, 0);
+
+        vsg::ref_ptr<vsg::Data> indices = vid->_indices;
+        if (mirrored)
+        {
+            std::vector<uint32_t> values;
+            if (!readIndices(vid->_indices.get(), 0, static_cast<uint32_t>(vid->_indices->valueCount()), values)) return vsg::ref_ptr<vsg::Node>();
+            for (size_t i = 0; i + 2 < values.size(); i += 3) std::swap(values[i + 1], values[i + 2]);
+
+            if (vid->_indices->valueSize() == sizeof(uint16_t))
+                indices = vsg::ushortArray::create(values.size());
+            else
+                indices = vsg::uintArray::create(values.size());
+            writeIndices(indices.get(), 0, values);
+        }
+
+        auto bakedVid = vsg::VertexIndexDraw::create();
+        bakedVid->_arrays = arrays;
+        bakedVid->_indices = indices;
+        bakedVid->indexCount = vid->indexCount;
+        bakedVid->instanceCount = 1;
+        bakedVid->firstIndex = vid->firstIndex;
+        bakedVid->vertexOffset = vid->vertexOffset;
+        bakedVid->firstInstance = vid->firstInstance;
+
+        for (size_t a = 0; a < arrays.size(); ++a) baked.arrays[arrays[a].get()] = vid->_arrays[a].get();
+        baked.vertexCount += vertexCount;
+        baked.meshCount++;
+        return bakedVid;
+    }
+
+    auto group = dynamic_cast<vsg::Group*>(node);
+    if (!group) return vsg::ref_ptr<vsg::Node>();
+
+    vsg::mat4 childMatrix = matrix;
+    vsg::ref_ptr<vsg::Group> copy;
+    if (auto stategroup = dynamic_cast<vsg::StateGroup*>(group))
+    {
+        auto stategroupCopy = vsg::StateGroup::create();
+        for (auto& command : stategroup->getStateCommands()) stategroupCopy->add(command);
+        copy = stategroupCopy;
+    }
+    else if (auto cullGroup = dynamic_cast<vsg::CullGroup*>(group))
+    {
+        const vsg::sphere& bound = cullGroup->getBound();
+        vsg::vec3 center = transformPoint(matrix, vsg::vec3(bound.center.x, bound.center.y, bound.center.z));
+        copy = vsg::CullGroup::create(vsg::sphere(center, bound.radius * maxScale(matrix)));
+    }
+    else if (auto transform = dynamic_cast<vsg::MatrixTransform*>(group))
+    {
+        childMatrix = multiply(matrix, transform->getMatrix());
+        copy = vsg::Group::create();
+    }
+    else if (typeid(*group) == typeid(vsg::Group))
+    {
+        copy = vsg::Group::create();
+    }
+    else
+    {
+        return vsg::ref_ptr<vsg::Node>();
+    }
+
+    for (auto& child : group->getChildren())
+    {
+        vsg::ref_ptr<vsg::Node> bakedChild = bakeNode(child.get(), childMatrix, baked);
+        if (!bakedChild) return vsg::ref_ptr<vsg::Node>();
+        copy->addChild(bakedChild);
+    }
+    return copy;
+}
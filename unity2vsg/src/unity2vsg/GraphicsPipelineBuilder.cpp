@@ -101,15 +101,29 @@ size_t GraphicsPipelineBuilder::sizeOf(VkFormat format)
     case VkFormat::VK_FORMAT_R32G32_SFLOAT: return sizeof(vec2);
     case VkFormat::VK_FORMAT_R32_SFLOAT: return sizeof(float);
 
+    // half float
+    case VkFormat::VK_FORMAT_R16G16B16A16_SFLOAT: return sizeof(usvec4);
+    case VkFormat::VK_FORMAT_R16G16_SFLOAT: return sizeof(usvec2);
+
     // uint8
     case VkFormat::VK_FORMAT_B8G8R8A8_UINT: return sizeof(ubvec4);
     case VkFormat::VK_FORMAT_B8G8R8_UINT: return sizeof(ubvec3);
     case VkFormat::VK_FORMAT_R8G8_UINT: return sizeof(ubvec2);
     case VkFormat::VK_FORMAT_R8_UINT: return sizeof(uint8_t);
 
+    // normalized uint8/int8
+    case VkFormat::VK_FORMAT_R8G8B8A8_UNORM: return sizeof(ubvec4);
+    case VkFormat::VK_FORMAT_R8G8B8A8_SNORM: return sizeof(ubvec4);
+
     // uint16
     case VkFormat::VK_FORMAT_R16_UINT: return sizeof(uint16_t);
 
+    // normalized uint16/int16
+    case VkFormat::VK_FORMAT_R16G16B16A16_UNORM: return sizeof(usvec4);
+    case VkFormat::VK_FORMAT_R16G16B16A16_SNORM: return sizeof(usvec4);
+    case VkFormat::VK_FORMAT_R16G16_UNORM: return sizeof(usvec2);
+    case VkFormat::VK_FORMAT_R16G16_SNORM: return sizeof(usvec2);
+
     // uint32
     case VkFormat::VK_FORMAT_R32_UINT: return sizeof(uint32_t);
 
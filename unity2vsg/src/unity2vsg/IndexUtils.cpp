@@ -0,0 +1,303 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/IndexUtils.h>
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#    define UNITY2VSG_INDEX_AVX2
+#    include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define UNITY2VSG_INDEX_SSE2
+#    include <emmintrin.h>
+#endif
+
+using namespace unity2vsg;
+
+namespace
+{
+#if defined(UNITY2VSG_INDEX_SSE2)
+    // SSE2 has no 32 bit integer min/max so select with a compare mask. Its compares are signed, flipping the sign bits
+    // first orders them as unsigned, so a negative or huge index is as large here as it is to the scalar code.
+    inline __m128i max_epu32(__m128i a, __m128i b)
+    {
+        const __m128i sign = _mm_set1_epi32(INT32_MIN);
+        __m128i mask = _mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    inline __m128i min_epu32(__m128i a, __m128i b)
+    {
+        const __m128i sign = _mm_set1_epi32(INT32_MIN);
+        __m128i mask = _mm_cmplt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    inline uint32_t horizontalMax(__m128i v)
+    {
+        v = max_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = max_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+    }
+
+    inline uint32_t horizontalMin(__m128i v)
+    {
+        v = min_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = min_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+    }
+#endif
+
+#if defined(UNITY2VSG_INDEX_AVX2)
+    // unsigned compares throughout, as with SSE2
+    inline uint32_t horizontalMax(__m256i v)
+    {
+        __m128i m = _mm_max_epu32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(m));
+    }
+
+    inline uint32_t horizontalMin(__m256i v)
+    {
+        __m128i m = _mm_min_epu32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(m));
+    }
+#endif
+} // namespace
+
+uint32_t unity2vsg::convertIndices(const int32_t* src, size_t count, uint16_t* dst, int32_t base)
+{
+    size_t i = 0;
+    uint32_t maxIndex = 0;
+
+#if defined(UNITY2VSG_INDEX_AVX2)
+    {
+        // packs is signed so bias into the int16 range first and flip the sign bit back afterwards
+        const __m256i bias = _mm256_set1_epi32(base + 0x8000);
+        const __m256i flip = _mm256_set1_epi16(static_cast<short>(0x8000));
+        __m256i vmax = _mm256_setzero_si256();
+        for (; i + 16 <= count; i += 16)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 8));
+            vmax = _mm256_max_epu32(vmax, _mm256_max_epu32(a, b));
+
+            // packs works within 128 bit lanes, so reorder the 64 bit quarters afterwards
+            __m256i packed = _mm256_packs_epi32(_mm256_sub_epi32(a, bias), _mm256_sub_epi32(b, bias));
+            packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(packed, flip));
+        }
+        maxIndex = horizontalMax(vmax);
+    }
+#elif defined(UNITY2VSG_INDEX_SSE2)
+    {
+        const __m128i bias = _mm_set1_epi32(base + 0x8000);
+        const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+        __m128i vmax = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+            vmax = max_epu32(vmax, max_epu32(a, b));
+
+            __m128i packed = _mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(packed, flip));
+        }
+        maxIndex = horizontalMax(vmax);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        uint32_t index = static_cast<uint32_t>(src[i]);
+        maxIndex = std::max(maxIndex, index);
+        dst[i] = static_cast<uint16_t>(src[i] - base);
+    }
+    return maxIndex;
+}
+
+uint32_t unity2vsg::convertIndices(const int32_t* src, size_t count, uint32_t* dst)
+{
+    size_t i = 0;
+    uint32_t maxIndex = 0;
+
+#if defined(UNITY2VSG_INDEX_AVX2)
+    {
+        __m256i vmax = _mm256_setzero_si256();
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            vmax = _mm256_max_epu32(vmax, a);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), a);
+        }
+        maxIndex = horizontalMax(vmax);
+    }
+#elif defined(UNITY2VSG_INDEX_SSE2)
+    {
+        __m128i vmax = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            vmax = max_epu32(vmax, a);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), a);
+        }
+        maxIndex = horizontalMax(vmax);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        uint32_t index = static_cast<uint32_t>(src[i]);
+        maxIndex = std::max(maxIndex, index);
+        dst[i] = index;
+    }
+    return maxIndex;
+}
+
+void unity2vsg::indexRange(const int32_t* src, size_t count, uint32_t& minIndex, uint32_t& maxIndex)
+{
+    size_t i = 0;
+    minIndex = UINT32_MAX;
+    maxIndex = 0;
+
+#if defined(UNITY2VSG_INDEX_AVX2)
+    if (count >= 8)
+    {
+        __m256i vmin = _mm256_set1_epi32(-1);
+        __m256i vmax = _mm256_setzero_si256();
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            vmin = _mm256_min_epu32(vmin, a);
+            vmax = _mm256_max_epu32(vmax, a);
+        }
+        minIndex = horizontalMin(vmin);
+        maxIndex = horizontalMax(vmax);
+    }
+#elif defined(UNITY2VSG_INDEX_SSE2)
+    if (count >= 4)
+    {
+        __m128i vmin = _mm_set1_epi32(-1);
+        __m128i vmax = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            vmin = min_epu32(vmin, a);
+            vmax = max_epu32(vmax, a);
+        }
+        minIndex = horizontalMin(vmin);
+        maxIndex = horizontalMax(vmax);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        uint32_t index = static_cast<uint32_t>(src[i]);
+        minIndex = std::min(minIndex, index);
+        maxIndex = std::max(maxIndex, index);
+    }
+}
+
+//
+// Splitting
+//
+
+IndexRanges unity2vsg::split16BitIndexRanges(const int32_t* src, size_t count)
+{
+    IndexRanges ranges;
+
+    uint32_t rangeStart = 0;
+    uint32_t rangeMin = UINT32_MAX;
+    uint32_t rangeMax = 0;
+
+    for (size_t i = 0; i < count; i += 3)
+    {
+        size_t end = std::min(i + 3, count);
+
+        uint32_t triMin = UINT32_MAX;
+        uint32_t triMax = 0;
+        for (size_t j = i; j < end; ++j)
+        {
+            triMin = std::min(triMin, static_cast<uint32_t>(src[j]));
+            triMax = std::max(triMax, static_cast<uint32_t>(src[j]));
+        }
+
+        // a single triangle that can't be addressed with 16 bits, no split possible
+        if (triMax - triMin > MAX_16BIT_INDEX) return IndexRanges();
+
+        uint32_t newMin = std::min(rangeMin, triMin);
+        uint32_t newMax = std::max(rangeMax, triMax);
+        if (newMax - newMin > MAX_16BIT_INDEX)
+        {
+            ranges.push_back({rangeStart, static_cast<uint32_t>(i) - rangeStart, static_cast<int32_t>(rangeMin)});
+            rangeStart = static_cast<uint32_t>(i);
+            newMin = triMin;
+            newMax = triMax;
+        }
+        rangeMin = newMin;
+        rangeMax = newMax;
+    }
+
+    if (count > rangeStart)
+    {
+        ranges.push_back({rangeStart, static_cast<uint32_t>(count) - rangeStart, static_cast<int32_t>(rangeMin)});
+    }
+    return ranges;
+}
+
+bool unity2vsg::isSplitProfitable(const IndexRanges& ranges, size_t indexCount)
+{
+    // each extra draw costs a little cpu and gpu time so only split when the draws stay large and few
+    const size_t maxRanges = 16;
+    const size_t minIndicesPerRange = 3 * 4096;
+
+    if (ranges.empty() || ranges.size() > maxRanges) return false;
+    return indexCount / ranges.size() >= minIndicesPerRange;
+}
+
+bool unity2vsg::readIndices(const vsg::Data* data, uint32_t firstIndex, uint32_t indexCount, std::vector<uint32_t>& indices)
+{
+    if (static_cast<size_t>(firstIndex) + indexCount > data->valueCount()) return false;
+
+    indices.resize(indexCount);
+    if (data->valueSize() == sizeof(uint16_t))
+    {
+        const uint16_t* src = static_cast<const uint16_t*>(data->dataPointer()) + firstIndex;
+        std::copy(src, src + indexCount, indices.begin());
+        return true;
+    }
+    if (data->valueSize() == sizeof(uint32_t))
+    {
+        const uint32_t* src = static_cast<const uint32_t*>(data->dataPointer()) + firstIndex;
+        std::copy(src, src + indexCount, indices.begin());
+        return true;
+    }
+    return false;
+}
+
+void unity2vsg::writeIndices(vsg::Data* data, uint32_t firstIndex, const std::vector<uint32_t>& indices)
+{
+    if (data->valueSize() == sizeof(uint16_t))
+    {
+        uint16_t* dst = static_cast<uint16_t*>(data->dataPointer()) + firstIndex;
+        for (size_t i = 0; i < indices.size(); ++i) dst[i] = static_cast<uint16_t>(indices[i]);
+    }
+    else
+    {
+        uint32_t* dst = static_cast<uint32_t*>(data->dataPointer()) + firstIndex;
+        std::copy(indices.begin(), indices.end(), dst);
+    }
+}
@@ -0,0 +1,324 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Instancing.h>
+
+#include <unity2vsg/DebugLog.h>
+#include <unity2vsg/MatrixUtils.h>
+#include <unity2vsg/ShaderUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace unity2vsg;
+
+namespace
+{
+    vsg::vec3 cross(const vsg::vec3& a, const vsg::vec3& b) { return vsg::vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+
+    // inverse of the upper 3x3, false if it's singular
+    bool invertBasis(const vsg::mat4& m, vsg::mat4& inverse)
+    {
+        vsg::vec3 a(m[0][0], m[0][1], m[0][2]), b(m[1][0], m[1][1], m[1][2]), c(m[2][0], m[2][1], m[2][2]);
+        vsg::vec3 rows[3] = {cross(b, c), cross(c, a), cross(a, b)};
+        float determinant = a.x * rows[0].x + a.y * rows[0].y + a.z * rows[0].z;
+        if (std::abs(determinant) < 1e-12f) return false;
+
+        inverse = identityMatrix();
+        for (int col = 0; col < 3; ++col)
+        {
+            for (int row = 0; row < 3; ++row) inverse[col][row] = rows[row][col] / determinant;
+        }
+        return true;
+    }
+
+    bool sameBasis(const vsg::mat4& lhs, const vsg::mat4& rhs)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                if (std::abs(lhs[c][r] - rhs[c][r]) > 1e-5f * std::max(1.0f, std::abs(lhs[c][r]))) return false;
+            }
+        }
+        return true;
+    }
+
+    // the positions drawn by a VertexIndexDraw or a Commands binding its own vertex buffers
+    const vsg::vec3Array* meshPositions(vsg::Node* mesh)
+    {
+        if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(mesh))
+        {
+            return vid->_arrays.empty() ? nullptr : dynamic_cast<const vsg::vec3Array*>(vid->_arrays[0].get());
+        }
+        if (auto commands = dynamic_cast<vsg::Commands*>(mesh))
+        {
+            for (auto& command : commands->getChildren())
+            {
+                auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get());
+                if (bvb && !bvb->getArrays().empty()) return dynamic_cast<const vsg::vec3Array*>(bvb->getArrays()[0].get());
+            }
+        }
+        return nullptr;
+    }
+} // namespace
+
+bool InstancingVisitor::Key::operator<(const Key& rhs) const
+{
+    if (mesh != rhs.mesh) return mesh < rhs.mesh;
+    if (pipeline != rhs.pipeline) return pipeline < rhs.pipeline;
+    return descriptorSet < rhs.descriptorSet;
+}
+
+InstancingVisitor::InstancingVisitor(size_t minInstances) :
+    _minInstances(std::max<size_t>(minInstances, 2)),
+    _instancedMeshCount(0),
+    _instanceCount(0)
+{
+    _matrixStack.push_back(identityMatrix());
+}
+
+void InstancingVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void InstancingVisitor::apply(vsg::Group& group)
+{
+    for (auto& child : group.getChildren())
+    {
+        auto stategroup = dynamic_cast<vsg::StateGroup*>(child.get());
+        if (stategroup && addInstance(group, *stategroup)) continue;
+        child->accept(*this);
+    }
+}
+
+void InstancingVisitor::apply(vsg::MatrixTransform& transform)
+{
+    _matrixStack.push_back(multiply(_matrixStack.back(), transform.getMatrix()));
+    apply(static_cast<vsg::Group&>(transform));
+    _matrixStack.pop_back();
+}
+
+void InstancingVisitor::apply(vsg::LOD& /*lod*/)
+{
+    // instances of different levels would all be drawn at once
+}
+
+void InstancingVisitor::collect(vsg::Group& root)
+{
+    _root = &root;
+    apply(root);
+}
+
+bool InstancingVisitor::addInstance(vsg::Group& parent, vsg::StateGroup& stategroup)
+{
+    if (_collected.count(&stategroup) > 0) return true;
+
+    Key key;
+    key.mesh = nullptr;
+    key.pipeline = nullptr;
+    key.descriptorSet = nullptr;
+
+    for (auto& command : stategroup.getStateCommands())
+    {
+        auto pipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(command.get());
+        if (pipeline && !key.pipeline)
+            key.pipeline = pipeline;
+        else if (dynamic_cast<vsg::BindDescriptorSet*>(command.get()) && !key.descriptorSet)
+            key.descriptorSet = command.get();
+        else
+            return false;
+    }
+    if (!key.pipeline || stategroup.getChildren().size() != 1) return false;
+
+    // single draws of a mesh, meshes are shared between the renderers using them so the node identifies the mesh
+    vsg::Node* mesh = stategroup.getChildren()[0].get();
+    if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(mesh))
+    {
+        if (vid->instanceCount != 1) return false;
+    }
+    else if (auto commands = dynamic_cast<vsg::Commands*>(mesh))
+    {
+        for (auto& command : commands->getChildren())
+        {
+            auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get());
+            if (drawIndexed && drawIndexed->instanceCount != 1) return false;
+            if (!drawIndexed && !dynamic_cast<vsg::BindVertexBuffers*>(command.get()) && !dynamic_cast<vsg::BindIndexBuffer*>(command.get()) &&
+                !dynamic_cast<vsg::BindDescriptorSet*>(command.get()))
+            {
+                return false;
+            }
+        }
+    }
+    else
+    {
+        return false;
+    }
+    if (!meshPositions(mesh)) return false;
+    key.mesh = mesh;
+
+    auto itr = _instances.find(key);
+    if (itr == _instances.end())
+    {
+        itr = _instances.insert({key, {}}).first;
+        _keys.push_back(key);
+    }
+    itr->second.push_back(Instance{vsg::ref_ptr<vsg::Group>(&parent), vsg::ref_ptr<vsg::StateGroup>(&stategroup), _matrixStack.back()});
+    _collected.insert(&stategroup);
+    return true;
+}
+
+void InstancingVisitor::instance(CreateInstancedPipeline createPipeline)
+{
+    for (auto& key : _keys)
+    {
+        auto& instances = _instances[key];
+        if (instances.size() < _minInstances) continue;
+
+        // a shared rotation and scale can sit in a transform above the draw leaving just a translation per instance
+        vsg::mat4 basis = instances[0].matrix;
+        basis[3] = vsg::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        vsg::mat4 inverseBasis;
+        bool translateOnly = invertBasis(basis, inverseBasis);
+        for (auto& instance : instances)
+        {
+            translateOnly = translateOnly && sameBasis(basis, instance.matrix);
+        }
+
+        uint32_t attribute = translateOnly ? TRANSLATE : INSTANCE_MATRIX;
+        vsg::ref_ptr<vsg::BindGraphicsPipeline> pipeline = createPipeline(key.pipeline, attribute);
+        if (!pipeline) continue;
+
+        vsg::ref_ptr<vsg::Data> instanceArray;
+        if (translateOnly)
+        {
+            auto translations = vsg::vec3Array::create(instances.size());
+            for (size_t i = 0; i < instances.size(); ++i)
+            {
+                const vsg::vec4& t = instances[i].matrix[3];
+                (*translations)[i] = transformVector(inverseBasis, vsg::vec3(t.x, t.y, t.z));
+            }
+            instanceArray = translations;
+        }
+        else
+        {
+            auto matrices = vsg::mat4Array::create(instances.size());
+            for (size_t i = 0; i < instances.size(); ++i) (*matrices)[i] = instances[i].matrix;
+            instanceArray = matrices;
+        }
+
+        // bound every instance of the meshes box in the roots space
+        const vsg::vec3Array* positions = meshPositions(const_cast<vsg::Node*>(key.mesh));
+        vsg::vec3 localMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        vsg::vec3 localMax(-localMin.x, -localMin.y, -localMin.z);
+        const vsg::vec3* vertices = static_cast<const vsg::vec3*>(positions->dataPointer());
+        for (size_t v = 0; v < positions->valueCount(); ++v)
+        {
+            const vsg::vec3& p = vertices[v];
+            localMin = vsg::vec3(std::min(localMin.x, p.x), std::min(localMin.y, p.y), std::min(localMin.z, p.z));
+            localMax = vsg::vec3(std::max(localMax.x, p.x), std::max(localMax.y, p.y), std::max(localMax.z, p.z));
+        }
+
+        vsg::vec3 minimum(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        vsg::vec3 maximum(-minimum.x, -minimum.y, -minimum.z);
+        for (auto& instance : instances)
+        {
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                vsg::vec3 p = transformPoint(instance.matrix, vsg::vec3((corner & 1) ? localMax.x : localMin.x, (corner & 2) ? localMax.y : localMin.y, (corner & 4) ? localMax.z : localMin.z));
+                minimum = vsg::vec3(std::min(minimum.x, p.x), std::min(minimum.y, p.y), std::min(minimum.z, p.z));
+                maximum = vsg::vec3(std::max(maximum.x, p.x), std::max(maximum.y, p.y), std::max(maximum.z, p.z));
+            }
+        }
+
+        // the instanced pipeline replaces the original, any descriptor set is kept
+        auto stategroup = vsg::StateGroup::create();
+        stategroup->add(pipeline);
+        for (auto& command : instances[0].stategroup->getStateCommands())
+        {
+            if (command.get() != key.pipeline) stategroup->add(command);
+        }
+        stategroup->addChild(createInstancedMesh(const_cast<vsg::Node*>(key.mesh), instanceArray, static_cast<uint32_t>(instances.size())));
+
+        vsg::vec3 center((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+        vsg::vec3 extent(maximum.x - center.x, maximum.y - center.y, maximum.z - center.z);
+        auto cullGroup = vsg::CullGroup::create(vsg::sphere(center, std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z)));
+        if (translateOnly && !isIdentity(basis))
+        {
+            auto transform = vsg::MatrixTransform::create(basis);
+            transform->addChild(stategroup);
+            cullGroup->addChild(transform);
+        }
+        else
+        {
+            cullGroup->addChild(stategroup);
+        }
+        _root->addChild(cullGroup);
+
+        for (auto& instance : instances)
+        {
+            auto& children = instance.parent->getChildren();
+            auto itr = std::find_if(children.begin(), children.end(), [&instance](const vsg::ref_ptr<vsg::Node>& child) { return child.get() == instance.stategroup.get(); });
+            if (itr != children.end()) children.erase(itr);
+        }
+
+        _instanceArrays[instanceArray.get()] = attribute;
+        _instancedMeshCount++;
+        _instanceCount += instances.size();
+    }
+
+    _keys.clear();
+    _instances.clear();
+    _collected.clear();
+}
+
+vsg::ref_ptr<vsg::Node> InstancingVisitor::createInstancedMesh(vsg::Node* mesh, vsg::ref_ptr<vsg::Data> instanceArray, uint32_t instanceCount)
+{
+    // the per instance array is bound after the vertex arrays, matching the pipelines instance rate binding
+    if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(mesh))
+    {
+        auto instanced = vsg::VertexIndexDraw::create();
+        instanced->_arrays = vid->_arrays;
+        instanced->_arrays.push_back(instanceArray);
+        instanced->_indices = vid->_indices;
+        instanced->indexCount = vid->indexCount;
+        instanced->instanceCount = instanceCount;
+        instanced->firstIndex = vid->firstIndex;
+        instanced->vertexOffset = vid->vertexOffset;
+        instanced->firstInstance = 0;
+        return instanced;
+    }
+
+    auto commands = dynamic_cast<vsg::Commands*>(mesh);
+    auto instanced = vsg::Commands::create();
+    for (auto& command : commands->getChildren())
+    {
+        if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+        {
+            vsg::DataList arrays = bvb->getArrays();
+            arrays.push_back(instanceArray);
+            instanced->addChild(vsg::BindVertexBuffers::create(bvb->getFirstBinding(), arrays));
+        }
+        else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+        {
+            instanced->addChild(vsg::DrawIndexed::create(drawIndexed->indexCount, instanceCount, drawIndexed->firstIndex, drawIndexed->vertexOffset, 0));
+        }
+        else
+        {
+            instanced->addChild(command);
+        }
+    }
+    return instanced;
+}
@@ -0,0 +1,488 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/MeshOptimizer.h>
+
+#include <unity2vsg/DebugLog.h>
+#include <unity2vsg/IndexUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <map>
+
+using namespace unity2vsg;
+
+namespace
+{
+    template<class T>
+    vsg::ref_ptr<vsg::Data> createArrayLike(const vsg::Data* array, size_t count)
+    {
+        if (dynamic_cast<const T*>(array) == nullptr) return vsg::ref_ptr<vsg::Data>();
+        return vsg::ref_ptr<vsg::Data>(new T(count));
+    }
+} // namespace
+
+VertexCacheStats unity2vsg::analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    stats.triangles = indexCount / 3;
+
+    // a vertex is in the fifo if it was one of the last cacheSize vertices added
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t v = indices[i];
+        if (v >= vertexCount) continue;
+
+        if (timestamps[v] == 0) stats.vertices++;
+        if (time - timestamps[v] > cacheSize)
+        {
+            timestamps[v] = time++;
+            stats.misses++;
+        }
+    }
+    return stats;
+}
+
+// Sander, Nehab and Barczak, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007
+std::vector<uint32_t> unity2vsg::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    std::vector<uint32_t> clusters;
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return clusters;
+
+    // triangles using each vertex
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) live[indices[i]]++;
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    // when fanning stalls go back to recently used vertices with triangles left, then on through the input order
+    size_t cursor = 0;
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnd.empty())
+        {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) return v;
+        }
+        while (cursor < vertexCount)
+        {
+            if (live[cursor] > 0) return static_cast<int64_t>(cursor++);
+            ++cursor;
+        }
+        return -1;
+    };
+
+    int64_t fan = skipDeadEnd();
+    if (fan >= 0) clusters.push_back(0);
+
+    while (fan >= 0)
+    {
+        candidates.clear();
+
+        for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; ++a)
+        {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                uint32_t v = indices[t * 3 + c];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - timestamps[v] > cacheSize) timestamps[v] = time++;
+            }
+            emitted[t] = 1;
+        }
+
+        // fan around the candidate that will still be in the cache once all its triangles are emitted, preferring the oldest
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates)
+        {
+            if (live[v] == 0) continue;
+
+            int64_t priority = 0;
+            if (time - timestamps[v] + 2 * live[v] <= cacheSize) priority = time - timestamps[v];
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        if (next < 0)
+        {
+            next = skipDeadEnd();
+            if (next >= 0) clusters.push_back(static_cast<uint32_t>(result.size() / 3));
+        }
+        fan = next;
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+    return clusters;
+}
+
+void unity2vsg::optimizeOverdraw(uint32_t* indices, size_t indexCount, const vsg::vec3* positions, size_t vertexCount, const std::vector<uint32_t>& clusters)
+{
+    size_t triangleCount = indexCount / 3;
+    if (clusters.size() < 2 || triangleCount == 0) return;
+
+    struct Cluster
+    {
+        uint32_t first;
+        uint32_t end;
+        float centroid[3];
+        float normal[3];
+        float area;
+        float sortKey;
+    };
+
+    std::vector<Cluster> sorted(clusters.size());
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        Cluster& cluster = sorted[c];
+        cluster = {};
+        cluster.first = clusters[c];
+        cluster.end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+
+        // area weighted centroid, the unnormalized cross products sum to the area weighted normal
+        for (uint32_t t = cluster.first; t < cluster.end; ++t)
+        {
+            uint32_t i0 = indices[t * 3], i1 = indices[t * 3 + 1], i2 = indices[t * 3 + 2];
+            if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) continue;
+
+            const vsg::vec3& p0 = positions[i0];
+            const vsg::vec3& p1 = positions[i1];
+            const vsg::vec3& p2 = positions[i2];
+
+            float e1[3] = {p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+            float e2[3] = {p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+            float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                float center = ((&p0.x)[k] + (&p1.x)[k] + (&p2.x)[k]) / 3.0f;
+                cluster.centroid[k] += center * area;
+                cluster.normal[k] += n[k];
+            }
+            cluster.area += area;
+        }
+
+        for (int k = 0; k < 3; ++k) meshCentroid[k] += cluster.centroid[k];
+        meshArea += cluster.area;
+
+        if (cluster.area > 0.0f)
+        {
+            for (int k = 0; k < 3; ++k) cluster.centroid[k] /= cluster.area;
+        }
+    }
+
+    if (meshArea <= 0.0f) return;
+    for (int k = 0; k < 3; ++k) meshCentroid[k] /= meshArea;
+
+    // clusters facing away from the centre are likely to occlude the rest so draw them first
+    for (auto& cluster : sorted)
+    {
+        float length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+        cluster.sortKey = 0.0f;
+        if (length > 0.0f)
+        {
+            for (int k = 0; k < 3; ++k) cluster.sortKey += (cluster.centroid[k] - meshCentroid[k]) * cluster.normal[k] / length;
+        }
+    }
+
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& lhs, const Cluster& rhs) { return lhs.sortKey > rhs.sortKey; });
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    for (auto& cluster : sorted)
+    {
+        result.insert(result.end(), indices + cluster.first * 3, indices + cluster.end * 3);
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+std::vector<uint32_t> unity2vsg::optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t& usedVertexCount)
+{
+    std::vector<uint32_t> remap(vertexCount, ~0u);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t& v = indices[i];
+        if (remap[v] == ~0u) remap[v] = next++;
+        v = remap[v];
+    }
+    usedVertexCount = next;
+    return remap;
+}
+
+vsg::ref_ptr<vsg::Data> unity2vsg::remapVertexArray(const vsg::Data* array, const std::vector<uint32_t>& remap, size_t usedVertexCount)
+{
+    if (array->valueCount() != remap.size()) return vsg::ref_ptr<vsg::Data>();
+
+    vsg::ref_ptr<vsg::Data> result = createArrayLike<vsg::vec3Array>(array, usedVertexCount);
+    if (!result) result = createArrayLike<vsg::vec4Array>(array, usedVertexCount);
+    if (!result) result = createArrayLike<vsg::vec2Array>(array, usedVertexCount);
+    if (!result) return result;
+
+    const uint8_t* src = static_cast<const uint8_t*>(array->dataPointer());
+    uint8_t* dst = static_cast<uint8_t*>(result->dataPointer());
+    size_t valueSize = array->valueSize();
+    for (size_t v = 0; v < remap.size(); ++v)
+    {
+        if (remap[v] != ~0u) std::memcpy(dst + remap[v] * valueSize, src + v * valueSize, valueSize);
+    }
+    return result;
+}
+
+//
+// MeshOptimizeVisitor
+//
+
+MeshOptimizeVisitor::MeshOptimizeVisitor(bool overdraw) :
+    _overdraw(overdraw),
+    _optimizedCount(0),
+    _remappedCount(0),
+    _overlappingCount(0)
+{
+}
+
+void MeshOptimizeVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void MeshOptimizeVisitor::apply(vsg::StateGroup& stategroup)
+{
+    vsg::DataList previousArrays = _boundVertexArrays;
+    vsg::ref_ptr<vsg::Data> previousIndices = _boundIndices;
+
+    for (auto& command : stategroup.getStateCommands())
+    {
+        if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+        {
+            _boundVertexArrays = bvb->getArrays();
+            for (auto& array : _boundVertexArrays) _boundArrays.insert(array.get());
+        }
+        else if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+        {
+            _boundIndices = bib->getIndices();
+        }
+    }
+
+    stategroup.traverse(*this);
+
+    _boundVertexArrays = previousArrays;
+    _boundIndices = previousIndices;
+}
+
+void MeshOptimizeVisitor::apply(vsg::Commands& commands)
+{
+    vsg::DataList arrays = _boundVertexArrays;
+    vsg::ref_ptr<vsg::Data> indices = _boundIndices;
+
+    for (auto& command : commands.getChildren())
+    {
+        if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+        {
+            arrays = bvb->getArrays();
+            for (auto& array : arrays) _boundArrays.insert(array.get());
+        }
+        else if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+        {
+            indices = bib->getIndices();
+        }
+        else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+        {
+            addRange(arrays, indices, drawIndexed->firstIndex, drawIndexed->indexCount, drawIndexed->vertexOffset);
+        }
+    }
+}
+
+void MeshOptimizeVisitor::apply(vsg::VertexIndexDraw& vid)
+{
+    addRange(vid._arrays, vid._indices, vid.firstIndex, vid.indexCount, vid.vertexOffset);
+    _vertexIndexDraws.push_back(vsg::ref_ptr<vsg::VertexIndexDraw>(&vid));
+}
+
+void MeshOptimizeVisitor::addRange(const vsg::DataList& arrays, vsg::ref_ptr<vsg::Data> indices, uint32_t firstIndex, uint32_t indexCount, int32_t vertexOffset)
+{
+    if (!indices.valid() || arrays.empty() || indexCount < 3) return;
+    _ranges.insert(DrawRange{indices, arrays[0], firstIndex, indexCount, vertexOffset});
+}
+
+void MeshOptimizeVisitor::optimizeRange(const DrawRange& range, bool overdraw)
+{
+    std::vector<uint32_t> indices;
+    if (!readIndices(range.indices.get(), range.firstIndex, range.indexCount, indices)) return;
+
+    uint32_t maxIndex = *std::max_element(indices.begin(), indices.end());
+    size_t vertexCount = static_cast<size_t>(maxIndex) + 1;
+
+    _before.add(analyzeVertexCache(indices.data(), indices.size(), vertexCount));
+
+    std::vector<uint32_t> clusters = optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+
+    // overdraw needs the positions each index refers to after the draws vertex offset is applied
+    const vsg::vec3Array* positions = dynamic_cast<const vsg::vec3Array*>(range.positions.get());
+    if (overdraw && positions && range.vertexOffset >= 0 && static_cast<size_t>(range.vertexOffset) < positions->valueCount())
+    {
+        const vsg::vec3* first = static_cast<const vsg::vec3*>(positions->dataPointer()) + range.vertexOffset;
+        optimizeOverdraw(indices.data(), indices.size(), first, positions->valueCount() - range.vertexOffset, clusters);
+    }
+
+    _after.add(analyzeVertexCache(indices.data(), indices.size(), vertexCount));
+
+    writeIndices(range.indices.get(), range.firstIndex, indices);
+    _optimizedCount++;
+}
+
+void MeshOptimizeVisitor::remapVertexIndexDraws()
+{
+    // an array can only be reordered if every draw using it does so with the same index buffer
+    std::map<const vsg::Data*, std::set<const vsg::Data*>> arrayIndices;
+    std::map<const vsg::Data*, std::set<std::vector<const vsg::Data*>>> indicesArrays;
+    for (auto& vid : _vertexIndexDraws)
+    {
+        std::vector<const vsg::Data*> arrays;
+        for (auto& array : vid->_arrays)
+        {
+            arrayIndices[array.get()].insert(vid->_indices.get());
+            arrays.push_back(array.get());
+        }
+        indicesArrays[vid->_indices.get()].insert(arrays);
+    }
+
+    struct Remapped
+    {
+        vsg::DataList arrays;
+        vsg::ref_ptr<vsg::Data> indices;
+    };
+    std::map<const vsg::Data*, Remapped> remapped;
+
+    for (auto& vid : _vertexIndexDraws)
+    {
+        if (!vid->_indices.valid() || vid->_arrays.empty()) continue;
+
+        auto itr = remapped.find(vid->_indices.get());
+        if (itr == remapped.end())
+        {
+            bool exclusive = indicesArrays[vid->_indices.get()].size() == 1 && vid->firstIndex == 0 && vid->vertexOffset == 0 &&
+                             vid->indexCount == vid->_indices->valueCount();
+            for (auto& array : vid->_arrays)
+            {
+                exclusive = exclusive && arrayIndices[array.get()].size() == 1 && _boundArrays.count(array.get()) == 0;
+            }
+            if (!exclusive) continue;
+
+            std::vector<uint32_t> indices;
+            if (!readIndices(vid->_indices.get(), 0, vid->indexCount, indices)) continue;
+
+            size_t vertexCount = vid->_arrays[0]->valueCount();
+            if (*std::max_element(indices.begin(), indices.end()) >= vertexCount) continue;
+
+            size_t usedVertexCount = 0;
+            std::vector<uint32_t> remap = optimizeVertexFetch(indices.data(), indices.size(), vertexCount, usedVertexCount);
+
+            Remapped result;
+            for (auto& array : vid->_arrays)
+            {
+                vsg::ref_ptr<vsg::Data> remappedArray = remapVertexArray(array.get(), remap, usedVertexCount);
+                if (!remappedArray) break;
+                result.arrays.push_back(remappedArray);
+            }
+            if (result.arrays.size() != vid->_arrays.size()) continue;
+
+            for (size_t i = 0; i < result.arrays.size(); ++i)
+            {
+                _remappedArrays[result.arrays[i].get()] = vid->_arrays[i].get();
+            }
+
+            // the original indices may be shared with other meshes with the same topology so write to a copy
+            if (vid->_indices->valueSize() == sizeof(uint16_t))
+                result.indices = new vsg::ushortArray(indices.size());
+            else
+                result.indices = new vsg::uintArray(indices.size());
+            writeIndices(result.indices.get(), 0, indices);
+
+            itr = remapped.emplace(vid->_indices.get(), result).first;
+            _remappedCount++;
+        }
+
+        vid->_arrays = itr->second.arrays;
+        vid->_indices = itr->second.indices;
+    }
+}
+
+void MeshOptimizeVisitor::optimize()
+{
+    // the ranges are written in place, so each run of identical ranges is optimized once and only if no other range
+    // of the buffer overlaps it, otherwise reordering one would change the triangles the other draws
+    uint32_t coveredEnd = 0;
+    for (auto itr = _ranges.begin(); itr != _ranges.end();)
+    {
+        bool firstOfBuffer = itr == _ranges.begin() || std::prev(itr)->indices.get() != itr->indices.get();
+        if (firstOfBuffer) coveredEnd = 0;
+
+        bool samePositions = true;
+        auto end = std::next(itr);
+        for (; end != _ranges.end() && end->sameIndices(*itr); ++end)
+        {
+            samePositions = samePositions && end->positions.get() == itr->positions.get() && end->vertexOffset == itr->vertexOffset;
+        }
+
+        bool overlapped = itr->firstIndex < coveredEnd || (end != _ranges.end() && end->indices.get() == itr->indices.get() && end->firstIndex < itr->endIndex());
+        coveredEnd = std::max(coveredEnd, itr->endIndex());
+
+        if (overlapped)
+        {
+            _overlappingCount++;
+        }
+        else
+        {
+            // overdraw order depends on the positions, meshes sharing the indices with different positions only get the cache order
+            optimizeRange(*itr, _overdraw && samePositions);
+        }
+        itr = end;
+    }
+
+    remapVertexIndexDraws();
+
+    _ranges.clear();
+    _vertexIndexDraws.clear();
+}
@@ -0,0 +1,648 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/MeshSimplifier.h>
+
+#include <unity2vsg/DebugLog.h>
+#include <unity2vsg/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace unity2vsg;
+
+namespace
+{
+    const uint32_t NONE = ~0u;
+
+    enum VertexKind : uint8_t
+    {
+        KIND_MANIFOLD,
+        KIND_BORDER,
+        KIND_SEAM,
+        KIND_LOCKED
+    };
+
+    // which kinds a vertex can collapse onto, only manifold vertices move freely
+    const bool CAN_COLLAPSE[4][4] = {
+        {true, true, true, true},
+        {false, true, false, false},
+        {false, false, true, false},
+        {false, false, false, false}};
+
+    // open border and seam edges are held in place by a plane perpendicular to the surface through the edge
+    const double EDGE_WEIGHT = 10.0;
+
+    struct Quadric
+    {
+        double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+        double a10 = 0.0, a20 = 0.0, a21 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        void addPlane(double nx, double ny, double nz, double d, double w)
+        {
+            a00 += w * nx * nx;
+            a11 += w * ny * ny;
+            a22 += w * nz * nz;
+            a10 += w * ny * nx;
+            a20 += w * nz * nx;
+            a21 += w * nz * ny;
+            b0 += w * nx * d;
+            b1 += w * ny * d;
+            b2 += w * nz * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        void add(const Quadric& q)
+        {
+            a00 += q.a00;
+            a11 += q.a11;
+            a22 += q.a22;
+            a10 += q.a10;
+            a20 += q.a20;
+            a21 += q.a21;
+            b0 += q.b0;
+            b1 += q.b1;
+            b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+        }
+
+        // weighted mean squared distance of p from the planes
+        double error(const vsg::vec3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double rx = a00 * x + a10 * y + a20 * z;
+            double ry = a10 * x + a11 * y + a21 * z;
+            double rz = a20 * x + a21 * y + a22 * z;
+            double r = rx * x + ry * y + rz * z + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return weight > 0.0 ? std::abs(r) / weight : 0.0;
+        }
+    };
+
+    vsg::vec3 sub(const vsg::vec3& a, const vsg::vec3& b) { return vsg::vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+    vsg::vec3 cross(const vsg::vec3& a, const vsg::vec3& b) { return vsg::vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+    float dot(const vsg::vec3& a, const vsg::vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    struct PositionKey
+    {
+        uint32_t bits[3];
+        bool operator==(const PositionKey& rhs) const { return bits[0] == rhs.bits[0] && bits[1] == rhs.bits[1] && bits[2] == rhs.bits[2]; }
+    };
+
+    struct PositionKeyHash
+    {
+        size_t operator()(const PositionKey& key) const
+        {
+            return (static_cast<size_t>(key.bits[0]) * 73856093u) ^ (static_cast<size_t>(key.bits[1]) * 19349663u) ^ (static_cast<size_t>(key.bits[2]) * 83492791u);
+        }
+    };
+
+    uint64_t edgeKey(uint32_t a, uint32_t b) { return (static_cast<uint64_t>(a) << 32) | b; }
+
+    bool hasLoop(const std::vector<uint32_t>& loop, uint32_t v) { return loop[v] != NONE && loop[v] != v; }
+
+    struct Collapse
+    {
+        uint32_t v0;
+        uint32_t v1;
+        double error;
+    };
+} // namespace
+
+std::vector<uint32_t> unity2vsg::simplifyMesh(const uint32_t* indices, size_t indexCount, const vsg::vec3* positions, size_t vertexCount, size_t targetIndexCount,
+                                              float maxError, float* resultError)
+{
+    if (resultError) *resultError = 0.0f;
+
+    // drop degenerate and out of range triangles up front
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount) continue;
+        if (a == b || b == c || c == a) continue;
+        result.insert(result.end(), {a, b, c});
+    }
+    if (result.size() <= targetIndexCount) return result;
+
+    // work in a unit box so errors are relative to the mesh size
+    vsg::vec3 minimum = positions[result[0]];
+    vsg::vec3 maximum = minimum;
+    for (uint32_t v : result)
+    {
+        const vsg::vec3& p = positions[v];
+        minimum = vsg::vec3(std::min(minimum.x, p.x), std::min(minimum.y, p.y), std::min(minimum.z, p.z));
+        maximum = vsg::vec3(std::max(maximum.x, p.x), std::max(maximum.y, p.y), std::max(maximum.z, p.z));
+    }
+    float extent = std::max(maximum.x - minimum.x, std::max(maximum.y - minimum.y, maximum.z - minimum.z));
+    if (extent <= 0.0f) return result;
+
+    std::vector<vsg::vec3> points(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        vsg::vec3 p = sub(positions[v], minimum);
+        points[v] = vsg::vec3(p.x / extent, p.y / extent, p.z / extent);
+    }
+
+    // vertices at the same position, remap points at the first and wedge links them in a circular list
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint32_t> wedge(vertexCount);
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firsts;
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            PositionKey key;
+            std::memcpy(key.bits, &positions[v], sizeof(key.bits));
+
+            auto itr = firsts.find(key);
+            if (itr == firsts.end())
+            {
+                firsts[key] = v;
+                remap[v] = v;
+                wedge[v] = v;
+            }
+            else
+            {
+                uint32_t first = itr->second;
+                remap[v] = first;
+                wedge[v] = wedge[first];
+                wedge[first] = v;
+            }
+        }
+    }
+
+    // edges without a twin in the attribute topology, loop follows them forwards and loopback backwards, a vertex on
+    // more than one open edge in the same direction links to itself
+    std::vector<uint32_t> loop(vertexCount, NONE);
+    std::vector<uint32_t> loopback(vertexCount, NONE);
+    std::unordered_set<uint64_t> edges;
+    edges.reserve(result.size());
+    {
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int e = 0; e < 3; ++e) edges.insert(edgeKey(result[i + e], result[i + (e + 1) % 3]));
+        }
+
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+                if (edges.count(edgeKey(b, a)) > 0) continue;
+
+                loop[a] = loop[a] == NONE ? b : a;
+                loopback[b] = loopback[b] == NONE ? a : b;
+            }
+        }
+    }
+
+    // classify each position, all its wedges share the kind
+    std::vector<uint8_t> kind(vertexCount, KIND_MANIFOLD);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] != v) continue;
+
+        auto isOpen = [&](uint32_t w) { return loop[w] != NONE || loopback[w] != NONE; };
+        auto isChain = [&](uint32_t w) { return hasLoop(loop, w) && hasLoop(loopback, w); };
+
+        uint8_t k = KIND_LOCKED;
+        uint32_t w = wedge[v];
+        if (w == v)
+        {
+            k = !isOpen(v) ? KIND_MANIFOLD : isChain(v) ? KIND_BORDER : KIND_LOCKED;
+        }
+        else if (wedge[w] == v)
+        {
+            // two wedges whose open edges mirror each other are either side of an attribute seam
+            if (isChain(v) && isChain(w) && remap[loop[v]] == remap[loopback[w]] && remap[loopback[v]] == remap[loop[w]]) k = KIND_SEAM;
+        }
+
+        uint32_t i = v;
+        do
+        {
+            kind[i] = k;
+            i = wedge[i];
+        } while (i != v);
+    }
+
+    // plane quadrics per position weighted by triangle area, plus edge planes for borders and seams
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const vsg::vec3& p0 = points[result[i]];
+        const vsg::vec3& p1 = points[result[i + 1]];
+        const vsg::vec3& p2 = points[result[i + 2]];
+
+        vsg::vec3 n = cross(sub(p1, p0), sub(p2, p0));
+        float length = std::sqrt(dot(n, n));
+        if (length <= 0.0f) continue;
+        n = vsg::vec3(n.x / length, n.y / length, n.z / length);
+
+        double d = -dot(n, p0);
+        for (int c = 0; c < 3; ++c) quadrics[remap[result[i + c]]].addPlane(n.x, n.y, n.z, d, length * 0.5);
+
+        for (int e = 0; e < 3; ++e)
+        {
+            uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+            if (edges.count(edgeKey(b, a)) > 0) continue;
+
+            vsg::vec3 edge = sub(points[b], points[a]);
+            vsg::vec3 en = cross(edge, n);
+            float enLength = std::sqrt(dot(en, en));
+            if (enLength <= 0.0f) continue;
+            en = vsg::vec3(en.x / enLength, en.y / enLength, en.z / enLength);
+
+            double ed = -dot(en, points[a]);
+            double weight = dot(edge, edge) * EDGE_WEIGHT;
+            quadrics[remap[a]].addPlane(en.x, en.y, en.z, ed, weight);
+            quadrics[remap[b]].addPlane(en.x, en.y, en.z, ed, weight);
+        }
+    }
+
+    std::vector<uint32_t> collapseRemap(vertexCount);
+    std::vector<uint8_t> collapseLocked(vertexCount);
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    double errorLimit = static_cast<double>(maxError) * static_cast<double>(maxError);
+    double currentError = 0.0;
+
+    // would moving position r0 onto v1 turn any remaining triangle around r0 over
+    auto hasTriangleFlips = [&](uint32_t r0, uint32_t v1) {
+        const vsg::vec3& target = points[v1];
+        for (uint32_t a = offsets[r0]; a < offsets[r0 + 1]; ++a)
+        {
+            const uint32_t* tri = &result[adjacency[a] * 3];
+            uint32_t t0 = collapseRemap[tri[0]], t1 = collapseRemap[tri[1]], t2 = collapseRemap[tri[2]];
+            if (remap[t0] == remap[v1] || remap[t1] == remap[v1] || remap[t2] == remap[v1]) continue;
+
+            vsg::vec3 q0 = remap[t0] == r0 ? target : points[t0];
+            vsg::vec3 q1 = remap[t1] == r0 ? target : points[t1];
+            vsg::vec3 q2 = remap[t2] == r0 ? target : points[t2];
+
+            vsg::vec3 before = cross(sub(points[t1], points[t0]), sub(points[t2], points[t0]));
+            vsg::vec3 after = cross(sub(q1, q0), sub(q2, q0));
+            if (dot(before, after) <= 0.0f) return true;
+        }
+        return false;
+    };
+
+    while (result.size() > targetIndexCount)
+    {
+        // triangles around each position
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (uint32_t v : result) offsets[remap[v] + 1]++;
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < result.size(); ++i) adjacency[fill[remap[result[i]]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // candidate collapses along every edge in both directions
+        collapses.clear();
+        auto addCollapse = [&](uint32_t v0, uint32_t v1) {
+            uint8_t k0 = kind[v0];
+            if (!CAN_COLLAPSE[k0][kind[v1]]) return;
+
+            // borders and seams can only slide along themselves, for seams the other side has to follow
+            if (k0 == KIND_BORDER || k0 == KIND_SEAM)
+            {
+                if (loop[v0] != v1 && loopback[v0] != v1) return;
+                if (k0 == KIND_SEAM)
+                {
+                    uint32_t s0 = wedge[v0];
+                    if (!hasLoop(loop, s0) || !hasLoop(loopback, s0)) return;
+                    if (remap[loop[s0]] != remap[v1] && remap[loopback[s0]] != remap[v1]) return;
+                }
+            }
+            collapses.push_back(Collapse{v0, v1, quadrics[remap[v0]].error(points[v1])});
+        };
+
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+                if (remap[a] == remap[b]) continue;
+                addCollapse(a, b);
+                addCollapse(b, a);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; });
+
+        for (uint32_t v = 0; v < vertexCount; ++v) collapseRemap[v] = v;
+        std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+
+        // take the cheapest collapses that don't touch each other until enough triangles have gone
+        size_t triangleGoal = (result.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        size_t performed = 0;
+        for (auto& collapse : collapses)
+        {
+            if (removed >= triangleGoal || collapse.error > errorLimit) break;
+
+            uint32_t r0 = remap[collapse.v0], r1 = remap[collapse.v1];
+            if (collapseLocked[r0] || collapseLocked[r1]) continue;
+            if (hasTriangleFlips(r0, collapse.v1)) continue;
+
+            collapseRemap[collapse.v0] = collapse.v1;
+            if (kind[collapse.v0] == KIND_SEAM) collapseRemap[wedge[collapse.v0]] = wedge[collapse.v1];
+
+            quadrics[r1].add(quadrics[r0]);
+            collapseLocked[r0] = 1;
+            collapseLocked[r1] = 1;
+
+            removed += kind[collapse.v0] == KIND_BORDER ? 1 : 2;
+            currentError = std::max(currentError, collapse.error);
+            performed++;
+        }
+        if (performed == 0) break;
+
+        // apply the collapses and drop the triangles that folded away
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            uint32_t a = collapseRemap[result[i]], b = collapseRemap[result[i + 1]], c = collapseRemap[result[i + 2]];
+            if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a]) continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+
+        // edge loops follow the collapsed vertices, skipping over any that collapsed onto the vertex itself
+        for (auto* loops : {&loop, &loopback})
+        {
+            std::vector<uint32_t>& l = *loops;
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                if (!hasLoop(l, v)) continue;
+                uint32_t target = collapseRemap[l[v]];
+                if (target != v)
+                    l[v] = target;
+                else if (l[l[v]] != NONE)
+                    l[v] = l[l[v]];
+            }
+        }
+    }
+
+    if (resultError) *resultError = static_cast<float>(std::sqrt(currentError));
+    return result;
+}
+
+LODGenerateVisitor::LODGenerateVisitor(float fullDetailScreenHeightRatio, const std::vector<Level>& levels, float maxError) :
+    _fullDetailScreenHeightRatio(fullDetailScreenHeightRatio),
+    _levels(levels),
+    _maxError(maxError),
+    _lodCount(0)
+{
+}
+
+void LODGenerateVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void LODGenerateVisitor::apply(vsg::Group& group)
+{
+    auto& children = group.getChildren();
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        const vsg::Node* child = children[i].get();
+        if (_meshIndices.find(child) == _meshIndices.end() && !addMesh(children[i])) continue;
+
+        _slots.push_back(Slot{vsg::ref_ptr<vsg::Group>(&group), i, _meshIndices[child]});
+    }
+
+    group.traverse(*this);
+}
+
+void LODGenerateVisitor::apply(vsg::LOD& /*lod*/)
+{
+    // levels set up by hand are left as they are
+}
+
+bool LODGenerateVisitor::addMesh(vsg::ref_ptr<vsg::Node> node)
+{
+    Mesh mesh;
+    mesh.node = node;
+
+    if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(node.get()))
+    {
+        // instanced draws spread over more space than the lod's bound of the mesh would cover
+        if (vid->_arrays.empty() || vid->instanceCount != 1) return false;
+        mesh.positions = vid->_arrays[0];
+        mesh.indices = vid->_indices;
+        mesh.ranges.push_back({vid->firstIndex, vid->indexCount, vid->vertexOffset});
+    }
+    else if (auto commands = dynamic_cast<vsg::Commands*>(node.get()))
+    {
+        // a single bound vertex and index buffer drawn by one or more DrawIndexed, as written for split meshes
+        for (auto& command : commands->getChildren())
+        {
+            if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+            {
+                if (mesh.positions.valid() || bvb->getArrays().empty()) return false;
+                mesh.positions = bvb->getArrays()[0];
+            }
+            else if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+            {
+                if (mesh.indices.valid()) return false;
+                mesh.indices = bib->getIndices();
+            }
+            else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+            {
+                if (!mesh.indices.valid() || drawIndexed->instanceCount != 1) return false;
+                mesh.ranges.push_back({drawIndexed->firstIndex, drawIndexed->indexCount, drawIndexed->vertexOffset});
+            }
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if (!mesh.indices.valid() || dynamic_cast<vsg::vec3Array*>(mesh.positions.get()) == nullptr) return false;
+
+    size_t indexCount = 0;
+    for (auto& range : mesh.ranges)
+    {
+        if (range.vertexOffset < 0 || static_cast<size_t>(range.vertexOffset) >= mesh.positions->valueCount()) return false;
+        indexCount += range.indexCount;
+    }
+    if (indexCount / 3 < MIN_TRIANGLES) return false;
+
+    _meshIndices[node.get()] = _meshes.size();
+    _meshes.push_back(mesh);
+    return true;
+}
+
+void LODGenerateVisitor::generateLOD(Mesh& mesh)
+{
+    const vsg::vec3* positions = static_cast<const vsg::vec3*>(mesh.positions->dataPointer());
+    size_t positionCount = mesh.positions->valueCount();
+
+    // each range is simplified on its own so the levels keep the draws of the original
+    std::vector<std::vector<uint32_t>> rangeIndices(mesh.ranges.size());
+    size_t originalTriangles = 0;
+    for (size_t r = 0; r < mesh.ranges.size(); ++r)
+    {
+        if (!readIndices(mesh.indices.get(), mesh.ranges[r].firstIndex, mesh.ranges[r].indexCount, rangeIndices[r])) return;
+        originalTriangles += rangeIndices[r].size() / 3;
+    }
+
+    // bound the referenced vertices so the lod can pick a level before its children are culled
+    vsg::vec3 minimum(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    vsg::vec3 maximum(-minimum.x, -minimum.y, -minimum.z);
+    for (size_t r = 0; r < mesh.ranges.size(); ++r)
+    {
+        for (uint32_t index : rangeIndices[r])
+        {
+            size_t v = static_cast<size_t>(index) + mesh.ranges[r].vertexOffset;
+            if (v >= positionCount) continue;
+            const vsg::vec3& p = positions[v];
+            minimum = vsg::vec3(std::min(minimum.x, p.x), std::min(minimum.y, p.y), std::min(minimum.z, p.z));
+            maximum = vsg::vec3(std::max(maximum.x, p.x), std::max(maximum.y, p.y), std::max(maximum.z, p.z));
+        }
+    }
+    if (minimum.x > maximum.x) return;
+
+    vsg::vec3 center((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+    float radius = 0.0f;
+    for (size_t r = 0; r < mesh.ranges.size(); ++r)
+    {
+        for (uint32_t index : rangeIndices[r])
+        {
+            size_t v = static_cast<size_t>(index) + mesh.ranges[r].vertexOffset;
+            if (v < positionCount) radius = std::max(radius, dot(sub(positions[v], center), sub(positions[v], center)));
+        }
+    }
+
+    auto lod = vsg::LOD::create();
+    lod->setBound(vsg::sphere(center, std::sqrt(radius)));
+    lod->addChild(vsg::LOD::LODChild{_fullDetailScreenHeightRatio, mesh.node});
+    mesh.levelTriangles.push_back(originalTriangles);
+
+    // each level is simplified from the one before, which is cheaper and keeps the levels nested
+    size_t previousTriangles = originalTriangles;
+    for (auto& level : _levels)
+    {
+        size_t triangles = 0;
+        for (size_t r = 0; r < mesh.ranges.size(); ++r)
+        {
+            size_t offset = static_cast<size_t>(mesh.ranges[r].vertexOffset);
+            size_t target = static_cast<size_t>(mesh.ranges[r].indexCount / 3 * level.triangleRatio) * 3;
+            rangeIndices[r] = simplifyMesh(rangeIndices[r].data(), rangeIndices[r].size(), positions + offset, positionCount - offset, target, _maxError);
+            triangles += rangeIndices[r].size() / 3;
+        }
+
+        // stop once the error limit holds the mesh back, a level that is barely smaller isn't worth its memory
+        if (triangles == 0 || triangles * 10 > previousTriangles * 9) break;
+
+        size_t indexCount = triangles * 3;
+        vsg::ref_ptr<vsg::Data> indices;
+        if (mesh.indices->valueSize() == sizeof(uint16_t))
+            indices = vsg::ushortArray::create(indexCount);
+        else
+            indices = vsg::uintArray::create(indexCount);
+
+        IndexRanges ranges;
+        uint32_t firstIndex = 0;
+        for (size_t r = 0; r < mesh.ranges.size(); ++r)
+        {
+            writeIndices(indices.get(), firstIndex, rangeIndices[r]);
+            ranges.push_back({firstIndex, static_cast<uint32_t>(rangeIndices[r].size()), mesh.ranges[r].vertexOffset});
+            firstIndex += static_cast<uint32_t>(rangeIndices[r].size());
+        }
+
+        lod->addChild(vsg::LOD::LODChild{level.minimumScreenHeightRatio, createLevelNode(mesh, indices, ranges)});
+        mesh.levelTriangles.push_back(triangles);
+        previousTriangles = triangles;
+    }
+
+    if (mesh.levelTriangles.size() > 1) mesh.lod = lod;
+}
+
+vsg::ref_ptr<vsg::Node> LODGenerateVisitor::createLevelNode(Mesh& mesh, vsg::ref_ptr<vsg::Data> indices, const IndexRanges& ranges)
+{
+    if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(mesh.node.get()))
+    {
+        auto levelVid = vsg::VertexIndexDraw::create();
+        levelVid->_arrays = vid->_arrays;
+        levelVid->_indices = indices;
+        levelVid->indexCount = ranges[0].indexCount;
+        levelVid->instanceCount = vid->instanceCount;
+        levelVid->firstIndex = 0;
+        levelVid->vertexOffset = ranges[0].vertexOffset;
+        levelVid->firstInstance = vid->firstInstance;
+        return levelVid;
+    }
+
+    // copy the commands with the new index buffer and ranges, draws simplified away entirely are dropped
+    auto commands = dynamic_cast<vsg::Commands*>(mesh.node.get());
+    auto levelCommands = vsg::Commands::create();
+    size_t range = 0;
+    for (auto& command : commands->getChildren())
+    {
+        if (dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+        {
+            levelCommands->addChild(vsg::BindIndexBuffer::create(indices));
+        }
+        else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+        {
+            const IndexRange& levelRange = ranges[range++];
+            if (levelRange.indexCount == 0) continue;
+            levelCommands->addChild(vsg::DrawIndexed::create(levelRange.indexCount, drawIndexed->instanceCount, levelRange.firstIndex, levelRange.vertexOffset, drawIndexed->firstInstance));
+        }
+        else
+        {
+            levelCommands->addChild(command);
+        }
+    }
+    return levelCommands;
+}
+
+void LODGenerateVisitor::generate()
+{
+    // meshes only touch their own entry so can be simplified side by side, the graph is only changed afterwards
+    parallelFor(_meshes.size(), [this](size_t i) { generateLOD(_meshes[i]); });
+
+    for (auto& slot : _slots)
+    {
+        const Mesh& mesh = _meshes[slot.mesh];
+        if (mesh.lod.valid()) slot.group->getChildren()[slot.child] = mesh.lod;
+    }
+
+    for (auto& mesh : _meshes)
+    {
+        if (!mesh.lod.valid()) continue;
+
+        _lodCount++;
+        if (_levelTriangles.size() < mesh.levelTriangles.size()) _levelTriangles.resize(mesh.levelTriangles.size(), 0);
+        for (size_t l = 0; l < mesh.levelTriangles.size(); ++l) _levelTriangles[l] += mesh.levelTriangles[l];
+    }
+
+    _meshes.clear();
+    _meshIndices.clear();
+    _slots.clear();
+}
@@ -0,0 +1,396 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/MipTrimmer.h>
+
+#include <unity2vsg/MatrixUtils.h>
+#include <unity2vsg/MipmapGenerator.h>
+#include <unity2vsg/ShaderUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // upper bound on the largest scale of the upper 3x3, exact unless its axes are skewed
+    float maxStretch(const vsg::mat4& m)
+    {
+        vsg::vec3 axes[3];
+        for (int c = 0; c < 3; ++c) axes[c] = vsg::vec3(m[c][0], m[c][1], m[c][2]);
+
+        bool orthogonal = true;
+        for (int a = 0; a < 3; ++a)
+        {
+            for (int b = a + 1; b < 3; ++b)
+            {
+                float dot = axes[a].x * axes[b].x + axes[a].y * axes[b].y + axes[a].z * axes[b].z;
+                float lengths = std::sqrt((axes[a].x * axes[a].x + axes[a].y * axes[a].y + axes[a].z * axes[a].z) * (axes[b].x * axes[b].x + axes[b].y * axes[b].y + axes[b].z * axes[b].z));
+                orthogonal = orthogonal && std::abs(dot) <= 1e-4f * lengths;
+            }
+        }
+        if (orthogonal) return maxScale(m);
+
+        float sum = 0.0f;
+        for (auto& axis : axes) sum += axis.x * axis.x + axis.y * axis.y + axis.z * axis.z;
+        return std::sqrt(sum);
+    }
+
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> trimArray2D(const vsg::Data* data, uint32_t level)
+    {
+        auto array = dynamic_cast<const vsg::Array2D<T>*>(data);
+        if (!array) return vsg::ref_ptr<vsg::Data>();
+
+        uint32_t width = array->width();
+        uint32_t height = array->height();
+        uint32_t levels = textureLevels(array);
+        if (levels <= 1 || width == 0 || height == 0) return vsg::ref_ptr<vsg::Data>();
+        level = std::min(level, levels - 1);
+
+        size_t offset = mipmapChainSize(width, height, level);
+        size_t count = mipmapChainSize(width, height, levels) - offset;
+        T* chain = new T[count];
+        std::memcpy(chain, static_cast<const T*>(array->dataPointer()) + offset, count * sizeof(T));
+
+        vsg::ref_ptr<vsg::Data> trimmed(new vsg::Array2D<T>(std::max(width >> level, 1u), std::max(height >> level, 1u), chain));
+        vsg::Data::Layout layout = array->getLayout();
+        layout.maxNumMipmaps = levels - level;
+        trimmed->setFormat(array->getFormat());
+        trimmed->setLayout(layout);
+        return trimmed;
+    }
+
+} // namespace
+
+uint32_t unity2vsg::textureLevels(const vsg::Data* data)
+{
+    return std::min(std::max<uint32_t>(data->getLayout().maxNumMipmaps, 1), fullMipmapCount(data->width(), data->height()));
+}
+
+size_t unity2vsg::textureBytes(const vsg::Data* data)
+{
+    return mipmapChainSize(data->width(), data->height(), textureLevels(data)) * std::max<uint32_t>(data->depth(), 1) * data->valueSize();
+}
+
+float unity2vsg::uvDensity(const vsg::vec3& p0, const vsg::vec3& p1, const vsg::vec3& p2, const vsg::vec2& uv0, const vsg::vec2& uv1, const vsg::vec2& uv2)
+{
+    double e1[3] = {p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+    double e2[3] = {p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+    double d1[2] = {uv1.x - uv0.x, uv1.y - uv0.y};
+    double d2[2] = {uv2.x - uv0.x, uv2.y - uv0.y};
+
+    // the stretches of the map from the triangle's plane to uvs solve D^T D x = s^2 G x, G being the edges' gram matrix
+    double g11 = e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2];
+    double g12 = e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2];
+    double g22 = e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2];
+    double areaSquared = g11 * g22 - g12 * g12;
+    if (!(areaSquared > 1e-12 * g11 * g22)) return -1.0f;
+
+    double h11 = d1[0] * d1[0] + d1[1] * d1[1];
+    double h12 = d1[0] * d2[0] + d1[1] * d2[1];
+    double h22 = d2[0] * d2[0] + d2[1] * d2[1];
+
+    double trace = (g22 * h11 - 2.0 * g12 * h12 + g11 * h22) / areaSquared;
+    double determinant = (h11 * h22 - h12 * h12) / areaSquared;
+    double spread = std::sqrt(std::max(trace * trace * 0.25 - determinant, 0.0));
+    double most = std::sqrt(std::max(trace * 0.5 + spread, 0.0));
+    double least = std::sqrt(std::max(trace * 0.5 - spread, 0.0));
+
+    return static_cast<float>(std::max(least, most / MipTrimVisitor::MAX_ANISOTROPY));
+}
+
+vsg::ref_ptr<vsg::Data> unity2vsg::trimMipmaps(const vsg::Data* data, uint32_t level)
+{
+    if (!data || level == 0) return vsg::ref_ptr<vsg::Data>();
+
+    switch (data->valueSize())
+    {
+    case 1: return trimArray2D<uint8_t>(data, level);
+    case 2: return trimArray2D<vsg::ubvec2>(data, level);
+    case 3: return trimArray2D<vsg::ubvec3>(data, level);
+    case 4: return trimArray2D<vsg::ubvec4>(data, level);
+    case 8: return trimArray2D<vsg::block64>(data, level);
+    case 16: return trimArray2D<vsg::block128>(data, level);
+    default: return vsg::ref_ptr<vsg::Data>();
+    }
+}
+
+MipTrimVisitor::MipTrimVisitor(const MipTrimOptions& options, const VertexArrayAttributes& attributes) :
+    _options(options),
+    _attributes(attributes),
+    _lowerLevels(0),
+    _measuredCount(0),
+    _bytesRemoved(0)
+{
+    float fieldOfView = std::min(std::max(options.fieldOfView, 1.0f), 179.0f);
+    _tanHalfFov = std::tan(fieldOfView * 0.5f * 3.14159265f / 180.0f);
+    _pixelSize = 2.0f * _tanHalfFov / static_cast<float>(std::max(options.screenHeight, 1u));
+
+    _matrixStack.push_back(identityMatrix());
+    _distanceStack.push_back(std::max(options.nearDistance, 0.0f));
+}
+
+void MipTrimVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void MipTrimVisitor::apply(vsg::MatrixTransform& transform)
+{
+    _matrixStack.push_back(multiply(_matrixStack.back(), transform.getMatrix()));
+    transform.traverse(*this);
+    _matrixStack.pop_back();
+}
+
+void MipTrimVisitor::apply(vsg::LOD& lod)
+{
+    // a level is only drawn once the bound covers less of the screen than the level before it asks for, it's made of
+    // the meshes inside the bound so can't come any closer than the bound's near side
+    float radius = lod.getBound().radius * maxScale(_matrixStack.back());
+    float previousRatio = 0.0f;
+    bool first = true;
+    for (auto& lodChild : lod.getChildren())
+    {
+        float distance = _distanceStack.back();
+        bool lower = !first;
+        if (lower)
+        {
+            if (previousRatio <= 0.0f) break; // the levels before always win
+            if (radius > 0.0f) distance = std::max(distance, radius / (previousRatio * _tanHalfFov) - radius);
+        }
+        first = false;
+        previousRatio = lodChild.minimumScreenHeightRatio;
+        if (!lodChild.child) continue;
+
+        _distanceStack.push_back(distance);
+        if (lower) _lowerLevels++;
+        lodChild.child->accept(*this);
+        if (lower) _lowerLevels--;
+        _distanceStack.pop_back();
+    }
+}
+
+void MipTrimVisitor::apply(vsg::StateGroup& stategroup)
+{
+    size_t depth = _bindStack.size();
+    for (auto& command : stategroup.getStateCommands())
+    {
+        if (auto bind = dynamic_cast<const vsg::BindDescriptorSet*>(command.get())) _bindStack.push_back(bind);
+    }
+    stategroup.traverse(*this);
+    _bindStack.resize(depth);
+}
+
+void MipTrimVisitor::apply(vsg::Geometry& /*geometry*/)
+{
+    // never written by the exporter, anything it binds is left alone
+    addDraw(_bindStack.empty() ? nullptr : _bindStack.back(), vsg::DataList(), nullptr, IndexRanges(), 1);
+}
+
+void MipTrimVisitor::apply(vsg::VertexIndexDraw& vid)
+{
+    addDraw(_bindStack.empty() ? nullptr : _bindStack.back(), vid._arrays, vid._indices.get(), {{vid.firstIndex, vid.indexCount, vid.vertexOffset}}, vid.instanceCount);
+}
+
+void MipTrimVisitor::apply(vsg::Commands& commands)
+{
+    const vsg::BindDescriptorSet* bind = _bindStack.empty() ? nullptr : _bindStack.back();
+    vsg::DataList arrays;
+    const vsg::Data* indices = nullptr;
+    for (auto& command : commands.getChildren())
+    {
+        if (auto bindDescriptorSet = dynamic_cast<const vsg::BindDescriptorSet*>(command.get()))
+            bind = bindDescriptorSet;
+        else if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+            arrays = bvb->getArrays();
+        else if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+            indices = bib->getIndices().get();
+        else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+            addDraw(bind, arrays, indices, {{drawIndexed->firstIndex, drawIndexed->indexCount, drawIndexed->vertexOffset}}, drawIndexed->instanceCount);
+        else if (dynamic_cast<vsg::Draw*>(command.get()))
+            addDraw(bind, arrays, nullptr, IndexRanges(), 1);
+    }
+}
+
+void MipTrimVisitor::collect(vsg::Group& root, GetDescriptors getDescriptors, IsMeasurable isMeasurable)
+{
+    _getDescriptors = getDescriptors;
+    _isMeasurable = isMeasurable;
+    root.accept(*this);
+}
+
+const std::vector<vsg::DescriptorImage*>* MipTrimVisitor::boundTextures(const vsg::BindDescriptorSet* bind)
+{
+    if (!bind) return nullptr;
+
+    auto itr = _boundTextures.find(bind);
+    if (itr != _boundTextures.end()) return &itr->second;
+
+    std::vector<vsg::DescriptorImage*>& textures = _boundTextures[bind];
+    vsg::Descriptors descriptors;
+    if (_getDescriptors && _getDescriptors(bind, descriptors))
+    {
+        for (auto& descriptor : descriptors)
+        {
+            if (auto texture = dynamic_cast<vsg::DescriptorImage*>(descriptor.get())) textures.push_back(texture);
+        }
+    }
+    return &textures;
+}
+
+float MipTrimVisitor::measure(const vsg::DataList& arrays, const vsg::Data* indices, const IndexRanges& ranges, uint32_t instanceCount, double& area) const
+{
+    area = 0.0;
+
+    const vsg::vec3Array* positions = nullptr;
+    const vsg::vec2Array* uvs = nullptr;
+    const vsg::Data* instanceMatrices = nullptr;
+    for (auto& array : arrays)
+    {
+        auto itr = _attributes.find(array.get());
+        if (itr == _attributes.end()) continue;
+        if (itr->second == VERTEX && !positions) positions = dynamic_cast<const vsg::vec3Array*>(array.get());
+        else if (itr->second == TEXCOORD0 && !uvs) uvs = dynamic_cast<const vsg::vec2Array*>(array.get());
+        else if (itr->second == INSTANCE_MATRIX) instanceMatrices = array.get();
+    }
+    if (!positions || !indices) return -1.0f;
+
+    // instances only stretch the uvs less than the draw's own transform by their largest scale, translations not at all.
+    // Their areas are scaled by at most the square of it, the sum of those bounds is what's added up
+    float instanceStretch = 1.0f;
+    double instanceArea = std::max<uint32_t>(instanceCount, 1);
+    if (instanceMatrices && instanceCount > 1)
+    {
+        auto matrices = dynamic_cast<const vsg::mat4Array*>(instanceMatrices);
+        if (!matrices) return -1.0f;
+
+        instanceStretch = 0.0f;
+        instanceArea = 0.0;
+        const vsg::mat4* values = static_cast<const vsg::mat4*>(matrices->dataPointer());
+        for (size_t i = 0; i < matrices->valueCount(); ++i)
+        {
+            float stretch = maxStretch(values[i]);
+            instanceStretch = std::max(instanceStretch, stretch);
+            instanceArea += static_cast<double>(stretch) * stretch;
+        }
+    }
+
+    const vsg::mat4& matrix = _matrixStack.back();
+    const vsg::vec3* vertices = static_cast<const vsg::vec3*>(positions->dataPointer());
+    const vsg::vec2* texcoords = uvs ? static_cast<const vsg::vec2*>(uvs->dataPointer()) : nullptr;
+    int64_t vertexCount = static_cast<int64_t>(uvs ? std::min(positions->valueCount(), uvs->valueCount()) : positions->valueCount());
+
+    float density = std::numeric_limits<float>::max();
+    double drawArea = 0.0;
+    std::vector<uint32_t> triangles;
+    for (auto& range : ranges)
+    {
+        if (!readIndices(indices, range.firstIndex, range.indexCount, triangles)) return -1.0f;
+
+        for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+        {
+            int64_t a = static_cast<int64_t>(triangles[i]) + range.vertexOffset;
+            int64_t b = static_cast<int64_t>(triangles[i + 1]) + range.vertexOffset;
+            int64_t c = static_cast<int64_t>(triangles[i + 2]) + range.vertexOffset;
+            if (a < 0 || b < 0 || c < 0 || a >= vertexCount || b >= vertexCount || c >= vertexCount) return -1.0f;
+
+            vsg::vec3 p0 = transformPoint(matrix, vertices[a]);
+            vsg::vec3 p1 = transformPoint(matrix, vertices[b]);
+            vsg::vec3 p2 = transformPoint(matrix, vertices[c]);
+            vsg::vec3 e1(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+            vsg::vec3 e2(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+            vsg::vec3 normal(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+            drawArea += 0.5 * std::sqrt(static_cast<double>(normal.x) * normal.x + static_cast<double>(normal.y) * normal.y + static_cast<double>(normal.z) * normal.z);
+
+            if (!texcoords) continue;
+            float triangle = uvDensity(p0, p1, p2, texcoords[a], texcoords[b], texcoords[c]);
+            if (triangle >= 0.0f) density = std::min(density, triangle);
+        }
+    }
+    area = drawArea * instanceArea;
+
+    if (!texcoords) return -1.0f;
+    if (instanceStretch <= 0.0f) return std::numeric_limits<float>::max();
+    return density == std::numeric_limits<float>::max() ? density : density / instanceStretch;
+}
+
+void MipTrimVisitor::addDraw(const vsg::BindDescriptorSet* bind, const vsg::DataList& arrays, const vsg::Data* indices, const IndexRanges& ranges, uint32_t instanceCount)
+{
+    const std::vector<vsg::DescriptorImage*>* textures = boundTextures(bind);
+    if (!textures || textures->empty()) return;
+
+    double area = 0.0;
+    float density = measure(arrays, indices, ranges, instanceCount, area);
+    double draws = _lowerLevels == 0 ? std::max<uint32_t>(instanceCount, 1) : 0.0;
+    if (_lowerLevels > 0) area = 0.0;
+
+    for (vsg::DescriptorImage* texture : *textures)
+    {
+        bool measurable = density >= 0.0f && _isMeasurable && _isMeasurable(texture);
+        for (auto& samplerImage : texture->getSamplerImages())
+        {
+            if (!samplerImage.second.valid()) continue;
+
+            auto itr = _usages.find(samplerImage.second.get());
+            if (itr == _usages.end())
+            {
+                itr = _usages.emplace(samplerImage.second.get(), Usage()).first;
+                itr->second.data = samplerImage.second;
+                itr->second.finest = std::numeric_limits<float>::max();
+            }
+
+            Usage& usage = itr->second;
+            usage.textures.insert(texture);
+            usage.measurable = usage.measurable && measurable;
+            usage.area += area;
+            usage.draws += draws;
+            if (measurable && density < std::numeric_limits<float>::max()) usage.finest = std::min(usage.finest, density * _distanceStack.back() * _pixelSize);
+        }
+    }
+}
+
+void MipTrimVisitor::trim()
+{
+    for (auto& entry : _usages)
+    {
+        Usage& usage = entry.second;
+        if (!usage.measurable) continue;
+        _measuredCount++;
+
+        // the level sampled is log2 of the texels a pixel covers, trilinear filtering blends in the next one down
+        const vsg::Data::Layout& layout = usage.data->getLayout();
+        float texels = static_cast<float>(std::min(usage.data->width() * std::max<uint32_t>(layout.blockWidth, 1), usage.data->height() * std::max<uint32_t>(layout.blockHeight, 1)));
+        float coverage = usage.finest * texels;
+        if (!(coverage >= 2.0f)) continue;
+
+        uint32_t level = coverage >= 1e9f ? 32u : static_cast<uint32_t>(std::floor(std::log2(coverage)));
+        vsg::ref_ptr<vsg::Data> trimmed = trimMipmaps(usage.data.get(), level);
+        if (!trimmed.valid()) continue;
+
+        for (vsg::DescriptorImage* texture : usage.textures)
+        {
+            for (auto& samplerImage : texture->getSamplerImages())
+            {
+                if (samplerImage.second.get() == entry.first) samplerImage.second = trimmed;
+            }
+        }
+
+        size_t bytesRemoved = textureBytes(usage.data.get()) - textureBytes(trimmed.get());
+        _trimmed.push_back({entry.first, trimmed, textureLevels(usage.data.get()) - textureLevels(trimmed.get()), bytesRemoved});
+        _bytesRemoved += bytesRemoved;
+        usage.data = trimmed;
+    }
+}
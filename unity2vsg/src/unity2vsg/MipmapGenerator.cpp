@@ -0,0 +1,380 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/MipmapGenerator.h>
+
+#include <unity2vsg/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define UNITY2VSG_MIPMAP_SSE2
+#    include <emmintrin.h>
+#endif
+
+using namespace unity2vsg;
+
+namespace
+{
+    // levels smaller than this are filtered on the calling thread, larger ones are split into jobs of about this many texels
+    const size_t TEXELS_PER_JOB = 16384;
+
+    struct ConversionTables
+    {
+        float unormToFloat[256];
+        float srgbToLinear[256];
+        float srgbThresholds[255]; // linear value half way between each pair of neighbouring srgb codes
+
+        ConversionTables()
+        {
+            auto decode = [](double v) { return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4); };
+            for (int i = 0; i < 256; ++i)
+            {
+                unormToFloat[i] = static_cast<float>(i / 255.0);
+                srgbToLinear[i] = static_cast<float>(decode(i / 255.0));
+            }
+            for (int i = 0; i < 255; ++i) srgbThresholds[i] = static_cast<float>(decode((i + 0.5) / 255.0));
+        }
+    };
+
+    const ConversionTables& tables()
+    {
+        static const ConversionTables s_tables;
+        return s_tables;
+    }
+
+    inline uint8_t encodeUnorm(float value)
+    {
+        return static_cast<uint8_t>(std::min(std::max(value * 255.0f + 0.5f, 0.0f), 255.0f));
+    }
+
+    // the code whose rounding interval holds value, same result as encoding then rounding without the pow
+    inline uint8_t encodeSrgb(float value, const float* thresholds)
+    {
+        return static_cast<uint8_t>(std::upper_bound(thresholds, thresholds + 255, value) - thresholds);
+    }
+
+    // the first source texel and number of source texels destination texel i covers along one axis
+    inline void footprint(uint32_t i, uint32_t size, uint32_t sourceSize, uint32_t& first, uint32_t& count)
+    {
+        first = std::min(i * 2, sourceSize - 1);
+        if (sourceSize == 1)
+            count = 1;
+        else if (i == size - 1 && (sourceSize & 1))
+            count = 3;
+        else
+            count = 2;
+    }
+
+    struct Level
+    {
+        const uint8_t* source;
+        uint32_t sourceWidth;
+        uint32_t sourceHeight;
+        float* filtered; // components floats per texel in 0 to 1, linear for srgb components
+        uint32_t width;
+        uint32_t height;
+        uint32_t components;
+        const float* decode[4]; // table converting each components 8 bit value to the filtered space
+    };
+
+    // average each footprint with the components decoded through the levels tables
+    void filterColor(const Level& level, uint32_t beginRow, uint32_t endRow)
+    {
+        const uint32_t components = level.components;
+
+#if defined(UNITY2VSG_MIPMAP_SSE2)
+        // 2x2 footprints of plain unorm rgba can be summed as integers, only srgb needs the per component tables
+        const ConversionTables& t = tables();
+        bool integerSums = components == 4 && level.sourceWidth > 1 && level.decode[0] == t.unormToFloat && level.decode[1] == t.unormToFloat &&
+                           level.decode[2] == t.unormToFloat && level.decode[3] == t.unormToFloat;
+        uint32_t pairedColumns = level.sourceWidth & 1 ? level.width - 1 : level.width; // the last column of an odd row covers three texels
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 quarter = _mm_set1_ps(1.0f / (4.0f * 255.0f));
+#endif
+
+        for (uint32_t y = beginRow; y < endRow; ++y)
+        {
+            uint32_t sy, ny;
+            footprint(y, level.height, level.sourceHeight, sy, ny);
+
+            uint32_t x = 0;
+            float* out = level.filtered + static_cast<size_t>(y) * level.width * components;
+
+#if defined(UNITY2VSG_MIPMAP_SSE2)
+            if (integerSums && ny == 2)
+            {
+                const uint8_t* row0 = level.source + static_cast<size_t>(sy) * level.sourceWidth * 4;
+                const uint8_t* row1 = row0 + static_cast<size_t>(level.sourceWidth) * 4;
+
+                // two destination texels from four source texels of each row
+                for (; x + 2 <= pairedColumns; x += 2)
+                {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+                    __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                    __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                    low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+                    high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+                    _mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), quarter));
+                    _mm_storeu_ps(out + x * 4 + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), quarter));
+                }
+            }
+#endif
+
+            for (; x < level.width; ++x)
+            {
+                uint32_t sx, nx;
+                footprint(x, level.width, level.sourceWidth, sx, nx);
+
+                float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                for (uint32_t j = 0; j < ny; ++j)
+                {
+                    const uint8_t* texel = level.source + (static_cast<size_t>(sy + j) * level.sourceWidth + sx) * components;
+                    for (uint32_t i = 0; i < nx; ++i, texel += components)
+                    {
+                        for (uint32_t k = 0; k < components; ++k) sum[k] += level.decode[k][texel[k]];
+                    }
+                }
+
+                float scale = 1.0f / static_cast<float>(nx * ny);
+                for (uint32_t k = 0; k < components; ++k) out[x * components + k] = sum[k] * scale;
+            }
+        }
+    }
+
+    // average the unit vectors of each footprint then renormalize, two component maps get z rebuilt from x and y
+    void filterNormals(const Level& level, uint32_t beginRow, uint32_t endRow)
+    {
+        const uint32_t components = level.components;
+        const float* unorm = tables().unormToFloat;
+
+        for (uint32_t y = beginRow; y < endRow; ++y)
+        {
+            uint32_t sy, ny;
+            footprint(y, level.height, level.sourceHeight, sy, ny);
+
+            float* out = level.filtered + static_cast<size_t>(y) * level.width * components;
+            for (uint32_t x = 0; x < level.width; ++x, out += components)
+            {
+                uint32_t sx, nx;
+                footprint(x, level.width, level.sourceWidth, sx, nx);
+
+                float n[3] = {0.0f, 0.0f, 0.0f};
+                float alpha = 0.0f;
+                for (uint32_t j = 0; j < ny; ++j)
+                {
+                    const uint8_t* texel = level.source + (static_cast<size_t>(sy + j) * level.sourceWidth + sx) * components;
+                    for (uint32_t i = 0; i < nx; ++i, texel += components)
+                    {
+                        float nx0 = unorm[texel[0]] * 2.0f - 1.0f;
+                        float ny0 = unorm[texel[1]] * 2.0f - 1.0f;
+                        float nz0 = components >= 3 ? unorm[texel[2]] * 2.0f - 1.0f : std::sqrt(std::max(0.0f, 1.0f - nx0 * nx0 - ny0 * ny0));
+                        n[0] += nx0;
+                        n[1] += ny0;
+                        n[2] += nz0;
+                        if (components == 4) alpha += unorm[texel[3]];
+                    }
+                }
+
+                // opposing normals can cancel out, fall back to straight up
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length > 1e-6f)
+                {
+                    for (int k = 0; k < 3; ++k) n[k] /= length;
+                }
+                else
+                {
+                    n[0] = 0.0f;
+                    n[1] = 0.0f;
+                    n[2] = 1.0f;
+                }
+
+                for (uint32_t k = 0; k < std::min(components, 3u); ++k) out[k] = n[k] * 0.5f + 0.5f;
+                if (components == 4) out[3] = alpha / static_cast<float>(nx * ny);
+            }
+        }
+    }
+
+    void encodeRows(const Level& level, uint8_t* destination, const bool srgb[4], uint32_t beginRow, uint32_t endRow)
+    {
+        const uint32_t components = level.components;
+        const float* thresholds = tables().srgbThresholds;
+
+        size_t begin = static_cast<size_t>(beginRow) * level.width * components;
+        size_t end = static_cast<size_t>(endRow) * level.width * components;
+        size_t i = begin;
+
+#if defined(UNITY2VSG_MIPMAP_SSE2)
+        if (components == 4 && !srgb[0] && !srgb[1] && !srgb[2] && !srgb[3])
+        {
+            const __m128 scale = _mm_set1_ps(255.0f);
+            for (; i < end; i += 4)
+            {
+                // cvtps rounds to nearest and the packs saturate so out of range values clamp
+                __m128i value = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(level.filtered + i), scale));
+                value = _mm_packs_epi32(value, value);
+                value = _mm_packus_epi16(value, value);
+                int32_t texel = _mm_cvtsi128_si32(value);
+                std::memcpy(destination + i, &texel, 4);
+            }
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            float value = level.filtered[i];
+            destination[i] = srgb[i % components] ? encodeSrgb(value, thresholds) : encodeUnorm(value);
+        }
+    }
+
+    size_t countCoverage(const float* filtered, size_t texelCount, float scale, float cutoff)
+    {
+        size_t covered = 0;
+        for (size_t i = 0; i < texelCount; ++i)
+        {
+            if (filtered[i * 4 + 3] * scale > cutoff) ++covered;
+        }
+        return covered;
+    }
+
+    // Castano, Computing Alpha Mipmaps, 2010. Scale alpha so the fraction of texels passing the alpha test matches the
+    // first level, otherwise cutout foliage and fences thin out and vanish with distance
+    void preserveCoverage(float* filtered, size_t texelCount, float cutoff, float targetCoverage)
+    {
+        size_t target = static_cast<size_t>(targetCoverage * static_cast<float>(texelCount) + 0.5f);
+
+        float low = 0.0f, high = 4.0f, scale = 1.0f;
+        size_t bestError = texelCount + 1;
+        for (int iteration = 0; iteration < 16; ++iteration)
+        {
+            float mid = (low + high) * 0.5f;
+            size_t covered = countCoverage(filtered, texelCount, mid, cutoff);
+            size_t error = covered > target ? covered - target : target - covered;
+            if (error < bestError)
+            {
+                bestError = error;
+                scale = mid;
+            }
+
+            if (covered < target)
+                low = mid;
+            else if (covered > target)
+                high = mid;
+            else
+                break;
+        }
+
+        for (size_t i = 0; i < texelCount; ++i) filtered[i * 4 + 3] = std::min(filtered[i * 4 + 3] * scale, 1.0f);
+    }
+
+} // namespace
+
+uint32_t unity2vsg::fullMipmapCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) ++count;
+    return count;
+}
+
+size_t unity2vsg::mipmapChainSize(uint32_t width, uint32_t height, uint32_t mipmapCount)
+{
+    size_t size = 0;
+    for (uint32_t i = 0; i < std::max(mipmapCount, 1u); ++i)
+    {
+        size += static_cast<size_t>(width) * height;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return size;
+}
+
+void unity2vsg::generateMipmaps(uint8_t* chain, uint32_t width, uint32_t height, uint32_t mipmapCount, const MipmapOptions& options)
+{
+    if (chain == nullptr || width == 0 || height == 0 || options.components < 1 || options.components > 4) return;
+
+    const ConversionTables& t = tables();
+    const uint32_t components = options.components;
+    const bool normals = options.filter == MIPMAP_FILTER_NORMAL && components >= 2;
+
+    // alpha is always linear, srgb only applies to color components of color maps
+    bool srgb[4] = {false, false, false, false};
+    Level level = {};
+    level.components = components;
+    for (uint32_t k = 0; k < components; ++k)
+    {
+        srgb[k] = options.srgb && !normals && (k < 3 || components < 4);
+        level.decode[k] = srgb[k] ? t.srgbToLinear : t.unormToFloat;
+    }
+
+    const bool coverage = options.alphaCutoff > 0.0f && components == 4;
+    float targetCoverage = 0.0f;
+    if (coverage)
+    {
+        size_t covered = 0;
+        size_t texelCount = static_cast<size_t>(width) * height;
+        for (size_t i = 0; i < texelCount; ++i)
+        {
+            if (t.unormToFloat[chain[i * 4 + 3]] > options.alphaCutoff) ++covered;
+        }
+        targetCoverage = static_cast<float>(covered) / static_cast<float>(texelCount);
+    }
+
+    std::vector<float> filtered;
+    level.source = chain;
+    level.sourceWidth = width;
+    level.sourceHeight = height;
+
+    mipmapCount = std::min(mipmapCount, fullMipmapCount(width, height));
+    for (uint32_t i = 1; i < mipmapCount; ++i)
+    {
+        level.width = std::max(level.sourceWidth / 2, 1u);
+        level.height = std::max(level.sourceHeight / 2, 1u);
+
+        size_t texelCount = static_cast<size_t>(level.width) * level.height;
+        filtered.resize(texelCount * components);
+        level.filtered = filtered.data();
+
+        uint8_t* destination = const_cast<uint8_t*>(level.source) + static_cast<size_t>(level.sourceWidth) * level.sourceHeight * components;
+
+        uint32_t rowsPerJob = static_cast<uint32_t>(std::max<size_t>(1, TEXELS_PER_JOB / level.width));
+        size_t jobCount = (level.height + rowsPerJob - 1) / rowsPerJob;
+        auto rows = [&](size_t job, uint32_t& begin, uint32_t& end) {
+            begin = static_cast<uint32_t>(job) * rowsPerJob;
+            end = std::min(begin + rowsPerJob, level.height);
+        };
+
+        parallelFor(jobCount, [&](size_t job) {
+            uint32_t begin, end;
+            rows(job, begin, end);
+            if (normals)
+                filterNormals(level, begin, end);
+            else
+                filterColor(level, begin, end);
+        });
+
+        if (coverage) preserveCoverage(level.filtered, texelCount, options.alphaCutoff, targetCoverage);
+
+        parallelFor(jobCount, [&](size_t job) {
+            uint32_t begin, end;
+            rows(job, begin, end);
+            encodeRows(level, destination, srgb, begin, end);
+        });
+
+        level.source = destination;
+        level.sourceWidth = level.width;
+        level.sourceHeight = level.height;
+    }
+}
@@ -37,6 +37,14 @@ std::vector<std::string> createPSCDefineStrings(const uint32_t& shaderModeMask,
     if (hastex0) defines.push_back("VSG_TEXCOORD0");
     if (hastex1) defines.push_back("VSG_TEXCOORD1");
 
+    // vertex input encodings
+    if (hasnormal && (geometryAttrbutes & NORMAL_OCTAHEDRAL)) defines.push_back("VSG_NORMAL_OCTAHEDRAL");
+    if (hastanget && (geometryAttrbutes & TANGENT_OCTAHEDRAL)) defines.push_back("VSG_TANGENT_OCTAHEDRAL");
+
+    // per instance inputs
+    if (geometryAttrbutes & TRANSLATE) defines.push_back("VSG_TRANSLATE");
+    if (geometryAttrbutes & INSTANCE_MATRIX) defines.push_back("VSG_INSTANCE_MATRIX");
+
     // shading modes/maps
     if (hasnormal && (shaderModeMask & LIGHTING)) defines.push_back("VSG_LIGHTING");
 
@@ -206,13 +214,39 @@ std::string unity2vsg::readGLSLShader(const std::string& filename, const uint32_
     return formatedSource;
 }
 
+bool unity2vsg::shaderImportsDefine(const std::string& filename, const std::string& define)
+{
+    if (filename.empty()) return true;
+
+    std::string sourceBuffer;
+    if (!vsg::readFile(sourceBuffer, filename)) return false;
+
+    std::istringstream iss(sourceBuffer);
+    for (std::string line; std::getline(iss, line);)
+    {
+        if (line.find("#pragma import_defines") == std::string::npos) continue;
+
+        size_t start = line.find('(');
+        size_t end = line.find(')', start);
+        if (start == std::string::npos || end == std::string::npos) continue;
+
+        std::istringstream csv(line.substr(start + 1, end - start - 1));
+        for (std::string importedDef; std::getline(csv, importedDef, ',');)
+        {
+            importedDef.erase(std::remove_if(importedDef.begin(), importedDef.end(), ::isspace), importedDef.end());
+            if (importedDef == define) return true;
+        }
+    }
+    return false;
+}
+
 // create an fbx vertex shader
 
 std::string unity2vsg::createFbxVertexSource(const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines)
 {
     std::string source =
         "#version 450\n"
-        "#pragma import_defines ( VSG_NORMAL, VSG_TANGENT, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_NORMAL_MAP, VSG_BILLBOARD )\n"
+        "#pragma import_defines ( VSG_NORMAL, VSG_TANGENT, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_NORMAL_MAP, VSG_BILLBOARD, VSG_NORMAL_OCTAHEDRAL, VSG_TANGENT_OCTAHEDRAL, VSG_TRANSLATE, VSG_INSTANCE_MATRIX )\n"
         "#extension GL_ARB_separate_shader_objects : enable\n"
         "layout(push_constant) uniform PushConstants {\n"
         "    mat4 projection;\n"
@@ -221,12 +255,20 @@ std::string unity2vsg::createFbxVertexSource(const uint32_t& shaderModeMask, con
         "} pc; \n"
         "layout(location = 0) in vec3 osg_Vertex;\n"
         "#ifdef VSG_NORMAL\n"
+        "#ifdef VSG_NORMAL_OCTAHEDRAL\n"
+        "layout(location = 1) in vec2 osg_NormalOct;\n"
+        "#else\n"
         "layout(location = 1) in vec3 osg_Normal;\n"
+        "#endif\n"
         "layout(location = 1) out vec3 normalDir;\n"
         "#endif\n"
         "#ifdef VSG_TANGENT\n"
+        "#ifdef VSG_TANGENT_OCTAHEDRAL\n"
+        "layout(location = 2) in vec2 osg_TangentOct;\n"
+        "#else\n"
         "layout(location = 2) in vec4 osg_Tangent;\n"
         "#endif\n"
+        "#endif\n"
         "#ifdef VSG_COLOR\n"
         "layout(location = 3) in vec4 osg_Color;\n"
         "layout(location = 3) out vec4 vertColor;\n"
@@ -235,15 +277,42 @@ std::string unity2vsg::createFbxVertexSource(const uint32_t& shaderModeMask, con
         "layout(location = 4) in vec2 osg_MultiTexCoord0;\n"
         "layout(location = 4) out vec2 texCoord0;\n"
         "#endif\n"
+        "#ifdef VSG_TRANSLATE\n"
+        "layout(location = 6) in vec3 vsg_Translate;\n"
+        "#endif\n"
+        "#ifdef VSG_INSTANCE_MATRIX\n"
+        "layout(location = 6) in mat4 vsg_InstanceMatrix;\n"
+        "#endif\n"
         "#ifdef VSG_LIGHTING\n"
         "layout(location = 5) out vec3 viewDir;\n"
         "layout(location = 6) out vec3 lightDir;\n"
         "#endif\n"
         "out gl_PerVertex{ vec4 gl_Position; };\n"
         "\n"
+        "#if defined(VSG_NORMAL_OCTAHEDRAL) || defined(VSG_TANGENT_OCTAHEDRAL)\n"
+        "vec3 octDecode(vec2 e)\n"
+        "{\n"
+        "    vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));\n"
+        "    if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);\n"
+        "    return normalize(v);\n"
+        "}\n"
+        "#endif\n"
+        "\n"
         "void main()\n"
         "{\n"
+        "#ifdef VSG_NORMAL_OCTAHEDRAL\n"
+        "    vec3 osg_Normal = octDecode(osg_NormalOct);\n"
+        "#endif\n"
+        "#ifdef VSG_TANGENT_OCTAHEDRAL\n"
+        "    vec4 osg_Tangent = vec4(octDecode(vec2(osg_TangentOct.x, abs(osg_TangentOct.y) * 2.0 - 1.0)), osg_TangentOct.y < 0.0 ? -1.0 : 1.0);\n"
+        "#endif\n"
         "    mat4 modelView = pc.modelview;\n"
+        "#ifdef VSG_TRANSLATE\n"
+        "    modelView = modelView * mat4(1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, vsg_Translate, 1.0);\n"
+        "#endif\n"
+        "#ifdef VSG_INSTANCE_MATRIX\n"
+        "    modelView = modelView * vsg_InstanceMatrix;\n"
+        "#endif\n"
         "#ifdef VSG_BILLBOARD\n"
         "    // xaxis\n"
         "    modelView[0][0] = 1.0;\n"
@@ -307,7 +376,7 @@ std::string unity2vsg::createFbxFragmentSource(const uint32_t& shaderModeMask, c
 {
     std::string source =
         "#version 450\n"
-        "#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_MATERIAL, VSG_DIFFUSE_MAP, VSG_OPACITY_MAP, VSG_AMBIENT_MAP, VSG_NORMAL_MAP, VSG_SPECULAR_MAP )\n"
+        "#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_MATERIAL, VSG_DIFFUSE_MAP, VSG_OPACITY_MAP, VSG_AMBIENT_MAP, VSG_NORMAL_MAP, VSG_SPECULAR_MAP, VSG_PACKED_AMBIENT_MAP, VSG_PACKED_SPECULAR_MAP, VSG_PACKED_OPACITY_MAP )\n"
         "#extension GL_ARB_separate_shader_objects : enable\n"
         "#ifdef VSG_DIFFUSE_MAP\n"
         "layout(binding = 0) uniform sampler2D diffuseMap; \n"
@@ -324,6 +393,22 @@ std::string unity2vsg::createFbxFragmentSource(const uint32_t& shaderModeMask, c
         "#ifdef VSG_SPECULAR_MAP\n"
         "layout(binding = 6) uniform sampler2D specularMap; \n"
         "#endif\n"
+        "#if defined(VSG_PACKED_AMBIENT_MAP) || defined(VSG_PACKED_SPECULAR_MAP) || defined(VSG_PACKED_OPACITY_MAP)\n"
+        "#define PACKED_MAP\n"
+        "layout(binding = 7) uniform sampler2D packedMap;\n"
+        "#ifdef VSG_PACKED_AMBIENT_MAP\n"
+        "#define PACKED_AMBIENT_INDEX 0\n"
+        "#define PACKED_SPECULAR_FIRST 1\n"
+        "#else\n"
+        "#define PACKED_SPECULAR_FIRST 0\n"
+        "#endif\n"
+        "#ifdef VSG_PACKED_SPECULAR_MAP\n"
+        "#define PACKED_SPECULAR_INDEX PACKED_SPECULAR_FIRST\n"
+        "#define PACKED_OPACITY_INDEX (PACKED_SPECULAR_FIRST + 1)\n"
+        "#else\n"
+        "#define PACKED_OPACITY_INDEX PACKED_SPECULAR_FIRST\n"
+        "#endif\n"
+        "#endif\n"
 
         "#ifdef VSG_MATERIAL\n"
         "layout(binding = 10) uniform MaterialData\n"
@@ -371,11 +456,18 @@ std::string unity2vsg::createFbxFragmentSource(const uint32_t& shaderModeMask, c
         "    vec3 specularColor = vec3(0.3,0.3,0.3);\n"
         "    float shine = 16.0;\n"
         "#endif\n"
+        "#ifdef PACKED_MAP\n"
+        "    vec4 packedTexel = texture(packedMap, texCoord0.st);\n"
+        "#endif\n"
         "#ifdef VSG_AMBIENT_MAP\n"
         "    ambientColor *= texture(ambientMap, texCoord0.st).r;\n"
+        "#elif defined(VSG_PACKED_AMBIENT_MAP)\n"
+        "    ambientColor *= packedTexel[PACKED_AMBIENT_INDEX];\n"
         "#endif\n"
         "#ifdef VSG_SPECULAR_MAP\n"
         "    specularColor = texture(specularMap, texCoord0.st).rrr;\n"
+        "#elif defined(VSG_PACKED_SPECULAR_MAP)\n"
+        "    specularColor = vec3(packedTexel[PACKED_SPECULAR_INDEX]);\n"
         "#endif\n"
         "#ifdef VSG_LIGHTING\n"
         "#ifdef VSG_NORMAL_MAP\n"
@@ -405,6 +497,8 @@ std::string unity2vsg::createFbxFragmentSource(const uint32_t& shaderModeMask, c
         "    outColor = color;\n"
         "#ifdef VSG_OPACITY_MAP\n"
         "    outColor.a *= texture(opacityMap, texCoord0.st).r;\n"
+        "#elif defined(VSG_PACKED_OPACITY_MAP)\n"
+        "    outColor.a *= packedTexel[PACKED_OPACITY_INDEX];\n"
         "#endif\n"
         "}\n";
 
@@ -414,15 +508,23 @@ std::string unity2vsg::createFbxFragmentSource(const uint32_t& shaderModeMask, c
     return formatedSource;
 }
 
+// glslang's process wide state is set up the first time a compiler is created, the static is initialized once even when
+// export contexts on several threads get here together. It's never finalized, as a context compiling on one thread
+// would lose it to another finishing, it lives until the process exits instead.
+static void initializeGlslangProcess()
+{
+    static const bool initialized = glslang::InitializeProcess();
+    (void)initialized;
+}
+
 ShaderCompiler::ShaderCompiler(vsg::Allocator* allocator) :
     vsg::Object(allocator)
 {
-    glslang::InitializeProcess();
+    initializeGlslangProcess();
 }
 
 ShaderCompiler::~ShaderCompiler()
 {
-    glslang::FinalizeProcess();
 }
 
 bool ShaderCompiler::compile(vsg::ShaderStages& shaders)
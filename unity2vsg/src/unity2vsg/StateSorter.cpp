@@ -0,0 +1,278 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/StateSorter.h>
+
+#include <unity2vsg/Flattener.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    class BindCountVisitor : public vsg::Visitor
+    {
+    public:
+        BindCounts counts;
+
+        void count(vsg::Object* command)
+        {
+            if (dynamic_cast<vsg::BindGraphicsPipeline*>(command))
+                counts.pipelines++;
+            else if (dynamic_cast<vsg::BindDescriptorSet*>(command))
+                counts.descriptorSets++;
+        }
+
+        void apply(vsg::Object& object) override
+        {
+            object.traverse(*this);
+        }
+
+        void apply(vsg::StateGroup& stategroup) override
+        {
+            for (auto& command : stategroup.getStateCommands()) count(command.get());
+            stategroup.traverse(*this);
+        }
+
+        void apply(vsg::Commands& commands) override
+        {
+            for (auto& command : commands.getChildren()) count(command.get());
+        }
+    };
+
+    class BlendedVisitor : public vsg::Visitor
+    {
+    public:
+        bool blended = false;
+
+        void apply(vsg::Object& object) override
+        {
+            if (!blended) object.traverse(*this);
+        }
+
+        void apply(vsg::StateGroup& stategroup) override
+        {
+            for (auto& command : stategroup.getStateCommands()) blended = blended || isBlendedPipeline(command.get());
+            apply(static_cast<vsg::Object&>(stategroup));
+        }
+
+        void apply(vsg::Commands& commands) override
+        {
+            for (auto& command : commands.getChildren()) blended = blended || isBlendedPipeline(command.get());
+        }
+    };
+} // namespace
+
+BindCounts unity2vsg::countBinds(vsg::Node* node)
+{
+    BindCountVisitor bindCount;
+    node->accept(bindCount);
+    return bindCount.counts;
+}
+
+bool unity2vsg::isBlendedPipeline(vsg::Object* command)
+{
+    auto bindPipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(command);
+    if (!bindPipeline || !bindPipeline->getPipeline()) return false;
+
+    for (auto& state : bindPipeline->getPipeline()->getPipelineStates())
+    {
+        auto colorBlendState = dynamic_cast<const vsg::ColorBlendState*>(state.get());
+        if (!colorBlendState) continue;
+
+        for (auto& attachment : colorBlendState->getColorBlendAttachments())
+        {
+            if (attachment.blendEnable) return true;
+        }
+    }
+    return false;
+}
+
+bool unity2vsg::drawsBlended(vsg::Node* node)
+{
+    BlendedVisitor blended;
+    node->accept(blended);
+    return blended.blended;
+}
+
+//
+// StateSortVisitor
+//
+
+StateSortVisitor::StateSortVisitor() :
+    _anyBlended(true),
+    _hoistedCount(0)
+{
+}
+
+void StateSortVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void StateSortVisitor::apply(vsg::Group& group)
+{
+    if (!_visited.insert(&group).second) return;
+
+    for (auto& child : group.getChildren()) child->accept(*this);
+    sortChildren(group);
+}
+
+void StateSortVisitor::sort(vsg::Group& root)
+{
+    _parentCounts = countParents(&root);
+    _anyBlended = drawsBlended(&root);
+    root.accept(*this);
+
+    _parentCounts.clear();
+    _visited.clear();
+}
+
+bool StateSortVisitor::findCarrier(vsg::Group& group, vsg::Node* child, Carrier& carrier) const
+{
+    auto parentCount = [this](const vsg::Node* node) {
+        auto itr = _parentCounts.find(node);
+        return itr != _parentCounts.end() ? itr->second : 0;
+    };
+
+    vsg::Group* parent = &group;
+    vsg::Node* node = child;
+    while (parentCount(node) <= 1)
+    {
+        if (auto stategroup = dynamic_cast<vsg::StateGroup*>(node))
+        {
+            carrier.parent = parent;
+            carrier.stategroup = stategroup;
+            for (auto& command : stategroup->getStateCommands())
+            {
+                if (!carrier.pipeline && dynamic_cast<vsg::BindGraphicsPipeline*>(command.get()))
+                    carrier.pipeline = command.get();
+                else if (!carrier.descriptorSet && dynamic_cast<vsg::BindDescriptorSet*>(command.get()))
+                    carrier.descriptorSet = command.get();
+            }
+            return carrier.pipeline != nullptr;
+        }
+
+        // state set below a group with a single child applies to everything the group draws
+        auto single = dynamic_cast<vsg::Group*>(node);
+        if (!single || single->getChildren().size() != 1) return false;
+
+        parent = single;
+        node = single->getChildren()[0].get();
+    }
+    return false;
+}
+
+void StateSortVisitor::removeState(const Carrier& carrier, vsg::Group::Children& children, const vsg::ref_ptr<vsg::Node>& child, bool removeDescriptorSet)
+{
+    auto& commands = carrier.stategroup->getStateCommands();
+    commands.erase(std::remove_if(commands.begin(), commands.end(),
+                                  [&](const vsg::ref_ptr<vsg::StateCommand>& command) {
+                                      return command.get() == carrier.pipeline || (removeDescriptorSet && command.get() == carrier.descriptorSet);
+                                  }),
+                   commands.end());
+
+    // a StateGroup left with nothing to bind is replaced by its children
+    bool empty = commands.empty();
+    vsg::Group::Children grandchildren = carrier.stategroup->getChildren();
+    if (carrier.stategroup == child.get())
+    {
+        if (empty)
+            children.insert(children.end(), grandchildren.begin(), grandchildren.end());
+        else
+            children.push_back(child);
+        return;
+    }
+
+    children.push_back(child);
+    if (empty) carrier.parent->getChildren() = grandchildren;
+}
+
+void StateSortVisitor::sortChildren(vsg::Group& group)
+{
+    struct Entry
+    {
+        vsg::ref_ptr<vsg::Node> node;
+        Carrier carrier;
+        size_t pipelineRank;
+        size_t descriptorSetRank;
+        bool blended;
+    };
+
+    // ranks follow the order state is first seen in so the result doesn't depend on pointer values
+    std::map<const vsg::StateCommand*, size_t> ranks;
+    auto rankOf = [&ranks](const vsg::StateCommand* command) -> size_t {
+        if (!command) return 0;
+        return ranks.insert({command, ranks.size() + 1}).first->second;
+    };
+
+    std::vector<Entry> entries;
+    for (auto& child : group.getChildren())
+    {
+        Entry entry;
+        entry.node = child;
+        findCarrier(group, child.get(), entry.carrier);
+        entry.pipelineRank = rankOf(entry.carrier.pipeline);
+        entry.descriptorSetRank = rankOf(entry.carrier.descriptorSet);
+        entry.blended = _anyBlended && drawsBlended(child.get());
+        entries.push_back(entry);
+    }
+
+    // blended children keep their place so blended draws are drawn in the order they were exported, and nothing is moved
+    // past them as what they blend with would change. The children between them are sorted.
+    auto byState = [](const Entry& lhs, const Entry& rhs) {
+        if (lhs.pipelineRank != rhs.pipelineRank) return lhs.pipelineRank < rhs.pipelineRank;
+        return lhs.descriptorSetRank < rhs.descriptorSetRank;
+    };
+    for (auto first = entries.begin(); first != entries.end();)
+    {
+        auto last = std::find_if(first, entries.end(), [](const Entry& entry) { return entry.blended; });
+        std::stable_sort(first, last, byState);
+        first = last != entries.end() ? last + 1 : last;
+    }
+
+    vsg::Group::Children children;
+    for (size_t i = 0; i < entries.size();)
+    {
+        size_t end = i + 1;
+        while (end < entries.size() && entries[i].pipelineRank != 0 && entries[end].pipelineRank == entries[i].pipelineRank) ++end;
+
+        if (end - i < 2)
+        {
+            children.push_back(entries[i].node);
+            i = end;
+            continue;
+        }
+
+        bool sharedDescriptorSet = entries[i].carrier.descriptorSet != nullptr;
+        for (size_t j = i + 1; j < end; ++j)
+        {
+            sharedDescriptorSet = sharedDescriptorSet && entries[j].carrier.descriptorSet == entries[i].carrier.descriptorSet;
+        }
+
+        auto hoisted = vsg::StateGroup::create();
+        hoisted->add(vsg::ref_ptr<vsg::StateCommand>(entries[i].carrier.pipeline));
+        if (sharedDescriptorSet) hoisted->add(vsg::ref_ptr<vsg::StateCommand>(entries[i].carrier.descriptorSet));
+
+        for (size_t j = i; j < end; ++j)
+        {
+            removeState(entries[j].carrier, hoisted->getChildren(), entries[j].node, sharedDescriptorSet);
+        }
+
+        children.push_back(hoisted);
+        _hoistedCount++;
+        i = end;
+    }
+    group.getChildren() = children;
+}
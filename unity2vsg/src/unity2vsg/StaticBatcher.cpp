@@ -0,0 +1,374 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/StaticBatcher.h>
+
+#include <unity2vsg/Bounds.h>
+#include <unity2vsg/DebugLog.h>
+#include <unity2vsg/MatrixUtils.h>
+#include <unity2vsg/ShaderUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // upper 3x3 applied to a direction, m is given as columns
+    vsg::vec3 transformByColumns(const vsg::vec3* m, float x, float y, float z)
+    {
+        return vsg::vec3(m[0].x * x + m[1].x * y + m[2].x * z,
+                         m[0].y * x + m[1].y * y + m[2].y * z,
+                         m[0].z * x + m[1].z * y + m[2].z * z);
+    }
+
+    vsg::vec3 cross(const vsg::vec3& a, const vsg::vec3& b) { return vsg::vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+
+    vsg::vec3 normalize(const vsg::vec3& v)
+    {
+        float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        return length > 0.0f ? vsg::vec3(v.x / length, v.y / length, v.z / length) : v;
+    }
+
+    bool isFloatArray(const vsg::Data* array)
+    {
+        return dynamic_cast<const vsg::vec2Array*>(array) || dynamic_cast<const vsg::vec3Array*>(array) || dynamic_cast<const vsg::vec4Array*>(array);
+    }
+
+    vsg::ref_ptr<vsg::Data> createFloatArray(size_t valueSize, size_t count)
+    {
+        if (valueSize == sizeof(vsg::vec2)) return vsg::vec2Array::create(count);
+        if (valueSize == sizeof(vsg::vec3)) return vsg::vec3Array::create(count);
+        return vsg::vec4Array::create(count);
+    }
+} // namespace
+
+bool unity2vsg::transformableVertexArrays(const vsg::DataList& arrays, const VertexArrayAttributes& attributes, std::vector<uint32_t>& arrayAttributes)
+{
+    arrayAttributes.clear();
+    if (arrays.empty()) return false;
+
+    size_t vertexCount = arrays[0]->valueCount();
+    for (auto& array : arrays)
+    {
+        auto itr = attributes.find(array.get());
+        if (itr == attributes.end() || (itr->second & INSTANCE_ATTS) != 0) return false;
+        if (!isFloatArray(array.get()) || array->valueCount() != vertexCount) return false;
+        arrayAttributes.push_back(itr->second);
+    }
+    return arrayAttributes[0] == VERTEX && arrays[0]->valueSize() == sizeof(vsg::vec3);
+}
+
+vsg::DataList unity2vsg::createTransformedVertexArrays(const vsg::DataList& arrays, size_t vertexCount)
+{
+    vsg::DataList result;
+    for (auto& array : arrays) result.push_back(createFloatArray(array->valueSize(), vertexCount));
+    return result;
+}
+
+bool unity2vsg::transformVertexArrays(const vsg::mat4& m, const vsg::DataList& arrays, const std::vector<uint32_t>& arrayAttributes, vsg::DataList& output, size_t baseVertex)
+{
+    size_t vertexCount = arrays[0]->valueCount();
+
+    // normals use the cofactors of the upper 3x3, the inverse transpose up to scale, mirrored transforms flip the
+    // tangent handedness
+    vsg::vec3 columns[3] = {vsg::vec3(m[0][0], m[0][1], m[0][2]), vsg::vec3(m[1][0], m[1][1], m[1][2]), vsg::vec3(m[2][0], m[2][1], m[2][2])};
+    vsg::vec3 cofactors[3] = {cross(columns[1], columns[2]), cross(columns[2], columns[0]), cross(columns[0], columns[1])};
+    float determinant = columns[0].x * cofactors[0].x + columns[0].y * cofactors[0].y + columns[0].z * cofactors[0].z;
+    bool mirrored = determinant < 0.0f;
+
+    for (size_t a = 0; a < arrays.size(); ++a)
+    {
+        uint32_t attribute = arrayAttributes[a];
+        const float* src = static_cast<const float*>(arrays[a]->dataPointer());
+        size_t components = arrays[a]->valueSize() / sizeof(float);
+        float* dst = static_cast<float*>(output[a]->dataPointer()) + baseVertex * components;
+
+        for (size_t v = 0; v < vertexCount; ++v, src += components, dst += components)
+        {
+            if (attribute == VERTEX)
+            {
+                vsg::vec3 p = transformPoint(m, vsg::vec3(src[0], src[1], src[2]));
+                dst[0] = p.x;
+                dst[1] = p.y;
+                dst[2] = p.z;
+            }
+            else if (attribute == NORMAL || attribute == TANGENT)
+            {
+                vsg::vec3 n = attribute == NORMAL ? transformByColumns(cofactors, src[0], src[1], src[2]) : transformByColumns(columns, src[0], src[1], src[2]);
+                n = normalize(attribute == NORMAL && mirrored ? vsg::vec3(-n.x, -n.y, -n.z) : n);
+                dst[0] = n.x;
+                dst[1] = n.y;
+                dst[2] = n.z;
+                if (components == 4) dst[3] = mirrored ? -src[3] : src[3];
+            }
+            else
+            {
+                std::copy(src, src + components, dst);
+            }
+        }
+    }
+    return mirrored;
+}
+
+bool StaticBatchVisitor::Key::operator<(const Key& rhs) const
+{
+    if (pipeline != rhs.pipeline) return pipeline < rhs.pipeline;
+    if (descriptorSet != rhs.descriptorSet) return descriptorSet < rhs.descriptorSet;
+    if (layout != rhs.layout) return layout < rhs.layout;
+    return cell < rhs.cell;
+}
+
+StaticBatchVisitor::StaticBatchVisitor(float cellSize, const VertexArrayAttributes& attributes) :
+    _cellSize(cellSize),
+    _attributes(attributes),
+    _collectedCount(0),
+    _batchedCount(0),
+    _batchCount(0)
+{
+    _matrixStack.push_back(identityMatrix());
+}
+
+void StaticBatchVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void StaticBatchVisitor::apply(vsg::Group& group)
+{
+    // draws are recorded against their parent so they can be removed, anything else is traversed as normal
+    for (auto& child : group.getChildren())
+    {
+        auto stategroup = dynamic_cast<vsg::StateGroup*>(child.get());
+        if (stategroup && addDraw(group, *stategroup)) continue;
+        child->accept(*this);
+    }
+}
+
+void StaticBatchVisitor::apply(vsg::MatrixTransform& transform)
+{
+    _matrixStack.push_back(multiply(_matrixStack.back(), transform.getMatrix()));
+    apply(static_cast<vsg::Group&>(transform));
+    _matrixStack.pop_back();
+}
+
+void StaticBatchVisitor::apply(vsg::LOD& /*lod*/)
+{
+    // merging would draw every level at once
+}
+
+void StaticBatchVisitor::collect(vsg::Group& root)
+{
+    _root = &root;
+    apply(root);
+}
+
+bool StaticBatchVisitor::addDraw(vsg::Group& parent, vsg::StateGroup& stategroup)
+{
+    if (_collected.count(&stategroup) > 0) return true;
+
+    Draw draw;
+    draw.parent = &parent;
+    draw.stategroup = &stategroup;
+    draw.matrix = _matrixStack.back();
+
+    Key key;
+    key.pipeline = nullptr;
+    key.descriptorSet = nullptr;
+
+    for (auto& command : stategroup.getStateCommands())
+    {
+        if (dynamic_cast<vsg::BindGraphicsPipeline*>(command.get()) && !key.pipeline)
+            key.pipeline = command.get();
+        else if (dynamic_cast<vsg::BindDescriptorSet*>(command.get()) && !key.descriptorSet)
+            key.descriptorSet = command.get();
+        else
+            return false;
+    }
+    if (!key.pipeline || stategroup.getChildren().size() != 1) return false;
+
+    // the mesh is either a VertexIndexDraw or the commands drawing a mesh split into 16 bit ranges
+    vsg::Node* mesh = stategroup.getChildren()[0].get();
+    if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(mesh))
+    {
+        if (vid->instanceCount != 1) return false;
+        draw.arrays = vid->_arrays;
+        draw.indices = vid->_indices;
+        draw.ranges.push_back({vid->firstIndex, vid->indexCount, vid->vertexOffset});
+    }
+    else if (auto commands = dynamic_cast<vsg::Commands*>(mesh))
+    {
+        for (auto& command : commands->getChildren())
+        {
+            if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+            {
+                if (!draw.arrays.empty() || bvb->getFirstBinding() != 0) return false;
+                draw.arrays = bvb->getArrays();
+            }
+            else if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+            {
+                if (draw.indices.valid()) return false;
+                draw.indices = bib->getIndices();
+            }
+            else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+            {
+                if (!draw.indices.valid() || drawIndexed->instanceCount != 1) return false;
+                draw.ranges.push_back({drawIndexed->firstIndex, drawIndexed->indexCount, drawIndexed->vertexOffset});
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if (draw.arrays.empty() || !draw.indices.valid() || draw.ranges.empty()) return false;
+
+    // every array needs a known attribute and one float value per vertex, the first holding the positions
+    size_t vertexCount = draw.arrays[0]->valueCount();
+    if (vertexCount == 0 || vertexCount > MAX_BATCH_VERTICES / 2) return false;
+    if (!transformableVertexArrays(draw.arrays, _attributes, draw.attributes)) return false;
+    for (size_t a = 0; a < draw.arrays.size(); ++a)
+    {
+        key.layout.push_back(draw.attributes[a]);
+        key.layout.push_back(static_cast<uint32_t>(draw.arrays[a]->valueSize()));
+    }
+
+    for (auto& range : draw.ranges)
+    {
+        if (range.vertexOffset < 0 || static_cast<size_t>(range.firstIndex) + range.indexCount > draw.indices->valueCount()) return false;
+    }
+
+    // cell of the world space bound center
+    vsg::vec3 minimum, maximum;
+    vertexBounds(static_cast<const vsg::vec3*>(draw.arrays[0]->dataPointer()), draw.arrays[0]->valueCount(), minimum, maximum);
+    vsg::vec3 center = transformPoint(draw.matrix, vsg::vec3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f));
+    for (int i = 0; i < 3; ++i)
+    {
+        key.cell[i] = _cellSize > 0.0f ? static_cast<int64_t>(std::floor(center[i] / _cellSize)) : 0;
+    }
+
+    // batches are created in the order their first draw was found so the output doesn't depend on pointer values
+    auto itr = _keyIndices.find(key);
+    if (itr == _keyIndices.end())
+    {
+        itr = _keyIndices.insert({key, _draws.size()}).first;
+        _draws.emplace_back();
+    }
+    _draws[itr->second].push_back(draw);
+    _collected.insert(&stategroup);
+    _collectedCount++;
+    return true;
+}
+
+void StaticBatchVisitor::batch()
+{
+    for (auto& draws : _draws)
+    {
+        if (draws.size() < 2) continue;
+
+        // fill batches in order up to the vertex limit
+        std::vector<Draw*> batchDraws;
+        size_t vertexCount = 0;
+        for (auto& draw : draws)
+        {
+            size_t drawVertexCount = draw.arrays[0]->valueCount();
+            if (vertexCount + drawVertexCount > MAX_BATCH_VERTICES)
+            {
+                if (batchDraws.size() > 1) createBatch(batchDraws);
+                batchDraws.clear();
+                vertexCount = 0;
+            }
+            batchDraws.push_back(&draw);
+            vertexCount += drawVertexCount;
+        }
+        if (batchDraws.size() > 1) createBatch(batchDraws);
+    }
+    _draws.clear();
+    _keyIndices.clear();
+    _collected.clear();
+}
+
+void StaticBatchVisitor::createBatch(const std::vector<Draw*>& draws)
+{
+    const Draw& first = *draws[0];
+
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (auto draw : draws)
+    {
+        vertexCount += draw->arrays[0]->valueCount();
+        for (auto& range : draw->ranges) indexCount += range.indexCount;
+    }
+
+    vsg::DataList arrays = createTransformedVertexArrays(first.arrays, vertexCount);
+    for (size_t a = 0; a < arrays.size(); ++a)
+    {
+        _batchedArrays[arrays[a].get()] = first.arrays[a].get();
+    }
+    auto indices = vsg::ushortArray::create(indexCount);
+
+    size_t baseVertex = 0;
+    size_t baseIndex = 0;
+    for (auto draw : draws)
+    {
+        size_t drawVertexCount = draw->arrays[0]->valueCount();
+        bool mirrored = transformVertexArrays(draw->matrix, draw->arrays, draw->attributes, arrays, baseVertex);
+
+        std::vector<uint32_t> drawIndices;
+        for (auto& range : draw->ranges)
+        {
+            if (!readIndices(draw->indices.get(), range.firstIndex, range.indexCount, drawIndices)) continue;
+            for (size_t i = 0; i + 2 < drawIndices.size(); i += 3)
+            {
+                uint32_t base = static_cast<uint32_t>(baseVertex + range.vertexOffset);
+                (*indices)[baseIndex++] = static_cast<uint16_t>(drawIndices[i] + base);
+                (*indices)[baseIndex++] = static_cast<uint16_t>(drawIndices[mirrored ? i + 2 : i + 1] + base);
+                (*indices)[baseIndex++] = static_cast<uint16_t>(drawIndices[mirrored ? i + 1 : i + 2] + base);
+            }
+        }
+        baseVertex += drawVertexCount;
+
+        // the original goes, its parent is left for the graph to be tidied up later
+        auto& children = draw->parent->getChildren();
+        auto itr = std::find_if(children.begin(), children.end(), [draw](const vsg::ref_ptr<vsg::Node>& child) { return child.get() == draw->stategroup.get(); });
+        if (itr != children.end()) children.erase(itr);
+    }
+
+    auto geometry = vsg::VertexIndexDraw::create();
+    geometry->_arrays = arrays;
+    geometry->_indices = indices;
+    geometry->indexCount = static_cast<uint32_t>(baseIndex);
+    geometry->instanceCount = 1;
+
+    vsg::vec3 minimum, maximum;
+    vertexBounds(static_cast<const vsg::vec3*>(arrays[0]->dataPointer()), arrays[0]->valueCount(), minimum, maximum);
+
+    auto stategroup = vsg::StateGroup::create();
+    for (auto& command : first.stategroup->getStateCommands()) stategroup->add(command);
+    stategroup->addChild(geometry);
+
+    vsg::vec3 center((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+    vsg::vec3 extent(maximum.x - center.x, maximum.y - center.y, maximum.z - center.z);
+    auto cullGroup = vsg::CullGroup::create(vsg::sphere(center, std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z)));
+    cullGroup->addChild(stategroup);
+    _root->addChild(cullGroup);
+
+    _batchedCount += draws.size();
+    _batchCount++;
+}
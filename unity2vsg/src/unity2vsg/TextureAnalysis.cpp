@@ -0,0 +1,240 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <unity2vsg/TextureAnalysis.h>
+
+#include <unity2vsg/MipmapGenerator.h>
+#include <unity2vsg/Parallel.h>
+#include <unity2vsg/TextureCompressor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define UNITY2VSG_ANALYSIS_SSE2
+#    include <emmintrin.h>
+#endif
+
+using namespace unity2vsg;
+
+namespace
+{
+    // texels each job analyzes, small enough that a non constant texture stops soon after it starts
+    const size_t TEXELS_PER_JOB = 1 << 16;
+
+    uint32_t analyzeTexels(const uint8_t* texels, size_t begin, size_t end, uint32_t components, const uint8_t* first, uint32_t content)
+    {
+        const uint8_t* p = texels + begin * components;
+        size_t i = begin;
+
+#if defined(UNITY2VSG_ANALYSIS_SSE2)
+        if (components == 4)
+        {
+            uint32_t firstTexel;
+            std::memcpy(&firstTexel, first, sizeof(firstTexel));
+            const __m128i firstTexels = _mm_set1_epi32(static_cast<int>(firstTexel));
+            const __m128i colorBytes = _mm_set1_epi32(0x00ffffff); // set in every byte but the alpha, so only alpha can differ from 255
+            const __m128i ones = _mm_set1_epi32(-1);
+
+            // four texels at a time, any difference clears the content bit for good
+            for (; i + 4 <= end && content != 0; i += 4, p += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if ((content & CONTENT_CONSTANT) && _mm_movemask_epi8(_mm_cmpeq_epi8(v, firstTexels)) != 0xffff) content &= ~CONTENT_CONSTANT;
+                if ((content & CONTENT_OPAQUE) && _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(v, colorBytes), ones)) != 0xffff) content &= ~CONTENT_OPAQUE;
+
+                // each of the first two bytes of a texel against the byte after it, the color components are either order
+                if ((content & CONTENT_GRAYSCALE) && (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_srli_epi32(v, 8))) & 0x3333) != 0x3333) content &= ~CONTENT_GRAYSCALE;
+            }
+        }
+        else if (components == 1 && (content & CONTENT_CONSTANT))
+        {
+            const __m128i firstTexels = _mm_set1_epi8(static_cast<char>(first[0]));
+            for (; i + 16 <= end; i += 16, p += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, firstTexels)) != 0xffff)
+                {
+                    content &= ~CONTENT_CONSTANT;
+                    break;
+                }
+            }
+        }
+#endif
+
+        for (; i < end && content != 0; ++i, p += components)
+        {
+            if ((content & CONTENT_CONSTANT) && std::memcmp(p, first, components) != 0) content &= ~CONTENT_CONSTANT;
+            if ((content & CONTENT_OPAQUE) && components == 4 && p[3] != 255) content &= ~CONTENT_OPAQUE;
+            if ((content & CONTENT_GRAYSCALE) && components >= 3 && (p[0] != p[1] || p[1] != p[2])) content &= ~CONTENT_GRAYSCALE;
+        }
+        return content;
+    }
+
+    struct FormatInfo
+    {
+        uint32_t components = 0;
+        uint32_t redOffset = 0; // byte of the component shaders read as red
+        bool srgb = false;
+        bool bgr = false;
+    };
+
+    bool describeFormat(VkFormat format, FormatInfo& info)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R8_UNORM: info.components = 1; break;
+        case VK_FORMAT_R8_SRGB: info.components = 1; info.srgb = true; break;
+        case VK_FORMAT_R8G8_UNORM: info.components = 2; break;
+        case VK_FORMAT_R8G8_SRGB: info.components = 2; info.srgb = true; break;
+        case VK_FORMAT_B8G8R8_UNORM: info.components = 3; info.bgr = true; break;
+        case VK_FORMAT_B8G8R8_SRGB: info.components = 3; info.bgr = true; info.srgb = true; break;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32: info.components = 4; break;
+        case VK_FORMAT_R8G8B8A8_SRGB: info.components = 4; info.srgb = true; break;
+        case VK_FORMAT_B8G8R8A8_UNORM: info.components = 4; info.bgr = true; break;
+        case VK_FORMAT_B8G8R8A8_SRGB: info.components = 4; info.bgr = true; info.srgb = true; break;
+        default: return false;
+        }
+        info.redOffset = info.bgr ? 2 : 0;
+        return true;
+    }
+
+    std::string describeTexel(const uint8_t* texel, uint32_t components)
+    {
+        std::string text = "(";
+        for (uint32_t c = 0; c < components; ++c) text += (c > 0 ? ", " : "") + std::to_string(texel[c]);
+        return text + ")";
+    }
+} // namespace
+
+TextureAnalysis unity2vsg::analyzeTexture(const uint8_t* texels, size_t texelCount, uint32_t components)
+{
+    TextureAnalysis analysis;
+    if (texels == nullptr || texelCount == 0 || components < 1 || components > 4) return analysis;
+
+    std::memcpy(analysis.texel, texels, components);
+
+    uint32_t content = CONTENT_CONSTANT | CONTENT_OPAQUE | CONTENT_GRAYSCALE;
+    if (components == 2) content &= ~CONTENT_GRAYSCALE;
+
+    // only four component textures have an alpha to check and a single component is already grayscale
+    uint32_t found = content & (components == 4 ? (CONTENT_CONSTANT | CONTENT_OPAQUE | CONTENT_GRAYSCALE) : CONTENT_CONSTANT);
+    uint32_t given = content & ~found;
+
+    std::atomic<uint32_t> remaining(found);
+    size_t jobCount = (texelCount + TEXELS_PER_JOB - 1) / TEXELS_PER_JOB;
+    parallelFor(jobCount, [&](size_t job) {
+        uint32_t current = remaining.load();
+        if (current == 0) return;
+
+        size_t begin = job * TEXELS_PER_JOB;
+        size_t end = std::min(begin + TEXELS_PER_JOB, texelCount);
+        uint32_t result = analyzeTexels(texels, begin, end, components, analysis.texel, current);
+        if (result != current) remaining.fetch_and(result);
+    });
+
+    analysis.content = given | remaining.load();
+    return analysis;
+}
+
+bool unity2vsg::reduceTexture(const ImageData& image, const ReduceOptions& options, ReducedTexture& reduced)
+{
+    reduced = ReducedTexture();
+
+    FormatInfo info;
+    if (image.depth != 1 || image.width < 1 || image.height < 1 || !describeFormat(image.format, info)) return false;
+
+    uint32_t width = static_cast<uint32_t>(image.width);
+    uint32_t height = static_cast<uint32_t>(image.height);
+    uint32_t mipmapCount = std::min(static_cast<uint32_t>(std::max(image.mipmapCount, 1)), fullMipmapCount(width, height));
+    size_t chainTexels = mipmapChainSize(width, height, mipmapCount);
+    if (image.pixels.data == nullptr || image.pixels.length < 0 || static_cast<size_t>(image.pixels.length) < chainTexels * info.components) return false;
+
+    const uint8_t* pixels = image.pixels.data;
+    TextureAnalysis analysis = analyzeTexture(pixels, static_cast<size_t>(width) * height, info.components);
+
+    bool singleComponent = options.firstComponentOnly && info.components > 1;
+    bool compressed = options.compress && compressibleMipmapCount(width, height, mipmapCount) > 0;
+    bool constant = (analysis.content & CONTENT_CONSTANT) && (width > 1 || height > 1);
+    bool dropAlpha = !options.firstComponentOnly && !constant && info.components == 4 && (analysis.content & CONTENT_OPAQUE) && compressed;
+    if (!constant && !singleComponent && !dropAlpha) return false;
+
+    // single component srgb can't be block compressed, so it's stored as the linear values it samples as instead
+    bool linearize = singleComponent && info.srgb && options.compress && !constant;
+    uint8_t toLinear[256];
+    for (int i = 0; i < 256; ++i)
+    {
+        double c = i / 255.0;
+        double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+        toLinear[i] = static_cast<uint8_t>(linear * 255.0 + 0.5);
+    }
+
+    if (constant) reduced.reductions |= REDUCED_CONSTANT;
+    if (singleComponent) reduced.reductions |= REDUCED_FIRST_COMPONENT;
+    if (dropAlpha) reduced.reductions |= REDUCED_ALPHA;
+
+    if (constant)
+    {
+        reduced.width = 1;
+        reduced.height = 1;
+        reduced.mipmapCount = 1;
+        chainTexels = 1;
+    }
+    else
+    {
+        reduced.width = width;
+        reduced.height = height;
+        reduced.mipmapCount = mipmapCount;
+    }
+
+    std::string size = std::to_string(width) + "x" + std::to_string(height);
+    if (singleComponent)
+    {
+        reduced.format = info.srgb && !linearize ? VK_FORMAT_R8_SRGB : VK_FORMAT_R8_UNORM;
+        reduced.pixels.resize(chainTexels);
+        for (size_t t = 0; t < chainTexels; ++t)
+        {
+            uint8_t value = pixels[t * info.components + info.redOffset];
+            reduced.pixels[t] = linearize ? toLinear[value] : value;
+        }
+        reduced.reason = constant ? "is a constant " + describeTexel(analysis.texel, info.components) + " only read through its first component, reduced to a single 8 bit texel from " + size
+                                  : std::string("is only read through its first component") + ((analysis.content & CONTENT_GRAYSCALE) ? " and grayscale" : "") + ", reduced to 8 bit" +
+                                        (linearize ? " linear" : "") + " single component";
+    }
+    else if (dropAlpha)
+    {
+        // only ever an input to the block compressor, three component formats are rarely supported for sampling. The
+        // compressor and mipmap generator take three components as bgr.
+        reduced.format = info.srgb ? VK_FORMAT_B8G8R8_SRGB : VK_FORMAT_B8G8R8_UNORM;
+        reduced.pixels.resize(chainTexels * 3);
+        for (size_t t = 0; t < chainTexels; ++t)
+        {
+            const uint8_t* in = pixels + t * 4;
+            uint8_t* out = reduced.pixels.data() + t * 3;
+            out[0] = in[info.bgr ? 0 : 2];
+            out[1] = in[1];
+            out[2] = in[info.bgr ? 2 : 0];
+        }
+        reduced.reason = "is opaque, alpha dropped so it's block compressed as rgb";
+    }
+    else
+    {
+        reduced.format = image.format;
+        reduced.pixels.assign(pixels, pixels + info.components);
+        reduced.reason = "is a constant " + describeTexel(analysis.texel, info.components) + ", reduced to a single texel from " + size;
+    }
+    return true;
+}
@@ -0,0 +1,360 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/TextureArray.h>
+
+#include <unity2vsg/MipmapGenerator.h>
+#include <unity2vsg/Parallel.h>
+#include <unity2vsg/TextureCompressor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace unity2vsg;
+
+namespace
+{
+    struct ColorTables
+    {
+        float srgbToLinear[256];
+        float srgbThresholds[255]; // linear value half way between each pair of neighbouring srgb codes
+
+        ColorTables()
+        {
+            auto decode = [](double c) { return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4); };
+            for (int i = 0; i < 256; ++i) srgbToLinear[i] = static_cast<float>(decode(i / 255.0));
+            for (int i = 0; i < 255; ++i) srgbThresholds[i] = static_cast<float>(decode((i + 0.5) / 255.0));
+        }
+    };
+
+    const ColorTables& tables()
+    {
+        static const ColorTables s_tables;
+        return s_tables;
+    }
+
+    inline uint8_t encodeUnorm(float value)
+    {
+        return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    inline uint8_t encodeSrgb(float value)
+    {
+        const float* thresholds = tables().srgbThresholds;
+        return static_cast<uint8_t>(std::upper_bound(thresholds, thresholds + 255, value) - thresholds);
+    }
+
+    // rewrite the color components of an rgba image in the other color space, alpha is always linear
+    void convertColorSpace(std::vector<uint8_t>& rgba, bool toSrgb)
+    {
+        uint8_t table[256];
+        for (int i = 0; i < 256; ++i)
+        {
+            table[i] = toSrgb ? encodeSrgb(i / 255.0f) : encodeUnorm(tables().srgbToLinear[i]);
+        }
+
+        for (size_t i = 0; i < rgba.size(); i += 4)
+        {
+            for (size_t k = 0; k < 3; ++k) rgba[i + k] = table[rgba[i + k]];
+        }
+    }
+
+    // source texels and their weights for each destination texel along one axis
+    struct Taps
+    {
+        std::vector<size_t> offsets; // first tap of each destination texel followed by the total
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    Taps computeTaps(uint32_t sourceSize, uint32_t size)
+    {
+        Taps taps;
+        float scale = static_cast<float>(sourceSize) / size;
+        float radius = std::max(scale, 1.0f);
+
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            taps.offsets.push_back(taps.indices.size());
+
+            float center = (i + 0.5f) * scale - 0.5f;
+            int first = static_cast<int>(std::floor(center - radius));
+            int last = static_cast<int>(std::ceil(center + radius));
+
+            float total = 0.0f;
+            size_t begin = taps.weights.size();
+            for (int s = first; s <= last; ++s)
+            {
+                float weight = 1.0f - std::abs(s - center) / radius;
+                if (weight <= 0.0f) continue;
+
+                // the edge texels repeat outside the image
+                taps.indices.push_back(static_cast<uint32_t>(std::min(std::max(s, 0), static_cast<int>(sourceSize) - 1)));
+                taps.weights.push_back(weight);
+                total += weight;
+            }
+            for (size_t t = begin; t < taps.weights.size(); ++t) taps.weights[t] /= total;
+        }
+        taps.offsets.push_back(taps.indices.size());
+        return taps;
+    }
+} // namespace
+
+bool unity2vsg::readImageRGBA8(const ImageData& image, std::vector<uint8_t>& rgba, bool& srgb)
+{
+    if (image.width < 1 || image.height < 1 || image.depth > 1 || image.pixels.data == nullptr || image.pixels.length < 0) return false;
+
+    uint32_t width = static_cast<uint32_t>(image.width);
+    uint32_t height = static_cast<uint32_t>(image.height);
+    size_t texels = static_cast<size_t>(width) * height;
+    size_t length = static_cast<size_t>(image.pixels.length);
+
+    uint32_t components = 0;
+    bool swapRedBlue = false;
+    bool compressed = false;
+    bool punchThroughAlpha = false;
+    BlockCompression compression = BLOCK_BC1;
+    srgb = false;
+    switch (image.format)
+    {
+    case VK_FORMAT_R8_UNORM: components = 1; break;
+    case VK_FORMAT_R8_SRGB: components = 1; srgb = true; break;
+    case VK_FORMAT_R8G8_UNORM: components = 2; break;
+    case VK_FORMAT_R8G8_SRGB: components = 2; srgb = true; break;
+    case VK_FORMAT_B8G8R8_UNORM: components = 3; swapRedBlue = true; break;
+    case VK_FORMAT_B8G8R8_SRGB: components = 3; swapRedBlue = true; srgb = true; break;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_A8B8G8R8_UNORM_PACK32: components = 4; break;
+    case VK_FORMAT_R8G8B8A8_SRGB: components = 4; srgb = true; break;
+    case VK_FORMAT_B8G8R8A8_UNORM: components = 4; swapRedBlue = true; break;
+    case VK_FORMAT_B8G8R8A8_SRGB: components = 4; swapRedBlue = true; srgb = true; break;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK: compressed = true; break;
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK: compressed = true; srgb = true; break;
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: compressed = true; punchThroughAlpha = true; break;
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: compressed = true; punchThroughAlpha = true; srgb = true; break;
+    case VK_FORMAT_BC3_UNORM_BLOCK: compressed = true; compression = BLOCK_BC3; break;
+    case VK_FORMAT_BC3_SRGB_BLOCK: compressed = true; compression = BLOCK_BC3; srgb = true; break;
+    case VK_FORMAT_BC4_UNORM_BLOCK: compressed = true; compression = BLOCK_BC4; break;
+    case VK_FORMAT_BC5_UNORM_BLOCK: compressed = true; compression = BLOCK_BC5; break;
+    default: return false;
+    }
+
+    if (compressed)
+    {
+        if (length < compressedChainSize(width, height, 1, compression)) return false;
+        rgba.resize(texels * 4);
+        return decompressTexture(image.pixels.data, width, height, compression, punchThroughAlpha, rgba.data());
+    }
+
+    if (length < texels * components) return false;
+    rgba.resize(texels * 4);
+
+    const uint8_t* in = image.pixels.data;
+    uint8_t* out = rgba.data();
+    for (size_t i = 0; i < texels; ++i, in += components, out += 4)
+    {
+        out[0] = in[0];
+        out[1] = components > 1 ? in[1] : 0;
+        out[2] = components > 2 ? in[2] : 0;
+        out[3] = components > 3 ? in[3] : 255;
+        if (swapRedBlue) std::swap(out[0], out[2]);
+    }
+    return true;
+}
+
+void unity2vsg::resizeRGBA8(const uint8_t* source, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* destination, uint32_t width, uint32_t height, bool srgb)
+{
+    if (source == nullptr || destination == nullptr || sourceWidth == 0 || sourceHeight == 0 || width == 0 || height == 0) return;
+
+    const ColorTables& t = tables();
+    Taps columns = computeTaps(sourceWidth, width);
+    Taps rows = computeTaps(sourceHeight, height);
+
+    // resample each source row horizontally, then the columns of the result vertically
+    std::vector<float> horizontal(static_cast<size_t>(width) * sourceHeight * 4);
+    parallelFor(sourceHeight, [&](size_t y) {
+        const uint8_t* row = source + y * sourceWidth * 4;
+        float* out = horizontal.data() + y * width * 4;
+        for (uint32_t x = 0; x < width; ++x, out += 4)
+        {
+            float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (size_t tap = columns.offsets[x]; tap < columns.offsets[x + 1]; ++tap)
+            {
+                const uint8_t* texel = row + columns.indices[tap] * 4;
+                float weight = columns.weights[tap];
+                for (int k = 0; k < 3; ++k) sum[k] += weight * (srgb ? t.srgbToLinear[texel[k]] : texel[k] / 255.0f);
+                sum[3] += weight * (texel[3] / 255.0f);
+            }
+            std::memcpy(out, sum, sizeof(sum));
+        }
+    });
+
+    parallelFor(height, [&](size_t y) {
+        uint8_t* out = destination + y * width * 4;
+        for (uint32_t x = 0; x < width; ++x, out += 4)
+        {
+            float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (size_t tap = rows.offsets[y]; tap < rows.offsets[y + 1]; ++tap)
+            {
+                const float* texel = horizontal.data() + (static_cast<size_t>(rows.indices[tap]) * width + x) * 4;
+                for (int k = 0; k < 4; ++k) sum[k] += rows.weights[tap] * texel[k];
+            }
+            for (int k = 0; k < 3; ++k) out[k] = srgb ? encodeSrgb(sum[k]) : encodeUnorm(sum[k]);
+            out[3] = encodeUnorm(sum[3]);
+        }
+    });
+}
+
+bool unity2vsg::packTextureArray(const ImageData* images, uint32_t count, bool createMipmaps, PackedTextureArray& packed)
+{
+    packed = PackedTextureArray();
+    if (images == nullptr || count == 0) return false;
+
+    std::vector<std::vector<uint8_t>> layers(count);
+    std::vector<char> layerSrgb(count, 0);
+    bool readAny = false;
+    bool anyMipmaps = false;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bool srgb = false;
+        if (!readImageRGBA8(images[i], layers[i], srgb))
+        {
+            layers[i].clear();
+            packed.unreadable.push_back(i);
+            continue;
+        }
+
+        if (!readAny) packed.srgb = srgb;
+        readAny = true;
+        layerSrgb[i] = srgb;
+        anyMipmaps = anyMipmaps || images[i].mipmapCount > 1;
+        packed.width = std::max(packed.width, static_cast<uint32_t>(images[i].width));
+        packed.height = std::max(packed.height, static_cast<uint32_t>(images[i].height));
+    }
+    if (!readAny) return false;
+
+    packed.layers = count;
+    packed.mipmapCount = createMipmaps || anyMipmaps ? fullMipmapCount(packed.width, packed.height) : 1;
+
+    const size_t layerLevelSize = static_cast<size_t>(packed.width) * packed.height * 4;
+    std::vector<uint8_t> layerChain(mipmapChainSize(packed.width, packed.height, packed.mipmapCount) * 4);
+    packed.chain.resize(layerChain.size() * count);
+
+    MipmapOptions options;
+    options.components = 4;
+    options.srgb = packed.srgb;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        std::vector<uint8_t>& layer = layers[i];
+        uint32_t width = static_cast<uint32_t>(images[i].width);
+        uint32_t height = static_cast<uint32_t>(images[i].height);
+
+        if (layer.empty())
+        {
+            std::fill(layerChain.begin(), layerChain.begin() + layerLevelSize, static_cast<uint8_t>(255));
+        }
+        else
+        {
+            bool resize = width != packed.width || height != packed.height;
+            bool convert = static_cast<bool>(layerSrgb[i]) != packed.srgb;
+            if (convert) convertColorSpace(layer, packed.srgb);
+            if (resize) resizeRGBA8(layer.data(), width, height, layerChain.data(), packed.width, packed.height, packed.srgb);
+            else std::memcpy(layerChain.data(), layer.data(), layerLevelSize);
+            if (resize || convert) packed.converted++;
+        }
+        std::vector<uint8_t>().swap(layer);
+
+        options.filter = images[i].mipmapFilter == MIPMAP_FILTER_NORMAL ? MIPMAP_FILTER_NORMAL : MIPMAP_FILTER_COLOR;
+        options.alphaCutoff = images[i].alphaCutoff;
+        generateMipmaps(layerChain.data(), packed.width, packed.height, packed.mipmapCount, options);
+
+        // scatter the layers levels into the level major array
+        uint32_t levelWidth = packed.width, levelHeight = packed.height;
+        size_t levelOffset = 0;
+        for (uint32_t level = 0; level < packed.mipmapCount; ++level)
+        {
+            size_t levelSize = static_cast<size_t>(levelWidth) * levelHeight * 4;
+            std::memcpy(packed.chain.data() + levelOffset * count + levelSize * i, layerChain.data() + levelOffset, levelSize);
+            levelOffset += levelSize;
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
+        }
+    }
+    return true;
+}
+
+bool unity2vsg::packTextureChannels(const ImageData* images, uint32_t count, bool createMipmaps, PackedTextureChannels& packed)
+{
+    packed = PackedTextureChannels();
+    if (images == nullptr || count == 0 || count > 4) return false;
+
+    std::vector<std::vector<uint8_t>> sources(count);
+    std::vector<char> sourceSrgb(count, 0);
+    bool readAny = false;
+    bool anyMipmaps = false;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bool srgb = false;
+        if (!readImageRGBA8(images[i], sources[i], srgb))
+        {
+            sources[i].clear();
+            packed.unreadable.push_back(i);
+            continue;
+        }
+
+        // the shader reads the packed channel as unorm, so srgb values have to be stored as the linear values they decode to
+        if (srgb) convertColorSpace(sources[i], false);
+        sourceSrgb[i] = srgb;
+
+        readAny = true;
+        anyMipmaps = anyMipmaps || images[i].mipmapCount > 1;
+        packed.width = std::max(packed.width, static_cast<uint32_t>(images[i].width));
+        packed.height = std::max(packed.height, static_cast<uint32_t>(images[i].height));
+    }
+    if (!readAny) return false;
+
+    packed.mipmapCount = createMipmaps || anyMipmaps ? fullMipmapCount(packed.width, packed.height) : 1;
+    packed.components = count == 3 ? 4 : count;
+    packed.chain.assign(mipmapChainSize(packed.width, packed.height, packed.mipmapCount) * packed.components, static_cast<uint8_t>(255));
+
+    const size_t texelCount = static_cast<size_t>(packed.width) * packed.height;
+    std::vector<uint8_t> resized;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        std::vector<uint8_t>& source = sources[i];
+        if (source.empty()) continue;
+
+        uint32_t width = static_cast<uint32_t>(images[i].width);
+        uint32_t height = static_cast<uint32_t>(images[i].height);
+        const uint8_t* texels = source.data();
+        bool resize = width != packed.width || height != packed.height;
+        if (resize)
+        {
+            resized.resize(texelCount * 4);
+            resizeRGBA8(source.data(), width, height, resized.data(), packed.width, packed.height, false);
+            texels = resized.data();
+        }
+        if (resize || sourceSrgb[i]) packed.converted++;
+
+        uint8_t* channel = packed.chain.data() + i;
+        for (size_t t = 0; t < texelCount; ++t) channel[t * packed.components] = texels[t * 4];
+        std::vector<uint8_t>().swap(source);
+    }
+
+    // the components are unrelated data so each is filtered as linear color, alpha included
+    MipmapOptions options;
+    options.components = packed.components;
+    generateMipmaps(packed.chain.data(), packed.width, packed.height, packed.mipmapCount, options);
+    return true;
+}
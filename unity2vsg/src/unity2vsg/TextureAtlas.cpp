@@ -0,0 +1,480 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/TextureAtlas.h>
+
+#include <unity2vsg/DataCache.h>
+#include <unity2vsg/MipmapGenerator.h>
+#include <unity2vsg/ShaderUtils.h>
+#include <unity2vsg/TextureArray.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // uvs a little outside 0 to 1 are rounding, anything further is tiling the texture
+    const float UV_TOLERANCE = 1.0f / 1024.0f;
+
+    inline uint32_t alignUp(uint32_t value, uint32_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+    inline uint32_t powerOfTwoAtLeast(uint32_t value)
+    {
+        uint32_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    // the first uv array of a draw, null if it has none or it isn't float vec2s
+    const vsg::vec2Array* uvArray(const vsg::VertexIndexDraw& vid, const VertexArrayAttributes& attributes, size_t& index)
+    {
+        for (index = 0; index < vid._arrays.size(); ++index)
+        {
+            auto itr = attributes.find(vid._arrays[index].get());
+            if (itr != attributes.end() && itr->second == TEXCOORD0) return dynamic_cast<const vsg::vec2Array*>(vid._arrays[index].get());
+        }
+        return nullptr;
+    }
+
+    bool uvsInRange(const vsg::vec2Array* uvs)
+    {
+        const vsg::vec2* values = uvs->data();
+        for (size_t i = 0; i < uvs->valueCount(); ++i)
+        {
+            if (values[i].x < -UV_TOLERANCE || values[i].x > 1.0f + UV_TOLERANCE || values[i].y < -UV_TOLERANCE || values[i].y > 1.0f + UV_TOLERANCE) return false;
+        }
+        return true;
+    }
+
+    // decode a textures first level to rgba, block compressed data is sized in blocks so is scaled back to texels
+    bool readTexture(const vsg::Data* data, std::vector<uint8_t>& rgba, uint32_t& width, uint32_t& height, bool& srgb)
+    {
+        if (data == nullptr || data->depth() > 1) return false;
+
+        const vsg::Data::Layout& layout = data->getLayout();
+        ImageData image = {};
+        image.format = data->getFormat();
+        image.width = static_cast<int>(data->width() * std::max<uint32_t>(layout.blockWidth, 1));
+        image.height = static_cast<int>(data->height() * std::max<uint32_t>(layout.blockHeight, 1));
+        image.depth = 1;
+        image.pixels.data = static_cast<uint8_t*>(const_cast<void*>(data->dataPointer()));
+        image.pixels.length = static_cast<int>(std::min<size_t>(data->dataSize(), static_cast<size_t>(std::numeric_limits<int>::max())));
+
+        if (!readImageRGBA8(image, rgba, srgb)) return false;
+        width = static_cast<uint32_t>(image.width);
+        height = static_cast<uint32_t>(image.height);
+        return true;
+    }
+
+    // copy an rgba image into a page and repeat its edges out into the padding around it
+    void blitPadded(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* page, uint32_t pageWidth, const AtlasRect& rect, uint32_t padding)
+    {
+        for (uint32_t y = 0; y < rect.height; ++y)
+        {
+            uint32_t sourceY = static_cast<uint32_t>(std::min(std::max(static_cast<int64_t>(y) - padding, int64_t(0)), static_cast<int64_t>(height) - 1));
+            const uint8_t* sourceRow = rgba + static_cast<size_t>(sourceY) * width * 4;
+            uint8_t* row = page + (static_cast<size_t>(rect.y + y) * pageWidth + rect.x) * 4;
+
+            for (uint32_t x = 0; x < rect.width; ++x)
+            {
+                uint32_t sourceX = static_cast<uint32_t>(std::min(std::max(static_cast<int64_t>(x) - padding, int64_t(0)), static_cast<int64_t>(width) - 1));
+                std::memcpy(row + x * 4, sourceRow + sourceX * 4, 4);
+            }
+        }
+    }
+} // namespace
+
+//
+// SkylinePacker
+//
+
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height) :
+    _width(width),
+    _height(height),
+    _usedArea(0)
+{
+    _skyline.push_back({0, 0, width});
+}
+
+bool SkylinePacker::fits(size_t index, uint32_t width, uint32_t height, uint32_t& y) const
+{
+    if (_skyline[index].x + width > _width) return false;
+
+    // the rectangle rests on the highest segment it spans
+    y = 0;
+    uint32_t remaining = width;
+    for (size_t i = index; remaining > 0 && i < _skyline.size(); ++i)
+    {
+        y = std::max(y, _skyline[i].y);
+        if (y + height > _height) return false;
+        remaining -= std::min(remaining, _skyline[i].width);
+    }
+    return remaining == 0;
+}
+
+bool SkylinePacker::insert(uint32_t width, uint32_t height, AtlasRect& rect)
+{
+    if (width == 0 || height == 0) return false;
+
+    size_t best = _skyline.size();
+    uint32_t bestTop = std::numeric_limits<uint32_t>::max();
+    uint32_t bestSegmentWidth = std::numeric_limits<uint32_t>::max();
+    uint32_t bestY = 0;
+    for (size_t i = 0; i < _skyline.size(); ++i)
+    {
+        uint32_t y;
+        if (!fits(i, width, height, y)) continue;
+
+        uint32_t top = y + height;
+        if (top < bestTop || (top == bestTop && _skyline[i].width < bestSegmentWidth))
+        {
+            best = i;
+            bestTop = top;
+            bestSegmentWidth = _skyline[i].width;
+            bestY = y;
+        }
+    }
+    if (best == _skyline.size()) return false;
+
+    rect = {_skyline[best].x, bestY, width, height};
+    _skyline.insert(_skyline.begin() + best, Segment{rect.x, bestTop, width});
+
+    // trim the segments the new one now covers
+    uint32_t end = rect.x + width;
+    for (size_t i = best + 1; i < _skyline.size();)
+    {
+        Segment& segment = _skyline[i];
+        if (segment.x >= end) break;
+
+        uint32_t covered = end - segment.x;
+        if (segment.width <= covered)
+        {
+            _skyline.erase(_skyline.begin() + i);
+            continue;
+        }
+        segment.x += covered;
+        segment.width -= covered;
+        break;
+    }
+
+    // merge neighbours left at the same height
+    for (size_t i = 0; i + 1 < _skyline.size();)
+    {
+        if (_skyline[i].y == _skyline[i + 1].y)
+        {
+            _skyline[i].width += _skyline[i + 1].width;
+            _skyline.erase(_skyline.begin() + i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    _usedArea += static_cast<uint64_t>(width) * height;
+    return true;
+}
+
+//
+// TextureAtlasVisitor
+//
+
+TextureAtlasVisitor::TextureAtlasVisitor(const TextureAtlasOptions& options, const VertexArrayAttributes& attributes) :
+    _options(options),
+    _attributes(attributes),
+    _atlasedCount(0),
+    _pageCount(0),
+    _textureBytes(0),
+    _pageBytes(0)
+{
+}
+
+void TextureAtlasVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void TextureAtlasVisitor::apply(vsg::StateGroup& stategroup)
+{
+    if (addStateGroup(stategroup)) return;
+    stategroup.traverse(*this);
+}
+
+void TextureAtlasVisitor::collect(vsg::Group& root, GetMaterial getMaterial)
+{
+    _getMaterial = getMaterial;
+    root.accept(*this);
+}
+
+bool TextureAtlasVisitor::addStateGroup(vsg::StateGroup& stategroup)
+{
+    if (!_visited.insert(&stategroup).second) return true;
+
+    const vsg::BindGraphicsPipeline* pipeline = nullptr;
+    const vsg::BindDescriptorSet* bind = nullptr;
+    for (auto& command : stategroup.getStateCommands())
+    {
+        if (dynamic_cast<vsg::BindGraphicsPipeline*>(command.get()) && !pipeline)
+            pipeline = static_cast<const vsg::BindGraphicsPipeline*>(command.get());
+        else if (dynamic_cast<vsg::BindDescriptorSet*>(command.get()) && !bind)
+            bind = static_cast<const vsg::BindDescriptorSet*>(command.get());
+        else
+            return false;
+    }
+    if (!pipeline || !bind || stategroup.getChildren().empty() || _rejected.count(bind) > 0) return false;
+
+    // every draw needs uvs that don't tile, as the rest of the page would show through
+    for (auto& child : stategroup.getChildren())
+    {
+        auto vid = dynamic_cast<vsg::VertexIndexDraw*>(child.get());
+        if (!vid) return false;
+
+        size_t index;
+        const vsg::vec2Array* uvs = uvArray(*vid, _attributes, index);
+        if (!uvs || !uvsInRange(uvs)) return false;
+    }
+
+    auto itr = _entries.find(bind);
+    if (itr == _entries.end())
+    {
+        Entry entry;
+        entry.bind = bind;
+        if (!_getMaterial || !_getMaterial(bind, entry.material) || !entry.material.texture.valid() || entry.material.texture->getSamplerImages().size() != 1)
+        {
+            _rejected.insert(bind);
+            return false;
+        }
+        itr = _entries.emplace(bind, entry).first;
+    }
+    itr->second.stategroups.push_back(&stategroup);
+    return true;
+}
+
+void TextureAtlasVisitor::atlas(CreateDescriptorSet createDescriptorSet)
+{
+    // the materials that can share pages, grouped by everything other than their texture
+    std::map<uint64_t, std::vector<Placed>> groups;
+    for (auto& [bind, entry] : _entries)
+    {
+        const ImageData& sampler = entry.material.sampler;
+        if (sampler.mipmapFilter != MIPMAP_FILTER_COLOR || sampler.alphaCutoff > 0.0f) continue;
+
+        Placed placed;
+        placed.entry = &entry;
+        bool srgb = false;
+        if (!readTexture(entry.material.texture->getSamplerImages()[0].second.get(), placed.rgba, placed.width, placed.height, srgb)) continue;
+        if (placed.width > _options.maxTextureSize || placed.height > _options.maxTextureSize) continue;
+
+        uint64_t key = entry.material.key;
+        key = hashBytes(&sampler.filterMode, sizeof(sampler.filterMode), key);
+        key = hashBytes(&sampler.mipmapMode, sizeof(sampler.mipmapMode), key);
+        key = hashBytes(&sampler.anisoLevel, sizeof(sampler.anisoLevel), key);
+        key = (key << 1) | (srgb ? 1 : 0); // kept in the low bit for the page format
+        groups[key].push_back(std::move(placed));
+    }
+
+    for (auto& [key, materials] : groups)
+    {
+        if (materials.size() < 2) continue;
+
+        // tallest first packs best with a skyline
+        std::sort(materials.begin(), materials.end(), [](const Placed& lhs, const Placed& rhs) {
+            if (lhs.height != rhs.height) return lhs.height > rhs.height;
+            return lhs.width > rhs.width;
+        });
+
+        std::vector<SkylinePacker> packers;
+        std::vector<std::vector<Placed>> pages;
+        for (auto& placed : materials)
+        {
+            // padded sizes and places stay multiples of the padding so every kept mip level lines up on whole texels
+            uint32_t width = alignUp(placed.width + PADDING * 2, PADDING);
+            uint32_t height = alignUp(placed.height + PADDING * 2, PADDING);
+
+            size_t page = 0;
+            for (; page < packers.size(); ++page)
+            {
+                if (packers[page].insert(width, height, placed.rect)) break;
+            }
+            if (page == packers.size())
+            {
+                packers.emplace_back(_options.pageSize, _options.pageSize);
+                pages.emplace_back();
+                if (!packers.back().insert(width, height, placed.rect))
+                {
+                    packers.pop_back();
+                    pages.pop_back();
+                    continue;
+                }
+            }
+            pages[page].push_back(std::move(placed));
+        }
+
+        for (auto& page : pages)
+        {
+            // a page holding a single texture saves nothing
+            if (page.size() >= 2) createPage(page, (key & 1) != 0, createDescriptorSet);
+        }
+    }
+
+    _entries.clear();
+}
+
+void TextureAtlasVisitor::createPage(std::vector<Placed>& placed, bool srgb, const CreateDescriptorSet& createDescriptorSet)
+{
+    uint32_t usedWidth = 0, usedHeight = 0;
+    for (auto& p : placed)
+    {
+        usedWidth = std::max(usedWidth, p.rect.x + p.rect.width);
+        usedHeight = std::max(usedHeight, p.rect.y + p.rect.height);
+    }
+    uint32_t width = powerOfTwoAtLeast(usedWidth);
+    uint32_t height = powerOfTwoAtLeast(usedHeight);
+
+    uint32_t mipmapCount = _options.generateMipmaps ? std::min(fullMipmapCount(width, height), PADDING_LEVELS) : 1;
+    std::vector<uint8_t> chain(mipmapChainSize(width, height, mipmapCount) * 4, 0);
+    for (auto& p : placed)
+    {
+        blitPadded(p.rgba.data(), p.width, p.height, chain.data(), width, p.rect, PADDING);
+    }
+
+    MipmapOptions mipmapOptions;
+    mipmapOptions.components = 4;
+    mipmapOptions.srgb = srgb;
+    generateMipmaps(chain.data(), width, height, mipmapCount, mipmapOptions);
+
+    VkFormat format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    vsg::ref_ptr<vsg::Data> data;
+
+    CompressOptions compressOptions;
+    compressOptions.quality = _options.quality;
+    uint32_t compressibleLevels = compressibleMipmapCount(width, height, mipmapCount);
+    if (_options.quality > COMPRESSION_NONE && compressibleLevels > 0)
+    {
+        BlockCompression compression = chooseBlockCompression(chain.data(), static_cast<size_t>(width) * height, 4, _options.quality);
+        switch (compression)
+        {
+        case BLOCK_BC3: format = srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK; break;
+        case BLOCK_BC7: format = srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK; break;
+        default: format = srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK; break;
+        }
+
+        mipmapCount = compressibleLevels;
+        size_t compressedSize = compressedChainSize(width, height, mipmapCount, compression);
+        if (blockBytes(compression) == 8)
+        {
+            vsg::block64* blocks = new vsg::block64[compressedSize / sizeof(vsg::block64)];
+            compressTexture(chain.data(), width, height, mipmapCount, compression, compressOptions, reinterpret_cast<uint8_t*>(blocks));
+            data = new vsg::block64Array2D(width / 4, height / 4, blocks);
+        }
+        else
+        {
+            vsg::block128* blocks = new vsg::block128[compressedSize / sizeof(vsg::block128)];
+            compressTexture(chain.data(), width, height, mipmapCount, compression, compressOptions, reinterpret_cast<uint8_t*>(blocks));
+            data = new vsg::block128Array2D(width / 4, height / 4, blocks);
+        }
+    }
+    else
+    {
+        vsg::ubvec4* texels = new vsg::ubvec4[chain.size() / 4];
+        std::memcpy(texels, chain.data(), chain.size());
+        data = new vsg::ubvec4Array2D(width, height, texels);
+    }
+
+    VkFormatSizeInfo sizeInfo = GetSizeInfoForFormat(format);
+    sizeInfo.layout.maxNumMipmaps = mipmapCount;
+    data->setFormat(format);
+    data->setLayout(sizeInfo.layout);
+
+    // the padding stands in for clamping, repeat would wrap onto the far side of the page
+    ImageData sampler = placed[0].entry->material.sampler;
+    sampler.pixels = {};
+    sampler.format = format;
+    sampler.width = static_cast<int>(width);
+    sampler.height = static_cast<int>(height);
+    sampler.depth = 1;
+    sampler.wrapMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler.mipmapCount = static_cast<int>(mipmapCount);
+
+    vsg::ref_ptr<vsg::BindDescriptorSet> bind = createDescriptorSet(placed[0].entry->bind, data, sampler);
+    if (!bind.valid()) return;
+
+    for (auto& p : placed)
+    {
+        float scaleX = static_cast<float>(p.width) / width, scaleY = static_cast<float>(p.height) / height;
+        float offsetX = static_cast<float>(p.rect.x + PADDING) / width, offsetY = static_cast<float>(p.rect.y + PADDING) / height;
+
+        // meshes are shared between materials so draws get a copy with their uvs rewritten, shared by the material's draws
+        std::map<const vsg::Node*, vsg::ref_ptr<vsg::Node>> atlasedDraws;
+        std::map<const vsg::Data*, vsg::ref_ptr<vsg::Data>> atlasedUvs;
+        vsg::Group::Children replaced; // keeps the originals alive while they're used as keys
+        for (auto stategroup : p.entry->stategroups)
+        {
+            for (auto& command : stategroup->getStateCommands())
+            {
+                if (command.get() == p.entry->bind) command = bind;
+            }
+
+            for (auto& child : stategroup->getChildren())
+            {
+                auto drawItr = atlasedDraws.find(child.get());
+                if (drawItr != atlasedDraws.end())
+                {
+                    child = drawItr->second;
+                    continue;
+                }
+
+                auto vid = static_cast<vsg::VertexIndexDraw*>(child.get());
+                size_t index;
+                const vsg::vec2Array* uvs = uvArray(*vid, _attributes, index);
+
+                auto uvItr = atlasedUvs.find(uvs);
+                if (uvItr == atlasedUvs.end())
+                {
+                    vsg::ref_ptr<vsg::vec2Array> rewritten(new vsg::vec2Array(uvs->valueCount()));
+                    const vsg::vec2* source = uvs->data();
+                    vsg::vec2* destination = rewritten->data();
+                    for (size_t i = 0; i < uvs->valueCount(); ++i)
+                    {
+                        destination[i].x = offsetX + std::min(std::max(source[i].x, 0.0f), 1.0f) * scaleX;
+                        destination[i].y = offsetY + std::min(std::max(source[i].y, 0.0f), 1.0f) * scaleY;
+                    }
+                    _atlasedArrays[rewritten.get()] = uvs;
+                    uvItr = atlasedUvs.emplace(uvs, rewritten).first;
+                }
+
+                auto atlasedVid = vsg::VertexIndexDraw::create();
+                atlasedVid->_arrays = vid->_arrays;
+                atlasedVid->_arrays[index] = uvItr->second;
+                atlasedVid->_indices = vid->_indices;
+                atlasedVid->indexCount = vid->indexCount;
+                atlasedVid->instanceCount = vid->instanceCount;
+                atlasedVid->firstIndex = vid->firstIndex;
+                atlasedVid->vertexOffset = vid->vertexOffset;
+                atlasedVid->firstInstance = vid->firstInstance;
+
+                atlasedDraws[child.get()] = atlasedVid;
+                replaced.push_back(child);
+                child = atlasedVid;
+            }
+        }
+
+        _textureBytes += static_cast<size_t>(p.width) * p.height * 4;
+        _atlasedCount++;
+    }
+
+    _pageBytes += static_cast<size_t>(width) * height * 4;
+    _pageCount++;
+}
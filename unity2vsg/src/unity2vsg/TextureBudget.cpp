@@ -0,0 +1,177 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/TextureBudget.h>
+
+#include <unity2vsg/MipTrimmer.h>
+#include <unity2vsg/MipmapGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+using namespace unity2vsg;
+
+namespace
+{
+    bool isSrgb(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R8_SRGB:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_SRGB:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB: return true;
+        default: return false;
+        }
+    }
+
+    // filter the first level down through the chain the mipmap generator would build and keep the last level
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> resampleArray2D(const vsg::Data* data, uint32_t levels, const MipmapOptions& options)
+    {
+        auto array = dynamic_cast<const vsg::Array2D<T>*>(data);
+        if (!array) return vsg::ref_ptr<vsg::Data>();
+
+        uint32_t width = array->width();
+        uint32_t height = array->height();
+        std::vector<uint8_t> chain(mipmapChainSize(width, height, levels + 1) * sizeof(T));
+        std::memcpy(chain.data(), array->dataPointer(), static_cast<size_t>(width) * height * sizeof(T));
+        generateMipmaps(chain.data(), width, height, levels + 1, options);
+
+        uint32_t levelWidth = std::max(width >> levels, 1u);
+        uint32_t levelHeight = std::max(height >> levels, 1u);
+        T* texels = new T[static_cast<size_t>(levelWidth) * levelHeight];
+        std::memcpy(texels, chain.data() + mipmapChainSize(width, height, levels) * sizeof(T), static_cast<size_t>(levelWidth) * levelHeight * sizeof(T));
+
+        vsg::ref_ptr<vsg::Data> resampled(new vsg::Array2D<T>(levelWidth, levelHeight, texels));
+        resampled->setFormat(array->getFormat());
+        resampled->setLayout(array->getLayout());
+        return resampled;
+    }
+
+    struct BudgetStep
+    {
+        double cost; // importance lost per byte saved
+        size_t index;
+        size_t bytes; // bytes of the texture after the step
+
+        bool operator>(const BudgetStep& rhs) const { return cost != rhs.cost ? cost > rhs.cost : index > rhs.index; }
+    };
+
+} // namespace
+
+float unity2vsg::textureRoleWeight(TextureRole role)
+{
+    switch (role)
+    {
+    case TEXTURE_ROLE_NORMAL: return 0.75f;
+    case TEXTURE_ROLE_MASK: return 0.5f;
+    default: return 1.0f;
+    }
+}
+
+size_t unity2vsg::downsampledBytes(const vsg::Data* data, uint32_t levels, uint32_t minimumSize)
+{
+    if (!data) return 0;
+    if (levels == 0) return textureBytes(data);
+    if (data->depth() > 1 || levels >= 32) return 0;
+
+    const vsg::Data::Layout& layout = data->getLayout();
+    uint32_t blockWidth = std::max<uint32_t>(layout.blockWidth, 1);
+    uint32_t blockHeight = std::max<uint32_t>(layout.blockHeight, 1);
+    uint32_t width = data->width();
+    uint32_t height = data->height();
+    if ((std::min(width * blockWidth, height * blockHeight) >> levels) < std::max(minimumSize, 1u)) return 0;
+
+    // the same levels trimMipmaps keeps
+    uint32_t chain = textureLevels(data);
+    if (chain > levels) return (mipmapChainSize(width, height, chain) - mipmapChainSize(width, height, levels)) * data->valueSize();
+
+    if (chain > 1 || blockWidth > 1 || blockHeight > 1 || data->valueSize() > 4) return 0;
+    return static_cast<size_t>(std::max(width >> levels, 1u)) * std::max(height >> levels, 1u) * data->valueSize();
+}
+
+size_t unity2vsg::planTextureBudget(std::vector<BudgetTexture>& textures, const TextureBudgetOptions& options)
+{
+    double totalArea = 0.0;
+    double totalDraws = 0.0;
+    size_t total = 0;
+    for (auto& texture : textures)
+    {
+        texture.levels = 0;
+        texture.bytesBefore = texture.bytesAfter = downsampledBytes(texture.data.get(), 0, options.minimumSize);
+        totalArea += texture.area;
+        totalDraws += texture.draws;
+        total += texture.bytesBefore;
+    }
+
+    // textures only drawn by lower LOD levels have no share but still rank by role, ahead of everything that's drawn
+    for (auto& texture : textures)
+    {
+        double share = 0.5 * (totalArea > 0.0 ? texture.area / totalArea : 0.0) + 0.5 * (totalDraws > 0.0 ? texture.draws / totalDraws : 0.0);
+        texture.importance = textureRoleWeight(texture.role) * static_cast<float>(share + 1e-6);
+    }
+    if (total <= options.budget) return total;
+
+    std::priority_queue<BudgetStep, std::vector<BudgetStep>, std::greater<BudgetStep>> steps;
+    auto addStep = [&](size_t index) {
+        const BudgetTexture& texture = textures[index];
+        size_t bytes = downsampledBytes(texture.data.get(), texture.levels + 1, options.minimumSize);
+        if (bytes == 0 || bytes >= texture.bytesAfter) return;
+        double cost = texture.importance * std::ldexp(1.0, static_cast<int>(texture.levels)) / static_cast<double>(texture.bytesAfter - bytes);
+        steps.push({cost, index, bytes});
+    };
+    for (size_t i = 0; i < textures.size(); ++i) addStep(i);
+
+    while (total > options.budget && !steps.empty())
+    {
+        BudgetStep step = steps.top();
+        steps.pop();
+
+        BudgetTexture& texture = textures[step.index];
+        total -= texture.bytesAfter - step.bytes;
+        texture.bytesAfter = step.bytes;
+        texture.levels++;
+        addStep(step.index);
+    }
+
+    return total;
+}
+
+vsg::ref_ptr<vsg::Data> unity2vsg::downsampleTexture(const vsg::Data* data, uint32_t levels, TextureRole role)
+{
+    if (!data || levels == 0 || data->depth() > 1) return vsg::ref_ptr<vsg::Data>();
+    if (textureLevels(data) > levels) return trimMipmaps(data, levels);
+
+    const vsg::Data::Layout& layout = data->getLayout();
+    if (textureLevels(data) > 1 || layout.blockWidth > 1 || layout.blockHeight > 1) return vsg::ref_ptr<vsg::Data>();
+    if (levels >= fullMipmapCount(data->width(), data->height())) return vsg::ref_ptr<vsg::Data>();
+
+    MipmapOptions options;
+    options.components = static_cast<uint32_t>(data->valueSize());
+    options.srgb = isSrgb(data->getFormat());
+    options.filter = role == TEXTURE_ROLE_NORMAL ? MIPMAP_FILTER_NORMAL : MIPMAP_FILTER_COLOR;
+
+    switch (data->valueSize())
+    {
+    case 1: return resampleArray2D<uint8_t>(data, levels, options);
+    case 2: return resampleArray2D<vsg::ubvec2>(data, levels, options);
+    case 3: return resampleArray2D<vsg::ubvec3>(data, levels, options);
+    case 4: return resampleArray2D<vsg::ubvec4>(data, levels, options);
+    default: return vsg::ref_ptr<vsg::Data>();
+    }
+}
@@ -0,0 +1,242 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/TextureCache.h>
+
+#include <unity2vsg/DataCache.h>
+#include <unity2vsg/TextureArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // everything other than the pixels that has to match for two images to create the same Data
+    struct ImageSettings
+    {
+        uint32_t format;
+        int32_t width;
+        int32_t height;
+        int32_t depth;
+        int32_t mipmapCount;
+        int32_t mipmapFilter;
+        float alphaCutoff;
+    };
+
+    ImageSettings describe(const ImageData& image)
+    {
+        ImageSettings settings = {};
+        settings.format = static_cast<uint32_t>(image.format);
+        settings.width = image.width;
+        settings.height = image.height;
+        settings.depth = image.depth;
+        settings.mipmapCount = std::max(image.mipmapCount, 1);
+        settings.mipmapFilter = image.mipmapFilter;
+        settings.alphaCutoff = image.alphaCutoff;
+        return settings;
+    }
+
+    bool operator==(const ImageSettings& lhs, const ImageSettings& rhs)
+    {
+        return lhs.format == rhs.format && lhs.width == rhs.width && lhs.height == rhs.height && lhs.depth == rhs.depth &&
+               lhs.mipmapCount == rhs.mipmapCount && lhs.mipmapFilter == rhs.mipmapFilter && lhs.alphaCutoff == rhs.alphaCutoff;
+    }
+
+    size_t pixelBytes(const ImageData& image)
+    {
+        return image.pixels.data != nullptr && image.pixels.length > 0 ? static_cast<size_t>(image.pixels.length) : 0;
+    }
+
+    uint64_t hashSettings(const ImageData& image)
+    {
+        ImageSettings settings = describe(image);
+        return hashBytes(&settings, sizeof(ImageSettings));
+    }
+
+    bool samePixels(const ImageData& lhs, const ImageData& rhs)
+    {
+        size_t size = pixelBytes(lhs);
+        if (size != pixelBytes(rhs)) return false;
+        return size == 0 || lhs.pixels.data == rhs.pixels.data || std::memcmp(lhs.pixels.data, rhs.pixels.data, size) == 0;
+    }
+
+    float rmsDifference(const uint8_t* lhs, const uint8_t* rhs, size_t count)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int d = static_cast<int>(lhs[i]) - static_cast<int>(rhs[i]);
+            sum += static_cast<uint64_t>(d * d);
+        }
+        return count > 0 ? static_cast<float>(std::sqrt(static_cast<double>(sum) / static_cast<double>(count))) : 0.0f;
+    }
+} // namespace
+
+uint64_t unity2vsg::hashImage(const ImageData& image)
+{
+    return hashBytes(image.pixels.data, pixelBytes(image), hashSettings(image));
+}
+
+bool unity2vsg::measureImageDifference(const ImageData& lhs, const ImageData& rhs, float& rms, float& tileRms)
+{
+    if (lhs.width != rhs.width || lhs.height != rhs.height) return false;
+
+    std::vector<uint8_t> lhsTexels, rhsTexels;
+    bool lhsSrgb = false, rhsSrgb = false;
+    if (!readImageRGBA8(lhs, lhsTexels, lhsSrgb) || !readImageRGBA8(rhs, rhsTexels, rhsSrgb)) return false;
+
+    uint32_t width = static_cast<uint32_t>(lhs.width);
+    uint32_t height = static_cast<uint32_t>(lhs.height);
+    const uint32_t tileSize = TextureCache::TILE_SIZE;
+
+    uint64_t total = 0;
+    uint64_t largestTile = 0;
+    size_t largestTileCount = 1;
+    for (uint32_t ty = 0; ty < height; ty += tileSize)
+    {
+        uint32_t rows = std::min(tileSize, height - ty);
+        for (uint32_t tx = 0; tx < width; tx += tileSize)
+        {
+            uint32_t columns = std::min(tileSize, width - tx);
+            uint64_t sum = 0;
+            for (uint32_t y = ty; y < ty + rows; ++y)
+            {
+                const uint8_t* a = lhsTexels.data() + (static_cast<size_t>(y) * width + tx) * 4;
+                const uint8_t* b = rhsTexels.data() + (static_cast<size_t>(y) * width + tx) * 4;
+                for (uint32_t i = 0; i < columns * 4; ++i)
+                {
+                    int d = static_cast<int>(a[i]) - static_cast<int>(b[i]);
+                    sum += static_cast<uint64_t>(d * d);
+                }
+            }
+            total += sum;
+
+            // compare mean squares without dividing, edge tiles hold fewer texels
+            size_t count = static_cast<size_t>(rows) * columns * 4;
+            if (sum * largestTileCount > largestTile * count)
+            {
+                largestTile = sum;
+                largestTileCount = count;
+            }
+        }
+    }
+
+    rms = static_cast<float>(std::sqrt(static_cast<double>(total) / (static_cast<double>(width) * height * 4)));
+    tileRms = static_cast<float>(std::sqrt(static_cast<double>(largestTile) / static_cast<double>(largestTileCount)));
+    return true;
+}
+
+//
+// TextureCache
+//
+
+TextureCache::TextureCache() :
+    _tolerance(0.0f),
+    _uniqueCount(0),
+    _exactCount(0),
+    _nearCount(0),
+    _bytesSaved(0)
+{
+}
+
+const std::vector<uint8_t>& TextureCache::fingerprint(Entry& entry)
+{
+    if (!entry.fingerprinted)
+    {
+        entry.fingerprinted = true;
+
+        std::vector<uint8_t> texels;
+        bool srgb = false;
+        if (readImageRGBA8(entry.image, texels, srgb))
+        {
+            // filtered without the srgb conversion so a thumbnails difference is an average of the full size differences
+            entry.fingerprint.resize(FINGERPRINT_SIZE * FINGERPRINT_SIZE * 4);
+            resizeRGBA8(texels.data(), static_cast<uint32_t>(entry.image.width), static_cast<uint32_t>(entry.image.height), entry.fingerprint.data(), FINGERPRINT_SIZE, FINGERPRINT_SIZE, false);
+        }
+    }
+    return entry.fingerprint;
+}
+
+vsg::ref_ptr<vsg::Data> TextureCache::share(const ImageData& image, const CreateData& createData, uint64_t salt)
+{
+    uint64_t settingsHash = hashSettings(image) ^ salt;
+    uint64_t hash = hashImage(image) ^ salt;
+    ImageSettings settings = describe(image);
+
+    auto exact = _exactEntries.equal_range(hash);
+    for (auto it = exact.first; it != exact.second; ++it)
+    {
+        Entry& entry = _entries[it->second];
+        if (entry.salt == salt && describe(entry.image) == settings && samePixels(entry.image, image))
+        {
+            _exactCount++;
+            _bytesSaved += entry.data->dataSize();
+            return entry.data;
+        }
+    }
+
+    Entry candidate;
+    candidate.salt = salt;
+    candidate.image = image;
+
+    if (_tolerance > 0.0f)
+    {
+        auto similar = _similarEntries.equal_range(settingsHash);
+        const std::vector<uint8_t>& print = similar.first != similar.second ? fingerprint(candidate) : candidate.fingerprint;
+        for (auto it = similar.first; !print.empty() && it != similar.second; ++it)
+        {
+            Entry& entry = _entries[it->second];
+            if (entry.salt != salt || !(describe(entry.image) == settings)) continue;
+
+            // thumbnails are a cheap lower bound on the full size difference, give or take their rounding
+            const std::vector<uint8_t>& other = fingerprint(entry);
+            if (other.empty() || rmsDifference(print.data(), other.data(), print.size()) > _tolerance + 1.0f) continue;
+
+            float rms = 0.0f, tileRms = 0.0f;
+            if (!measureImageDifference(entry.image, image, rms, tileRms)) continue;
+            if (rms > _tolerance || tileRms > _tolerance * TILE_TOLERANCE_SCALE) continue;
+
+            _nearCount++;
+            _bytesSaved += entry.data->dataSize();
+
+            // later exact copies of this image match straight away, but it's never a near match for anything else so
+            // matches can't drift away from the first image through a series of small differences
+            candidate.data = entry.data;
+            _exactEntries.emplace(hash, _entries.size());
+            _entries.push_back(std::move(candidate));
+            return _entries.back().data;
+        }
+    }
+
+    candidate.data = createData(image);
+    if (!candidate.data.valid()) return candidate.data;
+
+    _uniqueCount++;
+    _exactEntries.emplace(hash, _entries.size());
+    _similarEntries.emplace(settingsHash, _entries.size());
+    _entries.push_back(std::move(candidate));
+    return _entries.back().data;
+}
+
+void TextureCache::clear()
+{
+    _entries.clear();
+    _exactEntries.clear();
+    _similarEntries.clear();
+    _uniqueCount = 0;
+    _exactCount = 0;
+    _nearCount = 0;
+    _bytesSaved = 0;
+}
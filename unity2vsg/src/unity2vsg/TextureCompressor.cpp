@@ -0,0 +1,759 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/TextureCompressor.h>
+
+#include <unity2vsg/MipmapGenerator.h>
+#include <unity2vsg/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // blocks encoded by each job handed to parallelFor
+    const uint32_t BLOCKS_PER_JOB = 256;
+
+    // the 16 texels of a block as rgba, missing components are 0 and missing alpha is 255
+    typedef uint8_t BlockTexels[16][4];
+
+    template<int N>
+    float distance2(const float* a, const float* b)
+    {
+        float d = 0.0f;
+        for (int k = 0; k < N; ++k) d += (a[k] - b[k]) * (a[k] - b[k]);
+        return d;
+    }
+
+    // mean and dominant direction of the first N components of the texels, by power iteration on the covariance
+    template<int N>
+    void principalAxis(const BlockTexels& texels, float mean[N], float axis[N])
+    {
+        for (int k = 0; k < N; ++k) mean[k] = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int k = 0; k < N; ++k) mean[k] += texels[i][k];
+        }
+        for (int k = 0; k < N; ++k) mean[k] /= 16.0f;
+
+        float covariance[N][N] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float d[N];
+            for (int k = 0; k < N; ++k) d[k] = texels[i][k] - mean[k];
+            for (int r = 0; r < N; ++r)
+            {
+                for (int c = 0; c < N; ++c) covariance[r][c] += d[r] * d[c];
+            }
+        }
+
+        // start from the largest diagonal so the iteration can't begin orthogonal to the answer
+        int largest = 0;
+        for (int k = 1; k < N; ++k)
+        {
+            if (covariance[k][k] > covariance[largest][largest]) largest = k;
+        }
+        for (int k = 0; k < N; ++k) axis[k] = covariance[largest][k];
+
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[N] = {};
+            for (int r = 0; r < N; ++r)
+            {
+                for (int c = 0; c < N; ++c) next[r] += covariance[r][c] * axis[c];
+            }
+
+            float length = 0.0f;
+            for (int k = 0; k < N; ++k) length += next[k] * next[k];
+            if (length < 1e-12f) break;
+
+            length = 1.0f / std::sqrt(length);
+            for (int k = 0; k < N; ++k) axis[k] = next[k] * length;
+        }
+
+        float length = 0.0f;
+        for (int k = 0; k < N; ++k) length += axis[k] * axis[k];
+        if (length < 1e-12f)
+        {
+            for (int k = 0; k < N; ++k) axis[k] = 1.0f / std::sqrt(static_cast<float>(N));
+        }
+    }
+
+    // Endpoints spanning the texels projected onto an axis, pulled in by 1/16 of the range as the ends of the palette
+    // rarely land exactly on the extreme texels. Fast uses the box diagonal rather than the principal axis.
+    template<int N>
+    void fitEndpoints(const BlockTexels& texels, bool usePrincipalAxis, float start[N], float end[N])
+    {
+        float mean[N], axis[N];
+        if (usePrincipalAxis)
+        {
+            principalAxis<N>(texels, mean, axis);
+        }
+        else
+        {
+            float minimum[N], maximum[N];
+            for (int k = 0; k < N; ++k)
+            {
+                minimum[k] = maximum[k] = texels[0][k];
+                mean[k] = 0.0f;
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int k = 0; k < N; ++k)
+                {
+                    minimum[k] = std::min(minimum[k], static_cast<float>(texels[i][k]));
+                    maximum[k] = std::max(maximum[k], static_cast<float>(texels[i][k]));
+                    mean[k] += texels[i][k] / 16.0f;
+                }
+            }
+            for (int k = 0; k < N; ++k) axis[k] = maximum[k] - minimum[k];
+        }
+
+        float low = std::numeric_limits<float>::max(), high = -std::numeric_limits<float>::max();
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0.0f;
+            for (int k = 0; k < N; ++k) t += (texels[i][k] - mean[k]) * axis[k];
+            low = std::min(low, t);
+            high = std::max(high, t);
+        }
+
+        float inset = (high - low) / 16.0f;
+        low += inset;
+        high -= inset;
+
+        float length2 = 0.0f;
+        for (int k = 0; k < N; ++k) length2 += axis[k] * axis[k];
+        float scale = length2 > 1e-12f ? 1.0f / length2 : 0.0f;
+
+        for (int k = 0; k < N; ++k)
+        {
+            start[k] = std::min(std::max(mean[k] + axis[k] * low * scale, 0.0f), 255.0f);
+            end[k] = std::min(std::max(mean[k] + axis[k] * high * scale, 0.0f), 255.0f);
+        }
+    }
+
+    // least squares endpoints for fixed indices, each texel being start + (end - start) * weights[index]
+    template<int N>
+    bool refitEndpoints(const BlockTexels& texels, const uint8_t indices[16], const float* weights, float start[N], float end[N])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[N] = {}, bx[N] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float b = weights[indices[i]];
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int k = 0; k < N; ++k)
+            {
+                ax[k] += a * texels[i][k];
+                bx[k] += b * texels[i][k];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f) return false;
+
+        float inverse = 1.0f / determinant;
+        for (int k = 0; k < N; ++k)
+        {
+            start[k] = std::min(std::max((ax[k] * bb - bx[k] * ab) * inverse, 0.0f), 255.0f);
+            end[k] = std::min(std::max((bx[k] * aa - ax[k] * ab) * inverse, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    //
+    // BC1 colour blocks, also the colour half of BC3
+    //
+
+    const float BC1_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+    inline uint16_t pack565(const float color[3])
+    {
+        uint32_t r = static_cast<uint32_t>(color[0] * (31.0f / 255.0f) + 0.5f);
+        uint32_t g = static_cast<uint32_t>(color[1] * (63.0f / 255.0f) + 0.5f);
+        uint32_t b = static_cast<uint32_t>(color[2] * (31.0f / 255.0f) + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    inline void unpack565(uint16_t packed, float color[3])
+    {
+        uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = static_cast<float>((r << 3) | (r >> 2));
+        color[1] = static_cast<float>((g << 2) | (g >> 4));
+        color[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    // nearest entry of the four colour palette for every texel, returns the total squared error
+    float selectColorIndices(const BlockTexels& texels, uint16_t color0, uint16_t color1, uint8_t indices[16])
+    {
+        float palette[4][3];
+        unpack565(color0, palette[0]);
+        unpack565(color1, palette[1]);
+        for (int k = 0; k < 3; ++k)
+        {
+            palette[2][k] = (2.0f * palette[0][k] + palette[1][k]) / 3.0f;
+            palette[3][k] = (palette[0][k] + 2.0f * palette[1][k]) / 3.0f;
+        }
+
+        float error = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float texel[3] = {static_cast<float>(texels[i][0]), static_cast<float>(texels[i][1]), static_cast<float>(texels[i][2])};
+            float best = distance2<3>(texel, palette[0]);
+            indices[i] = 0;
+            for (uint8_t p = 1; p < 4; ++p)
+            {
+                float d = distance2<3>(texel, palette[p]);
+                if (d < best)
+                {
+                    best = d;
+                    indices[i] = p;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    void encodeColorBlock(const BlockTexels& texels, CompressionQuality quality, uint8_t* out)
+    {
+        float start[3], end[3];
+        fitEndpoints<3>(texels, quality >= COMPRESSION_NORMAL, start, end);
+
+        uint16_t color0 = pack565(start), color1 = pack565(end);
+        uint8_t indices[16];
+        float error = selectColorIndices(texels, color0, color1, indices);
+
+        int refits = quality >= COMPRESSION_HIGH ? 4 : (quality >= COMPRESSION_NORMAL ? 1 : 0);
+        for (int i = 0; i < refits && error > 0.0f; ++i)
+        {
+            if (!refitEndpoints<3>(texels, indices, BC1_WEIGHTS, start, end)) break;
+
+            uint16_t refit0 = pack565(start), refit1 = pack565(end);
+            uint8_t refitIndices[16];
+            float refitError = selectColorIndices(texels, refit0, refit1, refitIndices);
+            if (refitError >= error) break;
+
+            color0 = refit0;
+            color1 = refit1;
+            error = refitError;
+            std::memcpy(indices, refitIndices, 16);
+        }
+
+        // the four colour palette needs color0 > color1, swapping the endpoints swaps index 0 with 1 and 2 with 3
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+            for (int i = 0; i < 16; ++i) indices[i] ^= 1;
+        }
+        else if (color0 == color1)
+        {
+            std::memset(indices, 0, 16);
+        }
+
+        uint32_t packedIndices = 0;
+        for (int i = 0; i < 16; ++i) packedIndices |= static_cast<uint32_t>(indices[i]) << (i * 2);
+
+        out[0] = static_cast<uint8_t>(color0 & 0xff);
+        out[1] = static_cast<uint8_t>(color0 >> 8);
+        out[2] = static_cast<uint8_t>(color1 & 0xff);
+        out[3] = static_cast<uint8_t>(color1 >> 8);
+        std::memcpy(out + 4, &packedIndices, 4);
+    }
+
+    //
+    // BC4 single channel blocks, also the alpha half of BC3 and both halves of BC5
+    //
+
+    // the eight value palette used when value0 > value1, otherwise six values plus 0 and 255
+    void channelPalette(uint8_t value0, uint8_t value1, int palette[8])
+    {
+        palette[0] = value0;
+        palette[1] = value1;
+        if (value0 > value1)
+        {
+            for (int i = 2; i < 8; ++i) palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+        }
+        else
+        {
+            for (int i = 2; i < 6; ++i) palette[i] = ((6 - i) * value0 + (i - 1) * value1 + 2) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    int selectChannelIndices(const uint8_t values[16], uint8_t value0, uint8_t value1, uint8_t indices[16])
+    {
+        int palette[8];
+        channelPalette(value0, value1, palette);
+
+        int error = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = std::numeric_limits<int>::max();
+            for (uint8_t p = 0; p < 8; ++p)
+            {
+                int d = (values[i] - palette[p]) * (values[i] - palette[p]);
+                if (d < best)
+                {
+                    best = d;
+                    indices[i] = p;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    void encodeChannelBlock(const BlockTexels& texels, int channel, CompressionQuality quality, uint8_t* out)
+    {
+        uint8_t values[16];
+        uint8_t minimum = 255, maximum = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            values[i] = texels[i][channel];
+            minimum = std::min(minimum, values[i]);
+            maximum = std::max(maximum, values[i]);
+        }
+
+        uint8_t value0 = maximum, value1 = minimum;
+        uint8_t indices[16];
+        int error = selectChannelIndices(values, value0, value1, indices);
+
+        if (quality >= COMPRESSION_NORMAL && error > 0 && maximum > minimum)
+        {
+            // pull the ends in towards the rest of the texels, one step at a time while it helps
+            int steps = quality >= COMPRESSION_HIGH ? 8 : 2;
+            for (int step = 0; step < steps; ++step)
+            {
+                bool improved = false;
+                const int moves[2][2] = {{-1, 0}, {0, 1}};
+                for (auto& move : moves)
+                {
+                    int candidate0 = value0 + move[0], candidate1 = value1 + move[1];
+                    if (candidate0 <= candidate1) continue;
+
+                    uint8_t candidateIndices[16];
+                    int candidateError = selectChannelIndices(values, static_cast<uint8_t>(candidate0), static_cast<uint8_t>(candidate1), candidateIndices);
+                    if (candidateError < error)
+                    {
+                        value0 = static_cast<uint8_t>(candidate0);
+                        value1 = static_cast<uint8_t>(candidate1);
+                        error = candidateError;
+                        std::memcpy(indices, candidateIndices, 16);
+                        improved = true;
+                    }
+                }
+                if (!improved) break;
+            }
+
+            // blocks with a few pure black or white texels fit better with 0 and 255 left to the explicit entries
+            if (quality >= COMPRESSION_HIGH)
+            {
+                uint8_t innerMinimum = 255, innerMaximum = 0;
+                for (int i = 0; i < 16; ++i)
+                {
+                    if (values[i] == 0 || values[i] == 255) continue;
+                    innerMinimum = std::min(innerMinimum, values[i]);
+                    innerMaximum = std::max(innerMaximum, values[i]);
+                }
+                if (innerMinimum <= innerMaximum)
+                {
+                    uint8_t candidateIndices[16];
+                    int candidateError = selectChannelIndices(values, innerMinimum, innerMaximum, candidateIndices);
+                    if (candidateError < error)
+                    {
+                        value0 = innerMinimum;
+                        value1 = innerMaximum;
+                        error = candidateError;
+                        std::memcpy(indices, candidateIndices, 16);
+                    }
+                }
+            }
+        }
+
+        uint64_t packedIndices = 0;
+        for (int i = 0; i < 16; ++i) packedIndices |= static_cast<uint64_t>(indices[i]) << (i * 3);
+
+        out[0] = value0;
+        out[1] = value1;
+        for (int i = 0; i < 6; ++i) out[2 + i] = static_cast<uint8_t>(packedIndices >> (i * 8));
+    }
+
+    //
+    // BC7 mode 6, a single rgba subset with 7 bit endpoints, a p bit each and 4 bit indices
+    //
+
+    const int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    struct Mode6Endpoint
+    {
+        uint8_t color[4]; // 7 bits per component
+        uint8_t pbit;
+    };
+
+    // the 7 bit endpoint and shared p bit closest to an 8 bit colour
+    Mode6Endpoint quantizeMode6(const float color[4])
+    {
+        Mode6Endpoint best = {};
+        float bestError = std::numeric_limits<float>::max();
+        for (uint8_t pbit = 0; pbit < 2; ++pbit)
+        {
+            Mode6Endpoint candidate;
+            candidate.pbit = pbit;
+            float error = 0.0f;
+            for (int k = 0; k < 4; ++k)
+            {
+                int q = static_cast<int>(std::floor((color[k] - pbit) * 0.5f + 0.5f));
+                candidate.color[k] = static_cast<uint8_t>(std::min(std::max(q, 0), 127));
+                float value = static_cast<float>((candidate.color[k] << 1) | pbit);
+                error += (value - color[k]) * (value - color[k]);
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                best = candidate;
+            }
+        }
+        return best;
+    }
+
+    float selectMode6Indices(const BlockTexels& texels, const Mode6Endpoint& endpoint0, const Mode6Endpoint& endpoint1, uint8_t indices[16])
+    {
+        float palette[16][4];
+        for (int k = 0; k < 4; ++k)
+        {
+            int e0 = (endpoint0.color[k] << 1) | endpoint0.pbit;
+            int e1 = (endpoint1.color[k] << 1) | endpoint1.pbit;
+            for (int p = 0; p < 16; ++p) palette[p][k] = static_cast<float>(((64 - BC7_WEIGHTS[p]) * e0 + BC7_WEIGHTS[p] * e1 + 32) >> 6);
+        }
+
+        float error = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float texel[4] = {static_cast<float>(texels[i][0]), static_cast<float>(texels[i][1]), static_cast<float>(texels[i][2]), static_cast<float>(texels[i][3])};
+            float best = std::numeric_limits<float>::max();
+            for (uint8_t p = 0; p < 16; ++p)
+            {
+                float d = distance2<4>(texel, palette[p]);
+                if (d < best)
+                {
+                    best = d;
+                    indices[i] = p;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    struct BitWriter
+    {
+        uint8_t* out;
+        uint32_t position = 0;
+
+        void write(uint32_t value, uint32_t bits)
+        {
+            for (uint32_t i = 0; i < bits; ++i, ++position)
+            {
+                if ((value >> i) & 1) out[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+            }
+        }
+    };
+
+    void encodeMode6Block(const BlockTexels& texels, CompressionQuality quality, uint8_t* out)
+    {
+        float start[4], end[4];
+        fitEndpoints<4>(texels, quality >= COMPRESSION_NORMAL, start, end);
+
+        Mode6Endpoint endpoint0 = quantizeMode6(start), endpoint1 = quantizeMode6(end);
+        uint8_t indices[16];
+        float error = selectMode6Indices(texels, endpoint0, endpoint1, indices);
+
+        float weights[16];
+        for (int p = 0; p < 16; ++p) weights[p] = BC7_WEIGHTS[p] / 64.0f;
+
+        int refits = quality >= COMPRESSION_HIGH ? 3 : (quality >= COMPRESSION_NORMAL ? 1 : 0);
+        for (int i = 0; i < refits && error > 0.0f; ++i)
+        {
+            if (!refitEndpoints<4>(texels, indices, weights, start, end)) break;
+
+            Mode6Endpoint refit0 = quantizeMode6(start), refit1 = quantizeMode6(end);
+            uint8_t refitIndices[16];
+            float refitError = selectMode6Indices(texels, refit0, refit1, refitIndices);
+            if (refitError >= error) break;
+
+            endpoint0 = refit0;
+            endpoint1 = refit1;
+            error = refitError;
+            std::memcpy(indices, refitIndices, 16);
+        }
+
+        // the first index is stored without its top bit so it has to be below 8
+        if (indices[0] >= 8)
+        {
+            std::swap(endpoint0, endpoint1);
+            for (int i = 0; i < 16; ++i) indices[i] = static_cast<uint8_t>(15 - indices[i]);
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter writer{out};
+        writer.write(1 << 6, 7); // mode 6
+        for (int k = 0; k < 4; ++k)
+        {
+            writer.write(endpoint0.color[k], 7);
+            writer.write(endpoint1.color[k], 7);
+        }
+        writer.write(endpoint0.pbit, 1);
+        writer.write(endpoint1.pbit, 1);
+        writer.write(indices[0], 3);
+        for (int i = 1; i < 16; ++i) writer.write(indices[i], 4);
+    }
+
+    //
+    // Levels and blocks
+    //
+
+    struct LevelLayout
+    {
+        const uint8_t* texels;
+        uint32_t width;
+        uint32_t height;
+        uint8_t* blocks;
+        uint32_t blocksWide;
+        uint32_t blocksHigh;
+    };
+
+    void loadBlock(const LevelLayout& level, uint32_t blockX, uint32_t blockY, const CompressOptions& options, BlockTexels& texels)
+    {
+        const uint32_t components = options.components;
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            uint32_t y = std::min(blockY * 4 + j, level.height - 1);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                uint32_t x = std::min(blockX * 4 + i, level.width - 1);
+                const uint8_t* texel = level.texels + (static_cast<size_t>(y) * level.width + x) * components;
+                uint8_t* rgba = texels[j * 4 + i];
+
+                rgba[0] = texel[0];
+                rgba[1] = components > 1 ? texel[1] : 0;
+                rgba[2] = components > 2 ? texel[2] : 0;
+                rgba[3] = components > 3 ? texel[3] : 255;
+                if (options.swapRedBlue && components > 2) std::swap(rgba[0], rgba[2]);
+            }
+        }
+    }
+
+    void encodeBlock(const BlockTexels& texels, BlockCompression compression, CompressionQuality quality, uint8_t* out)
+    {
+        switch (compression)
+        {
+        case BLOCK_BC1: encodeColorBlock(texels, quality, out); break;
+        case BLOCK_BC3:
+            encodeChannelBlock(texels, 3, quality, out);
+            encodeColorBlock(texels, quality, out + 8);
+            break;
+        case BLOCK_BC4: encodeChannelBlock(texels, 0, quality, out); break;
+        case BLOCK_BC5:
+            encodeChannelBlock(texels, 0, quality, out);
+            encodeChannelBlock(texels, 1, quality, out + 8);
+            break;
+        case BLOCK_BC7: encodeMode6Block(texels, quality, out); break;
+        }
+    }
+
+    inline uint32_t blocksFor(uint32_t texels) { return std::max((texels + 3) / 4, 1u); }
+
+    void decodeColorBlock(const uint8_t* in, bool fourColorOnly, bool punchThroughAlpha, BlockTexels& texels)
+    {
+        uint16_t color0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+        uint16_t color1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+
+        float palette[4][3];
+        unpack565(color0, palette[0]);
+        unpack565(color1, palette[1]);
+        bool fourColor = fourColorOnly || color0 > color1;
+        for (int k = 0; k < 3; ++k)
+        {
+            palette[2][k] = fourColor ? (2.0f * palette[0][k] + palette[1][k]) / 3.0f : (palette[0][k] + palette[1][k]) * 0.5f;
+            palette[3][k] = fourColor ? (palette[0][k] + 2.0f * palette[1][k]) / 3.0f : 0.0f;
+        }
+
+        uint32_t packedIndices;
+        std::memcpy(&packedIndices, in + 4, 4);
+        for (int i = 0; i < 16; ++i)
+        {
+            uint32_t index = (packedIndices >> (i * 2)) & 3;
+            for (int k = 0; k < 3; ++k) texels[i][k] = static_cast<uint8_t>(palette[index][k] + 0.5f);
+            if (punchThroughAlpha && !fourColor && index == 3) texels[i][3] = 0;
+        }
+    }
+
+    void decodeChannelBlock(const uint8_t* in, int channel, BlockTexels& texels)
+    {
+        int palette[8];
+        channelPalette(in[0], in[1], palette);
+
+        uint64_t packedIndices = 0;
+        for (int i = 0; i < 6; ++i) packedIndices |= static_cast<uint64_t>(in[2 + i]) << (i * 8);
+        for (int i = 0; i < 16; ++i) texels[i][channel] = static_cast<uint8_t>(palette[(packedIndices >> (i * 3)) & 7]);
+    }
+
+} // namespace
+
+uint32_t unity2vsg::blockBytes(BlockCompression compression)
+{
+    return compression == BLOCK_BC1 || compression == BLOCK_BC4 ? 8 : 16;
+}
+
+BlockCompression unity2vsg::chooseBlockCompression(const uint8_t* texels, size_t texelCount, uint32_t components, CompressionQuality quality)
+{
+    if (components == 1) return BLOCK_BC4;
+    if (components == 2) return BLOCK_BC5;
+    if (quality >= COMPRESSION_HIGH) return BLOCK_BC7;
+    if (components == 3) return BLOCK_BC1;
+
+    for (size_t i = 0; i < texelCount; ++i)
+    {
+        if (texels[i * 4 + 3] != 255) return BLOCK_BC3;
+    }
+    return BLOCK_BC1;
+}
+
+uint32_t unity2vsg::compressibleMipmapCount(uint32_t width, uint32_t height, uint32_t mipmapCount)
+{
+    if (width == 0 || height == 0 || width % 4 != 0 || height % 4 != 0) return 0;
+
+    uint32_t blocksWide = width / 4, blocksHigh = height / 4;
+    uint32_t count = std::min(std::max(mipmapCount, 1u), fullMipmapCount(blocksWide, blocksHigh));
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        if (blocksFor(std::max(width >> i, 1u)) != std::max(blocksWide >> i, 1u)) return i;
+        if (blocksFor(std::max(height >> i, 1u)) != std::max(blocksHigh >> i, 1u)) return i;
+    }
+    return count;
+}
+
+size_t unity2vsg::compressedChainSize(uint32_t width, uint32_t height, uint32_t mipmapCount, BlockCompression compression)
+{
+    size_t size = 0;
+    for (uint32_t i = 0; i < std::max(mipmapCount, 1u); ++i)
+    {
+        size += static_cast<size_t>(blocksFor(width)) * blocksFor(height) * blockBytes(compression);
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return size;
+}
+
+void unity2vsg::compressTexture(const uint8_t* chain, uint32_t width, uint32_t height, uint32_t mipmapCount, BlockCompression compression, const CompressOptions& options, uint8_t* blocks)
+{
+    if (chain == nullptr || blocks == nullptr || width == 0 || height == 0 || options.components < 1 || options.components > 4) return;
+
+    std::vector<LevelLayout> levels;
+    for (uint32_t i = 0; i < std::max(mipmapCount, 1u); ++i)
+    {
+        LevelLayout level = {chain, width, height, blocks, blocksFor(width), blocksFor(height)};
+        levels.push_back(level);
+
+        chain += static_cast<size_t>(width) * height * options.components;
+        blocks += static_cast<size_t>(level.blocksWide) * level.blocksHigh * blockBytes(compression);
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    // rows of blocks from every level make up the jobs
+    struct Job
+    {
+        const LevelLayout* level;
+        uint32_t beginRow;
+        uint32_t endRow;
+    };
+    std::vector<Job> jobs;
+    for (auto& level : levels)
+    {
+        uint32_t rowsPerJob = std::max(BLOCKS_PER_JOB / level.blocksWide, 1u);
+        for (uint32_t row = 0; row < level.blocksHigh; row += rowsPerJob) jobs.push_back({&level, row, std::min(row + rowsPerJob, level.blocksHigh)});
+    }
+
+    const uint32_t bytes = blockBytes(compression);
+    parallelFor(jobs.size(), [&](size_t i) {
+        const Job& job = jobs[i];
+        const LevelLayout& level = *job.level;
+
+        BlockTexels texels;
+        for (uint32_t y = job.beginRow; y < job.endRow; ++y)
+        {
+            for (uint32_t x = 0; x < level.blocksWide; ++x)
+            {
+                loadBlock(level, x, y, options, texels);
+                encodeBlock(texels, compression, options.quality, level.blocks + (static_cast<size_t>(y) * level.blocksWide + x) * bytes);
+            }
+        }
+    });
+}
+
+bool unity2vsg::decompressTexture(const uint8_t* blocks, uint32_t width, uint32_t height, BlockCompression compression, bool punchThroughAlpha, uint8_t* rgba)
+{
+    if (blocks == nullptr || rgba == nullptr || compression == BLOCK_BC7) return false;
+
+    const uint32_t blocksWide = blocksFor(width), blocksHigh = blocksFor(height);
+    const uint32_t bytes = blockBytes(compression);
+
+    parallelFor(blocksHigh, [&](size_t y) {
+        BlockTexels texels;
+        for (uint32_t x = 0; x < blocksWide; ++x)
+        {
+            for (auto& texel : texels)
+            {
+                texel[0] = texel[1] = texel[2] = 0;
+                texel[3] = 255;
+            }
+
+            const uint8_t* in = blocks + (y * blocksWide + x) * bytes;
+            switch (compression)
+            {
+            case BLOCK_BC1: decodeColorBlock(in, false, punchThroughAlpha, texels); break;
+            case BLOCK_BC3:
+                decodeChannelBlock(in, 3, texels);
+                decodeColorBlock(in + 8, true, false, texels);
+                break;
+            case BLOCK_BC4: decodeChannelBlock(in, 0, texels); break;
+            case BLOCK_BC5:
+                decodeChannelBlock(in, 0, texels);
+                decodeChannelBlock(in + 8, 1, texels);
+                break;
+            default: break;
+            }
+
+            // blocks hanging over the edge only write the texels inside the image
+            for (uint32_t j = 0; j < 4 && y * 4 + j < height; ++j)
+            {
+                for (uint32_t i = 0; i < 4 && x * 4 + i < width; ++i)
+                {
+                    std::memcpy(rgba + ((y * 4 + j) * width + x * 4 + i) * 4, texels[j * 4 + i], 4);
+                }
+            }
+        }
+    });
+    return true;
+}
@@ -0,0 +1,392 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/VertexFormat.h>
+
+#include <unity2vsg/DebugLog.h>
+#include <unity2vsg/ShaderUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace unity2vsg;
+
+namespace
+{
+    int16_t toSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+    }
+
+    uint16_t toUnorm16(float value)
+    {
+        return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+    }
+
+    uint8_t toUnorm8(float value)
+    {
+        return static_cast<uint8_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+    }
+
+    // number of floats per value the exporter writes for each attribute
+    size_t attributeComponents(uint32_t attribute)
+    {
+        switch (attribute)
+        {
+        case VERTEX:
+        case NORMAL: return 3;
+        case TANGENT:
+        case COLOR: return 4;
+        case TEXCOORD0:
+        case TEXCOORD1: return 2;
+        default: return 0;
+        }
+    }
+} // namespace
+
+//
+// Encodings
+//
+
+uint32_t VertexEncodings::encodingFor(uint32_t attribute) const
+{
+    switch (attribute)
+    {
+    case NORMAL: return normal;
+    case TANGENT: return tangent;
+    case COLOR: return color;
+    case TEXCOORD0:
+    case TEXCOORD1: return uv;
+    default: return ENCODING_FLOAT32;
+    }
+}
+
+bool unity2vsg::isEncodingSupported(uint32_t attribute, uint32_t encoding)
+{
+    if (encoding == ENCODING_FLOAT32) return true;
+
+    switch (attribute)
+    {
+    case NORMAL:
+    case TANGENT: return encoding == ENCODING_SNORM16 || encoding == ENCODING_OCTAHEDRAL16;
+    case COLOR: return encoding == ENCODING_UNORM8;
+    case TEXCOORD0:
+    case TEXCOORD1: return encoding == ENCODING_FLOAT16 || encoding == ENCODING_UNORM16;
+    default: return false;
+    }
+}
+
+VkFormat unity2vsg::encodedFormat(uint32_t attribute, uint32_t encoding)
+{
+    switch (isEncodingSupported(attribute, encoding) ? encoding : ENCODING_FLOAT32)
+    {
+    case ENCODING_SNORM16: return VK_FORMAT_R16G16B16A16_SNORM;
+    case ENCODING_OCTAHEDRAL16: return VK_FORMAT_R16G16_SNORM;
+    case ENCODING_FLOAT16: return VK_FORMAT_R16G16_SFLOAT;
+    case ENCODING_UNORM16: return VK_FORMAT_R16G16_UNORM;
+    case ENCODING_UNORM8: return VK_FORMAT_R8G8B8A8_UNORM;
+    default: break;
+    }
+
+    switch (attributeComponents(attribute))
+    {
+    case 2: return VK_FORMAT_R32G32_SFLOAT;
+    case 4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+    default: return VK_FORMAT_R32G32B32_SFLOAT;
+    }
+}
+
+// round to nearest even, values too large for half become infinity
+uint16_t unity2vsg::floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    if (bits >= 0x47800000) // 65536 and above, infinity or nan
+    {
+        return sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    if (bits < 0x38800000) // below the smallest normal half, 2^-14
+    {
+        float magnitude;
+        std::memcpy(&magnitude, &bits, sizeof(magnitude));
+        return sign | static_cast<uint16_t>(std::lrint(magnitude * 16777216.0f)); // multiples of 2^-24
+    }
+
+    uint32_t mantissaOdd = (bits >> 13) & 1;
+    bits += 0xc8000fff + mantissaOdd; // rebias the exponent from 127 to 15 and round
+    return sign | static_cast<uint16_t>(bits >> 13);
+}
+
+// project onto the octahedron then fold the lower half over the upper, result is in -1 to 1
+void unity2vsg::octahedralEncode(const float* normal, float* result)
+{
+    float l1 = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+    if (l1 <= 0.0f)
+    {
+        result[0] = 0.0f;
+        result[1] = 0.0f;
+        return;
+    }
+
+    float x = normal[0] / l1;
+    float y = normal[1] / l1;
+    if (normal[2] < 0.0f)
+    {
+        float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    result[0] = x;
+    result[1] = y;
+}
+
+vsg::ref_ptr<vsg::Data> unity2vsg::encodeVertexArray(vsg::ref_ptr<vsg::Data> array, uint32_t attribute, uint32_t encoding)
+{
+    if (!array.valid() || encoding == ENCODING_FLOAT32) return array;
+
+    if (!isEncodingSupported(attribute, encoding))
+    {
+        DebugLog("GraphBuilder Warning: Vertex encoding " + std::to_string(encoding) + " isn't supported for attribute " + std::to_string(attribute) + ", leaving as float.");
+        return array;
+    }
+
+    size_t components = attributeComponents(attribute);
+    if (array->valueSize() != components * sizeof(float))
+    {
+        DebugLog("GraphBuilder Warning: Vertex array for attribute " + std::to_string(attribute) + " isn't float data, leaving unencoded.");
+        return array;
+    }
+
+    const float* src = static_cast<const float*>(array->dataPointer());
+    size_t count = array->valueCount();
+
+    switch (encoding)
+    {
+    case ENCODING_SNORM16:
+    {
+        // 3 component 16 bit formats are rarely supported for vertex input so normals are padded, tangents keep their sign in w
+        vsg::ref_ptr<vsg::usvec4Array> encoded(new vsg::usvec4Array(count));
+        int16_t* dst = reinterpret_cast<int16_t*>(encoded->dataPointer());
+        for (size_t i = 0; i < count; ++i, src += components, dst += 4)
+        {
+            for (size_t c = 0; c < 4; ++c) dst[c] = c < components ? toSnorm16(src[c]) : 0;
+        }
+        return encoded;
+    }
+    case ENCODING_OCTAHEDRAL16:
+    {
+        vsg::ref_ptr<vsg::usvec2Array> encoded(new vsg::usvec2Array(count));
+        int16_t* dst = reinterpret_cast<int16_t*>(encoded->dataPointer());
+        for (size_t i = 0; i < count; ++i, src += components, dst += 2)
+        {
+            float oct[2];
+            octahedralEncode(src, oct);
+            if (components == 4)
+            {
+                // fold the bitangent sign into y, remapped to 0-1 and kept above zero so the sign survives quantization
+                float y = std::max(oct[1] * 0.5f + 0.5f, 1.0f / 32767.0f);
+                oct[1] = src[3] < 0.0f ? -y : y;
+            }
+            dst[0] = toSnorm16(oct[0]);
+            dst[1] = toSnorm16(oct[1]);
+        }
+        return encoded;
+    }
+    case ENCODING_FLOAT16:
+    {
+        vsg::ref_ptr<vsg::usvec2Array> encoded(new vsg::usvec2Array(count));
+        uint16_t* dst = static_cast<uint16_t*>(encoded->dataPointer());
+        for (size_t i = 0; i < count * 2; ++i) dst[i] = floatToHalf(src[i]);
+        return encoded;
+    }
+    case ENCODING_UNORM16:
+    {
+        vsg::ref_ptr<vsg::usvec2Array> encoded(new vsg::usvec2Array(count));
+        uint16_t* dst = static_cast<uint16_t*>(encoded->dataPointer());
+        size_t clamped = 0;
+        for (size_t i = 0; i < count * 2; ++i)
+        {
+            if (src[i] < 0.0f || src[i] > 1.0f) clamped++;
+            dst[i] = toUnorm16(src[i]);
+        }
+        if (clamped > 0)
+        {
+            DebugLog("GraphBuilder Warning: Clamped " + std::to_string(clamped) + " uv values outside 0-1 for unorm16 encoding, use float16 for tiled uvs.");
+        }
+        return encoded;
+    }
+    case ENCODING_UNORM8:
+    {
+        vsg::ref_ptr<vsg::ubvec4Array> encoded(new vsg::ubvec4Array(count));
+        uint8_t* dst = static_cast<uint8_t*>(encoded->dataPointer());
+        for (size_t i = 0; i < count * 4; ++i) dst[i] = toUnorm8(src[i]);
+        return encoded;
+    }
+    default: break;
+    }
+    return array;
+}
+
+vsg::ref_ptr<vsg::Data> unity2vsg::interleaveArrays(const vsg::DataList& arrays)
+{
+    if (arrays.empty()) return vsg::ref_ptr<vsg::Data>();
+
+    size_t vertexCount = arrays[0]->valueCount();
+    size_t stride = 0;
+    for (auto& array : arrays)
+    {
+        if (array->valueCount() != vertexCount)
+        {
+            DebugLog("GraphBuilder Error: Can't interleave vertex arrays of different lengths.");
+            return vsg::ref_ptr<vsg::Data>();
+        }
+        stride += array->valueSize();
+    }
+
+    vsg::ref_ptr<vsg::ubyteArray> interleaved(new vsg::ubyteArray(vertexCount * stride));
+    uint8_t* dst = interleaved->data();
+
+    size_t offset = 0;
+    for (auto& array : arrays)
+    {
+        const uint8_t* src = static_cast<const uint8_t*>(array->dataPointer());
+        size_t valueSize = array->valueSize();
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            std::memcpy(dst + v * stride + offset, src + v * valueSize, valueSize);
+        }
+        offset += valueSize;
+    }
+
+    return interleaved;
+}
+
+//
+// VertexFormatVisitor
+//
+
+VertexFormatVisitor::VertexFormatVisitor(bool interleave, const VertexArrayAttributes& attributes, const PipelineVertexEncodings& pipelineEncodings) :
+    _interleave(interleave),
+    _attributes(attributes),
+    _pipelineEncodings(pipelineEncodings),
+    _sourceBytes(0),
+    _encodedBytes(0)
+{
+}
+
+void VertexFormatVisitor::apply(vsg::Object& object)
+{
+    object.traverse(*this);
+}
+
+void VertexFormatVisitor::apply(vsg::StateGroup& stategroup)
+{
+    VertexEncodings previous = _encodings;
+
+    for (auto& command : stategroup.getStateCommands())
+    {
+        vsg::BindGraphicsPipeline* bindPipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(command.get());
+        if (bindPipeline)
+        {
+            auto itr = _pipelineEncodings.find(bindPipeline);
+            _encodings = itr != _pipelineEncodings.end() ? itr->second : VertexEncodings();
+        }
+        command->accept(*this);
+    }
+
+    stategroup.traverse(*this);
+
+    _encodings = previous;
+}
+
+void VertexFormatVisitor::apply(vsg::VertexIndexDraw& vid)
+{
+    vid._arrays = convert(vid._arrays);
+}
+
+void VertexFormatVisitor::apply(vsg::BindVertexBuffers& bvb)
+{
+    bvb.getArrays() = convert(bvb.getArrays());
+}
+
+vsg::DataList VertexFormatVisitor::convert(const vsg::DataList& arrays)
+{
+    // per instance arrays have their own binding after the vertex rate ones so are never interleaved with them
+    size_t vertexArrayCount = 0;
+    for (auto& array : arrays)
+    {
+        auto attribute = _attributes.find(array.get());
+        if (attribute == _attributes.end() || (attribute->second & INSTANCE_ATTS) == 0) vertexArrayCount++;
+    }
+
+    bool interleave = _interleave && vertexArrayCount > 1;
+    if (!interleave && _encodings.isFloat32()) return arrays;
+
+    ConvertKey key;
+    for (auto& array : arrays) key.first.push_back(array.get());
+    key.second = _encodings.key();
+
+    auto itr = _converted.find(key);
+    if (itr != _converted.end()) return itr->second;
+
+    // nodes can be reached more than once, so skip arrays that are already the result of a conversion
+    if (_outputs.count(key.first) > 0) return arrays;
+
+    vsg::DataList result;
+    for (auto& array : arrays)
+    {
+        auto attribute = _attributes.find(array.get());
+        result.push_back(attribute != _attributes.end() ? encode(array, attribute->second) : array);
+    }
+
+    if (interleave)
+    {
+        vsg::DataList vertexArrays(result.begin(), result.begin() + vertexArrayCount);
+        vsg::ref_ptr<vsg::Data> interleaved = interleaveArrays(vertexArrays);
+        if (interleaved.valid())
+        {
+            vertexArrays = {interleaved};
+            vertexArrays.insert(vertexArrays.end(), result.begin() + vertexArrayCount, result.end());
+            result = vertexArrays;
+        }
+    }
+
+    _converted[key] = result;
+
+    std::vector<const vsg::Data*> output;
+    for (auto& array : result) output.push_back(array.get());
+    if (output != key.first) _outputs.insert(output);
+    return result;
+}
+
+vsg::ref_ptr<vsg::Data> VertexFormatVisitor::encode(vsg::ref_ptr<vsg::Data> array, uint32_t attribute)
+{
+    uint32_t encoding = _encodings.encodingFor(attribute);
+    if (encoding == ENCODING_FLOAT32) return array;
+
+    auto key = std::make_pair(static_cast<const vsg::Data*>(array.get()), encoding);
+    auto itr = _encoded.find(key);
+    if (itr != _encoded.end()) return itr->second;
+
+    vsg::ref_ptr<vsg::Data> encoded = encodeVertexArray(array, attribute, encoding);
+    _encoded[key] = encoded;
+
+    _sourceBytes += array->dataSize();
+    _encodedBytes += encoded->dataSize();
+    return encoded;
+}
@@ -12,13 +12,38 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <unity2vsg/unity2vsg.h>
 
+#include <unity2vsg/Bounds.h>
+#include <unity2vsg/CommandStream.h>
+#include <unity2vsg/CullHierarchy.h>
+#include <unity2vsg/DataCache.h>
 #include <unity2vsg/DebugLog.h>
+#include <unity2vsg/Flattener.h>
 #include <unity2vsg/GraphicsPipelineBuilder.h>
+#include <unity2vsg/IndexUtils.h>
+#include <unity2vsg/Instancing.h>
+#include <unity2vsg/MeshOptimizer.h>
+#include <unity2vsg/MeshSimplifier.h>
+#include <unity2vsg/MipTrimmer.h>
+#include <unity2vsg/MipmapGenerator.h>
 #include <unity2vsg/ShaderUtils.h>
+#include <unity2vsg/StateSorter.h>
+#include <unity2vsg/StaticBatcher.h>
+#include <unity2vsg/TextureAnalysis.h>
+#include <unity2vsg/TextureArray.h>
+#include <unity2vsg/TextureAtlas.h>
+#include <unity2vsg/TextureBudget.h>
+#include <unity2vsg/TextureCache.h>
+#include <unity2vsg/TextureCompressor.h>
+#include <unity2vsg/VertexFormat.h>
 
 #include <vsg/all.h>
 #include <vsg/core/Objects.h>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <set>
+
 using namespace unity2vsg;
 
 class LeafDataCollection : public vsg::Visitor
@@ -31,78 +56,14 @@ public:
         objects = new vsg::Objects;
     }
 
-    void apply(vsg::Object& object) override
-    {
-        if (typeid(object) == typeid(vsg::DescriptorImage))
-        {
-            vsg::DescriptorImage* texture = static_cast<vsg::DescriptorImage*>(&object);
-            for (auto& samplerimage : texture->getSamplerImages())
-            {
-                if (samplerimage.second.valid())
-                {
-                    objects->addChild(samplerimage.second);
-                }
-            }
-        }
-
-        object.traverse(*this);
-    }
-
-    void apply(vsg::Geometry& geometry) override
-    {
-        for (auto& data : geometry._arrays)
-        {
-            objects->addChild(data);
-        }
-        if (geometry._indices)
-        {
-            objects->addChild(geometry._indices);
-        }
-    }
-
-    void apply(vsg::VertexIndexDraw& vid) override
-    {
-        for (auto& data : vid._arrays)
-        {
-            objects->addChild(data);
-        }
-        if (vid._indices)
-        {
-            objects->addChild(vid._indices);
-        }
-    }
-
-    void apply(vsg::BindVertexBuffers& bvb) override
-    {
-        for (auto& data : bvb.getArrays())
-        {
-            objects->addChild(data);
-        }
-    }
-
-    void apply(vsg::BindIndexBuffer& bib) override
-    {
-        if (bib.getIndices())
-        {
-            objects->addChild(vsg::ref_ptr<vsg::Data>(bib.getIndices()));
-        }
-    }
-
-    void apply(vsg::StateGroup& stategroup) override
+    // data can be shared by several leaves so only add each instance once
+    void addData(vsg::Data* data)
     {
-        for (auto& command : stategroup.getStateCommands())
+        if (_collected.insert(data).second)
         {
-            command->accept(*this);
+            objects->addChild(vsg::ref_ptr<vsg::Data>(data));
         }
-
-        stategroup.traverse(*this);
     }
-};
-
-class LeafDataRelease : public vsg::Visitor
-{
-public:
-    LeafDataRelease() {}
 
     void apply(vsg::Object& object) override
     {
@@ -113,7 +74,7 @@ public:
             {
                 if (samplerimage.second.valid())
                 {
-                    samplerimage.second->dataRelease();
+                    addData(samplerimage.second);
                 }
             }
         }
@@ -125,11 +86,11 @@ public:
     {
         for (auto& data : geometry._arrays)
         {
-            data->dataRelease();
+            addData(data);
         }
         if (geometry._indices)
         {
-            //geometry._indices->dataRelease();
+            addData(geometry._indices);
         }
     }
 
@@ -137,11 +98,11 @@ public:
     {
         for (auto& data : vid._arrays)
         {
-            data->dataRelease();
+            addData(data);
         }
         if (vid._indices)
         {
-            //vid._indices->dataRelease();
+            addData(vid._indices);
         }
     }
 
@@ -149,7 +110,7 @@ public:
     {
         for (auto& data : bvb.getArrays())
         {
-            data->dataRelease();
+            addData(data);
         }
     }
 
@@ -157,7 +118,7 @@ public:
     {
         if (bib.getIndices())
         {
-            //bib.getIndices()->dataRelease();
+            addData(bib.getIndices());
         }
     }
 
@@ -170,6 +131,9 @@ public:
 
         stategroup.traverse(*this);
     }
+
+protected:
+    std::set<vsg::Data*> _collected;
 };
 
 class GraphBuilder : public vsg::Object
@@ -179,6 +143,34 @@ public:
     {
         _root = vsg::MatrixTransform::create();
         pushNodeToStack(_root);
+        _settings = {};
+    }
+
+    void setExportSettings(const ExportSettingsData& settings)
+    {
+        _settings = settings;
+
+        auto checkEncoding = [](uint32_t attribute, int encoding, const std::string& name) -> uint32_t {
+            if (encoding < 0 || !isEncodingSupported(attribute, static_cast<uint32_t>(encoding)))
+            {
+                DebugLog("GraphBuilder Warning: Vertex encoding " + std::to_string(encoding) + " isn't supported for " + name + ", using float32.");
+                return ENCODING_FLOAT32;
+            }
+            return static_cast<uint32_t>(encoding);
+        };
+
+        _vertexEncodings.normal = checkEncoding(NORMAL, settings.normalEncoding, "normals");
+        _vertexEncodings.tangent = checkEncoding(TANGENT, settings.tangentEncoding, "tangents");
+        _vertexEncodings.uv = checkEncoding(TEXCOORD0, settings.uvEncoding, "uvs");
+        _vertexEncodings.color = checkEncoding(COLOR, settings.colorEncoding, "colors");
+
+        if (settings.lodLevelCount < 0 || settings.lodLevelCount > MAX_LOD_LEVELS)
+        {
+            DebugLog("GraphBuilder Warning: LOD level count " + std::to_string(settings.lodLevelCount) + " is out of range, generating at most " + std::to_string(MAX_LOD_LEVELS) + ".");
+            _settings.lodLevelCount = std::min(std::max(settings.lodLevelCount, 0), MAX_LOD_LEVELS);
+        }
+
+        _textureDataCache.setTolerance(std::max(settings.textureDuplicateTolerance, 0.0f));
     }
 
     //
@@ -218,6 +210,7 @@ public:
         {
             DebugLog("GraphBuilder Error: Current head is not a group");
         }
+        addPendingBound(cullNode, cull);
         pushNodeToStack(cullNode);
     }
 
@@ -228,6 +221,7 @@ public:
         {
             DebugLog("GraphBuilder Error: Current head is not a group");
         }
+        addPendingBound(cullGroup, cull);
         pushNodeToStack(cullGroup);
     }
 
@@ -239,6 +233,7 @@ public:
         {
             DebugLog("GraphBuilder Error: Current head is not a group");
         }
+        addPendingBound(lod, cull);
         pushNodeToStack(lod);
     }
 
@@ -283,54 +278,371 @@ public:
         }
         else
         {
-            auto geometry = vsg::VertexIndexDraw::create();
+            // vertex inputs, use native arrays filled by the caller if they've been committed for this id
+            NativeMeshArrays* nativeArrays = getCommittedMeshArrays(data.id);
+            vsg::DataList arrays = nativeArrays ? nativeArrays->vertexArrays() : createExternalVertexArrays(data);
+
+            // meshes that need 32 bit indices may be cheaper drawn as a few 16 bit ranges
+            if (!nativeArrays && data.use32BitIndicies != 0)
+            {
+                geomNode = createSplit16BitDraws(arrays, data.triangles);
+            }
+
+            if (!geomNode)
+            {
+                vsg::ref_ptr<vsg::Data> indices = nativeArrays ? nativeArrays->indices : createIndexArray(data.triangles, data.use32BitIndicies != 0);
+
+                auto geometry = vsg::VertexIndexDraw::create();
+                geometry->_arrays = arrays;
+                geometry->_indices = indices;
+                geometry->indexCount = static_cast<uint32_t>(indices->valueCount());
+                geometry->instanceCount = 1;
+                geomNode = geometry;
+            }
+
+            _vertexIndexDrawCache[data.id] = geomNode;
+            addMeshPositions(data.id, arrays);
+        }
+
+        includeMeshBound(data.id);
+
+        if (!addChildToHead(geomNode))
+        {
+            DebugLog("GraphBuilder Error: Current head is not a group");
+        }
+
+        pushNodeToStack(geomNode);
+    }
+
+    //
+    // Mesh arrays
+    //
+
+    // wrap the callers vertex arrays without copying, they're released before the graph is destroyed
+    template<typename T>
+    vsg::DataList createExternalVertexArrays(const T& data)
+    {
+        vsg::DataList inputarrays;
+        auto addArray = [&](vsg::ref_ptr<vsg::Data> array, uint32_t attribute) {
+            _externalData.push_back(array);
+            inputarrays.push_back(shareVertexArray(array, attribute));
+        };
+
+        addArray(createVsgArray<vsg::vec3>(data.verticies.data, data.verticies.length), VERTEX); // always have verticies
+
+        if (data.normals.length > 0) addArray(createVsgArray<vsg::vec3>(data.normals.data, data.normals.length), NORMAL);
+        if (data.tangents.length > 0) addArray(createVsgArray<vsg::vec4>(data.tangents.data, data.tangents.length), TANGENT);
+        if (data.colors.length > 0) addArray(createVsgArray<vsg::vec4>(data.colors.data, data.colors.length), COLOR);
+        if (data.uv0.length > 0) addArray(createVsgArray<vsg::vec2>(data.uv0.data, data.uv0.length), TEXCOORD0);
+        if (data.uv1.length > 0) addArray(createVsgArray<vsg::vec2>(data.uv1.data, data.uv1.length), TEXCOORD1);
+
+        return inputarrays;
+    }
+
+    // share a vertex array with any identical ones in the same role and remember which attribute it holds for encoding
+    vsg::ref_ptr<vsg::Data> shareVertexArray(vsg::ref_ptr<vsg::Data> array, uint32_t attribute)
+    {
+        vsg::ref_ptr<vsg::Data> shared = _dataCache.share(array, attribute);
+        _vertexArrayAttributes[shared.get()] = attribute;
+        return shared;
+    }
+
+    // convert the int32 indices to the smallest type that can hold them, the 32 bit flag only tells us which to try first
+    vsg::ref_ptr<vsg::Data> createIndexArray(const IntArray& triangles, bool use32BitIndicies)
+    {
+        const int32_t* src = reinterpret_cast<const int32_t*>(triangles.data);
+        size_t count = static_cast<size_t>(triangles.length);
+
+        // the conversion finds the largest index as it goes, so a mesh that fits the width tried first is read only once
+        if (!use32BitIndicies)
+        {
+            vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(count));
+            if (convertIndices(src, count, indiciesushort->data()) <= MAX_16BIT_INDEX) return _dataCache.share(indiciesushort);
+
+            DebugLog("GraphBuilder Warning: Mesh flagged as 16 bit has indices larger than 65535, using 32 bit indices.");
+        }
 
-            // vertex inputs
-            auto inputarrays = vsg::DataList{createVsgArray<vsg::vec3>(data.verticies.data, data.verticies.length)}; // always have verticies
+        vsg::ref_ptr<vsg::uintArray> indiciesuint(new vsg::uintArray(count));
+        if (convertIndices(src, count, indiciesuint->data()) > MAX_16BIT_INDEX) return _dataCache.share(indiciesuint);
 
-            if (data.normals.length > 0) inputarrays.push_back(createVsgArray<vsg::vec3>(data.normals.data, data.normals.length));
-            if (data.tangents.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.tangents.data, data.tangents.length));
-            if (data.colors.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.colors.data, data.colors.length));
-            if (data.uv0.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv0.data, data.uv0.length));
-            if (data.uv1.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv1.data, data.uv1.length));
+        // flagged as 32 bit but fits in 16
+        vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(count));
+        convertIndices(src, count, indiciesushort->data());
+        _indexStats.narrowed++;
+        return _dataCache.share(indiciesushort);
+    }
+
+    // draw a mesh needing 32 bit indices as several 16 bit ranges each with their own vertex offset, returns null if not worthwhile
+    vsg::ref_ptr<vsg::Node> createSplit16BitDraws(const vsg::DataList& arrays, const IntArray& triangles)
+    {
+        const int32_t* src = reinterpret_cast<const int32_t*>(triangles.data);
+        size_t count = static_cast<size_t>(triangles.length);
+
+        // nothing to gain if the indices already fit
+        uint32_t minIndex, maxIndex;
+        indexRange(src, count, minIndex, maxIndex);
+        if (maxIndex <= MAX_16BIT_INDEX) return vsg::ref_ptr<vsg::Node>();
+
+        IndexRanges ranges = split16BitIndexRanges(src, count);
+        if (!isSplitProfitable(ranges, count)) return vsg::ref_ptr<vsg::Node>();
+
+        vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(count));
+        for (auto& range : ranges)
+        {
+            convertIndices(src + range.firstIndex, range.indexCount, indiciesushort->data() + range.firstIndex, range.vertexOffset);
+        }
 
-            geometry->_arrays = inputarrays;
+        auto commands = vsg::Commands::create();
+        commands->addChild(vsg::BindVertexBuffers::create(0, arrays));
+        commands->addChild(vsg::BindIndexBuffer::create(_dataCache.share(indiciesushort)));
+        for (auto& range : ranges)
+        {
+            commands->addChild(vsg::DrawIndexed::create(range.indexCount, 1, range.firstIndex, range.vertexOffset, 0));
+        }
+
+        _indexStats.split++;
+        _indexStats.splitDraws += ranges.size();
+        return commands;
+    }
 
-            if (data.use32BitIndicies == 0)
+    // arrays allocated by us and filled in place by the caller, indexed by the GeometryAttributes they represent
+    struct NativeMeshArrays
+    {
+        vsg::ref_ptr<vsg::Data> verticies;
+        vsg::ref_ptr<vsg::Data> normals;
+        vsg::ref_ptr<vsg::Data> tangents;
+        vsg::ref_ptr<vsg::Data> colors;
+        vsg::ref_ptr<vsg::Data> uv0;
+        vsg::ref_ptr<vsg::Data> uv1;
+        vsg::ref_ptr<vsg::Data> indices;
+        bool committed = false;
+
+        vsg::ref_ptr<vsg::Data>* attributeArray(uint32_t attribute)
+        {
+            switch (attribute)
             {
-                // for now convert the int32 array indicies to uint16
-                vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(data.triangles.length));
-                for (uint32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesushort->set(i, static_cast<uint16_t>(data.triangles.data[i]));
-                }
+            case VERTEX: return &verticies;
+            case NORMAL: return &normals;
+            case TANGENT: return &tangents;
+            case COLOR: return &colors;
+            case TEXCOORD0: return &uv0;
+            case TEXCOORD1: return &uv1;
+            default: return nullptr;
+            }
+        }
 
-                geometry->_indices = indiciesushort;
+        // in the same order as the pipelines vertex input bindings
+        vsg::DataList vertexArrays() const
+        {
+            vsg::DataList arrays;
+            for (auto& array : {verticies, normals, tangents, colors, uv0, uv1})
+            {
+                if (array.valid()) arrays.push_back(array);
             }
-            else
+            return arrays;
+        }
+    };
+
+    void* allocateVertexArray(int meshId, uint32_t attribute, uint32_t count)
+    {
+        NativeMeshArrays& mesh = _nativeMeshArrays[meshId];
+        if (mesh.committed)
+        {
+            DebugLog("GraphBuilder Error: Mesh arrays for id " + std::to_string(meshId) + " have already been committed.");
+            return nullptr;
+        }
+
+        vsg::ref_ptr<vsg::Data>* array = mesh.attributeArray(attribute);
+        if (!array)
+        {
+            DebugLog("GraphBuilder Error: Unsupported vertex attribute " + std::to_string(attribute) + " for native array.");
+            return nullptr;
+        }
+
+        switch (attribute)
+        {
+        case VERTEX:
+        case NORMAL: *array = vsg::ref_ptr<vsg::Data>(new vsg::vec3Array(count)); break;
+        case TANGENT:
+        case COLOR: *array = vsg::ref_ptr<vsg::Data>(new vsg::vec4Array(count)); break;
+        default: *array = vsg::ref_ptr<vsg::Data>(new vsg::vec2Array(count)); break;
+        }
+        return (*array)->dataPointer();
+    }
+
+    void* allocateIndexArray(int meshId, uint32_t count, bool use32BitIndicies)
+    {
+        NativeMeshArrays& mesh = _nativeMeshArrays[meshId];
+        if (mesh.committed)
+        {
+            DebugLog("GraphBuilder Error: Mesh arrays for id " + std::to_string(meshId) + " have already been committed.");
+            return nullptr;
+        }
+
+        if (use32BitIndicies)
+            mesh.indices = vsg::ref_ptr<vsg::Data>(new vsg::uintArray(count));
+        else
+            mesh.indices = vsg::ref_ptr<vsg::Data>(new vsg::ushortArray(count));
+        return mesh.indices->dataPointer();
+    }
+
+    bool commitMeshArrays(int meshId)
+    {
+        auto itr = _nativeMeshArrays.find(meshId);
+        if (itr == _nativeMeshArrays.end())
+        {
+            DebugLog("GraphBuilder Error: No mesh arrays allocated for id " + std::to_string(meshId) + ".");
+            return false;
+        }
+
+        NativeMeshArrays& mesh = itr->second;
+        if (!mesh.verticies.valid() || !mesh.indices.valid())
+        {
+            DebugLog("GraphBuilder Error: Mesh arrays for id " + std::to_string(meshId) + " need both verticies and indices.");
+            return false;
+        }
+
+        for (auto& array : mesh.vertexArrays())
+        {
+            if (array->valueCount() != mesh.verticies->valueCount())
             {
-                vsg::ref_ptr<vsg::uintArray> indiciesuint(new vsg::uintArray(data.triangles.length));
-                for (uint32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesuint->set(i, static_cast<uint32_t>(data.triangles.data[i]));
-                }
+                DebugLog("GraphBuilder Error: Mesh arrays for id " + std::to_string(meshId) + " have mismatched vertex counts.");
+                return false;
+            }
+        }
+
+        // the caller wrote the indices directly so check they stay inside the vertex arrays before anything reads them
+        size_t indexCount = mesh.indices->valueCount();
+        uint32_t maxIndex = 0;
+        if (mesh.indices->valueSize() == sizeof(uint32_t))
+        {
+            uint32_t minIndex;
+            indexRange(static_cast<const int32_t*>(mesh.indices->dataPointer()), indexCount, minIndex, maxIndex);
+        }
+        else
+        {
+            const uint16_t* src = static_cast<const uint16_t*>(mesh.indices->dataPointer());
+            if (indexCount > 0) maxIndex = *std::max_element(src, src + indexCount);
+        }
+
+        if (indexCount > 0 && maxIndex >= mesh.verticies->valueCount())
+        {
+            DebugLog("GraphBuilder Error: Mesh arrays for id " + std::to_string(meshId) + " have index " + std::to_string(maxIndex) + " past the end of " + std::to_string(mesh.verticies->valueCount()) + " verticies.");
+            return false;
+        }
 
-                geometry->_indices = indiciesuint;
+        // the caller may have allocated 32 bit indices that would fit in 16
+        if (mesh.indices->valueSize() == sizeof(uint32_t))
+        {
+            const int32_t* src = static_cast<const int32_t*>(mesh.indices->dataPointer());
+            size_t count = indexCount;
+
+            if (maxIndex <= MAX_16BIT_INDEX)
+            {
+                vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(count));
+                convertIndices(src, count, indiciesushort->data());
+                mesh.indices = indiciesushort;
+                _indexStats.narrowed++;
             }
+        }
+
+        // the contents are final now so can be shared with any identical arrays
+        for (uint32_t attribute : {VERTEX, NORMAL, TANGENT, COLOR, TEXCOORD0, TEXCOORD1})
+        {
+            vsg::ref_ptr<vsg::Data>* array = mesh.attributeArray(attribute);
+            if (array->valid()) *array = shareVertexArray(*array, attribute);
+        }
+        mesh.indices = _dataCache.share(mesh.indices);
+
+        mesh.committed = true;
+        return true;
+    }
+
+    NativeMeshArrays* getCommittedMeshArrays(int meshId)
+    {
+        auto itr = _nativeMeshArrays.find(meshId);
+        if (itr == _nativeMeshArrays.end() || !itr->second.committed) return nullptr;
+        return &itr->second;
+    }
+
+    //
+    // Bounds
+    //
 
-            geometry->indexCount = data.triangles.length;
-            geometry->instanceCount = 1;
+    // remember a meshes positions so its bound can be computed if a node above it needs one
+    void addMeshPositions(int meshId, const vsg::DataList& arrays)
+    {
+        vsg::ref_ptr<vsg::vec3Array> positions(arrays.empty() ? nullptr : dynamic_cast<vsg::vec3Array*>(arrays[0].get()));
+        if (!positions || positions->valueCount() == 0) return;
+
+        MeshBound& meshBound = _meshBounds[meshId];
+        meshBound.positions = positions;
+        meshBound.bound = vsg::sphere(vsg::vec3(0.0f, 0.0f, 0.0f), -1.0f);
+    }
+
+    // the bounding sphere of a meshes positions, computed once per mesh id as the mesh may be drawn in many places
+    const vsg::sphere* getMeshBound(int meshId)
+    {
+        auto itr = _meshBounds.find(meshId);
+        if (itr == _meshBounds.end()) return nullptr;
+
+        MeshBound& meshBound = itr->second;
+        if (!meshBound.bound.valid())
+        {
+            float boxRadius = 0.0f;
+            meshBound.bound = boundingSphere(static_cast<const vsg::vec3*>(meshBound.positions->dataPointer()), meshBound.positions->valueCount(), &boxRadius);
 
-            _vertexIndexDrawCache[data.id] = geometry;
-            geomNode = geometry;
+            _boundsStats.meshes++;
+            _boundsStats.radius += meshBound.bound.radius;
+            _boundsStats.boxRadius += boxRadius;
         }
+        return &meshBound.bound;
+    }
 
-        if (!addChildToHead(geomNode))
+    // a zero radius asks for the bound to be computed from the meshes added below the node
+    void addPendingBound(vsg::ref_ptr<vsg::Node> node, const CullData& cull)
+    {
+        if (cull.radius > 0.0f) return;
+        _pendingBounds.push_back(PendingBound{node, _nodeStack.size(), vsg::sphere(vsg::vec3(0.0f, 0.0f, 0.0f), -1.0f)});
+    }
+
+    // grow the pending bounds open on the stack by a mesh added to the head, through any transforms in between
+    void includeMeshBound(int meshId)
+    {
+        if (_pendingBounds.empty()) return;
+
+        const vsg::sphere* meshBound = getMeshBound(meshId);
+        if (!meshBound) return;
+
+        vsg::sphere bound = *meshBound;
+        auto pending = _pendingBounds.rbegin();
+        for (size_t depth = _nodeStack.size(); depth-- > 0 && pending != _pendingBounds.rend();)
         {
-            DebugLog("GraphBuilder Error: Current head is not a group");
+            for (; pending != _pendingBounds.rend() && pending->depth == depth; ++pending) expandBy(pending->bound, bound);
+
+            if (auto transform = dynamic_cast<vsg::MatrixTransform*>(_nodeStack[depth].get())) bound = transformSphere(transform->getMatrix(), bound);
         }
+    }
 
-        pushNodeToStack(geomNode);
+    void resolvePendingBound()
+    {
+        PendingBound& pending = _pendingBounds.back();
+        if (!pending.bound.valid())
+        {
+            DebugLog("GraphBuilder Warning: Node with a zero radius has no meshes to compute a bound from.");
+            _boundsStats.unresolved++;
+        }
+        else
+        {
+            if (auto cullNode = dynamic_cast<vsg::CullNode*>(pending.node.get()))
+                cullNode->setBound(pending.bound);
+            else if (auto cullGroup = dynamic_cast<vsg::CullGroup*>(pending.node.get()))
+                cullGroup->setBound(pending.bound);
+            else if (auto lod = dynamic_cast<vsg::LOD*>(pending.node.get()))
+                lod->setBound(pending.bound);
+            _boundsStats.resolved++;
+        }
+        _pendingBounds.pop_back();
     }
 
     //
@@ -346,6 +658,27 @@ public:
     // Commands
     //
 
+    // everything needed to build a pipeline, kept after the callers PipelineData has gone so instanced variants can be made
+    struct PipelineRecipe
+    {
+        struct Stage
+        {
+            VkShaderStageFlagBits stages;
+            std::string source;
+            std::string customDefines;
+            std::vector<uint32_t> specializationData;
+        };
+
+        std::vector<Stage> stages;
+        std::vector<VkDescriptorSetLayoutBinding> descriptorBindings;
+        bool hasNormals = false;
+        bool hasTangents = false;
+        bool hasColors = false;
+        int uvChannelCount = 0;
+        bool useAlpha = false;
+        VertexEncodings encodings;
+    };
+
     vsg::ref_ptr<vsg::ShaderModule> getOrCreateShaderModule(VkShaderStageFlagBits stage, std::string shaderSourceFile, uint32_t inputAtts, uint32_t shaderMode, std::string customDefStr)
     {
         auto split = [](const std::string& str, const char& seperator) {
@@ -397,147 +730,239 @@ public:
         return shaderModule;
     }
 
-    vsg::ref_ptr<vsg::ShaderStage> createShaderStage(VkShaderStageFlagBits stage, vsg::ref_ptr<vsg::ShaderModule> shaderModule, UIntArray specializationConstants)
+    vsg::ref_ptr<vsg::ShaderStage> createShaderStage(VkShaderStageFlagBits stage, vsg::ref_ptr<vsg::ShaderModule> shaderModule, const std::vector<uint32_t>& specializationConstants)
     {
         auto shaderStage = vsg::ShaderStage::create(stage, "main", shaderModule);
 
-        if (specializationConstants.length > 0)
+        if (!specializationConstants.empty())
         {
             vsg::ShaderStage::SpecializationMapEntries specialEntires;
-            auto dataarray = new vsg::uintArray(specializationConstants.length);
+            auto dataarray = new vsg::uintArray(static_cast<uint32_t>(specializationConstants.size()));
 
-            for (uint32_t i = 0; i < specializationConstants.length; i++)
+            for (uint32_t i = 0; i < specializationConstants.size(); i++)
             {
                 specialEntires.push_back({i, i * sizeof(uint32_t), sizeof(uint32_t)});
-                dataarray->at(i) = specializationConstants.data[i];
+                dataarray->at(i) = specializationConstants[i];
             }
 
             shaderStage->setSpecializationMapEntries(specialEntires);
-            shaderStage->setSpecializationData(dataarray);
+            shaderStage->setSpecializationData(_dataCache.share(vsg::ref_ptr<vsg::Data>(dataarray)));
         }
 
         return shaderStage;
     }
 
-    bool addBindGraphicsPipelineCommand(const PipelineData& data, bool addToActiveStateGroup)
+    // copy what's needed from the callers PipelineData so the pipeline can be built again once it has gone
+    PipelineRecipe createPipelineRecipe(const PipelineData& data)
     {
-        std::string idstr = std::string(data.id);
-        vsg::ref_ptr<vsg::BindGraphicsPipeline> bindGraphicsPipeline;
-
-        if (_bindGraphicsPipelineCache.find(idstr) != _bindGraphicsPipelineCache.end())
+        PipelineRecipe recipe;
+        recipe.hasNormals = data.hasNormals != 0;
+        recipe.hasTangents = data.hasTangents != 0;
+        recipe.hasColors = data.hasColors != 0;
+        recipe.uvChannelCount = data.uvChannelCount;
+        recipe.useAlpha = data.useAlpha == 1;
+        recipe.descriptorBindings.assign(data.descriptorBindings.data, data.descriptorBindings.data + data.descriptorBindings.length);
+
+        // vertex encodings, octahedral attributes need a shader that decodes them so fall back to snorm16 for any that don't
+        recipe.encodings = _vertexEncodings;
+        for (int i = 0; i < data.shaderStages.stagesCount; i++)
         {
-            bindGraphicsPipeline = _bindGraphicsPipelineCache[idstr];
+            ShaderStageData& shaderStageData = data.shaderStages.stages[i];
+
+            PipelineRecipe::Stage stage;
+            stage.stages = shaderStageData.stages;
+            stage.source = std::string(shaderStageData.source);
+            stage.customDefines = std::string(shaderStageData.customDefines);
+            stage.specializationData.assign(shaderStageData.specializationData.data, shaderStageData.specializationData.data + shaderStageData.specializationData.length);
+            recipe.stages.push_back(stage);
+
+            if ((stage.stages & VK_SHADER_STAGE_VERTEX_BIT) != VK_SHADER_STAGE_VERTEX_BIT) continue;
+            if (recipe.encodings.normal == ENCODING_OCTAHEDRAL16 && !shaderImportsDefine(stage.source, "VSG_NORMAL_OCTAHEDRAL")) recipe.encodings.normal = ENCODING_SNORM16;
+            if (recipe.encodings.tangent == ENCODING_OCTAHEDRAL16 && !shaderImportsDefine(stage.source, "VSG_TANGENT_OCTAHEDRAL")) recipe.encodings.tangent = ENCODING_SNORM16;
         }
-        else
-        {
-            vsg::ref_ptr<vsg::GraphicsPipelineBuilder> pipelinebuilder = vsg::GraphicsPipelineBuilder::create();
-            vsg::ref_ptr<vsg::GraphicsPipelineBuilder::Traits> traits = vsg::GraphicsPipelineBuilder::Traits::create();
+        return recipe;
+    }
 
-            // vertex input
-            vsg::GraphicsPipelineBuilder::Traits::InputAttributeDescriptions inputAttributes = {{{0, VK_FORMAT_R32G32B32_SFLOAT}}};
-            uint32_t inputshaderatts = VERTEX;
+    // build the pipeline described by recipe, instanceAttribute adds a per instance TRANSLATE or INSTANCE_MATRIX input
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> buildGraphicsPipeline(const PipelineRecipe& recipe, uint32_t instanceAttribute)
+    {
+        vsg::ref_ptr<vsg::GraphicsPipelineBuilder> pipelinebuilder = vsg::GraphicsPipelineBuilder::create();
+        vsg::ref_ptr<vsg::GraphicsPipelineBuilder::Traits> traits = vsg::GraphicsPipelineBuilder::Traits::create();
 
-            if (data.hasNormals)
-            {
-                inputAttributes.push_back({{1, VK_FORMAT_R32G32B32_SFLOAT}});
-                inputshaderatts |= NORMAL;
-            }
-            if (data.hasTangents)
-            {
-                inputAttributes.push_back({{2, VK_FORMAT_R32G32B32A32_SFLOAT}});
-                inputshaderatts |= TANGENT;
-            }
-            if (data.hasColors)
-            {
-                inputAttributes.push_back({{3, VK_FORMAT_R32G32B32A32_SFLOAT}});
-                inputshaderatts |= COLOR;
-            }
-            if (data.uvChannelCount > 0) // uv set 0
-            {
-                inputAttributes.push_back({{4, VK_FORMAT_R32G32_SFLOAT}});
-                inputshaderatts |= TEXCOORD0;
-            }
-            if (data.uvChannelCount > 1) // uv set 1
-            {
-                inputAttributes.push_back({{5, VK_FORMAT_R32G32_SFLOAT}});
-                inputshaderatts |= TEXCOORD1;
-            }
+        const VertexEncodings& encodings = recipe.encodings;
 
-            traits->vertexAttributeDescriptions[VK_VERTEX_INPUT_RATE_VERTEX] = inputAttributes;
+        // vertex input
+        vsg::GraphicsPipelineBuilder::Traits::InputAttributeDescriptions inputAttributes = {{{0, VK_FORMAT_R32G32B32_SFLOAT}}};
+        uint32_t inputshaderatts = VERTEX;
 
-            // descriptor sets layout
-            vsg::GraphicsPipelineBuilder::Traits::DescriptorBindingSet bindingSet;
-            uint32_t shaderMode = 0;
+        if (recipe.hasNormals)
+        {
+            inputAttributes.push_back({{1, encodedFormat(NORMAL, encodings.normal)}});
+            inputshaderatts |= NORMAL;
+            if (encodings.normal == ENCODING_OCTAHEDRAL16) inputshaderatts |= NORMAL_OCTAHEDRAL;
+        }
+        if (recipe.hasTangents)
+        {
+            inputAttributes.push_back({{2, encodedFormat(TANGENT, encodings.tangent)}});
+            inputshaderatts |= TANGENT;
+            if (encodings.tangent == ENCODING_OCTAHEDRAL16) inputshaderatts |= TANGENT_OCTAHEDRAL;
+        }
+        if (recipe.hasColors)
+        {
+            inputAttributes.push_back({{3, encodedFormat(COLOR, encodings.color)}});
+            inputshaderatts |= COLOR;
+        }
+        if (recipe.uvChannelCount > 0) // uv set 0
+        {
+            inputAttributes.push_back({{4, encodedFormat(TEXCOORD0, encodings.uv)}});
+            inputshaderatts |= TEXCOORD0;
+        }
+        if (recipe.uvChannelCount > 1) // uv set 1
+        {
+            inputAttributes.push_back({{5, encodedFormat(TEXCOORD1, encodings.uv)}});
+            inputshaderatts |= TEXCOORD1;
+        }
 
-            for (uint32_t i = 0; i < data.descriptorBindings.length; i++)
+        // interleaved meshes have all their attributes in a single binding, VertexFormatVisitor packs the arrays to match
+        if (_settings.interleaveVertexArrays)
+        {
+            vsg::GraphicsPipelineBuilder::Traits::StructInputAttributeDescription interleaved;
+            for (auto& attribute : inputAttributes)
             {
-                VkDescriptorSetLayoutBinding dslb = data.descriptorBindings.data[i];
-                vsg::GraphicsPipelineBuilder::Traits::DescriptorBinding binding = {dslb.binding, dslb.descriptorType, dslb.descriptorCount};
-                bindingSet[dslb.stageFlags].push_back(binding);
+                interleaved.insert(interleaved.end(), attribute.begin(), attribute.end());
             }
+            inputAttributes = {interleaved};
+        }
 
-            traits->descriptorLayouts = {bindingSet};
-
-            // setup shaders
-            vsg::ShaderStages shaders;
+        traits->vertexAttributeDescriptions[VK_VERTEX_INPUT_RATE_VERTEX] = inputAttributes;
 
-            for (int i = 0; i < data.shaderStages.stagesCount; i++)
-            {
-                ShaderStageData& shaderStageData = data.shaderStages.stages[i];
-                std::string customDefs = std::string(shaderStageData.customDefines);
+        // the per instance transform is bound after the vertex arrays, a mat4 takes a location per column
+        if (instanceAttribute == TRANSLATE)
+        {
+            traits->vertexAttributeDescriptions[VK_VERTEX_INPUT_RATE_INSTANCE] = {{{6, VK_FORMAT_R32G32B32_SFLOAT}}};
+            inputshaderatts |= TRANSLATE;
+        }
+        else if (instanceAttribute == INSTANCE_MATRIX)
+        {
+            traits->vertexAttributeDescriptions[VK_VERTEX_INPUT_RATE_INSTANCE] = {
+                {{6, VK_FORMAT_R32G32B32A32_SFLOAT}, {7, VK_FORMAT_R32G32B32A32_SFLOAT}, {8, VK_FORMAT_R32G32B32A32_SFLOAT}, {9, VK_FORMAT_R32G32B32A32_SFLOAT}}};
+            inputshaderatts |= INSTANCE_MATRIX;
+        }
 
-                if ((shaderStageData.stages & VK_SHADER_STAGE_VERTEX_BIT) == VK_SHADER_STAGE_VERTEX_BIT)
-                {
-                    std::string vertDefines = customDefs + ", VSG_VERTEX_CODE";
-                    auto vertShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_VERTEX_BIT, std::string(shaderStageData.source), inputshaderatts, shaderMode, vertDefines);
-                    shaders.push_back(createShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, shaderStageData.specializationData));
-                }
-                if ((shaderStageData.stages & VK_SHADER_STAGE_FRAGMENT_BIT) == VK_SHADER_STAGE_FRAGMENT_BIT)
-                {
-                    std::string fragDefines = customDefs + ", VSG_FRAGMENT_CODE";
-                    auto fragShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, std::string(shaderStageData.source), inputshaderatts, shaderMode, fragDefines);
-                    shaders.push_back(createShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, shaderStageData.specializationData));
-                }
-            }
+        // descriptor sets layout
+        vsg::GraphicsPipelineBuilder::Traits::DescriptorBindingSet bindingSet;
+        uint32_t shaderMode = 0;
+
+        for (auto& dslb : recipe.descriptorBindings)
+        {
+            vsg::GraphicsPipelineBuilder::Traits::DescriptorBinding binding = {dslb.binding, dslb.descriptorType, dslb.descriptorCount};
+            bindingSet[dslb.stageFlags].push_back(binding);
+        }
 
-            ShaderCompiler shaderCompiler;
-            if (!shaderCompiler.compile(shaders))
+        traits->descriptorLayouts = {bindingSet};
+
+        // setup shaders
+        vsg::ShaderStages shaders;
+
+        for (auto& stage : recipe.stages)
+        {
+            if ((stage.stages & VK_SHADER_STAGE_VERTEX_BIT) == VK_SHADER_STAGE_VERTEX_BIT)
             {
-                DebugLog("GraphBuilder Error: Failed to compile shaders.");
-                return false;
+                std::string vertDefines = stage.customDefines + ", VSG_VERTEX_CODE";
+                auto vertShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_VERTEX_BIT, stage.source, inputshaderatts, shaderMode, vertDefines);
+                shaders.push_back(createShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, stage.specializationData));
             }
+            if ((stage.stages & VK_SHADER_STAGE_FRAGMENT_BIT) == VK_SHADER_STAGE_FRAGMENT_BIT)
+            {
+                std::string fragDefines = stage.customDefines + ", VSG_FRAGMENT_CODE";
+                auto fragShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, stage.source, inputshaderatts, shaderMode, fragDefines);
+                shaders.push_back(createShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, stage.specializationData));
+            }
+        }
+
+        ShaderCompiler shaderCompiler;
+        if (!shaderCompiler.compile(shaders))
+        {
+            DebugLog("GraphBuilder Error: Failed to compile shaders.");
+            return vsg::ref_ptr<vsg::BindGraphicsPipeline>();
+        }
+
+        traits->shaderStages = shaders;
+
+        // topology
+        traits->primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-            traits->shaderStages = shaders;
+        // alpha blending
+        if (recipe.useAlpha)
+        {
+            vsg::ColorBlendState::ColorBlendAttachments colorBlendAttachments;
+            VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+            colorBlendAttachment.blendEnable = VK_TRUE;
+            colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+                                                  VK_COLOR_COMPONENT_G_BIT |
+                                                  VK_COLOR_COMPONENT_B_BIT |
+                                                  VK_COLOR_COMPONENT_A_BIT;
+
+            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+            traits->colorBlendAttachments.push_back(colorBlendAttachment);
+        }
+
+        // create our graphics pipeline
+        pipelinebuilder->build(traits);
+
+        auto bindGraphicsPipeline = vsg::BindGraphicsPipeline::create(pipelinebuilder->getGraphicsPipeline());
+        _pipelineVertexEncodings[bindGraphicsPipeline.get()] = encodings;
+        return bindGraphicsPipeline;
+    }
 
-            // topology
-            traits->primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    // the variant of pipeline drawing with a per instance transform, null if one of its vertex shaders has no input for it.
+    // only the vertex input differs so descriptor sets bound with the original pipelines layout can be bound with this one
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> createInstancedGraphicsPipeline(const vsg::BindGraphicsPipeline* pipeline, uint32_t instanceAttribute)
+    {
+        auto key = std::make_pair(pipeline, instanceAttribute);
+        auto itr = _instancedGraphicsPipelineCache.find(key);
+        if (itr != _instancedGraphicsPipelineCache.end()) return itr->second;
 
-            // alpha blending
-            if (data.useAlpha == 1)
+        vsg::ref_ptr<vsg::BindGraphicsPipeline> instanced;
+        auto recipe = _pipelineRecipes.find(pipeline);
+        if (recipe != _pipelineRecipes.end())
+        {
+            std::string define = instanceAttribute == TRANSLATE ? "VSG_TRANSLATE" : "VSG_INSTANCE_MATRIX";
+            bool supported = true;
+            for (auto& stage : recipe->second.stages)
             {
-                vsg::ColorBlendState::ColorBlendAttachments colorBlendAttachments;
-                VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-                colorBlendAttachment.blendEnable = VK_TRUE;
-                colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
-                                                      VK_COLOR_COMPONENT_G_BIT |
-                                                      VK_COLOR_COMPONENT_B_BIT |
-                                                      VK_COLOR_COMPONENT_A_BIT;
-
-                colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-                colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-                colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-                colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-                colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-                colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-                traits->colorBlendAttachments.push_back(colorBlendAttachment);
+                if ((stage.stages & VK_SHADER_STAGE_VERTEX_BIT) == VK_SHADER_STAGE_VERTEX_BIT && !shaderImportsDefine(stage.source, define)) supported = false;
             }
+            if (supported) instanced = buildGraphicsPipeline(recipe->second, instanceAttribute);
+        }
 
-            // create our graphics pipeline
-            pipelinebuilder->build(traits);
+        _instancedGraphicsPipelineCache[key] = instanced;
+        return instanced;
+    }
+
+    bool addBindGraphicsPipelineCommand(const PipelineData& data, bool addToActiveStateGroup)
+    {
+        std::string idstr = std::string(data.id);
+        vsg::ref_ptr<vsg::BindGraphicsPipeline> bindGraphicsPipeline;
+
+        if (_bindGraphicsPipelineCache.find(idstr) != _bindGraphicsPipelineCache.end())
+        {
+            bindGraphicsPipeline = _bindGraphicsPipelineCache[idstr];
+        }
+        else
+        {
+            PipelineRecipe recipe = createPipelineRecipe(data);
+            bindGraphicsPipeline = buildGraphicsPipeline(recipe, 0);
+            if (!bindGraphicsPipeline) return false;
 
-            bindGraphicsPipeline = vsg::BindGraphicsPipeline::create(pipelinebuilder->getGraphicsPipeline());
             _bindGraphicsPipelineCache[idstr] = bindGraphicsPipeline;
+            _pipelineRecipes[bindGraphicsPipeline.get()] = recipe;
         }
 
         if (addToActiveStateGroup)
@@ -571,25 +996,14 @@ public:
         }
         else
         {
-            if (data.use32BitIndicies == 0)
+            NativeMeshArrays* nativeArrays = getCommittedMeshArrays(data.id);
+            if (nativeArrays)
             {
-                // for now convert the int32 array indicies to uint16
-                vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(data.triangles.length));
-                for (uint32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesushort->set(i, static_cast<uint16_t>(data.triangles.data[i]));
-                }
-                cmd = vsg::BindIndexBuffer::create(indiciesushort);
+                cmd = vsg::BindIndexBuffer::create(nativeArrays->indices);
             }
             else
             {
-                vsg::ref_ptr<vsg::uintArray> indiciesuint(new vsg::uintArray(data.triangles.length));
-                for (uint32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesuint->set(i, static_cast<uint32_t>(data.triangles.data[i]));
-                }
-
-                cmd = vsg::BindIndexBuffer::create(indiciesuint);
+                cmd = vsg::BindIndexBuffer::create(createIndexArray(data.triangles, data.use32BitIndicies != 0));
             }
             _bindIndexBufferCache[data.id] = cmd;
         }
@@ -606,18 +1020,22 @@ public:
         }
         else
         {
-            auto inputarrays = vsg::DataList{createVsgArray<vsg::vec3>(data.verticies.data, data.verticies.length)}; // always have verticies
-
-            if (data.normals.length > 0) inputarrays.push_back(createVsgArray<vsg::vec3>(data.normals.data, data.normals.length));
-            if (data.tangents.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.tangents.data, data.tangents.length));
-            if (data.colors.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.colors.data, data.colors.length));
-            if (data.uv0.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv0.data, data.uv0.length));
-            if (data.uv1.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv1.data, data.uv1.length));
-
-            cmd = vsg::BindVertexBuffers::create(0, inputarrays);
+            NativeMeshArrays* nativeArrays = getCommittedMeshArrays(data.id);
+            if (nativeArrays)
+            {
+                cmd = vsg::BindVertexBuffers::create(0, nativeArrays->vertexArrays());
+            }
+            else
+            {
+                cmd = vsg::BindVertexBuffers::create(0, createExternalVertexArrays(data));
+            }
             _bindVertexBuffersCache[data.id] = cmd;
+            addMeshPositions(data.id, static_cast<vsg::BindVertexBuffers*>(cmd.get())->getArrays());
         }
 
+        // the whole vertex array is bounded even if the draws only use some of it, that's still tighter than the renderer box
+        includeMeshBound(data.id);
+
         addCommandToHead(cmd);
     }
 
@@ -676,6 +1094,7 @@ public:
             auto descriptorSet = vsg::DescriptorSet::create(_activeGraphicsPipeline->getPipelineLayout()->getDescriptorSetLayouts(), _descriptors);
             bindDescriptorSet = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, _activeGraphicsPipeline->getPipelineLayout(), 0, descriptorSet);
             _bindDescriptorSetCache[fullid] = bindDescriptorSet;
+            _descriptorSetContents[bindDescriptorSet.get()] = {_descriptors, _activeGraphicsPipeline};
         }
 
         if (addToStateGroup)
@@ -701,14 +1120,164 @@ public:
     // Descriptors
     //
 
-    vsg::ref_ptr<vsg::Data> createDataForTexture(const ImageData& data)
+    // copy the first level into a chain vsg owns and fill in the rest of the levels
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> createMipmappedArray2D(const ImageData& data, const MipmapOptions& options, uint32_t mipmapCount)
+    {
+        uint32_t width = static_cast<uint32_t>(data.width);
+        uint32_t height = static_cast<uint32_t>(data.height);
+
+        T* chain = new T[mipmapChainSize(width, height, mipmapCount)];
+        std::memcpy(chain, data.pixels.data, static_cast<size_t>(width) * height * sizeof(T));
+        generateMipmaps(reinterpret_cast<uint8_t*>(chain), width, height, mipmapCount, options);
+
+        return vsg::ref_ptr<vsg::Data>(new vsg::Array2D<T>(width, height, chain));
+    }
+
+    // a full mip chain for 8 bit 2D textures exported with only their first level, otherwise an invalid ref_ptr
+    vsg::ref_ptr<vsg::Data> createMipmappedDataForTexture(const ImageData& data, uint32_t& mipmapCount)
     {
+        if (!_settings.generateMipmaps || data.mipmapCount > 1 || data.depth != 1 || data.width < 1 || data.height < 1) return vsg::ref_ptr<vsg::Data>();
+
+        MipmapOptions options;
+        switch (data.format)
+        {
+        case VK_FORMAT_R8_UNORM: options.components = 1; break;
+        case VK_FORMAT_R8_SRGB: options.components = 1; options.srgb = true; break;
+        case VK_FORMAT_R8G8_UNORM: options.components = 2; break;
+        case VK_FORMAT_R8G8_SRGB: options.components = 2; options.srgb = true; break;
+        case VK_FORMAT_B8G8R8_UNORM: options.components = 3; break;
+        case VK_FORMAT_B8G8R8_SRGB: options.components = 3; options.srgb = true; break;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32: options.components = 4; break;
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB: options.components = 4; options.srgb = true; break;
+        default: return vsg::ref_ptr<vsg::Data>();
+        }
+        options.filter = data.mipmapFilter == MIPMAP_FILTER_NORMAL ? MIPMAP_FILTER_NORMAL : MIPMAP_FILTER_COLOR;
+        options.alphaCutoff = data.alphaCutoff;
+
+        uint32_t fullCount = fullMipmapCount(static_cast<uint32_t>(data.width), static_cast<uint32_t>(data.height));
+        if (fullCount <= 1) return vsg::ref_ptr<vsg::Data>();
+
+        size_t levelSize = static_cast<size_t>(data.width) * data.height * options.components;
+        if (data.pixels.data == nullptr || data.pixels.length < 0 || static_cast<size_t>(data.pixels.length) < levelSize)
+        {
+            DebugLog("GraphBuilder Warning: Texture " + std::to_string(data.id) + " has fewer pixels than its size, mipmaps not generated.");
+            return vsg::ref_ptr<vsg::Data>();
+        }
+
+        vsg::ref_ptr<vsg::Data> texdata;
+        switch (options.components)
+        {
+        case 1: texdata = createMipmappedArray2D<uint8_t>(data, options, fullCount); break;
+        case 2: texdata = createMipmappedArray2D<vsg::ubvec2>(data, options, fullCount); break;
+        case 3: texdata = createMipmappedArray2D<vsg::ubvec3>(data, options, fullCount); break;
+        default: texdata = createMipmappedArray2D<vsg::ubvec4>(data, options, fullCount); break;
+        }
+
+        _mipmapStats.textures++;
+        _mipmapStats.bytes += (mipmapChainSize(static_cast<uint32_t>(data.width), static_cast<uint32_t>(data.height), fullCount) * options.components) - levelSize;
+        mipmapCount = fullCount;
+        return texdata;
+    }
+
+    // Block compress an 8 bit 2D texture's mip chain, either the callers pixels or a generated chain. The format is
+    // picked from the contents, see chooseBlockCompression. Returns an invalid ref_ptr for textures that can't be handled.
+    vsg::ref_ptr<vsg::Data> createCompressedDataForTexture(const ImageData& data, const uint8_t* chain, uint32_t mipmapCount)
+    {
+        if (_settings.textureCompression <= COMPRESSION_NONE || data.depth != 1 || chain == nullptr) return vsg::ref_ptr<vsg::Data>();
+
+        CompressOptions options;
+        options.quality = static_cast<CompressionQuality>(std::min(_settings.textureCompression, static_cast<int>(COMPRESSION_HIGH)));
+        bool srgb = false;
+        switch (data.format)
+        {
+        case VK_FORMAT_R8_UNORM: options.components = 1; break;
+        case VK_FORMAT_R8G8_UNORM: options.components = 2; break;
+        case VK_FORMAT_B8G8R8_UNORM: options.components = 3; options.swapRedBlue = true; break;
+        case VK_FORMAT_B8G8R8_SRGB: options.components = 3; options.swapRedBlue = true; srgb = true; break;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32: options.components = 4; break;
+        case VK_FORMAT_R8G8B8A8_SRGB: options.components = 4; srgb = true; break;
+        case VK_FORMAT_B8G8R8A8_UNORM: options.components = 4; options.swapRedBlue = true; break;
+        case VK_FORMAT_B8G8R8A8_SRGB: options.components = 4; options.swapRedBlue = true; srgb = true; break;
+        default: return vsg::ref_ptr<vsg::Data>(); // BC4 and BC5 have no srgb variants
+        }
+
+        uint32_t width = static_cast<uint32_t>(data.width);
+        uint32_t height = static_cast<uint32_t>(data.height);
+        uint32_t levels = compressibleMipmapCount(width, height, mipmapCount);
+        if (levels == 0) return vsg::ref_ptr<vsg::Data>();
+
+        size_t chainSize = mipmapChainSize(width, height, levels) * options.components;
+        if (chain == data.pixels.data && (data.pixels.length < 0 || static_cast<size_t>(data.pixels.length) < chainSize))
+        {
+            DebugLog("GraphBuilder Warning: Texture " + std::to_string(data.id) + " has fewer pixels than its size, not compressed.");
+            return vsg::ref_ptr<vsg::Data>();
+        }
+
+        BlockCompression compression = chooseBlockCompression(chain, static_cast<size_t>(width) * height, options.components, options.quality);
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        switch (compression)
+        {
+        case BLOCK_BC1: format = srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK; break;
+        case BLOCK_BC3: format = srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK; break;
+        case BLOCK_BC4: format = VK_FORMAT_BC4_UNORM_BLOCK; break;
+        case BLOCK_BC5: format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+        case BLOCK_BC7: format = srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK; break;
+        }
+
+        size_t compressedSize = compressedChainSize(width, height, levels, compression);
         vsg::ref_ptr<vsg::Data> texdata;
+        if (blockBytes(compression) == 8)
+        {
+            vsg::block64* blocks = new vsg::block64[compressedSize / sizeof(vsg::block64)];
+            compressTexture(chain, width, height, levels, compression, options, reinterpret_cast<uint8_t*>(blocks));
+            texdata = new vsg::block64Array2D(width / 4, height / 4, blocks);
+        }
+        else
+        {
+            vsg::block128* blocks = new vsg::block128[compressedSize / sizeof(vsg::block128)];
+            compressTexture(chain, width, height, levels, compression, options, reinterpret_cast<uint8_t*>(blocks));
+            texdata = new vsg::block128Array2D(width / 4, height / 4, blocks);
+        }
+
+        VkFormatSizeInfo sizeInfo = GetSizeInfoForFormat(format);
+        sizeInfo.layout.maxNumMipmaps = levels;
+        texdata->setFormat(format);
+        texdata->setLayout(sizeInfo.layout);
+
+        _compressionStats.textures++;
+        _compressionStats.bytesBefore += chainSize;
+        _compressionStats.bytesAfter += compressedSize;
+        return texdata;
+    }
+
+    vsg::ref_ptr<vsg::Data> createDataForTexture(const ImageData& data)
+    {
         VkFormat format = data.format;
         VkFormatSizeInfo sizeInfo = GetSizeInfoForFormat(data.format);
         sizeInfo.layout.maxNumMipmaps = data.mipmapCount;
         uint32_t blockVolume = sizeInfo.layout.blockWidth * sizeInfo.layout.blockHeight * sizeInfo.layout.blockDepth;
 
+        // generated and compressed chains are copies so they're deleted with the graph rather than released
+        uint32_t mipmapCount = static_cast<uint32_t>(std::max(data.mipmapCount, 1));
+        vsg::ref_ptr<vsg::Data> texdata = createMipmappedDataForTexture(data, mipmapCount);
+
+        const uint8_t* chain = texdata.valid() ? static_cast<const uint8_t*>(texdata->dataPointer()) : data.pixels.data;
+        vsg::ref_ptr<vsg::Data> compressed = createCompressedDataForTexture(data, chain, mipmapCount);
+        if (compressed.valid()) return _dataCache.share(compressed);
+
+        if (texdata.valid())
+        {
+            sizeInfo.layout.maxNumMipmaps = mipmapCount;
+            texdata->setFormat(format);
+            texdata->setLayout(sizeInfo.layout);
+            return _dataCache.share(texdata);
+        }
+
         if (data.depth == 1)
         {
             if (blockVolume == 1)
@@ -844,7 +1413,175 @@ public:
 
         texdata->setFormat(format);
         texdata->setLayout(sizeInfo.layout);
-        return texdata;
+
+        // pixels still belong to the caller
+        _externalData.push_back(texdata);
+        return _dataCache.share(texdata);
+    }
+
+    // Pack a descriptors images into the layers of one 2D array image, block compressing each layer of each level when
+    // texture compression is enabled. Returns an invalid ref_ptr if none of the images could be read.
+    vsg::ref_ptr<vsg::Data> createTextureArrayData(const DescriptorImageData& data)
+    {
+        PackedTextureArray packed;
+        if (!packTextureArray(data.images, static_cast<uint32_t>(data.descriptorCount), _settings.generateMipmaps != 0, packed))
+        {
+            DebugLog("GraphBuilder Error: None of the layers of texture array " + std::to_string(data.id) + " could be read.");
+            return vsg::ref_ptr<vsg::Data>();
+        }
+        for (uint32_t layer : packed.unreadable)
+        {
+            DebugLog("GraphBuilder Warning: Texture " + std::to_string(data.images[layer].id) + " can't be packed into texture array " + std::to_string(data.id) + ", layer left white.");
+        }
+
+        VkFormat format = packed.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        uint32_t levels = packed.mipmapCount;
+        size_t arraySize = packed.chain.size();
+        vsg::ref_ptr<vsg::Data> texdata;
+
+        CompressOptions options;
+        options.quality = static_cast<CompressionQuality>(std::min(_settings.textureCompression, static_cast<int>(COMPRESSION_HIGH)));
+        uint32_t compressibleLevels = compressibleMipmapCount(packed.width, packed.height, packed.mipmapCount);
+        if (options.quality > COMPRESSION_NONE && compressibleLevels > 0)
+        {
+            // the first level of every layer is contiguous so the format is picked from all of them at once
+            BlockCompression compression = chooseBlockCompression(packed.chain.data(), static_cast<size_t>(packed.width) * packed.height * packed.layers, 4, options.quality);
+            switch (compression)
+            {
+            case BLOCK_BC3: format = packed.srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK; break;
+            case BLOCK_BC7: format = packed.srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK; break;
+            default: format = packed.srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK; break;
+            }
+
+            levels = compressibleLevels;
+            arraySize = mipmapChainSize(packed.width, packed.height, levels) * packed.layers * 4;
+            size_t layerBlocksSize = compressedChainSize(packed.width, packed.height, levels, compression);
+            uint8_t* blocks = blockBytes(compression) == 8 ? reinterpret_cast<uint8_t*>(new vsg::block64[layerBlocksSize * packed.layers / sizeof(vsg::block64)])
+                                                           : reinterpret_cast<uint8_t*>(new vsg::block128[layerBlocksSize * packed.layers / sizeof(vsg::block128)]);
+
+            // levels hold every layer so each layer of each level is compressed as its own single level texture
+            const uint8_t* level = packed.chain.data();
+            uint8_t* out = blocks;
+            uint32_t width = packed.width, height = packed.height;
+            for (uint32_t i = 0; i < levels; ++i)
+            {
+                size_t layerSize = static_cast<size_t>(width) * height * 4;
+                size_t layerBlocks = compressedChainSize(width, height, 1, compression);
+                for (uint32_t layer = 0; layer < packed.layers; ++layer, out += layerBlocks)
+                {
+                    compressTexture(level + layerSize * layer, width, height, 1, compression, options, out);
+                }
+                level += layerSize * packed.layers;
+                width = std::max(width / 2, 1u);
+                height = std::max(height / 2, 1u);
+            }
+
+            if (blockBytes(compression) == 8) texdata = new vsg::block64Array3D(packed.width / 4, packed.height / 4, packed.layers, reinterpret_cast<vsg::block64*>(blocks));
+            else texdata = new vsg::block128Array3D(packed.width / 4, packed.height / 4, packed.layers, reinterpret_cast<vsg::block128*>(blocks));
+
+            _compressionStats.textures++;
+            _compressionStats.bytesBefore += arraySize;
+            _compressionStats.bytesAfter += layerBlocksSize * packed.layers;
+        }
+        else
+        {
+            vsg::ubvec4* texels = new vsg::ubvec4[packed.chain.size() / 4];
+            std::memcpy(texels, packed.chain.data(), packed.chain.size());
+            texdata = new vsg::ubvec4Array3D(packed.width, packed.height, packed.layers, texels);
+        }
+
+        VkFormatSizeInfo sizeInfo = GetSizeInfoForFormat(format);
+        sizeInfo.layout.maxNumMipmaps = levels;
+        sizeInfo.layout.imageViewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        texdata->setFormat(format);
+        texdata->setLayout(sizeInfo.layout);
+
+        _textureArrayStats.arrays++;
+        _textureArrayStats.layers += packed.layers;
+        _textureArrayStats.converted += packed.converted;
+        _textureArrayStats.bytes += arraySize;
+        return _dataCache.share(texdata);
+    }
+
+    // Pack the first component of each of a descriptors images into one unorm image, described by an ImageData with the
+    // first images sampler state so it's mipmapped, compressed and shared like any other texture. Returns false if none of
+    // the images could be read.
+    bool createChannelPackedImage(const DescriptorImageData& data, ImageData& image)
+    {
+        PackedTextureChannels packed;
+        if (!packTextureChannels(data.images, static_cast<uint32_t>(data.descriptorCount), _settings.generateMipmaps != 0, packed))
+        {
+            DebugLog("GraphBuilder Error: None of the images of channel packed texture " + std::to_string(data.id) + " could be read.");
+            return false;
+        }
+        for (uint32_t channel : packed.unreadable)
+        {
+            DebugLog("GraphBuilder Warning: Texture " + std::to_string(data.images[channel].id) + " can't be packed into texture " + std::to_string(data.id) + ", channel " +
+                     std::to_string(channel) + " left white.");
+        }
+
+        // the pixels have to outlive the export like a callers would
+        auto pixels = vsg::ubyteArray::create(static_cast<uint32_t>(packed.chain.size()));
+        std::memcpy(pixels->dataPointer(), packed.chain.data(), packed.chain.size());
+        _generatedPixels.push_back(pixels);
+
+        image = data.images[0];
+        image.pixels.data = static_cast<uint8_t*>(pixels->dataPointer());
+        image.pixels.length = static_cast<int>(packed.chain.size());
+        image.width = static_cast<int>(packed.width);
+        image.height = static_cast<int>(packed.height);
+        image.depth = 1;
+        image.mipmapCount = static_cast<int>(packed.mipmapCount);
+        image.mipmapFilter = MIPMAP_FILTER_COLOR;
+        image.alphaCutoff = 0.0f;
+        switch (packed.components)
+        {
+        case 1: image.format = VK_FORMAT_R8_UNORM; break;
+        case 2: image.format = VK_FORMAT_R8G8_UNORM; break;
+        default: image.format = VK_FORMAT_R8G8B8A8_UNORM; break;
+        }
+
+        _channelPackStats.textures++;
+        _channelPackStats.images += static_cast<size_t>(data.descriptorCount);
+        _channelPackStats.converted += packed.converted;
+        return true;
+    }
+
+    // Shrink textures whose content doesn't need their format before creating their data, constant textures to a single
+    // texel, textures whose shader only reads the first component to one component and opaque rgba that will be
+    // compressed to rgb.
+    vsg::ref_ptr<vsg::Data> createAnalyzedDataForTexture(const ImageData& data, bool firstComponentOnly)
+    {
+        if (!_settings.analyzeTextures) return createDataForTexture(data);
+
+        ReduceOptions options;
+        options.firstComponentOnly = firstComponentOnly;
+        options.compress = _settings.textureCompression > COMPRESSION_NONE;
+
+        ReducedTexture reduced;
+        if (!reduceTexture(data, options, reduced)) return createDataForTexture(data);
+
+        auto pixels = vsg::ubyteArray::create(static_cast<uint32_t>(reduced.pixels.size()));
+        std::memcpy(pixels->dataPointer(), reduced.pixels.data(), reduced.pixels.size());
+        _generatedPixels.push_back(pixels);
+
+        ImageData image = data;
+        image.pixels.data = static_cast<uint8_t*>(pixels->dataPointer());
+        image.pixels.length = static_cast<int>(reduced.pixels.size());
+        image.format = reduced.format;
+        image.width = static_cast<int>(reduced.width);
+        image.height = static_cast<int>(reduced.height);
+        image.mipmapCount = static_cast<int>(reduced.mipmapCount);
+
+        DebugLog("GraphBuilder Report: Texture " + std::to_string(data.id) + " " + reduced.reason + ".");
+
+        if (reduced.reductions & REDUCED_CONSTANT) _analysisStats.constant++;
+        if (reduced.reductions & REDUCED_FIRST_COMPONENT) _analysisStats.singleComponent++;
+        if (reduced.reductions & REDUCED_ALPHA) _analysisStats.opaque++;
+        _analysisStats.bytesBefore += static_cast<size_t>(std::max(data.pixels.length, 0));
+        _analysisStats.bytesAfter += reduced.pixels.size();
+
+        return createDataForTexture(image);
     }
 
     vsg::ref_ptr<vsg::DescriptorImage> createTexture(const DescriptorImageData& data, bool useCache = true)
@@ -859,13 +1596,50 @@ public:
         else
         {
             vsg::SamplerImages samplerImages;
-            for (int i = 0; i < data.descriptorCount; i++)
+            if (data.packLayers && data.descriptorCount > 0)
+            {
+                vsg::ref_ptr<vsg::Data> texdata = createTextureArrayData(data);
+                if (!texdata.valid()) return vsg::ref_ptr<vsg::DescriptorImage>();
+
+                // the layers share the first images sampler
+                ImageData image = data.images[0];
+                image.mipmapCount = static_cast<int>(texdata->getLayout().maxNumMipmaps);
+
+                vsg::ref_ptr<vsg::Sampler> sampler = shareSampler(vkSamplerCreateInfoForTextureData(image));
+
+                samplerImages.push_back({ sampler, texdata });
+            }
+            ImageData packedImage = {};
+            if (data.packChannels && data.descriptorCount > 0)
+            {
+                if (!createChannelPackedImage(data, packedImage)) return vsg::ref_ptr<vsg::DescriptorImage>();
+
+                vsg::ref_ptr<vsg::Data> texdata = _textureDataCache.share(packedImage, [this](const ImageData& image) { return createDataForTexture(image); });
+                if (!texdata.valid()) return vsg::ref_ptr<vsg::DescriptorImage>();
+                _textureDataIds.emplace(texdata.get(), packedImage.id);
+
+                // the channels share the first images sampler
+                packedImage.mipmapCount = std::max(packedImage.mipmapCount, static_cast<int>(texdata->getLayout().maxNumMipmaps));
+
+                vsg::ref_ptr<vsg::Sampler> sampler = shareSampler(vkSamplerCreateInfoForTextureData(packedImage));
+
+                samplerImages.push_back({ sampler, texdata });
+            }
+            bool firstComponentOnly = data.firstComponentOnly != 0;
+            for (int i = 0; !data.packLayers && !data.packChannels && i < data.descriptorCount; i++)
             {
-                vsg::ref_ptr<vsg::Data> texdata = createDataForTexture(data.images[i]);
+                // textures with the same contents as an earlier one reuse its mipmapped and compressed data, unless they
+                // were reduced for a shader reading different components
+                vsg::ref_ptr<vsg::Data> texdata = _textureDataCache.share(
+                    data.images[i], [this, firstComponentOnly](const ImageData& image) { return createAnalyzedDataForTexture(image, firstComponentOnly); }, firstComponentOnly ? 1 : 0);
                 if (!texdata.valid()) return vsg::ref_ptr<vsg::DescriptorImage>();
+                _textureDataIds.emplace(texdata.get(), data.images[i].id);
 
-                vsg::ref_ptr<vsg::Sampler> sampler = vsg::Sampler::create();
-                sampler->info() = vkSamplerCreateInfoForTextureData(data.images[i]);
+                // the sampler lod range has to cover any generated levels
+                ImageData image = data.images[i];
+                image.mipmapCount = std::max(image.mipmapCount, static_cast<int>(texdata->getLayout().maxNumMipmaps));
+
+                vsg::ref_ptr<vsg::Sampler> sampler = shareSampler(vkSamplerCreateInfoForTextureData(image));
 
                 samplerImages.push_back({ sampler, texdata });
             }
@@ -873,6 +1647,23 @@ public:
 
             texture = vsg::DescriptorImage::create(samplerImages, data.binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
+            // the shader samples the images at the first uvs so their texel density can be measured, see MipTrimVisitor
+            if (data.sampledAtFirstUvs) _uvSampledTextures.insert(texture.get());
+
+            // normal maps are the ones filtered as normals, packed and first component maps are masks
+            if (data.descriptorCount > 0 && data.images[0].mipmapFilter == MIPMAP_FILTER_NORMAL)
+                _textureRoles[texture.get()] = TEXTURE_ROLE_NORMAL;
+            else if (data.packChannels || data.firstComponentOnly)
+                _textureRoles[texture.get()] = TEXTURE_ROLE_MASK;
+
+            // single textures can be atlased once the graph is complete
+            if (data.packChannels || (!data.packLayers && data.descriptorCount == 1))
+            {
+                ImageData image = data.packChannels ? packedImage : data.images[0];
+                image.pixels = {};
+                _atlasableTextures[texture.get()] = {image, static_cast<uint32_t>(data.binding)};
+            }
+
             if (useCache) _textureCache[data.id] = texture;
         }
 
@@ -893,7 +1684,7 @@ public:
     {
         vsg::ref_ptr<vsg::floatValue> floatval = vsg::ref_ptr<vsg::floatValue>(new vsg::floatValue());
         floatval->value() = data.value;
-        _descriptors.push_back(vsg::DescriptorBuffer::create(floatval, data.binding));
+        _descriptors.push_back(shareDescriptorBuffer({_dataCache.share(floatval)}, data.binding));
         _descriptorObjectIds.push_back(std::to_string(data.id));
     }
 
@@ -904,10 +1695,10 @@ public:
         {
             vsg::ref_ptr<vsg::floatValue> floatval = vsg::ref_ptr<vsg::floatValue>(new vsg::floatValue());
             floatval->value() = data.value.data[i];
-            vallist.push_back(floatval);
+            vallist.push_back(_dataCache.share(floatval));
         }
 
-        _descriptors.push_back(vsg::DescriptorBuffer::create(vallist, data.binding));
+        _descriptors.push_back(shareDescriptorBuffer(vallist, data.binding));
         _descriptorObjectIds.push_back(std::to_string(data.id));
     }
 
@@ -915,7 +1706,7 @@ public:
     {
         vsg::ref_ptr<vsg::vec4Value> vecval = vsg::ref_ptr<vsg::vec4Value>(new vsg::vec4Value());
         vecval->value() = data.value;
-        _descriptors.push_back(vsg::DescriptorBuffer::create(vecval, data.binding));
+        _descriptors.push_back(shareDescriptorBuffer({_dataCache.share(vecval)}, data.binding));
         _descriptorObjectIds.push_back(std::to_string(data.id));
     }
 
@@ -926,67 +1717,286 @@ public:
         {
             vsg::ref_ptr<vsg::vec4Value> vecval = vsg::ref_ptr<vsg::vec4Value>(new vsg::vec4Value());
             vecval->value() = data.value.data[i];
-            vallist.push_back(vecval);
+            vallist.push_back(_dataCache.share(vecval));
         }
 
-        _descriptors.push_back(vsg::DescriptorBuffer::create(vallist, data.binding));
+        _descriptors.push_back(shareDescriptorBuffer(vallist, data.binding));
         _descriptorObjectIds.push_back(std::to_string(data.id));
     }
 
-    //
-    // Helpers
-    //
+    // the create info fields samplers are compared by, pNext and the struct's padding are left out
+    static std::array<uint32_t, 16> samplerKey(const VkSamplerCreateInfo& info)
+    {
+        std::array<uint32_t, 16> key = {static_cast<uint32_t>(info.flags), static_cast<uint32_t>(info.magFilter), static_cast<uint32_t>(info.minFilter),
+                                        static_cast<uint32_t>(info.mipmapMode), static_cast<uint32_t>(info.addressModeU), static_cast<uint32_t>(info.addressModeV),
+                                        static_cast<uint32_t>(info.addressModeW), 0, static_cast<uint32_t>(info.anisotropyEnable), 0, static_cast<uint32_t>(info.compareEnable),
+                                        static_cast<uint32_t>(info.compareOp), 0, 0, static_cast<uint32_t>(info.borderColor), static_cast<uint32_t>(info.unnormalizedCoordinates)};
+        std::memcpy(&key[7], &info.mipLodBias, sizeof(float));
+        std::memcpy(&key[9], &info.maxAnisotropy, sizeof(float));
+        std::memcpy(&key[12], &info.minLod, sizeof(float));
+        std::memcpy(&key[13], &info.maxLod, sizeof(float));
+        return key;
+    }
 
-    vsg::Node* getHead()
+    // samplers with the same create info are shared across textures, drivers limit how many can exist at once
+    vsg::ref_ptr<vsg::Sampler> shareSampler(const VkSamplerCreateInfo& info)
     {
-        if (_nodeStack.size() == 0) return nullptr;
-        return _nodeStack[_nodeStack.size() - 1];
+        _samplerStats.requested++;
+
+        std::array<uint32_t, 16> key = samplerKey(info);
+        std::vector<vsg::ref_ptr<vsg::Sampler>>& samplers = _samplerCache[hashBytes(key.data(), sizeof(key))];
+        if (!info.pNext)
+        {
+            for (auto& sampler : samplers)
+            {
+                if (!sampler->info().pNext && samplerKey(sampler->info()) == key) return sampler;
+            }
+        }
+
+        vsg::ref_ptr<vsg::Sampler> sampler = vsg::Sampler::create();
+        sampler->info() = info;
+        samplers.push_back(sampler);
+        return sampler;
     }
 
-    vsg::Group* getHeadAsGroup()
+    // uniform buffers with the same binding and contents are shared so materials that only differ by texture end up with
+    // identical descriptors, see TextureAtlasVisitor
+    vsg::ref_ptr<vsg::Descriptor> shareDescriptorBuffer(const vsg::DataList& values, int binding)
     {
-        if (_nodeStack.size() == 0) return nullptr;
-        return dynamic_cast<vsg::Group*>(_nodeStack[_nodeStack.size() - 1].get());
+        std::pair<int, std::vector<const vsg::Data*>> key(binding, {});
+        for (auto& value : values) key.second.push_back(value.get());
+
+        auto itr = _descriptorBufferCache.find(key);
+        if (itr != _descriptorBufferCache.end()) return itr->second;
+
+        vsg::ref_ptr<vsg::Descriptor> descriptor = vsg::DescriptorBuffer::create(values, binding);
+        _descriptorBufferCache[key] = descriptor;
+        return descriptor;
     }
 
-    vsg::LOD* getHeadAsLOD()
+    //
+    // Texture atlases
+    //
+
+    bool getAtlasMaterial(const vsg::BindDescriptorSet* bind, TextureAtlasVisitor::Material& material)
     {
-        if (_nodeStack.size() == 0) return nullptr;
-        return dynamic_cast<vsg::LOD*>(_nodeStack[_nodeStack.size() - 1].get());
+        auto contents = _descriptorSetContents.find(bind);
+        if (contents == _descriptorSetContents.end()) return false;
+
+        const vsg::GraphicsPipeline* pipeline = contents->second.pipeline.get();
+        uint64_t key = hashBytes(&pipeline, sizeof(pipeline));
+        size_t textureCount = 0;
+        for (size_t i = 0; i < contents->second.descriptors.size(); ++i)
+        {
+            const vsg::Descriptor* descriptor = contents->second.descriptors[i].get();
+            auto texture = _atlasableTextures.find(descriptor);
+            if (texture != _atlasableTextures.end())
+            {
+                material.texture = vsg::ref_ptr<vsg::DescriptorImage>(static_cast<vsg::DescriptorImage*>(const_cast<vsg::Descriptor*>(descriptor)));
+                material.sampler = texture->second.image;
+                key = hashBytes(&i, sizeof(i), key);
+                textureCount++;
+            }
+            else if (dynamic_cast<const vsg::DescriptorImage*>(descriptor))
+            {
+                return false;
+            }
+            else
+            {
+                key = hashBytes(&descriptor, sizeof(descriptor), key);
+            }
+        }
+
+        material.key = key;
+        return textureCount == 1;
     }
 
-    vsg::StateGroup* getHeadAsStateGroup()
+    vsg::ref_ptr<vsg::BindDescriptorSet> createAtlasDescriptorSet(const vsg::BindDescriptorSet* original, vsg::ref_ptr<vsg::Data> page, const ImageData& image)
     {
-        if (_nodeStack.size() == 0) return nullptr;
-        return dynamic_cast<vsg::StateGroup*>(_nodeStack[_nodeStack.size() - 1].get());
+        auto contents = _descriptorSetContents.find(original);
+        if (contents == _descriptorSetContents.end()) return vsg::ref_ptr<vsg::BindDescriptorSet>();
+
+        vsg::ref_ptr<vsg::Sampler> sampler = shareSampler(vkSamplerCreateInfoForTextureData(image));
+
+        vsg::Descriptors descriptors = contents->second.descriptors;
+        for (auto& descriptor : descriptors)
+        {
+            auto texture = _atlasableTextures.find(descriptor.get());
+            if (texture == _atlasableTextures.end()) continue;
+
+            vsg::SamplerImages samplerImages;
+            samplerImages.push_back({sampler, page});
+            auto role = _textureRoles.find(descriptor.get());
+            descriptor = vsg::DescriptorImage::create(samplerImages, texture->second.binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+            if (role != _textureRoles.end()) _textureRoles[descriptor.get()] = role->second;
+        }
+
+        const vsg::ref_ptr<vsg::GraphicsPipeline>& pipeline = contents->second.pipeline;
+        auto descriptorSet = vsg::DescriptorSet::create(pipeline->getPipelineLayout()->getDescriptorSetLayouts(), descriptors);
+        auto bindDescriptorSet = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getPipelineLayout(), 0, descriptorSet);
+        _descriptorSetContents[bindDescriptorSet.get()] = {descriptors, pipeline};
+        return bindDescriptorSet;
     }
 
-    vsg::Commands* getHeadAsCommandsNode()
+    //
+    // Texture memory
+    //
+
+    std::string textureDataName(const vsg::Data* data) const
     {
-        if (_nodeStack.size() == 0) return nullptr;
-        return dynamic_cast<vsg::Commands*>(_nodeStack[_nodeStack.size() - 1].get());
+        auto id = _textureDataIds.find(data);
+        return id != _textureDataIds.end() ? "Texture " + std::to_string(id->second) : "Texture data";
     }
 
-    bool addChildToHead(vsg::ref_ptr<vsg::Node> node)
+    static std::string textureDimensions(const vsg::Data* data)
     {
-        vsg::Group* headGroup = getHeadAsGroup();
-        if (headGroup != nullptr)
+        const vsg::Data::Layout& layout = data->getLayout();
+        uint32_t width = data->width() * std::max<uint32_t>(layout.blockWidth, 1);
+        uint32_t height = data->height() * std::max<uint32_t>(layout.blockHeight, 1);
+        return std::to_string(width) + "x" + std::to_string(height);
+    }
+
+    void trimTextureMipmaps(MipTrimVisitor& mipTrim)
+    {
+        mipTrim.trim();
+
+        for (auto& trimmed : mipTrim.trimmed())
         {
-            headGroup->addChild(node);
-            return true;
+            DebugLog("GraphBuilder Report: " + textureDataName(trimmed.original) + " is never sampled finer than mipmap " + std::to_string(trimmed.levels) + ", trimmed to " +
+                     textureDimensions(trimmed.data.get()) + " removing " + std::to_string(trimmed.bytesRemoved) + " bytes.");
         }
-        return false;
+        DebugLog("GraphBuilder Report: Trimmed mipmaps from " + std::to_string(mipTrim.trimmed().size()) + " of " + std::to_string(mipTrim.measuredCount()) + " measured textures, removing " +
+                 std::to_string(mipTrim.bytesRemoved()) + " bytes.");
     }
 
-    bool addLODChildToHead(vsg::ref_ptr<vsg::Node> node, LODChildData lodData)
+    // downsample the least important textures drawn by the graph until they all fit in the budget, see planTextureBudget
+    void applyTextureBudget(const MipTrimVisitor& mipTrim)
     {
-        vsg::LOD* headLOD = getHeadAsLOD();
-        if (headLOD != nullptr)
+        std::vector<BudgetTexture> textures;
+        std::vector<std::pair<const vsg::Data*, const MipTrimVisitor::Usage*>> usages;
+        for (auto& entry : mipTrim.usages())
         {
-            vsg::LOD::LODChild lod;
-            lod.child = node;
-            lod.minimumScreenHeightRatio = lodData.minimumScreenHeightRatio;
-            headLOD->addChild(lod);
+            BudgetTexture texture;
+            texture.data = entry.second.data;
+            texture.area = entry.second.area;
+            texture.draws = entry.second.draws;
+
+            // data shared by textures with different roles ranks by the most important
+            texture.role = TEXTURE_ROLE_MASK;
+            for (const vsg::DescriptorImage* image : entry.second.textures)
+            {
+                auto role = _textureRoles.find(image);
+                TextureRole imageRole = role != _textureRoles.end() ? role->second : TEXTURE_ROLE_COLOR;
+                if (textureRoleWeight(imageRole) > textureRoleWeight(texture.role)) texture.role = imageRole;
+            }
+
+            textures.push_back(texture);
+            usages.push_back({entry.first, &entry.second});
+        }
+
+        TextureBudgetOptions options;
+        options.budget = static_cast<size_t>(_settings.textureMemoryBudget) * 1024 * 1024;
+        planTextureBudget(textures, options);
+
+        size_t bytesBefore = 0;
+        size_t bytesAfter = 0;
+        size_t downsampled = 0;
+        size_t roleBytes[3] = {0, 0, 0};
+        for (size_t i = 0; i < textures.size(); ++i)
+        {
+            BudgetTexture& texture = textures[i];
+            if (texture.levels > 0)
+            {
+                vsg::ref_ptr<vsg::Data> data = downsampleTexture(texture.data.get(), texture.levels, texture.role);
+                if (data.valid())
+                {
+                    for (vsg::DescriptorImage* image : usages[i].second->textures)
+                    {
+                        for (auto& samplerImage : image->getSamplerImages())
+                        {
+                            if (samplerImage.second.get() == texture.data.get()) samplerImage.second = data;
+                        }
+                    }
+
+                    DebugLog("GraphBuilder Report: " + textureDataName(usages[i].first) + " downsampled by " + std::to_string(texture.levels) + " levels to " + textureDimensions(data.get()) +
+                             " with importance " + std::to_string(texture.importance) + ", " + std::to_string(texture.bytesBefore) + " -> " + std::to_string(texture.bytesAfter) + " bytes.");
+                    downsampled++;
+                }
+                else
+                {
+                    texture.bytesAfter = texture.bytesBefore;
+                }
+            }
+
+            bytesBefore += texture.bytesBefore;
+            bytesAfter += texture.bytesAfter;
+            roleBytes[texture.role] += texture.bytesAfter;
+        }
+
+        DebugLog("GraphBuilder Report: Texture memory " + std::to_string(bytesBefore) + " -> " + std::to_string(bytesAfter) + " bytes against a budget of " + std::to_string(options.budget) +
+                 ", downsampled " + std::to_string(downsampled) + " of " + std::to_string(textures.size()) + " textures. Color " + std::to_string(roleBytes[TEXTURE_ROLE_COLOR]) + ", normal " +
+                 std::to_string(roleBytes[TEXTURE_ROLE_NORMAL]) + ", mask " + std::to_string(roleBytes[TEXTURE_ROLE_MASK]) + " bytes.");
+        if (bytesAfter > options.budget)
+        {
+            DebugLog("GraphBuilder Warning: Textures still use " + std::to_string(bytesAfter) + " bytes, over the budget of " + std::to_string(options.budget) +
+                     ". Texture arrays, compressed textures without mipmaps and textures at the minimum size can't be downsampled.");
+        }
+    }
+
+    //
+    // Helpers
+    //
+
+    vsg::Node* getHead()
+    {
+        if (_nodeStack.size() == 0) return nullptr;
+        return _nodeStack[_nodeStack.size() - 1];
+    }
+
+    vsg::Group* getHeadAsGroup()
+    {
+        if (_nodeStack.size() == 0) return nullptr;
+        return dynamic_cast<vsg::Group*>(_nodeStack[_nodeStack.size() - 1].get());
+    }
+
+    vsg::LOD* getHeadAsLOD()
+    {
+        if (_nodeStack.size() == 0) return nullptr;
+        return dynamic_cast<vsg::LOD*>(_nodeStack[_nodeStack.size() - 1].get());
+    }
+
+    vsg::StateGroup* getHeadAsStateGroup()
+    {
+        if (_nodeStack.size() == 0) return nullptr;
+        return dynamic_cast<vsg::StateGroup*>(_nodeStack[_nodeStack.size() - 1].get());
+    }
+
+    vsg::Commands* getHeadAsCommandsNode()
+    {
+        if (_nodeStack.size() == 0) return nullptr;
+        return dynamic_cast<vsg::Commands*>(_nodeStack[_nodeStack.size() - 1].get());
+    }
+
+    bool addChildToHead(vsg::ref_ptr<vsg::Node> node)
+    {
+        vsg::Group* headGroup = getHeadAsGroup();
+        if (headGroup != nullptr)
+        {
+            headGroup->addChild(node);
+            return true;
+        }
+        return false;
+    }
+
+    bool addLODChildToHead(vsg::ref_ptr<vsg::Node> node, LODChildData lodData)
+    {
+        vsg::LOD* headLOD = getHeadAsLOD();
+        if (headLOD != nullptr)
+        {
+            vsg::LOD::LODChild lod;
+            lod.child = node;
+            lod.minimumScreenHeightRatio = lodData.minimumScreenHeightRatio;
+            headLOD->addChild(lod);
             return true;
         }
         return false;
@@ -1020,27 +2030,273 @@ public:
 
     void popNodeFromStack()
     {
+        if (!_pendingBounds.empty() && _pendingBounds.back().depth + 1 == _nodeStack.size()) resolvePendingBound();
         _nodeStack.pop_back();
     }
 
     void writeFile(std::string fileName)
     {
+        // atlas first so instancing and batching see the draws that now share a descriptor set
+        if (_settings.textureAtlasMaxSize > 0)
+        {
+            TextureAtlasOptions options;
+            options.maxTextureSize = static_cast<uint32_t>(_settings.textureAtlasMaxSize);
+            options.pageSize = static_cast<uint32_t>(std::max(_settings.textureAtlasPageSize, _settings.textureAtlasMaxSize * 2));
+            options.generateMipmaps = _settings.generateMipmaps != 0;
+            options.quality = static_cast<CompressionQuality>(std::min(_settings.textureCompression, static_cast<int>(COMPRESSION_HIGH)));
+
+            TextureAtlasVisitor textureAtlas(options, _vertexArrayAttributes);
+            textureAtlas.collect(*_root, [this](const vsg::BindDescriptorSet* bind, TextureAtlasVisitor::Material& material) { return getAtlasMaterial(bind, material); });
+            textureAtlas.atlas([this](const vsg::BindDescriptorSet* original, vsg::ref_ptr<vsg::Data> page, const ImageData& sampler) { return createAtlasDescriptorSet(original, page, sampler); });
+
+            for (auto& atlased : textureAtlas.atlasedArrays())
+            {
+                auto itr = _vertexArrayAttributes.find(atlased.second);
+                if (itr != _vertexArrayAttributes.end()) _vertexArrayAttributes[atlased.first] = itr->second;
+            }
+
+            DebugLog("GraphBuilder Report: Atlased " + std::to_string(textureAtlas.atlasedCount()) + " textures of " + std::to_string(textureAtlas.textureBytes()) + " bytes into " +
+                     std::to_string(textureAtlas.pageCount()) + " pages of " + std::to_string(textureAtlas.pageBytes()) + " bytes.");
+        }
+
+        // instance repeated meshes before batching so the batches are left with the meshes that only appear a few times
+        if (_settings.instancingMinCount > 0)
+        {
+            InstancingVisitor instancing(static_cast<size_t>(_settings.instancingMinCount));
+            instancing.collect(*_root);
+            instancing.instance([this](const vsg::BindGraphicsPipeline* pipeline, uint32_t instanceAttribute) { return createInstancedGraphicsPipeline(pipeline, instanceAttribute); });
+
+            for (auto& instanceArray : instancing.instanceArrays())
+            {
+                _vertexArrayAttributes[instanceArray.first] = instanceArray.second;
+            }
+
+            DebugLog("GraphBuilder Report: Instanced " + std::to_string(instancing.instancedMeshCount()) + " meshes replacing " + std::to_string(instancing.instanceCount()) + " draws.");
+        }
+
+        // batch before anything else works on the meshes, batches are treated like any other mesh from then on
+        if (_settings.staticBatching)
+        {
+            StaticBatchVisitor staticBatch(_settings.staticBatchCellSize, _vertexArrayAttributes);
+            staticBatch.collect(*_root);
+            staticBatch.batch();
+
+            for (auto& batched : staticBatch.batchedArrays())
+            {
+                auto itr = _vertexArrayAttributes.find(batched.second);
+                if (itr != _vertexArrayAttributes.end()) _vertexArrayAttributes[batched.first] = itr->second;
+            }
+
+            DebugLog("GraphBuilder Report: Static batching merged " + std::to_string(staticBatch.batchedCount()) + " of " + std::to_string(staticBatch.collectedCount()) + " draws into " +
+                     std::to_string(staticBatch.batchCount()) + " batches.");
+        }
+
+        // generate lods first so the simplified index buffers are optimized along with the originals
+        if (_settings.lodLevelCount > 0)
+        {
+            std::vector<LODGenerateVisitor::Level> levels;
+            for (int i = 0; i < _settings.lodLevelCount; i++)
+            {
+                levels.push_back({_settings.lodTriangleRatios[i], _settings.lodScreenHeightRatios[i + 1]});
+            }
+
+            LODGenerateVisitor lodGenerate(_settings.lodScreenHeightRatios[0], levels, _settings.lodMaxError);
+            _root->accept(lodGenerate);
+            lodGenerate.generate();
+
+            std::string triangles;
+            for (auto count : lodGenerate.levelTriangles())
+            {
+                triangles += (triangles.empty() ? "" : ", ") + std::to_string(count);
+            }
+            DebugLog("GraphBuilder Report: Generated LODs for " + std::to_string(lodGenerate.lodCount()) + " meshes, triangles per level " + triangles + ".");
+        }
+
+        // flatten once instancing and batching have left their emptied groups behind, baked meshes are then optimized like the rest
+        if (_settings.flattenGraph)
+        {
+            // traversal time is measured by the flatten benchmark rather than on every export
+            size_t nodesBefore = countNodes(_root.get());
+
+            FlattenVisitor flatten(static_cast<size_t>(std::max(_settings.bakeTransformsMaxVertices, 0)), _vertexArrayAttributes);
+            flatten.flatten(*_root);
+
+            for (auto& baked : flatten.bakedArrays())
+            {
+                _vertexArrayAttributes[baked.first] = baked.second;
+            }
+
+            size_t nodesAfter = countNodes(_root.get());
+            DebugLog("GraphBuilder Report: Flattened graph from " + std::to_string(nodesBefore) + " to " + std::to_string(nodesAfter) + " nodes, removed " +
+                     std::to_string(flatten.removedGroupCount()) + " groups, merged " + std::to_string(flatten.mergedTransformCount()) + " transforms, baked " +
+                     std::to_string(flatten.bakedMeshCount()) + " meshes.");
+        }
+
+        // sort before building the cull hierarchy so the hierarchy is built within each hoisted StateGroup and adds no binds
+        if (_settings.sortState)
+        {
+            BindCounts before = countBinds(_root.get());
+
+            StateSortVisitor stateSort;
+            stateSort.sort(*_root);
+
+            BindCounts after = countBinds(_root.get());
+            DebugLog("GraphBuilder Report: State sorting hoisted " + std::to_string(stateSort.hoistedCount()) + " shared binds, pipeline binds " + std::to_string(before.pipelines) + " -> " +
+                     std::to_string(after.pipelines) + ", descriptor set binds " + std::to_string(before.descriptorSets) + " -> " + std::to_string(after.descriptorSets) + ".");
+        }
+
+        // regroup once the graph is flat so the hierarchy sees as many siblings as possible
+        if (_settings.cullHierarchy > 0)
+        {
+            CullHierarchyVisitor::Split split = _settings.cullHierarchy > 1 ? CullHierarchyVisitor::SAH_SPLIT : CullHierarchyVisitor::MEDIAN_SPLIT;
+            CullHierarchyVisitor cullHierarchy(split, static_cast<size_t>(std::max(_settings.cullHierarchyMinChildren, 0)));
+            _root->accept(cullHierarchy);
+
+            DebugLog("GraphBuilder Report: Regrouped " + std::to_string(cullHierarchy.regroupedCount()) + " groups below " + std::to_string(cullHierarchy.cullGroupCount()) +
+                     " CullGroups, expected bound tests per frame " + std::to_string(cullHierarchy.testsBefore()) + " -> " + std::to_string(cullHierarchy.testsAfter()) + ", " +
+                     std::to_string(cullHierarchy.blendedCount()) + " groups drawing blended left in order.");
+        }
+
+        if (_settings.optimizeMeshes > 0)
+        {
+            MeshOptimizeVisitor meshOptimize(_settings.optimizeMeshes > 1);
+            _root->accept(meshOptimize);
+            meshOptimize.optimize();
+
+            // arrays rebuilt in fetch order hold the same attribute as the ones they replace
+            for (auto& remapped : meshOptimize.remappedArrays())
+            {
+                auto itr = _vertexArrayAttributes.find(remapped.second);
+                if (itr != _vertexArrayAttributes.end()) _vertexArrayAttributes[remapped.first] = itr->second;
+            }
+
+            const VertexCacheStats& before = meshOptimize.statsBefore();
+            const VertexCacheStats& after = meshOptimize.statsAfter();
+            DebugLog("GraphBuilder Report: Optimized " + std::to_string(meshOptimize.optimizedCount()) + " index ranges for the vertex cache, ACMR " + std::to_string(before.acmr()) + " -> " +
+                     std::to_string(after.acmr()) + ", ATVR " + std::to_string(before.atvr()) + " -> " + std::to_string(after.atvr()) + ", " +
+                     std::to_string(meshOptimize.remappedCount()) + " meshes reordered for vertex fetch.");
+            if (meshOptimize.overlappingCount() > 0)
+            {
+                DebugLog("GraphBuilder Report: Left " + std::to_string(meshOptimize.overlappingCount()) + " index ranges unoptimized as they partly overlap other ranges of the same buffer.");
+            }
+        }
+
+        // measure texel density and how much each texture is drawn once the meshes are final but while the vertex arrays are still floats
+        bool trimming = _settings.trimMipmapsScreenHeight > 0;
+        if (trimming || _settings.textureMemoryBudget > 0)
+        {
+            MipTrimOptions options;
+            if (trimming)
+            {
+                options.screenHeight = static_cast<uint32_t>(_settings.trimMipmapsScreenHeight);
+                options.fieldOfView = _settings.trimMipmapsFieldOfView;
+                options.nearDistance = _settings.trimMipmapsNearDistance;
+            }
+
+            MipTrimVisitor mipTrim(options, _vertexArrayAttributes);
+            mipTrim.collect(
+                *_root,
+                [this](const vsg::BindDescriptorSet* bind, vsg::Descriptors& descriptors) {
+                    auto contents = _descriptorSetContents.find(bind);
+                    if (contents == _descriptorSetContents.end()) return false;
+                    descriptors = contents->second.descriptors;
+                    return true;
+                },
+                [this](const vsg::DescriptorImage* texture) { return _uvSampledTextures.count(texture) > 0; });
+            if (trimming) trimTextureMipmaps(mipTrim);
+            if (_settings.textureMemoryBudget > 0) applyTextureBudget(mipTrim);
+        }
+
+        // convert vertex arrays to the encodings and layout the pipelines expect, this has to be the final change to the vertex data
+        VertexFormatVisitor vertexFormat(_settings.interleaveVertexArrays != 0, _vertexArrayAttributes, _pipelineVertexEncodings);
+        _root->accept(vertexFormat);
+        if (_settings.interleaveVertexArrays)
+        {
+            DebugLog("GraphBuilder Report: Interleaved " + std::to_string(vertexFormat.convertedCount()) + " vertex array sets.");
+        }
+        if (vertexFormat.encodedCount() > 0)
+        {
+            DebugLog("GraphBuilder Report: Encoded " + std::to_string(vertexFormat.encodedCount()) + " vertex arrays from " + std::to_string(vertexFormat.sourceBytes()) + " to " +
+                     std::to_string(vertexFormat.encodedBytes()) + " bytes.");
+        }
+
         LeafDataCollection leafDataCollection;
         _root->accept(leafDataCollection);
         _root->setObject("batch", leafDataCollection.objects);
 
+        DebugLog("GraphBuilder Report: Shared " + std::to_string(_dataCache.duplicateCount()) + " duplicate data objects across " + std::to_string(_dataCache.uniqueCount()) +
+                 " unique, saving " + std::to_string(_dataCache.bytesSaved()) + " bytes.");
+        if (_samplerStats.requested > 0)
+        {
+            size_t uniqueSamplers = 0;
+            for (auto& samplers : _samplerCache) uniqueSamplers += samplers.second.size();
+            DebugLog("GraphBuilder Report: Shared " + std::to_string(uniqueSamplers) + " unique samplers across " + std::to_string(_samplerStats.requested) + " sampler images.");
+        }
+        if (_boundsStats.resolved + _boundsStats.unresolved > 0)
+        {
+            double ratio = _boundsStats.boxRadius > 0.0 ? _boundsStats.radius / _boundsStats.boxRadius : 1.0;
+            DebugLog("GraphBuilder Report: Computed " + std::to_string(_boundsStats.resolved) + " node bounds from " + std::to_string(_boundsStats.meshes) +
+                     " mesh bounding spheres, radius " + std::to_string(ratio) + " of the box spheres, " + std::to_string(_boundsStats.unresolved) + " nodes had no meshes to bound.");
+        }
+
+        if (_mipmapStats.textures > 0)
+        {
+            DebugLog("GraphBuilder Report: Generated mipmaps for " + std::to_string(_mipmapStats.textures) + " textures, adding " + std::to_string(_mipmapStats.bytes) + " bytes.");
+        }
+
+        if (_textureDataCache.exactCount() + _textureDataCache.nearCount() > 0)
+        {
+            DebugLog("GraphBuilder Report: Reused " + std::to_string(_textureDataCache.exactCount()) + " exact and " + std::to_string(_textureDataCache.nearCount()) + " near duplicate textures across " +
+                     std::to_string(_textureDataCache.uniqueCount()) + " unique, saving " + std::to_string(_textureDataCache.bytesSaved()) + " bytes.");
+        }
+
+        if (_textureArrayStats.arrays > 0)
+        {
+            DebugLog("GraphBuilder Report: Packed " + std::to_string(_textureArrayStats.layers) + " textures into " + std::to_string(_textureArrayStats.arrays) + " texture arrays of " +
+                     std::to_string(_textureArrayStats.bytes) + " bytes, " + std::to_string(_textureArrayStats.converted) + " layers were resized or converted to fit.");
+        }
+
+        if (_channelPackStats.textures > 0)
+        {
+            DebugLog("GraphBuilder Report: Channel packed " + std::to_string(_channelPackStats.images) + " single channel textures into " + std::to_string(_channelPackStats.textures) + " textures, " +
+                     std::to_string(_channelPackStats.converted) + " were resized or decoded from srgb to fit.");
+        }
+
+        if (_analysisStats.bytesBefore > 0)
+        {
+            DebugLog("GraphBuilder Report: Texture analysis shrank " + std::to_string(_analysisStats.constant) + " constant textures to a texel, " + std::to_string(_analysisStats.singleComponent) +
+                     " to their first component and dropped the alpha of " + std::to_string(_analysisStats.opaque) + ", from " + std::to_string(_analysisStats.bytesBefore) + " to " +
+                     std::to_string(_analysisStats.bytesAfter) + " bytes before mipmapping and compression.");
+        }
+
+        if (_compressionStats.textures > 0)
+        {
+            DebugLog("GraphBuilder Report: Block compressed " + std::to_string(_compressionStats.textures) + " textures from " + std::to_string(_compressionStats.bytesBefore) +
+                     " to " + std::to_string(_compressionStats.bytesAfter) + " bytes.");
+        }
+
+        DebugLog("GraphBuilder Report: Narrowed " + std::to_string(_indexStats.narrowed) + " index arrays to 16 bit, split " + std::to_string(_indexStats.split) +
+                 " large meshes into " + std::to_string(_indexStats.splitDraws) + " 16 bit draws.");
+
         vsg::vsgReaderWriter io;
         io.writeFile(_root.get(), fileName);
     }
 
+    // detach any data we wrapped from the caller so vsg doesn't try to delete it
     void releaseObjects()
     {
-        LeafDataRelease releaser;
-        _root->accept(releaser);
+        for (auto& data : _externalData)
+        {
+            data->dataRelease();
+        }
+        _externalData.clear();
     }
 
     vsg::ref_ptr<vsg::MatrixTransform> _root;
 
+    ExportSettingsData _settings;
+    VertexEncodings _vertexEncodings;
+
     // the stack of nodes added, last node is the current head being acted on
     std::vector<vsg::ref_ptr<vsg::Node>> _nodeStack;
 
@@ -1061,20 +2317,154 @@ public:
     std::map<int, vsg::ref_ptr<vsg::Command>> _bindVertexBuffersCache;
     std::map<int, vsg::ref_ptr<vsg::Command>> _bindIndexBufferCache;
     std::map<int, vsg::ref_ptr<vsg::Command>> _drawIndexedCache;
-    std::map<int, vsg::ref_ptr<vsg::VertexIndexDraw>> _vertexIndexDrawCache;
+    std::map<int, vsg::ref_ptr<vsg::Node>> _vertexIndexDrawCache;
+
+    // map of mesh ids to the arrays allocated for the caller to fill
+    std::map<int, NativeMeshArrays> _nativeMeshArrays;
+
+    // shares data with identical contents
+    DataCache _dataCache;
+
+    // the attribute each vertex array holds and the encodings each pipeline expects, used by VertexFormatVisitor
+    VertexArrayAttributes _vertexArrayAttributes;
+    PipelineVertexEncodings _pipelineVertexEncodings;
+
+    struct IndexStats
+    {
+        size_t narrowed = 0;
+        size_t split = 0;
+        size_t splitDraws = 0;
+    };
+    IndexStats _indexStats;
+
+    // bounding spheres of mesh positions by mesh id, computed on first use
+    struct MeshBound
+    {
+        vsg::ref_ptr<vsg::vec3Array> positions;
+        vsg::sphere bound;
+    };
+    std::map<int, MeshBound> _meshBounds;
+
+    // nodes on the stack waiting for the meshes below them to give them a bound
+    struct PendingBound
+    {
+        vsg::ref_ptr<vsg::Node> node;
+        size_t depth; // index in the node stack
+        vsg::sphere bound;
+    };
+    std::vector<PendingBound> _pendingBounds;
+
+    struct BoundsStats
+    {
+        size_t meshes = 0;
+        double radius = 0.0;
+        double boxRadius = 0.0; // what the spheres around the mesh boxes would have been
+        size_t resolved = 0;
+        size_t unresolved = 0;
+    };
+    BoundsStats _boundsStats;
+
+    struct MipmapStats
+    {
+        size_t textures = 0;
+        size_t bytes = 0; // size of the generated levels
+    };
+    MipmapStats _mipmapStats;
+
+    struct CompressionStats
+    {
+        size_t textures = 0;
+        size_t bytesBefore = 0;
+        size_t bytesAfter = 0;
+    };
+    CompressionStats _compressionStats;
+
+    struct TextureArrayStats
+    {
+        size_t arrays = 0;
+        size_t layers = 0;
+        size_t converted = 0; // layers resized or converted to match the rest of their array
+        size_t bytes = 0; // uncompressed size of the packed arrays
+    };
+    TextureArrayStats _textureArrayStats;
+
+    struct ChannelPackStats
+    {
+        size_t textures = 0;
+        size_t images = 0; // single channel images packed into the textures
+        size_t converted = 0; // images resized or decoded from srgb to fit
+    };
+    ChannelPackStats _channelPackStats;
+
+    struct AnalysisStats
+    {
+        size_t constant = 0;
+        size_t singleComponent = 0;
+        size_t opaque = 0;
+        size_t bytesBefore = 0; // pixels as passed in, before mipmapping and compression
+        size_t bytesAfter = 0;
+    };
+    AnalysisStats _analysisStats;
+
+    struct SamplerStats
+    {
+        size_t requested = 0; // samplers asked for by sampler images, shared or not
+    };
+    SamplerStats _samplerStats;
+
+    // data wrapping memory owned by the caller, released rather than deleted once the export is done
+    vsg::DataList _externalData;
+
+    // pixels of channel packed and reduced images, standing in for the callers pixels until the export is done
+    vsg::DataList _generatedPixels;
 
     // map of shader modules to the masks used to create them
     std::map<std::string, vsg::ref_ptr<vsg::ShaderModule>> _shaderModulesCache;
 
     // map of descriptorimage to the ImageData ID they represent
     std::map<int, vsg::ref_ptr<vsg::DescriptorImage>> _textureCache;
+    TextureCache _textureDataCache;
+
+    // the first ImageData ID each texture's data was created for, to name it in reports
+    std::map<const vsg::Data*, int> _textureDataIds;
+
+    // textures sampled at the first uvs as they are
+    std::set<const vsg::DescriptorImage*> _uvSampledTextures;
+
+    // what textures other than color maps are sampled for, see planTextureBudget
+    std::map<const vsg::DescriptorImage*, TextureRole> _textureRoles;
 
     // map of bind descriptor set to IDs
     std::map<std::string, vsg::ref_ptr<vsg::BindDescriptorSet>> _bindDescriptorSetCache;
 
+    // uniform buffer descriptors by binding and values
+    std::map<std::pair<int, std::vector<const vsg::Data*>>, vsg::ref_ptr<vsg::Descriptor>> _descriptorBufferCache;
+
+    // samplers by the hash of their create info, see shareSampler
+    std::map<uint64_t, std::vector<vsg::ref_ptr<vsg::Sampler>>> _samplerCache;
+
+    // what each descriptor set was built from and the single image textures in them, used to build atlased variants
+    struct DescriptorSetContents
+    {
+        vsg::Descriptors descriptors;
+        vsg::ref_ptr<vsg::GraphicsPipeline> pipeline;
+    };
+    std::map<const vsg::BindDescriptorSet*, DescriptorSetContents> _descriptorSetContents;
+
+    struct AtlasableTexture
+    {
+        ImageData image; // sampler state, the pixels aren't kept
+        uint32_t binding;
+    };
+    std::map<const vsg::Descriptor*, AtlasableTexture> _atlasableTextures;
+
     // map of bind graphics piplelines to IDs
     std::map<std::string, vsg::ref_ptr<vsg::BindGraphicsPipeline>> _bindGraphicsPipelineCache;
 
+    // how each pipeline was built and the instanced variants made from them
+    std::map<const vsg::BindGraphicsPipeline*, PipelineRecipe> _pipelineRecipes;
+    std::map<std::pair<const vsg::BindGraphicsPipeline*, uint32_t>, vsg::ref_ptr<vsg::BindGraphicsPipeline>> _instancedGraphicsPipelineCache;
+
     std::string _saveFileName;
 };
 
@@ -1098,6 +2488,16 @@ void unity2vsg_EndExport(const char* saveFileName)
     _builder = nullptr;
 }
 
+void unity2vsg_SetExportSettings(unity2vsg::ExportSettingsData settings)
+{
+    if (!_builder.valid())
+    {
+        DebugLog("GraphBuilder Error: No export in progress.");
+        return;
+    }
+    _builder->setExportSettings(settings);
+}
+
 void unity2vsg_AddGroupNode()
 {
     _builder->addGroup();
@@ -1152,6 +2552,41 @@ void unity2vsg_AddStringValue(const char* name, const char* value)
     _builder->addStringValue(std::string(name), std::string(value));
 }
 
+void* unity2vsg_AllocateVertexArray(int meshId, uint32_t attribute, uint32_t count)
+{
+    if (!_builder.valid())
+    {
+        DebugLog("GraphBuilder Error: No export in progress.");
+        return nullptr;
+    }
+    return _builder->allocateVertexArray(meshId, attribute, count);
+}
+
+void* unity2vsg_AllocateIndexArray(int meshId, uint32_t count, uint32_t use32BitIndicies)
+{
+    if (!_builder.valid())
+    {
+        DebugLog("GraphBuilder Error: No export in progress.");
+        return nullptr;
+    }
+    return _builder->allocateIndexArray(meshId, count, use32BitIndicies == 1);
+}
+
+int unity2vsg_CommitMeshArrays(int meshId)
+{
+    if (!_builder.valid())
+    {
+        DebugLog("GraphBuilder Error: No export in progress.");
+        return 0;
+    }
+    return _builder->commitMeshArrays(meshId) ? 1 : 0;
+}
+
+void unity2vsg_CopyToNativeArray(void* dst, const void* src, uint32_t bytes)
+{
+    if (dst && src && bytes > 0) std::memcpy(dst, src, bytes);
+}
+
 //
 // Commands
 //
@@ -1215,6 +2650,252 @@ void unity2vsg_EndNode()
     _builder->popNodeFromStack();
 }
 
+//
+// Command streams
+//
+
+class GraphBuilderCommandHandler : public CommandStreamHandler
+{
+public:
+    GraphBuilderCommandHandler(GraphBuilder* builder) :
+        _builder(builder) {}
+
+    void addGroupNode() override { _builder->addGroup(); }
+    void addTransformNode(const TransformData& transform) override { _builder->addMatrixTrasform(transform); }
+    void addCullNode(const CullData& cull) override { _builder->addCullNode(cull); }
+    void addCullGroupNode(const CullData& cull) override { _builder->addCullGroup(cull); }
+    void addLODNode(const CullData& cull) override { _builder->addLOD(cull); }
+    void addLODChild(const LODChildData& lodChildData) override { _builder->addLODChild(lodChildData); }
+    void addStateGroupNode() override { _builder->addStateGroup(); }
+    void addCommandsNode() override { _builder->addCommands(); }
+    void addVertexIndexDrawNode(const VertexIndexDrawData& mesh) override { _builder->addVertexIndexDraw(mesh); }
+
+    void addStringValue(const char* name, const char* value) override { _builder->addStringValue(std::string(name), std::string(value)); }
+
+    bool addBindGraphicsPipelineCommand(const PipelineData& pipeline, uint32_t addToStateGroup) override { return _builder->addBindGraphicsPipelineCommand(pipeline, addToStateGroup == 1); }
+    void addBindIndexBufferCommand(const IndexBufferData& data) override { _builder->addBindIndexBufferCommand(data); }
+    void addBindVertexBuffersCommand(const VertexBuffersData& data) override { _builder->addBindVertexBuffersCommand(data); }
+    void addDrawIndexedCommand(const DrawIndexedData& data) override { _builder->addDrawIndexedCommand(data); }
+    void createBindDescriptorSetCommand(uint32_t addToStateGroup) override { _builder->createBindDescriptorSetCommand(addToStateGroup == 1); }
+
+    void addDescriptorImage(const DescriptorImageData& texture) override { _builder->addTexture(texture); }
+    void addDescriptorBufferFloat(const DescriptorFloatUniformData& data) override { _builder->addDescriptorBuffer(data); }
+    void addDescriptorBufferFloatArray(const DescriptorFloatArrayUniformData& data) override { _builder->addDescriptorBuffer(data); }
+    void addDescriptorBufferVector(const DescriptorVectorUniformData& data) override { _builder->addDescriptorBuffer(data); }
+    void addDescriptorBufferVectorArray(const DescriptorVectorArrayUniformData& data) override { _builder->addDescriptorBuffer(data); }
+
+    void endNode() override { _builder->popNodeFromStack(); }
+
+protected:
+    GraphBuilder* _builder;
+};
+
+int submitCommandBuffer(GraphBuilder* builder, const void* ops, size_t bytes)
+{
+    GraphBuilderCommandHandler handler(builder);
+    if (!readCommandStream(ops, bytes, handler))
+    {
+        DebugLog("GraphBuilder Error: Malformed or unsupported command stream.");
+        return 0;
+    }
+    return 1;
+}
+
+int unity2vsg_SubmitCommandBuffer(const void* ops, size_t bytes)
+{
+    if (!_builder.valid())
+    {
+        DebugLog("GraphBuilder Error: No export in progress.");
+        return 0;
+    }
+    return submitCommandBuffer(_builder.get(), ops, bytes);
+}
+
+//
+// Export contexts
+//
+
+struct unity2vsg::ExportContext
+{
+    vsg::ref_ptr<GraphBuilder> builder;
+};
+
+GraphBuilder* getContextBuilder(ExportContext* context)
+{
+    if (context == nullptr || !context->builder.valid())
+    {
+        DebugLog("GraphBuilder Error: Invalid or finished export context.");
+        return nullptr;
+    }
+    return context->builder.get();
+}
+
+ExportContext* unity2vsg_CreateExportContext()
+{
+    ExportContext* context = new ExportContext();
+    context->builder = vsg::ref_ptr<GraphBuilder>(new GraphBuilder());
+    return context;
+}
+
+void unity2vsg_DestroyExportContext(ExportContext* context)
+{
+    if (context == nullptr) return;
+    if (context->builder.valid()) context->builder->releaseObjects();
+    delete context;
+}
+
+int unity2vsg_Context_EndExport(ExportContext* context, const char* saveFileName)
+{
+    GraphBuilder* builder = getContextBuilder(context);
+    if (builder == nullptr) return 0;
+
+    builder->writeFile(std::string(saveFileName));
+
+    builder->releaseObjects();
+    context->builder = nullptr;
+    return 1;
+}
+
+void unity2vsg_Context_SetExportSettings(ExportContext* context, unity2vsg::ExportSettingsData settings)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->setExportSettings(settings);
+}
+
+void unity2vsg_Context_AddGroupNode(ExportContext* context)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addGroup();
+}
+
+void unity2vsg_Context_AddTransformNode(ExportContext* context, unity2vsg::TransformData transform)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addMatrixTrasform(transform);
+}
+
+void unity2vsg_Context_AddCullNode(ExportContext* context, unity2vsg::CullData cull)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addCullNode(cull);
+}
+
+void unity2vsg_Context_AddCullGroupNode(ExportContext* context, unity2vsg::CullData cull)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addCullGroup(cull);
+}
+
+void unity2vsg_Context_AddLODNode(ExportContext* context, unity2vsg::CullData cull)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addLOD(cull);
+}
+
+void unity2vsg_Context_AddLODChild(ExportContext* context, unity2vsg::LODChildData lodChildData)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addLODChild(lodChildData);
+}
+
+void unity2vsg_Context_AddStateGroupNode(ExportContext* context)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addStateGroup();
+}
+
+void unity2vsg_Context_AddCommandsNode(ExportContext* context)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addCommands();
+}
+
+void unity2vsg_Context_AddVertexIndexDrawNode(ExportContext* context, unity2vsg::VertexIndexDrawData mesh)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addVertexIndexDraw(mesh);
+}
+
+void unity2vsg_Context_AddStringValue(ExportContext* context, const char* name, const char* value)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addStringValue(std::string(name), std::string(value));
+}
+
+void* unity2vsg_Context_AllocateVertexArray(ExportContext* context, int meshId, uint32_t attribute, uint32_t count)
+{
+    GraphBuilder* builder = getContextBuilder(context);
+    if (builder == nullptr) return nullptr;
+    return builder->allocateVertexArray(meshId, attribute, count);
+}
+
+void* unity2vsg_Context_AllocateIndexArray(ExportContext* context, int meshId, uint32_t count, uint32_t use32BitIndicies)
+{
+    GraphBuilder* builder = getContextBuilder(context);
+    if (builder == nullptr) return nullptr;
+    return builder->allocateIndexArray(meshId, count, use32BitIndicies == 1);
+}
+
+int unity2vsg_Context_CommitMeshArrays(ExportContext* context, int meshId)
+{
+    GraphBuilder* builder = getContextBuilder(context);
+    if (builder == nullptr) return 0;
+    return builder->commitMeshArrays(meshId) ? 1 : 0;
+}
+
+int unity2vsg_Context_AddBindGraphicsPipelineCommand(ExportContext* context, unity2vsg::PipelineData pipeline, uint32_t addToStateGroup)
+{
+    GraphBuilder* builder = getContextBuilder(context);
+    if (builder == nullptr) return 0;
+    return builder->addBindGraphicsPipelineCommand(pipeline, addToStateGroup == 1) ? 1 : 0;
+}
+
+void unity2vsg_Context_AddBindIndexBufferCommand(ExportContext* context, unity2vsg::IndexBufferData data)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addBindIndexBufferCommand(data);
+}
+
+void unity2vsg_Context_AddBindVertexBuffersCommand(ExportContext* context, unity2vsg::VertexBuffersData data)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addBindVertexBuffersCommand(data);
+}
+
+void unity2vsg_Context_AddDrawIndexedCommand(ExportContext* context, unity2vsg::DrawIndexedData data)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addDrawIndexedCommand(data);
+}
+
+void unity2vsg_Context_CreateBindDescriptorSetCommand(ExportContext* context, uint32_t addToStateGroup)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->createBindDescriptorSetCommand(addToStateGroup == 1);
+}
+
+void unity2vsg_Context_AddDescriptorImage(ExportContext* context, unity2vsg::DescriptorImageData texture)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addTexture(texture);
+}
+
+void unity2vsg_Context_AddDescriptorBufferFloat(ExportContext* context, unity2vsg::DescriptorFloatUniformData data)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addDescriptorBuffer(data);
+}
+
+void unity2vsg_Context_AddDescriptorBufferFloatArray(ExportContext* context, unity2vsg::DescriptorFloatArrayUniformData data)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addDescriptorBuffer(data);
+}
+
+void unity2vsg_Context_AddDescriptorBufferVector(ExportContext* context, unity2vsg::DescriptorVectorUniformData data)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addDescriptorBuffer(data);
+}
+
+void unity2vsg_Context_AddDescriptorBufferVectorArray(ExportContext* context, unity2vsg::DescriptorVectorArrayUniformData data)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->addDescriptorBuffer(data);
+}
+
+void unity2vsg_Context_EndNode(ExportContext* context)
+{
+    if (GraphBuilder* builder = getContextBuilder(context)) builder->popNodeFromStack();
+}
+
+int unity2vsg_Context_SubmitCommandBuffer(ExportContext* context, const void* ops, size_t bytes)
+{
+    GraphBuilder* builder = getContextBuilder(context);
+    if (builder == nullptr) return 0;
+    return submitCommandBuffer(builder, ops, bytes);
+}
+
 void unity2vsg_LaunchViewer(const char* filename, uint32_t useCamData, unity2vsg::CameraData camdata)
 {
     try
@@ -0,0 +1,40 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#pragma once
+
+#include <cstdio>
+
+// minimal checks for the unit tests, each failure is printed and counted and main returns the count through CHECK_RESULT
+
+namespace unity2vsg_tests
+{
+    inline int& failureCount()
+    {
+        static int count = 0;
+        return count;
+    }
+} // namespace unity2vsg_tests
+
+#define CHECK(expr)                                                                      \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(expr))                                                                     \
+        {                                                                                \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            ++unity2vsg_tests::failureCount();                                           \
+        }                                                                                \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) CHECK(((a) > (b) ? (a) - (b) : (b) - (a)) <= (tolerance))
+
+#define CHECK_RESULT() (unity2vsg_tests::failureCount() == 0 ? 0 : 1)
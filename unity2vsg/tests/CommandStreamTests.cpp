@@ -0,0 +1,189 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "Check.h"
+
+#include <unity2vsg/CommandStream.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // counts the ops dispatched, none should be for a stream that's rejected
+    class CountingHandler : public CommandStreamHandler
+    {
+    public:
+        size_t count = 0;
+        std::vector<std::string> strings;
+
+        void addGroupNode() override { count++; }
+        void addTransformNode(const TransformData&) override { count++; }
+        void addCullNode(const CullData&) override { count++; }
+        void addCullGroupNode(const CullData&) override { count++; }
+        void addLODNode(const CullData&) override { count++; }
+        void addLODChild(const LODChildData&) override { count++; }
+        void addStateGroupNode() override { count++; }
+        void addCommandsNode() override { count++; }
+        void addVertexIndexDrawNode(const VertexIndexDrawData&) override { count++; }
+        void addStringValue(const char* name, const char* value) override
+        {
+            count++;
+            strings.push_back(name);
+            strings.push_back(value);
+        }
+        bool addBindGraphicsPipelineCommand(const PipelineData&, uint32_t) override
+        {
+            count++;
+            return true;
+        }
+        void addBindIndexBufferCommand(const IndexBufferData&) override { count++; }
+        void addBindVertexBuffersCommand(const VertexBuffersData&) override { count++; }
+        void addDrawIndexedCommand(const DrawIndexedData&) override { count++; }
+        void createBindDescriptorSetCommand(uint32_t) override { count++; }
+        void addDescriptorImage(const DescriptorImageData&) override { count++; }
+        void addDescriptorBufferFloat(const DescriptorFloatUniformData&) override { count++; }
+        void addDescriptorBufferFloatArray(const DescriptorFloatArrayUniformData&) override { count++; }
+        void addDescriptorBufferVector(const DescriptorVectorUniformData&) override { count++; }
+        void addDescriptorBufferVectorArray(const DescriptorVectorArrayUniformData&) override { count++; }
+        void endNode() override { count++; }
+    };
+
+    std::vector<uint8_t> copyStream(const CommandStreamEncoder& encoder)
+    {
+        const uint8_t* data = static_cast<const uint8_t*>(encoder.data());
+        return std::vector<uint8_t>(data, data + encoder.size());
+    }
+
+    // offset of the first payload byte of the first op
+    const size_t FIRST_PAYLOAD = sizeof(CommandStreamHeader) + sizeof(CommandStreamOp);
+
+    void testStrings()
+    {
+        CommandStreamEncoder encoder;
+        encoder.addGroupNode();
+        encoder.addStringValue("name", "value");
+        encoder.endNode();
+
+        CountingHandler handler;
+        CHECK(readCommandStream(encoder.data(), encoder.size(), handler));
+        CHECK(handler.count == 3);
+        CHECK(handler.strings.size() == 2 && handler.strings[0] == "name" && handler.strings[1] == "value");
+
+        // the length of "name" is the first value of the second op's payload
+        size_t nameLength = FIRST_PAYLOAD + sizeof(CommandStreamOp);
+        for (uint32_t length : {0xffffffffu, 0xfffffffeu, 0x7fffffffu, 64u})
+        {
+            std::vector<uint8_t> stream = copyStream(encoder);
+            std::memcpy(stream.data() + nameLength, &length, sizeof(length));
+
+            CountingHandler rejected;
+            CHECK(!readCommandStream(stream.data(), stream.size(), rejected));
+            CHECK(rejected.count == 0);
+        }
+
+        // a string whose terminator isn't where its length says
+        std::vector<uint8_t> stream = copyStream(encoder);
+        uint32_t shorter = 3;
+        std::memcpy(stream.data() + nameLength, &shorter, sizeof(shorter));
+        CountingHandler rejected;
+        CHECK(!readCommandStream(stream.data(), stream.size(), rejected));
+        CHECK(rejected.count == 0);
+    }
+
+    // the count before a list of stages or images, found by encoding the op again with one more element
+    size_t countOffset(const std::vector<uint8_t>& one, const std::vector<uint8_t>& two)
+    {
+        size_t offset = FIRST_PAYLOAD;
+        while (offset + sizeof(uint32_t) <= one.size() && one[offset] == two[offset]) offset += sizeof(uint32_t);
+        return offset;
+    }
+
+    void testCounts()
+    {
+        ShaderStageData stageData[2] = {};
+        stageData[0].customDefines = stageData[1].customDefines = "";
+        stageData[0].source = stageData[1].source = "";
+
+        PipelineData pipeline = {};
+        pipeline.id = "pipeline";
+        pipeline.shaderStages.stages = stageData;
+
+        ImageData imageData[2] = {};
+        DescriptorImageData texture = {};
+        texture.images = imageData;
+
+        std::vector<uint8_t> streams[2][2];
+        for (int count = 1; count <= 2; ++count)
+        {
+            CommandStreamEncoder encoder;
+            pipeline.shaderStages.stagesCount = count;
+            encoder.addBindGraphicsPipelineCommand(pipeline, 1);
+            streams[0][count - 1] = copyStream(encoder);
+
+            encoder.clear();
+            texture.descriptorCount = count;
+            encoder.addDescriptorImage(texture);
+            streams[1][count - 1] = copyStream(encoder);
+        }
+
+        for (auto& stream : streams)
+        {
+            CountingHandler handler;
+            CHECK(readCommandStream(stream[0].data(), stream[0].size(), handler));
+            CHECK(handler.count == 1);
+
+            // a count that could only fit if elements took a byte each is rejected before anything is allocated for it
+            size_t offset = countOffset(stream[0], stream[1]);
+            uint32_t encodedCount = 0;
+            CHECK(offset < stream[0].size());
+            if (offset < stream[0].size()) std::memcpy(&encodedCount, stream[0].data() + offset, sizeof(encodedCount));
+            CHECK(encodedCount == 1);
+            for (uint32_t count : {2u, static_cast<uint32_t>(stream[0].size()), 0xffffffffu})
+            {
+                std::vector<uint8_t> hostile = stream[0];
+                std::memcpy(hostile.data() + offset, &count, sizeof(count));
+
+                CountingHandler rejected;
+                CHECK(!readCommandStream(hostile.data(), hostile.size(), rejected));
+                CHECK(rejected.count == 0);
+            }
+        }
+    }
+
+    void testTruncated()
+    {
+        CommandStreamEncoder encoder;
+        encoder.addGroupNode();
+        encoder.addStringValue("a longer name", "a longer value");
+        encoder.endNode();
+
+        // every cut through the stream is rejected without anything being dispatched
+        for (size_t size = 0; size < encoder.size(); ++size)
+        {
+            CountingHandler handler;
+            CHECK(!readCommandStream(encoder.data(), size, handler));
+            CHECK(handler.count == 0);
+        }
+    }
+} // namespace
+
+int main()
+{
+    testStrings();
+    testCounts();
+    testTruncated();
+    return CHECK_RESULT();
+}
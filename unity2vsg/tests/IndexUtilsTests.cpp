@@ -0,0 +1,182 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "Check.h"
+
+#include <unity2vsg/IndexUtils.h>
+
+#include <vsg/core/Array.h>
+
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // long enough to run through the SIMD loops with a scalar tail left over
+    std::vector<int32_t> sequence(size_t count, int32_t first, int32_t step)
+    {
+        std::vector<int32_t> indices(count);
+        for (size_t i = 0; i < count; ++i) indices[i] = first + static_cast<int32_t>(i) * step;
+        return indices;
+    }
+
+    void testConvert16()
+    {
+        std::vector<int32_t> src = sequence(37, 3, 1771); // 3 ... 63759
+        std::vector<uint16_t> dst(src.size());
+        CHECK(convertIndices(src.data(), src.size(), dst.data()) == 63759u);
+        for (size_t i = 0; i < src.size(); ++i) CHECK(dst[i] == static_cast<uint16_t>(src[i]));
+
+        // rebased indices above 65535 still fit once the base is subtracted
+        std::vector<int32_t> high = sequence(21, 100000, 3000);
+        std::vector<uint16_t> rebased(high.size());
+        CHECK(convertIndices(high.data(), high.size(), rebased.data(), 100000) == 160000u);
+        for (size_t i = 0; i < high.size(); ++i) CHECK(rebased[i] == i * 3000);
+
+        // the largest index is found wherever it is
+        for (size_t position : {0u, 7u, 8u, 15u, 16u, 36u})
+        {
+            std::vector<int32_t> peak(37, 1);
+            peak[position] = 65535;
+            CHECK(convertIndices(peak.data(), peak.size(), dst.data()) == 65535u);
+            CHECK(dst[position] == 65535);
+            CHECK(dst[position == 0 ? 1 : 0] == 1);
+        }
+
+        CHECK(convertIndices(src.data(), 0, dst.data()) == 0u);
+
+        // negative and huge indices don't fit, the largest returned says so wherever they are
+        for (size_t position : {0u, 7u, 8u, 15u, 16u, 36u})
+        {
+            for (int32_t bad : {-1, INT32_MIN, 65536})
+            {
+                std::vector<int32_t> indices(37, 1);
+                indices[position] = bad;
+                CHECK(convertIndices(indices.data(), indices.size(), dst.data()) == static_cast<uint32_t>(bad));
+            }
+        }
+    }
+
+    void testConvert32()
+    {
+        std::vector<int32_t> src = sequence(19, 70000, 12345);
+        std::vector<uint32_t> dst(src.size());
+        CHECK(convertIndices(src.data(), src.size(), dst.data()) == 70000u + 18u * 12345u);
+        for (size_t i = 0; i < src.size(); ++i) CHECK(dst[i] == static_cast<uint32_t>(src[i]));
+
+        for (size_t position : {0u, 3u, 4u, 7u, 8u, 18u})
+        {
+            std::vector<int32_t> indices = src;
+            indices[position] = INT32_MIN;
+            CHECK(convertIndices(indices.data(), indices.size(), dst.data()) == 0x80000000u);
+            CHECK(dst[position] == 0x80000000u);
+
+            indices[position] = -1;
+            CHECK(convertIndices(indices.data(), indices.size(), dst.data()) == 0xffffffffu);
+        }
+    }
+
+    void testIndexRange()
+    {
+        uint32_t minIndex, maxIndex;
+        indexRange(nullptr, 0, minIndex, maxIndex);
+        CHECK(minIndex == UINT32_MAX);
+        CHECK(maxIndex == 0u);
+
+        std::vector<int32_t> src = {9, 4, 12, 7, 300000, 5, 6, 8, 10, 11, 2, 13, 14};
+        indexRange(src.data(), src.size(), minIndex, maxIndex);
+        CHECK(minIndex == 2u);
+        CHECK(maxIndex == 300000u);
+
+        // fewer than one SIMD register
+        indexRange(src.data(), 3, minIndex, maxIndex);
+        CHECK(minIndex == 4u);
+        CHECK(maxIndex == 12u);
+
+        // indices of 2^31 and up, as a caller writing uint32 indices could give, are the largest wherever they are
+        for (size_t position : {0u, 3u, 7u, 8u, 12u, 16u})
+        {
+            std::vector<int32_t> high = sequence(17, 0, 1);
+            high[position] = INT32_MIN;
+            indexRange(high.data(), high.size(), minIndex, maxIndex);
+            CHECK(minIndex == (position == 0 ? 1u : 0u));
+            CHECK(maxIndex == 0x80000000u);
+
+            high[position] = -1;
+            indexRange(high.data(), high.size(), minIndex, maxIndex);
+            CHECK(maxIndex == 0xffffffffu);
+        }
+
+        std::vector<int32_t> allHigh(17, INT32_MIN);
+        allHigh[9] = INT32_MAX;
+        indexRange(allHigh.data(), allHigh.size(), minIndex, maxIndex);
+        CHECK(minIndex == 0x7fffffffu);
+        CHECK(maxIndex == 0x80000000u);
+    }
+
+    void testSplit()
+    {
+        // two triangles near 0 and two near 200000, they can't share a range
+        std::vector<int32_t> src = {0, 1, 2, 2, 1, 65535, 200000, 200001, 200002, 200003, 200002, 200001};
+        IndexRanges ranges = split16BitIndexRanges(src.data(), src.size());
+        CHECK(ranges.size() == 2);
+        if (ranges.size() == 2)
+        {
+            CHECK(ranges[0].firstIndex == 0u);
+            CHECK(ranges[0].indexCount == 6u);
+            CHECK(ranges[0].vertexOffset == 0);
+            CHECK(ranges[1].firstIndex == 6u);
+            CHECK(ranges[1].indexCount == 6u);
+            CHECK(ranges[1].vertexOffset == 200000);
+        }
+
+        // one triangle spanning more than 16 bits can't be split
+        std::vector<int32_t> wide = {0, 1, 65536};
+        CHECK(split16BitIndexRanges(wide.data(), wide.size()).empty());
+
+        // a few large ranges are worth it, many small ones aren't
+        CHECK(isSplitProfitable({{0, 3 * 4096, 0}, {3 * 4096, 3 * 4096, 70000}}, 2 * 3 * 4096));
+        CHECK(!isSplitProfitable({{0, 3, 0}, {3, 3, 70000}}, 6));
+        CHECK(!isSplitProfitable(IndexRanges(), 0));
+    }
+
+    void testReadWrite()
+    {
+        vsg::ref_ptr<vsg::ushortArray> shorts(new vsg::ushortArray(6));
+        writeIndices(shorts.get(), 2, {7, 8, 9});
+        CHECK(shorts->at(1) == 0 && shorts->at(2) == 7 && shorts->at(4) == 9 && shorts->at(5) == 0);
+
+        std::vector<uint32_t> indices;
+        CHECK(readIndices(shorts.get(), 2, 3, indices));
+        CHECK(indices == std::vector<uint32_t>({7, 8, 9}));
+        CHECK(!readIndices(shorts.get(), 4, 3, indices));
+
+        vsg::ref_ptr<vsg::uintArray> ints(new vsg::uintArray(4));
+        writeIndices(ints.get(), 1, {100000, 5});
+        CHECK(readIndices(ints.get(), 0, 4, indices));
+        CHECK(indices == std::vector<uint32_t>({0, 100000, 5, 0}));
+
+        vsg::ref_ptr<vsg::ubyteArray> bytes(new vsg::ubyteArray(4));
+        CHECK(!readIndices(bytes.get(), 0, 4, indices));
+    }
+} // namespace
+
+int main()
+{
+    testConvert16();
+    testConvert32();
+    testIndexRange();
+    testSplit();
+    testReadWrite();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,169 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "Check.h"
+
+#include <unity2vsg/IndexUtils.h>
+#include <unity2vsg/MeshOptimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    const uint32_t GRID_SIZE = 8;
+
+    // a grid of quads with the triangles in a scrambled order so there is something to optimize
+    vsg::ref_ptr<vsg::ushortArray> createGridIndices()
+    {
+        std::vector<uint16_t> triangles;
+        for (uint32_t y = 0; y < GRID_SIZE; ++y)
+        {
+            for (uint32_t x = 0; x < GRID_SIZE; ++x)
+            {
+                uint16_t i = static_cast<uint16_t>(y * (GRID_SIZE + 1) + x);
+                uint16_t quad[6] = {i, static_cast<uint16_t>(i + 1), static_cast<uint16_t>(i + GRID_SIZE + 1),
+                                    static_cast<uint16_t>(i + 1), static_cast<uint16_t>(i + GRID_SIZE + 2), static_cast<uint16_t>(i + GRID_SIZE + 1)};
+                triangles.insert(triangles.end(), quad, quad + 6);
+            }
+        }
+
+        size_t triangleCount = triangles.size() / 3;
+        vsg::ref_ptr<vsg::ushortArray> indices(new vsg::ushortArray(triangles.size()));
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            size_t source = (t * 37) % triangleCount;
+            for (size_t c = 0; c < 3; ++c) indices->at(t * 3 + c) = triangles[source * 3 + c];
+        }
+        return indices;
+    }
+
+    vsg::ref_ptr<vsg::vec3Array> createGridPositions(float height)
+    {
+        vsg::ref_ptr<vsg::vec3Array> positions(new vsg::vec3Array((GRID_SIZE + 1) * (GRID_SIZE + 1)));
+        for (uint32_t y = 0; y <= GRID_SIZE; ++y)
+        {
+            for (uint32_t x = 0; x <= GRID_SIZE; ++x)
+            {
+                positions->at(y * (GRID_SIZE + 1) + x) = vsg::vec3(static_cast<float>(x), static_cast<float>(y), height * static_cast<float>(x * y));
+            }
+        }
+        return positions;
+    }
+
+    // the triangles of a range with each rotated to start at its smallest index, sorted so reordering doesn't matter
+    std::vector<std::array<uint32_t, 3>> triangleSet(const vsg::Data* data, uint32_t firstIndex, uint32_t indexCount)
+    {
+        std::vector<uint32_t> indices;
+        readIndices(data, firstIndex, indexCount, indices);
+
+        std::vector<std::array<uint32_t, 3>> triangles;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            std::array<uint32_t, 3> triangle = {indices[i], indices[i + 1], indices[i + 2]};
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    vsg::ref_ptr<vsg::VertexIndexDraw> createDraw(vsg::ref_ptr<vsg::Data> indices, vsg::ref_ptr<vsg::Data> positions)
+    {
+        auto vid = vsg::VertexIndexDraw::create();
+        vid->_arrays = {positions};
+        vid->_indices = indices;
+        vid->indexCount = static_cast<uint32_t>(indices->valueCount());
+        vid->instanceCount = 1;
+        return vid;
+    }
+
+    void testOptimize()
+    {
+        auto indices = createGridIndices();
+        auto triangles = triangleSet(indices.get(), 0, static_cast<uint32_t>(indices->valueCount()));
+
+        auto root = vsg::Group::create();
+        root->addChild(createDraw(indices, createGridPositions(0.0f)));
+
+        MeshOptimizeVisitor optimizer(true);
+        root->accept(optimizer);
+        optimizer.optimize();
+
+        CHECK(optimizer.optimizedCount() == 1);
+        CHECK(optimizer.statsAfter().acmr() < optimizer.statsBefore().acmr());
+        CHECK(triangleSet(indices.get(), 0, static_cast<uint32_t>(indices->valueCount())) == triangles);
+    }
+
+    void testSharedIndices()
+    {
+        // two meshes with the same topology share one index buffer, it's ordered once and stays valid for both
+        auto indices = createGridIndices();
+        auto triangles = triangleSet(indices.get(), 0, static_cast<uint32_t>(indices->valueCount()));
+
+        auto first = createDraw(indices, createGridPositions(1.0f));
+        auto second = createDraw(indices, createGridPositions(-1.0f));
+        auto root = vsg::Group::create();
+        root->addChild(first);
+        root->addChild(second);
+
+        MeshOptimizeVisitor optimizer(true);
+        root->accept(optimizer);
+        optimizer.optimize();
+
+        CHECK(optimizer.optimizedCount() == 1);
+        CHECK(first->_indices.get() == second->_indices.get());
+        CHECK(triangleSet(indices.get(), 0, static_cast<uint32_t>(indices->valueCount())) == triangles);
+    }
+
+    void testOverlappingRanges()
+    {
+        auto indices = createGridIndices();
+        uint32_t indexCount = static_cast<uint32_t>(indices->valueCount());
+        uint32_t third = indexCount / 9 * 3;
+
+        std::vector<uint32_t> original;
+        readIndices(indices.get(), 0, indexCount, original);
+        auto lastTriangles = triangleSet(indices.get(), 3 * third, indexCount - 3 * third);
+
+        auto commands = vsg::Commands::create();
+        commands->addChild(vsg::BindVertexBuffers::create(0, vsg::DataList{createGridPositions(0.0f)}));
+        commands->addChild(vsg::BindIndexBuffer::create(indices));
+        commands->addChild(vsg::DrawIndexed::create(2 * third, 1, 0, 0, 0));
+        commands->addChild(vsg::DrawIndexed::create(2 * third, 1, third, 0, 0));
+        commands->addChild(vsg::DrawIndexed::create(indexCount - 3 * third, 1, 3 * third, 0, 0));
+
+        MeshOptimizeVisitor optimizer(true);
+        commands->accept(optimizer);
+        optimizer.optimize();
+
+        // the first two ranges overlap so are left as they were, the last is separate and still optimized
+        CHECK(optimizer.overlappingCount() == 2);
+        CHECK(optimizer.optimizedCount() == 1);
+
+        std::vector<uint32_t> result;
+        readIndices(indices.get(), 0, indexCount, result);
+        CHECK(std::equal(original.begin(), original.begin() + 3 * third, result.begin()));
+        CHECK(triangleSet(indices.get(), 3 * third, indexCount - 3 * third) == lastTriangles);
+    }
+} // namespace
+
+int main()
+{
+    testOptimize();
+    testSharedIndices();
+    testOverlappingRanges();
+    return CHECK_RESULT();
+}
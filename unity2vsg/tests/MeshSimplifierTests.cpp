@@ -0,0 +1,208 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "Check.h"
+
+#include <unity2vsg/MeshSimplifier.h>
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    struct TestMesh
+    {
+        std::vector<vsg::vec3> positions;
+        std::vector<uint32_t> indices;
+    };
+
+    // a size x size grid of quads in the z = 0 plane starting at x offset, facing +z
+    void addGrid(TestMesh& mesh, uint32_t size, float offset)
+    {
+        uint32_t first = static_cast<uint32_t>(mesh.positions.size());
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x) mesh.positions.push_back(vsg::vec3(offset + static_cast<float>(x), static_cast<float>(y), 0.0f));
+        }
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                uint32_t i = first + y * (size + 1) + x;
+                mesh.indices.insert(mesh.indices.end(), {i, i + 1, i + size + 1, i + 1, i + size + 2, i + size + 1});
+            }
+        }
+    }
+
+    TestMesh createSphere(uint32_t segments)
+    {
+        TestMesh mesh;
+        const float pi = 3.14159265f;
+        mesh.positions.push_back(vsg::vec3(0.0f, 0.0f, 1.0f));
+        for (uint32_t ring = 1; ring < segments; ++ring)
+        {
+            float theta = pi * static_cast<float>(ring) / static_cast<float>(segments);
+            for (uint32_t s = 0; s < segments * 2; ++s)
+            {
+                float phi = pi * static_cast<float>(s) / static_cast<float>(segments);
+                mesh.positions.push_back(vsg::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)));
+            }
+        }
+        mesh.positions.push_back(vsg::vec3(0.0f, 0.0f, -1.0f));
+
+        uint32_t ringSize = segments * 2;
+        uint32_t last = static_cast<uint32_t>(mesh.positions.size()) - 1;
+        auto at = [&](uint32_t ring, uint32_t s) { return 1 + (ring - 1) * ringSize + s % ringSize; };
+        for (uint32_t s = 0; s < ringSize; ++s)
+        {
+            mesh.indices.insert(mesh.indices.end(), {0, at(1, s), at(1, s + 1)});
+            for (uint32_t ring = 1; ring + 1 < segments; ++ring)
+            {
+                mesh.indices.insert(mesh.indices.end(), {at(ring, s), at(ring + 1, s), at(ring + 1, s + 1)});
+                mesh.indices.insert(mesh.indices.end(), {at(ring, s), at(ring + 1, s + 1), at(ring, s + 1)});
+            }
+            mesh.indices.insert(mesh.indices.end(), {last, at(segments - 1, s + 1), at(segments - 1, s)});
+        }
+        return mesh;
+    }
+
+    vsg::vec3 triangleNormal(const TestMesh& mesh, const std::vector<uint32_t>& indices, size_t i)
+    {
+        const vsg::vec3& a = mesh.positions[indices[i]];
+        const vsg::vec3& b = mesh.positions[indices[i + 1]];
+        const vsg::vec3& c = mesh.positions[indices[i + 2]];
+        vsg::vec3 u(b.x - a.x, b.y - a.y, b.z - a.z), v(c.x - a.x, c.y - a.y, c.z - a.z);
+        return vsg::vec3(u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x);
+    }
+
+    // every triangle in range and not degenerate
+    bool validTriangles(const TestMesh& mesh, const std::vector<uint32_t>& indices)
+    {
+        if (indices.size() % 3 != 0) return false;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            if (a >= mesh.positions.size() || b >= mesh.positions.size() || c >= mesh.positions.size()) return false;
+            if (a == b || b == c || c == a) return false;
+        }
+        return true;
+    }
+
+    float planarArea(const TestMesh& mesh, const std::vector<uint32_t>& indices)
+    {
+        float area = 0.0f;
+        for (size_t i = 0; i < indices.size(); i += 3) area += 0.5f * triangleNormal(mesh, indices, i).z;
+        return area;
+    }
+
+    void testPassThrough()
+    {
+        TestMesh mesh;
+        addGrid(mesh, 1, 0.0f);
+        mesh.indices.insert(mesh.indices.end(), {0, 0, 1, 0, 1, 99});
+
+        // degenerate and out of range triangles are dropped, nothing else happens when already under the target
+        float error = -1.0f;
+        std::vector<uint32_t> result = simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.positions.size(), 6, 1.0f, &error);
+        CHECK(result == std::vector<uint32_t>({0, 1, 2, 1, 3, 2}));
+        CHECK(error == 0.0f);
+    }
+
+    void testPlane()
+    {
+        TestMesh mesh;
+        addGrid(mesh, 16, 0.0f);
+
+        float error = -1.0f;
+        size_t target = mesh.indices.size() / 4;
+        std::vector<uint32_t> result = simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.positions.size(), target, 0.01f, &error);
+
+        // a plane simplifies without error, keeps its outline and nothing flips over
+        CHECK(result.size() <= target);
+        CHECK(validTriangles(mesh, result));
+        CHECK(error < 1e-3f);
+        CHECK_NEAR(planarArea(mesh, result), 256.0f, 1e-3f);
+        for (size_t i = 0; i < result.size(); i += 3) CHECK(triangleNormal(mesh, result, i).z > 0.0f);
+
+        std::set<uint32_t> used(result.begin(), result.end());
+        for (uint32_t corner : {0u, 16u, 17u * 16u, 17u * 17u - 1u}) CHECK(used.count(corner) == 1);
+    }
+
+    void testSeam()
+    {
+        // two grids meeting along x = 4 with their own vertices there, like a uv seam
+        TestMesh mesh;
+        addGrid(mesh, 4, 0.0f);
+        addGrid(mesh, 4, 4.0f);
+        uint32_t half = static_cast<uint32_t>(mesh.positions.size()) / 2;
+
+        size_t target = mesh.indices.size() / 3;
+        std::vector<uint32_t> result = simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.positions.size(), target, 0.01f);
+
+        CHECK(result.size() < mesh.indices.size());
+        CHECK(validTriangles(mesh, result));
+        CHECK_NEAR(planarArea(mesh, result), 32.0f, 1e-3f);
+
+        // triangles stay on their own side and both sides keep the same seam positions so no crack opens
+        std::set<float> left, right;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            bool side = result[i] >= half;
+            CHECK((result[i + 1] >= half) == side && (result[i + 2] >= half) == side);
+            for (size_t c = 0; c < 3; ++c)
+            {
+                const vsg::vec3& p = mesh.positions[result[i + c]];
+                if (p.x == 4.0f) (side ? right : left).insert(p.y);
+            }
+        }
+        CHECK(left == right);
+    }
+
+    void testErrorLimit()
+    {
+        TestMesh sphere = createSphere(16);
+
+        float coarseError = 0.0f;
+        std::vector<uint32_t> coarse = simplifyMesh(sphere.indices.data(), sphere.indices.size(), sphere.positions.data(), sphere.positions.size(), 0, 1.0f, &coarseError);
+
+        float fineError = 0.0f;
+        std::vector<uint32_t> fine = simplifyMesh(sphere.indices.data(), sphere.indices.size(), sphere.positions.data(), sphere.positions.size(), 0, 0.01f, &fineError);
+
+        // a curved surface costs error to simplify, so a tight limit stops well before a loose one
+        CHECK(validTriangles(sphere, coarse));
+        CHECK(validTriangles(sphere, fine));
+        CHECK(fine.size() < sphere.indices.size());
+        CHECK(fine.size() > coarse.size());
+        CHECK(fineError <= 0.01f);
+        CHECK(coarseError > fineError);
+
+        // nothing turns inside out
+        for (size_t i = 0; i < fine.size(); i += 3)
+        {
+            vsg::vec3 n = triangleNormal(sphere, fine, i);
+            const vsg::vec3& p = sphere.positions[fine[i]];
+            CHECK(n.x * p.x + n.y * p.y + n.z * p.z > 0.0f);
+        }
+    }
+} // namespace
+
+int main()
+{
+    testPassThrough();
+    testPlane();
+    testSeam();
+    testErrorLimit();
+    return CHECK_RESULT();
+}
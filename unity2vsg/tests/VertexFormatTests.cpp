@@ -0,0 +1,174 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include "Check.h"
+
+#include <unity2vsg/ShaderUtils.h>
+#include <unity2vsg/VertexFormat.h>
+
+#include <cstring>
+#include <limits>
+
+using namespace unity2vsg;
+
+namespace
+{
+    void testFloatToHalf()
+    {
+        CHECK(floatToHalf(0.0f) == 0x0000);
+        CHECK(floatToHalf(-0.0f) == 0x8000);
+        CHECK(floatToHalf(1.0f) == 0x3c00);
+        CHECK(floatToHalf(-2.0f) == 0xc000);
+        CHECK(floatToHalf(0.5f) == 0x3800);
+        CHECK(floatToHalf(1.0f / 3.0f) == 0x3555);
+        CHECK(floatToHalf(65504.0f) == 0x7bff);
+
+        // halfway cases round to even
+        CHECK(floatToHalf(1.0f + 1.0f / 2048.0f) == 0x3c00);
+        CHECK(floatToHalf(1.0f + 3.0f / 2048.0f) == 0x3c02);
+        CHECK(floatToHalf(65520.0f) == 0x7c00);
+
+        // smallest normal and subnormal
+        CHECK(floatToHalf(1.0f / 16384.0f) == 0x0400);
+        CHECK(floatToHalf(1.0f / 16777216.0f) == 0x0001);
+        CHECK(floatToHalf(-1.0f / 16777216.0f) == 0x8001);
+
+        CHECK(floatToHalf(std::numeric_limits<float>::infinity()) == 0x7c00);
+        CHECK(floatToHalf(-std::numeric_limits<float>::infinity()) == 0xfc00);
+        CHECK(floatToHalf(std::numeric_limits<float>::quiet_NaN()) == 0x7e00);
+    }
+
+    void testOctahedralEncode()
+    {
+        struct Case
+        {
+            float normal[3];
+            float expected[2];
+        };
+        const Case cases[] = {
+            {{0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+            {{1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+            {{0.0f, -1.0f, 0.0f}, {0.0f, -1.0f}},
+            {{0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}}, // the lower pole folds to a corner
+            {{-1.0f, -1.0f, -1.0f}, {-2.0f / 3.0f, -2.0f / 3.0f}},
+            {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f}}};
+
+        for (auto& c : cases)
+        {
+            float result[2];
+            octahedralEncode(c.normal, result);
+            CHECK_NEAR(result[0], c.expected[0], 1e-6f);
+            CHECK_NEAR(result[1], c.expected[1], 1e-6f);
+        }
+    }
+
+    template<class T>
+    const T* values(const vsg::ref_ptr<vsg::Data>& data)
+    {
+        return static_cast<const T*>(data->dataPointer());
+    }
+
+    void testEncodeVertexArray()
+    {
+        vsg::ref_ptr<vsg::vec3Array> normals(new vsg::vec3Array(2));
+        normals->at(0) = vsg::vec3(1.0f, 0.0f, -1.0f);
+        normals->at(1) = vsg::vec3(0.0f, 0.0f, -1.0f);
+
+        auto snorm = encodeVertexArray(normals, NORMAL, ENCODING_SNORM16);
+        CHECK(snorm->valueCount() == 2 && snorm->valueSize() == 8);
+        const int16_t* s = values<int16_t>(snorm);
+        CHECK(s[0] == 32767 && s[1] == 0 && s[2] == -32767 && s[3] == 0);
+
+        auto oct = encodeVertexArray(normals, NORMAL, ENCODING_OCTAHEDRAL16);
+        CHECK(oct->valueCount() == 2 && oct->valueSize() == 4);
+        const int16_t* o = values<int16_t>(oct);
+        CHECK(o[0] == 32767 && o[1] == 16384 && o[2] == 32767 && o[3] == 32767);
+
+        // tangents keep the bitangent sign in the sign of y
+        vsg::ref_ptr<vsg::vec4Array> tangents(new vsg::vec4Array(2));
+        tangents->at(0) = vsg::vec4(0.0f, 0.0f, 1.0f, -1.0f);
+        tangents->at(1) = vsg::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        auto octTangents = encodeVertexArray(tangents, TANGENT, ENCODING_OCTAHEDRAL16);
+        const int16_t* t = values<int16_t>(octTangents);
+        CHECK(t[0] == 0 && t[1] == -16384);
+        CHECK(t[2] == 0 && t[3] == 16384);
+
+        vsg::ref_ptr<vsg::vec2Array> uvs(new vsg::vec2Array(2));
+        uvs->at(0) = vsg::vec2(0.5f, 1.0f);
+        uvs->at(1) = vsg::vec2(-1.0f, 2.0f);
+
+        auto halfs = encodeVertexArray(uvs, TEXCOORD0, ENCODING_FLOAT16);
+        const uint16_t* h = values<uint16_t>(halfs);
+        CHECK(h[0] == 0x3800 && h[1] == 0x3c00 && h[2] == 0xbc00 && h[3] == 0x4000);
+
+        // unorm clamps to 0-1
+        auto unorms = encodeVertexArray(uvs, TEXCOORD1, ENCODING_UNORM16);
+        const uint16_t* u = values<uint16_t>(unorms);
+        CHECK(u[0] == 32768 && u[1] == 65535 && u[2] == 0 && u[3] == 65535);
+
+        vsg::ref_ptr<vsg::vec4Array> colors(new vsg::vec4Array(1));
+        colors->at(0) = vsg::vec4(1.0f, 0.5f, 0.0f, 2.0f);
+        auto bytes = encodeVertexArray(colors, COLOR, ENCODING_UNORM8);
+        const uint8_t* c = values<uint8_t>(bytes);
+        CHECK(c[0] == 255 && c[1] == 128 && c[2] == 0 && c[3] == 255);
+
+        // nothing to do, unsupported, or not float data all return the source array
+        CHECK(encodeVertexArray(normals, NORMAL, ENCODING_FLOAT32).get() == normals.get());
+        CHECK(encodeVertexArray(normals, VERTEX, ENCODING_SNORM16).get() == normals.get());
+        CHECK(encodeVertexArray(uvs, NORMAL, ENCODING_SNORM16).get() == uvs.get());
+        CHECK(encodeVertexArray(colors, COLOR, ENCODING_FLOAT16).get() == colors.get());
+    }
+
+    void testFormats()
+    {
+        CHECK(encodedFormat(NORMAL, ENCODING_SNORM16) == VK_FORMAT_R16G16B16A16_SNORM);
+        CHECK(encodedFormat(TANGENT, ENCODING_OCTAHEDRAL16) == VK_FORMAT_R16G16_SNORM);
+        CHECK(encodedFormat(TEXCOORD0, ENCODING_FLOAT16) == VK_FORMAT_R16G16_SFLOAT);
+        CHECK(encodedFormat(COLOR, ENCODING_UNORM8) == VK_FORMAT_R8G8B8A8_UNORM);
+
+        // unsupported encodings fall back to the float format of the attribute
+        CHECK(encodedFormat(NORMAL, ENCODING_UNORM8) == VK_FORMAT_R32G32B32_SFLOAT);
+        CHECK(encodedFormat(COLOR, ENCODING_SNORM16) == VK_FORMAT_R32G32B32A32_SFLOAT);
+        CHECK(encodedFormat(TEXCOORD1, ENCODING_FLOAT32) == VK_FORMAT_R32G32_SFLOAT);
+    }
+
+    void testInterleave()
+    {
+        vsg::ref_ptr<vsg::vec3Array> positions(new vsg::vec3Array(2));
+        positions->at(0) = vsg::vec3(1.0f, 2.0f, 3.0f);
+        positions->at(1) = vsg::vec3(4.0f, 5.0f, 6.0f);
+        vsg::ref_ptr<vsg::vec2Array> uvs(new vsg::vec2Array(2));
+        uvs->at(0) = vsg::vec2(7.0f, 8.0f);
+        uvs->at(1) = vsg::vec2(9.0f, 10.0f);
+
+        auto interleaved = interleaveArrays({positions, uvs});
+        CHECK(interleaved.valid() && interleaved->dataSize() == 2 * 5 * sizeof(float));
+        if (interleaved.valid())
+        {
+            float expected[] = {1.0f, 2.0f, 3.0f, 7.0f, 8.0f, 4.0f, 5.0f, 6.0f, 9.0f, 10.0f};
+            CHECK(std::memcmp(interleaved->dataPointer(), expected, sizeof(expected)) == 0);
+        }
+
+        vsg::ref_ptr<vsg::vec2Array> shorter(new vsg::vec2Array(1));
+        CHECK(!interleaveArrays({positions, shorter}).valid());
+    }
+} // namespace
+
+int main()
+{
+    testFloatToHalf();
+    testOctahedralEncode();
+    testEncodeVertexArray();
+    testFormats();
+    testInterleave();
+    return CHECK_RESULT();
+}
@@ -58,7 +58,42 @@ namespace vsgUnity.Editor
             if(!_hasInited)
             {
                 _settings.autoAddCullNodes = false;
+                _settings.nativeBounds = true;
                 _settings.zeroRootTransform = false;
+                _settings.interleaveVertexArrays = false;
+                _settings.normalEncoding = GraphBuilder.NormalEncoding.Float32;
+                _settings.tangentEncoding = GraphBuilder.NormalEncoding.Float32;
+                _settings.uvEncoding = GraphBuilder.UVEncoding.Float32;
+                _settings.colorEncoding = GraphBuilder.ColorEncoding.Float32;
+                _settings.optimizeMeshes = GraphBuilder.MeshOptimization.None;
+                _settings.lodLevelCount = 0;
+                _settings.lodTriangleRatios = new float[] { 0.5f, 0.25f, 0.125f, 0.0625f };
+                _settings.lodScreenHeightRatios = new float[] { 0.25f, 0.1f, 0.04f, 0.015f, 0.0f };
+                _settings.lodMaxError = 0.02f;
+                _settings.staticBatching = false;
+                _settings.staticBatchCellSize = 50.0f;
+                _settings.gpuInstancing = false;
+                _settings.instancingMinCount = 8;
+                _settings.flattenGraph = true;
+                _settings.bakeTransformsMaxVertices = 0;
+                _settings.sortState = false;
+                _settings.cullHierarchy = GraphBuilder.CullHierarchy.None;
+                _settings.cullHierarchyMinChildren = 16;
+                _settings.generateMipmaps = true;
+                _settings.textureCompression = GraphBuilder.TextureCompression.Normal;
+                _settings.textureAtlas = false;
+                _settings.textureAtlasMaxSize = 256;
+                _settings.textureAtlasPageSize = 2048;
+                _settings.nearDuplicateTextures = false;
+                _settings.textureDuplicateTolerance = 2.0f;
+                _settings.packChannelMaps = true;
+                _settings.analyzeTextures = true;
+                _settings.trimMipmaps = false;
+                _settings.trimScreenHeight = 1080;
+                _settings.trimFieldOfView = 60.0f;
+                _settings.trimNearDistance = 1.0f;
+                _settings.limitTextureMemory = false;
+                _settings.textureMemoryBudget = 256;
 
                 _settings.standardTerrainShaderMappingPath = PathForShaderAsset("standardTerrain-ShaderMapping");
 
@@ -159,7 +194,103 @@ namespace vsgUnity.Editor
             _binaryExport = EditorGUILayout.Toggle("Binary", _binaryExport);
 
             _settings.autoAddCullNodes = EditorGUILayout.Toggle("Add Cull Nodes", _settings.autoAddCullNodes);
+            _settings.nativeBounds = EditorGUILayout.Toggle("Compute Tight Bounds", _settings.nativeBounds);
             _settings.zeroRootTransform = EditorGUILayout.Toggle("Zero Root Transform", _settings.zeroRootTransform);
+            _settings.interleaveVertexArrays = EditorGUILayout.Toggle("Interleave Vertex Arrays", _settings.interleaveVertexArrays);
+            _settings.normalEncoding = (GraphBuilder.NormalEncoding)EditorGUILayout.EnumPopup("Normal Encoding", _settings.normalEncoding);
+            _settings.tangentEncoding = (GraphBuilder.NormalEncoding)EditorGUILayout.EnumPopup("Tangent Encoding", _settings.tangentEncoding);
+            _settings.uvEncoding = (GraphBuilder.UVEncoding)EditorGUILayout.EnumPopup("UV Encoding", _settings.uvEncoding);
+            _settings.colorEncoding = (GraphBuilder.ColorEncoding)EditorGUILayout.EnumPopup("Color Encoding", _settings.colorEncoding);
+            _settings.optimizeMeshes = (GraphBuilder.MeshOptimization)EditorGUILayout.EnumPopup("Optimize Meshes", _settings.optimizeMeshes);
+
+            _settings.lodLevelCount = EditorGUILayout.IntSlider("Generate LOD Levels", _settings.lodLevelCount, 0, GraphBuilder.MaxLODLevels);
+            if (_settings.lodLevelCount > 0)
+            {
+                EditorGUI.indentLevel++;
+                _settings.lodScreenHeightRatios[0] = EditorGUILayout.Slider("Full Detail Screen Height", _settings.lodScreenHeightRatios[0], 0.0f, 1.0f);
+                for (int i = 0; i < _settings.lodLevelCount; i++)
+                {
+                    _settings.lodTriangleRatios[i] = EditorGUILayout.Slider("Level " + (i + 1) + " Triangles", _settings.lodTriangleRatios[i], 0.01f, 1.0f);
+                    _settings.lodScreenHeightRatios[i + 1] = EditorGUILayout.Slider("Level " + (i + 1) + " Screen Height", _settings.lodScreenHeightRatios[i + 1], 0.0f, 1.0f);
+                }
+                _settings.lodMaxError = EditorGUILayout.Slider("Max Error", _settings.lodMaxError, 0.0f, 0.1f);
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.gpuInstancing = EditorGUILayout.Toggle("GPU Instancing", _settings.gpuInstancing);
+            if (_settings.gpuInstancing)
+            {
+                EditorGUI.indentLevel++;
+                _settings.instancingMinCount = Mathf.Max(2, EditorGUILayout.IntField("Min Instances", _settings.instancingMinCount));
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.staticBatching = EditorGUILayout.Toggle("Static Batching", _settings.staticBatching);
+            if (_settings.staticBatching)
+            {
+                EditorGUI.indentLevel++;
+                _settings.staticBatchCellSize = Mathf.Max(0.0f, EditorGUILayout.FloatField("Batch Cell Size", _settings.staticBatchCellSize));
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.flattenGraph = EditorGUILayout.Toggle("Flatten Graph", _settings.flattenGraph);
+            if (_settings.flattenGraph)
+            {
+                EditorGUI.indentLevel++;
+                _settings.bakeTransformsMaxVertices = Mathf.Max(0, EditorGUILayout.IntField("Bake Transforms Max Vertices", _settings.bakeTransformsMaxVertices));
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.sortState = EditorGUILayout.Toggle("Sort State", _settings.sortState);
+
+            _settings.cullHierarchy = (GraphBuilder.CullHierarchy)EditorGUILayout.EnumPopup("Cull Hierarchy", _settings.cullHierarchy);
+            if (_settings.cullHierarchy != GraphBuilder.CullHierarchy.None)
+            {
+                EditorGUI.indentLevel++;
+                _settings.cullHierarchyMinChildren = Mathf.Max(5, EditorGUILayout.IntField("Min Children", _settings.cullHierarchyMinChildren));
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.generateMipmaps = EditorGUILayout.Toggle("Generate Mipmaps", _settings.generateMipmaps);
+            _settings.textureCompression = (GraphBuilder.TextureCompression)EditorGUILayout.EnumPopup("Texture Compression", _settings.textureCompression);
+
+            _settings.textureAtlas = EditorGUILayout.Toggle("Texture Atlas", _settings.textureAtlas);
+            if (_settings.textureAtlas)
+            {
+                EditorGUI.indentLevel++;
+                _settings.textureAtlasMaxSize = Mathf.Clamp(EditorGUILayout.IntField("Max Texture Size", _settings.textureAtlasMaxSize), 16, 1024);
+                _settings.textureAtlasPageSize = Mathf.Clamp(EditorGUILayout.IntField("Page Size", _settings.textureAtlasPageSize), 256, 8192);
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.nearDuplicateTextures = EditorGUILayout.Toggle("Near Duplicate Textures", _settings.nearDuplicateTextures);
+            if (_settings.nearDuplicateTextures)
+            {
+                EditorGUI.indentLevel++;
+                _settings.textureDuplicateTolerance = EditorGUILayout.Slider("Tolerance", _settings.textureDuplicateTolerance, 0.5f, 16.0f);
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.packChannelMaps = EditorGUILayout.Toggle("Pack Channel Maps", _settings.packChannelMaps);
+            _settings.analyzeTextures = EditorGUILayout.Toggle("Analyze Textures", _settings.analyzeTextures);
+
+            _settings.trimMipmaps = EditorGUILayout.Toggle("Trim Mipmaps", _settings.trimMipmaps);
+            if (_settings.trimMipmaps)
+            {
+                EditorGUI.indentLevel++;
+                _settings.trimScreenHeight = Mathf.Clamp(EditorGUILayout.IntField("Screen Height", _settings.trimScreenHeight), 240, 8640);
+                _settings.trimFieldOfView = EditorGUILayout.Slider("Field Of View", _settings.trimFieldOfView, 10.0f, 120.0f);
+                _settings.trimNearDistance = Mathf.Max(0.0f, EditorGUILayout.FloatField("Near Distance", _settings.trimNearDistance));
+                EditorGUI.indentLevel--;
+            }
+
+            _settings.limitTextureMemory = EditorGUILayout.Toggle("Limit Texture Memory", _settings.limitTextureMemory);
+            if (_settings.limitTextureMemory)
+            {
+                EditorGUI.indentLevel++;
+                _settings.textureMemoryBudget = Mathf.Clamp(EditorGUILayout.IntField("Budget (MB)", _settings.textureMemoryBudget), 1, 16384);
+                EditorGUI.indentLevel--;
+            }
 
             EditorGUILayout.LabelField(_settings.standardTerrainShaderMappingPath);
 
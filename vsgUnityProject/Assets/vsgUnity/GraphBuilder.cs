@@ -10,7 +10,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+using System;
 using System.Collections.Generic;
+using System.Runtime.InteropServices;
 using UnityEngine;
 
 using vsgUnity.Native;
@@ -24,12 +26,92 @@ namespace vsgUnity
             GraphBuilderInterface.unity2vsg_LaunchViewer(fileName, useCamData ? 1 : 0, NativeUtils.CreateCameraData(camera));
         }
 
+        // values match unity2vsg VertexEncoding, each attribute only offers the encodings it supports
+        public enum NormalEncoding
+        {
+            Float32 = 0,
+            Snorm16 = 1,
+            Octahedral16 = 2
+        }
+
+        public enum UVEncoding
+        {
+            Float32 = 0,
+            Float16 = 3,
+            Unorm16 = 4
+        }
+
+        public enum ColorEncoding
+        {
+            Float32 = 0,
+            Unorm8 = 5
+        }
+
+        public const int MaxLODLevels = 4;
+
+        public enum MeshOptimization
+        {
+            None = 0,
+            VertexCache = 1,
+            VertexCacheAndOverdraw = 2
+        }
+
+        public enum CullHierarchy
+        {
+            None = 0,
+            MedianSplit = 1,
+            SurfaceAreaHeuristic = 2
+        }
+
+        public enum TextureCompression
+        {
+            None = 0,
+            Fast = 1,
+            Normal = 2,
+            High = 3 // slowest, color textures use BC7
+        }
+
         public struct ExportSettings
         {
             public bool autoAddCullNodes;
+            public bool nativeBounds; // cull and lod spheres are computed from the exported vertices rather than renderer bounds
             public bool zeroRootTransform;
             public string standardShaderMappingPath;
             public string standardTerrainShaderMappingPath;
+            public bool interleaveVertexArrays;
+            public NormalEncoding normalEncoding;
+            public NormalEncoding tangentEncoding;
+            public UVEncoding uvEncoding;
+            public ColorEncoding colorEncoding;
+            public MeshOptimization optimizeMeshes;
+            public int lodLevelCount;
+            public float[] lodTriangleRatios; // per level, fraction of the original triangles to keep
+            public float[] lodScreenHeightRatios; // full detail followed by each level
+            public float lodMaxError;
+            public bool staticBatching;
+            public float staticBatchCellSize; // batches only merge draws within the same cell of a grid this size
+            public bool gpuInstancing;
+            public int instancingMinCount; // meshes drawn fewer times than this are left to batching
+            public bool flattenGraph;
+            public int bakeTransformsMaxVertices; // meshes with up to this many vertices get their transform baked in, 0 off
+            public bool sortState; // draw order changes so blended materials may draw in a different order
+            public CullHierarchy cullHierarchy;
+            public int cullHierarchyMinChildren; // groups with fewer children are left as they are
+            public bool generateMipmaps; // textures exported with a single level get a full mip chain built natively
+            public TextureCompression textureCompression; // uncompressed 8 bit textures are block compressed on export
+            public bool textureAtlas; // small textures of materials that only differ by texture share atlas pages, their meshes uvs are rewritten
+            public int textureAtlasMaxSize; // textures wider or taller than this keep their own descriptor set
+            public int textureAtlasPageSize;
+            public bool nearDuplicateTextures; // textures that only differ by resaving or recompression share the first ones data, exact duplicates always do
+            public float textureDuplicateTolerance; // rms difference per 8 bit component
+            public bool packChannelMaps; // ambient, specular and opacity maps of a material share the components of one texture
+            public bool analyzeTextures; // constant textures shrink to a texel, single channel maps to one component and opaque alpha is dropped
+            public bool trimMipmaps; // drop mipmaps finer than the view below can sample, anything closer or sharper will look blurred
+            public int trimScreenHeight; // pixels
+            public float trimFieldOfView; // vertical, in degrees
+            public float trimNearDistance; // closest the camera gets to any surface
+            public bool limitTextureMemory; // the textures drawn least, and masks before normals before color, are downsampled until they fit
+            public int textureMemoryBudget; // megabytes
         }
 
         public static void Export(GameObject[] gameObjects, string saveFileName, ExportSettings settings)
@@ -38,7 +120,12 @@ namespace vsgUnity
             TextureConverter.ClearCaches();
             MaterialConverter.ClearCaches();
 
-            GraphBuilderInterface.unity2vsg_BeginExport();
+            // each export gets its own context so nothing is left in the global builder between exports
+            IntPtr context = GraphBuilderInterface.unity2vsg_CreateExportContext();
+            GraphBuilderInterface.unity2vsg_Context_SetExportSettings(context, NativeUtils.CreateExportSettingsData(settings));
+
+            // the whole graph is encoded into one stream and submitted in a single call once traversal is done
+            CommandStreamEncoder stream = new CommandStreamEncoder();
 
             List<PipelineData> storePipelines = new List<PipelineData>();
 
@@ -60,7 +147,7 @@ namespace vsgUnity
                     {
                         // add as a transform
                         TransformData transformdata = TransformConverter.CreateTransformData(gotrans);
-                        GraphBuilderInterface.unity2vsg_AddTransformNode(transformdata);
+                        stream.AddTransformNode(transformdata);
                         nodeAdded = true;
                     }
                 }
@@ -69,7 +156,7 @@ namespace vsgUnity
                 if (!nodeAdded)// && gotrans.childCount > 0)
                 {
                     //add as a group
-                    GraphBuilderInterface.unity2vsg_AddGroupNode();
+                    stream.AddGroupNode();
                     nodeAdded = true;
                 }
 
@@ -98,8 +185,8 @@ namespace vsgUnity
                                 if(boundsrenderer != null) bounds.Encapsulate(boundsrenderer.bounds);
                             }
                             lodCullData.center = bounds.center + -gotrans.localPosition;
-                            lodCullData.radius = bounds.size.magnitude * 0.5f;
-                            GraphBuilderInterface.unity2vsg_AddLODNode(lodCullData);
+                            lodCullData.radius = settings.nativeBounds ? 0.0f : bounds.size.magnitude * 0.5f; // zero has the native side compute it
+                            stream.AddLODNode(lodCullData);
 
                             insideLODGroup = true;
 
@@ -110,14 +197,14 @@ namespace vsgUnity
 
                                 LODChildData lodChild = new LODChildData();
                                 lodChild.minimumScreenHeightRatio = lods[i].screenRelativeTransitionHeight;
-                                GraphBuilderInterface.unity2vsg_AddLODChild(lodChild);
+                                stream.AddLODChild(lodChild);
 
                                 foreach (Renderer lodrenderer in lods[i].renderers)
                                 {
                                     if (lodrenderer == meshRenderer)
                                     {
                                         meshexported = true;
-                                        ExportMesh(meshFilter.sharedMesh, meshRenderer, gotrans, settings, storePipelines);
+                                        ExportMesh(stream, context, meshFilter.sharedMesh, meshRenderer, gotrans, settings, storePipelines);
                                     }
                                     else if(lodrenderer != null)
                                     {
@@ -126,12 +213,12 @@ namespace vsgUnity
                                     }
                                 }
 
-                                GraphBuilderInterface.unity2vsg_EndNode();
+                                stream.EndNode();
                             }
 
                             insideLODGroup = false;
 
-                            GraphBuilderInterface.unity2vsg_EndNode(); // end the lod node
+                            stream.EndNode(); // end the lod node
                         }
                     }
                 }
@@ -148,20 +235,20 @@ namespace vsgUnity
                 if (!meshexported && meshFilter && meshFilter.sharedMesh && meshRenderer)
                 {
                     Mesh mesh = meshFilter.sharedMesh;
-                    ExportMesh(mesh, meshRenderer, gotrans, settings, storePipelines);
+                    ExportMesh(stream, context, mesh, meshRenderer, gotrans, settings, storePipelines);
                 }
 
                 // does this node have a terrain
                 Terrain terrain = go.GetComponent<Terrain>();
                 if (terrain != null)
                 {
-                    ExportTerrainMesh(terrain, settings, storePipelines);
+                    ExportTerrainMesh(stream, context, terrain, settings, storePipelines);
                 }
 
                 // if we added a group or transform step out
                 if (nodeAdded)
                 {
-                    GraphBuilderInterface.unity2vsg_EndNode();
+                    stream.EndNode();
                 }
             };
 
@@ -172,42 +259,54 @@ namespace vsgUnity
 
             //GraphBuilderInterface.unity2vsg_EndNode(); // step out of convert coord system node
 
-            GraphBuilderInterface.unity2vsg_EndExport(saveFileName);
+            // the stream stays pinned until the export has finished as the native side references its array data
+            bool submitted;
+            GCHandle streamHandle = stream.Submit(context, out submitted);
+            try
+            {
+                if (!submitted) NativeLog.WriteLine("Export: Native side rejected the command stream.");
+                GraphBuilderInterface.unity2vsg_Context_EndExport(context, saveFileName);
+            }
+            finally
+            {
+                streamHandle.Free();
+                GraphBuilderInterface.unity2vsg_DestroyExportContext(context);
+            }
             NativeLog.PrintReport();
         }
 
         // Bind the descriptors in a materialinfo, should be called from within a StateGroup
         
-        private static void BindDescriptors(MaterialInfo materialInfo)
+        private static void BindDescriptors(CommandStreamEncoder stream, MaterialInfo materialInfo)
         {
             bool addedAny = false;
             foreach (DescriptorImageData t in materialInfo.imageDescriptors)
             {
-                GraphBuilderInterface.unity2vsg_AddDescriptorImage(t);
+                stream.AddDescriptorImage(t);
                 addedAny = true;
             }
             foreach (DescriptorVectorUniformData t in materialInfo.vectorDescriptors)
             {
-                GraphBuilderInterface.unity2vsg_AddDescriptorBufferVector(t);
+                stream.AddDescriptorBufferVector(t);
                 addedAny = true;
             }
             foreach (DescriptorFloatUniformData t in materialInfo.floatDescriptors)
             {
-                GraphBuilderInterface.unity2vsg_AddDescriptorBufferFloat(t);
+                stream.AddDescriptorBufferFloat(t);
                 addedAny = true;
             }
-            if (addedAny) GraphBuilderInterface.unity2vsg_CreateBindDescriptorSetCommand(1);
+            if (addedAny) stream.CreateBindDescriptorSetCommand(1);
         }
 
-        private static void ExportMesh(Mesh mesh, MeshRenderer meshRenderer, Transform gotrans,  ExportSettings settings, List<PipelineData> storePipelines = null)
+        private static void ExportMesh(CommandStreamEncoder stream, IntPtr context, Mesh mesh, MeshRenderer meshRenderer, Transform gotrans,  ExportSettings settings, List<PipelineData> storePipelines = null)
         {
             bool addedCullGroup = false;
             if (settings.autoAddCullNodes)
             {
                 CullData culldata = new CullData();
                 culldata.center = meshRenderer.bounds.center + -gotrans.localPosition;
-                culldata.radius = meshRenderer.bounds.size.magnitude * 0.5f;
-                GraphBuilderInterface.unity2vsg_AddCullGroupNode(culldata);
+                culldata.radius = settings.nativeBounds ? 0.0f : meshRenderer.bounds.size.magnitude * 0.5f; // zero has the native side compute it
+                stream.AddCullGroupNode(culldata);
                 addedCullGroup = true;
             }
 
@@ -219,6 +318,7 @@ namespace vsgUnity
                 int meshid = mesh.GetInstanceID();
 
                 MeshInfo meshInfo = MeshConverter.GetOrCreateMeshInfo(mesh);
+                MeshConverter.CommitNativeArrays(context, meshInfo);
 
                 int subMeshCount = mesh.subMeshCount;
 
@@ -229,7 +329,7 @@ namespace vsgUnity
                     Material mat = materials[matindex];
                     if (mat == null) continue;
 
-                    MaterialInfo matdata = MaterialConverter.GetOrCreateMaterialData(mat);
+                    MaterialInfo matdata = MaterialConverter.GetOrCreateMaterialData(mat, null, settings.packChannelMaps);
                     int matshaderid = matdata.shaderStages.id;
 
                     if (!meshMaterials.ContainsKey(matshaderid)) meshMaterials.Add(matshaderid, new Dictionary<MaterialInfo, List<int>>());
@@ -249,7 +349,7 @@ namespace vsgUnity
                         if (mds.Count == 0) continue;
 
                         // add stategroup and pipeline for shader
-                        GraphBuilderInterface.unity2vsg_AddStateGroupNode();
+                        stream.AddStateGroupNode();
 
                         PipelineData pipelineData = NativeUtils.CreatePipelineData(meshInfo); //WE NEED INFO ABOUT THE SHADER SO WE CAN BUILD A PIPLE LINE
                         pipelineData.descriptorBindings = NativeUtils.WrapArray(mds[0].descriptorBindings.ToArray());
@@ -258,32 +358,31 @@ namespace vsgUnity
                         pipelineData.id = NativeUtils.ToNative(NativeUtils.GetIDForPipeline(pipelineData));
                         storePipelines.Add(pipelineData);
 
-                        if (GraphBuilderInterface.unity2vsg_AddBindGraphicsPipelineCommand(pipelineData, 1) == 1)
-                        {
+                        // if the pipeline fails to bind the native side skips everything up to the end of the state group
+                        stream.AddBindGraphicsPipelineCommand(pipelineData, 1);
 
-                            GraphBuilderInterface.unity2vsg_AddCommandsNode();
+                        stream.AddCommandsNode();
 
-                            VertexBuffersData vertexBuffersData = MeshConverter.GetOrCreateVertexBuffersData(meshInfo);
-                            GraphBuilderInterface.unity2vsg_AddBindVertexBuffersCommand(vertexBuffersData);
+                        VertexBuffersData vertexBuffersData = MeshConverter.GetOrCreateVertexBuffersData(meshInfo);
+                        stream.AddBindVertexBuffersCommand(vertexBuffersData);
 
-                            IndexBufferData indexBufferData = MeshConverter.GetOrCreateIndexBufferData(meshInfo);
-                            GraphBuilderInterface.unity2vsg_AddBindIndexBufferCommand(indexBufferData);
+                        IndexBufferData indexBufferData = MeshConverter.GetOrCreateIndexBufferData(meshInfo);
+                        stream.AddBindIndexBufferCommand(indexBufferData);
 
 
-                            foreach (MaterialInfo md in mds)
-                            {
-                                BindDescriptors(md);
+                        foreach (MaterialInfo md in mds)
+                        {
+                            BindDescriptors(stream, md);
 
-                                foreach (int submeshIndex in meshMaterials[shaderkey][md])
-                                {
-                                    DrawIndexedData drawIndexedData = MeshConverter.GetOrCreateDrawIndexedData(meshInfo, submeshIndex);
-                                    GraphBuilderInterface.unity2vsg_AddDrawIndexedCommand(drawIndexedData);
-                                }
+                            foreach (int submeshIndex in meshMaterials[shaderkey][md])
+                            {
+                                DrawIndexedData drawIndexedData = MeshConverter.GetOrCreateDrawIndexedData(meshInfo, submeshIndex);
+                                stream.AddDrawIndexedCommand(drawIndexedData);
                             }
-
-                            GraphBuilderInterface.unity2vsg_EndNode(); // step out of commands node for descriptors and draw indexed commands
                         }
-                        GraphBuilderInterface.unity2vsg_EndNode(); // step out of stategroup node for shader
+
+                        stream.EndNode(); // step out of commands node for descriptors and draw indexed commands
+                        stream.EndNode(); // step out of stategroup node for shader
                     }
                 }
                 else
@@ -296,7 +395,7 @@ namespace vsgUnity
                         if (mds.Count > 0)
                         {
                             // add stategroup and pipeline for shader
-                            GraphBuilderInterface.unity2vsg_AddStateGroupNode();
+                            stream.AddStateGroupNode();
 
                             PipelineData pipelineData = NativeUtils.CreatePipelineData(meshInfo); //WE NEED INFO ABOUT THE SHADER SO WE CAN BUILD A PIPLE LINE
                             pipelineData.descriptorBindings = NativeUtils.WrapArray(mds[0].descriptorBindings.ToArray());
@@ -305,16 +404,15 @@ namespace vsgUnity
                             pipelineData.id = NativeUtils.ToNative(NativeUtils.GetIDForPipeline(pipelineData));
                             storePipelines.Add(pipelineData);
 
-                            if (GraphBuilderInterface.unity2vsg_AddBindGraphicsPipelineCommand(pipelineData, 1) == 1)
-                            {
-                                BindDescriptors(mds[0]);
+                            stream.AddBindGraphicsPipelineCommand(pipelineData, 1);
 
-                                VertexIndexDrawData vertexIndexDrawData = MeshConverter.GetOrCreateVertexIndexDrawData(meshInfo);
-                                GraphBuilderInterface.unity2vsg_AddVertexIndexDrawNode(vertexIndexDrawData);
+                            BindDescriptors(stream, mds[0]);
 
-                                GraphBuilderInterface.unity2vsg_EndNode(); // step out of vertex index draw node
-                            }
-                            GraphBuilderInterface.unity2vsg_EndNode(); // step out of stategroup node
+                            VertexIndexDrawData vertexIndexDrawData = MeshConverter.GetOrCreateVertexIndexDrawData(meshInfo);
+                            stream.AddVertexIndexDrawNode(vertexIndexDrawData);
+
+                            stream.EndNode(); // step out of vertex index draw node
+                            stream.EndNode(); // step out of stategroup node
                         }
                     }
                 }
@@ -327,18 +425,20 @@ namespace vsgUnity
 
             if (addedCullGroup)
             {
-                GraphBuilderInterface.unity2vsg_EndNode();
+                stream.EndNode();
             }
         }
 
-        private static void ExportTerrainMesh(Terrain terrain, ExportSettings settings, List<PipelineData> storePipelines = null)
+        private static void ExportTerrainMesh(CommandStreamEncoder stream, IntPtr context, Terrain terrain, ExportSettings settings, List<PipelineData> storePipelines = null)
         {
             TerrainConverter.TerrainInfo terrainInfo = TerrainConverter.CreateTerrainInfo(terrain, settings);
 
             if (terrainInfo == null || ((terrainInfo.diffuseTextureDatas.Count == 0 || terrainInfo.maskTextureDatas.Count == 0) && terrainInfo.customMaterial == null)) return;
 
+            MeshConverter.CommitNativeArrays(context, terrainInfo.terrainMesh);
+
             // add stategroup and pipeline for shader
-            GraphBuilderInterface.unity2vsg_AddStateGroupNode();
+            stream.AddStateGroupNode();
 
             PipelineData pipelineData = new PipelineData();
             pipelineData.hasNormals = 1;
@@ -354,38 +454,37 @@ namespace vsgUnity
                 pipelineData.id = NativeUtils.ToNative(NativeUtils.GetIDForPipeline(pipelineData));
                 storePipelines.Add(pipelineData);
 
-                if (GraphBuilderInterface.unity2vsg_AddBindGraphicsPipelineCommand(pipelineData, 1) == 1)
+                stream.AddBindGraphicsPipelineCommand(pipelineData, 1);
+
+                if (terrainInfo.diffuseTextureDatas.Count > 0)
                 {
-                    if (terrainInfo.diffuseTextureDatas.Count > 0)
-                    {
-                        DescriptorImageData layerDiffuseTextureArray = MaterialConverter.GetOrCreateDescriptorImageData(terrainInfo.diffuseTextureDatas.ToArray(), 0);
-                        GraphBuilderInterface.unity2vsg_AddDescriptorImage(layerDiffuseTextureArray);
-                    }
+                    DescriptorImageData layerDiffuseTextureArray = MaterialConverter.GetOrCreateDescriptorImageData(terrainInfo.diffuseTextureDatas.ToArray(), 0, true);
+                    stream.AddDescriptorImage(layerDiffuseTextureArray);
+                }
 
-                    if (terrainInfo.diffuseScales.Count > 0)
-                    {
-                        DescriptorVectorArrayUniformData scalesDescriptor = new DescriptorVectorArrayUniformData();
-                        scalesDescriptor.binding = 2;
-                        scalesDescriptor.value = NativeUtils.WrapArray(terrainInfo.diffuseScales.ToArray());
-                        GraphBuilderInterface.unity2vsg_AddDescriptorBufferVectorArray(scalesDescriptor);
-                    }
+                if (terrainInfo.diffuseScales.Count > 0)
+                {
+                    DescriptorVectorArrayUniformData scalesDescriptor = new DescriptorVectorArrayUniformData();
+                    scalesDescriptor.binding = 2;
+                    scalesDescriptor.value = NativeUtils.WrapArray(terrainInfo.diffuseScales.ToArray());
+                    stream.AddDescriptorBufferVectorArray(scalesDescriptor);
+                }
 
-                    DescriptorVectorUniformData sizeDescriptor = new DescriptorVectorUniformData();
-                    sizeDescriptor.binding = 3;
-                    sizeDescriptor.value = terrainInfo.terrainSize;
-                    GraphBuilderInterface.unity2vsg_AddDescriptorBufferVector(sizeDescriptor);
+                DescriptorVectorUniformData sizeDescriptor = new DescriptorVectorUniformData();
+                sizeDescriptor.binding = 3;
+                sizeDescriptor.value = terrainInfo.terrainSize;
+                stream.AddDescriptorBufferVector(sizeDescriptor);
 
-                    if (terrainInfo.maskTextureDatas.Count > 0)
-                    {
-                        DescriptorImageData layerMaskTextureArray = MaterialConverter.GetOrCreateDescriptorImageData(terrainInfo.maskTextureDatas.ToArray(), 1);
-                        GraphBuilderInterface.unity2vsg_AddDescriptorImage(layerMaskTextureArray);
-                    }
+                if (terrainInfo.maskTextureDatas.Count > 0)
+                {
+                    DescriptorImageData layerMaskTextureArray = MaterialConverter.GetOrCreateDescriptorImageData(terrainInfo.maskTextureDatas.ToArray(), 1, true);
+                    stream.AddDescriptorImage(layerMaskTextureArray);
+                }
 
-                    GraphBuilderInterface.unity2vsg_CreateBindDescriptorSetCommand(1);
+                stream.CreateBindDescriptorSetCommand(1);
 
-                    GraphBuilderInterface.unity2vsg_AddVertexIndexDrawNode(MeshConverter.GetOrCreateVertexIndexDrawData(terrainInfo.terrainMesh));
-                    GraphBuilderInterface.unity2vsg_EndNode(); // step out of vertex index draw node
-                }
+                stream.AddVertexIndexDrawNode(MeshConverter.GetOrCreateVertexIndexDrawData(terrainInfo.terrainMesh));
+                stream.EndNode(); // step out of vertex index draw node
             }
             else
             {
@@ -394,17 +493,16 @@ namespace vsgUnity
                 pipelineData.id = NativeUtils.ToNative(NativeUtils.GetIDForPipeline(pipelineData));
                 storePipelines.Add(pipelineData);
 
-                if (GraphBuilderInterface.unity2vsg_AddBindGraphicsPipelineCommand(pipelineData, 1) == 1)
-                {
-                    BindDescriptors(terrainInfo.customMaterial);
+                stream.AddBindGraphicsPipelineCommand(pipelineData, 1);
 
-                    GraphBuilderInterface.unity2vsg_AddVertexIndexDrawNode(MeshConverter.GetOrCreateVertexIndexDrawData(terrainInfo.terrainMesh));
-                    GraphBuilderInterface.unity2vsg_EndNode(); // step out of vertex index draw node
-                }
+                BindDescriptors(stream, terrainInfo.customMaterial);
+
+                stream.AddVertexIndexDrawNode(MeshConverter.GetOrCreateVertexIndexDrawData(terrainInfo.terrainMesh));
+                stream.EndNode(); // step out of vertex index draw node
 
                 
             }
-            GraphBuilderInterface.unity2vsg_EndNode(); // step out of stategroup node
+            stream.EndNode(); // step out of stategroup node
 
         }
     }
@@ -11,6 +11,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 </editor-fold> */
 
 using System;
+using System.IO;
 using System.Linq;
 using System.Collections.Generic;
 using UnityEngine;
@@ -96,6 +97,7 @@ namespace vsgUnity
         public List<VkDescriptorSetLayoutBinding> descriptorBindings = new List<VkDescriptorSetLayoutBinding>();
         public List<string> customDefines = new List<string>();
         public int useAlpha;
+        public string[] packedChannels = new string[0]; // the map define read from each component of the packed map, in order from red
     }
 
     /// <summary>
@@ -109,6 +111,12 @@ namespace vsgUnity
         public static Dictionary<int, DescriptorImageData> _descriptorImageDataCache = new Dictionary<int, DescriptorImageData>();
         public static Dictionary<int, ShaderStageInfo> _shaderStageInfoCache = new Dictionary<int, ShaderStageInfo>();
         public static Dictionary<int, ShaderStagesInfo> _shaderStagesInfoCache = new Dictionary<int, ShaderStagesInfo>();
+        public static Dictionary<string, bool> _packedChannelSupportCache = new Dictionary<string, bool>();
+
+        // maps whose shaders only read their first component, in the order they're packed into the components of one texture
+        public static readonly string[] PackableMapDefines = { "VSG_AMBIENT_MAP", "VSG_SPECULAR_MAP", "VSG_OPACITY_MAP" };
+        public const string PackedMapDefinePrefix = "VSG_PACKED_";
+        public const int PackedMapBinding = 7;
 
         public static void ClearCaches()
         {
@@ -116,6 +124,7 @@ namespace vsgUnity
             _descriptorImageDataCache.Clear();
             _shaderStageInfoCache.Clear();
             _shaderStagesInfoCache.Clear();
+            _packedChannelSupportCache.Clear();
         }
 
         /// <summary>
@@ -123,15 +132,18 @@ namespace vsgUnity
         /// </summary>
         /// <param name="imageData"></param>
         /// <param name="binding"></param>
+        /// <param name="firstComponentOnly">the shader only reads the first component of the image</param>
+        /// <param name="sampledAtFirstUvs">the shader samples the image at the first uvs as they are</param>
         /// <returns></returns>
 
-        public static DescriptorImageData GetOrCreateDescriptorImageData(ImageData imageData, int binding)
+        public static DescriptorImageData GetOrCreateDescriptorImageData(ImageData imageData, int binding, bool firstComponentOnly = false, bool sampledAtFirstUvs = false)
         {
             // see if we have one already
             foreach (int idkey in _descriptorImageDataCache.Keys)
             {
                 DescriptorImageData did = _descriptorImageDataCache[idkey];
-                if (did.binding == binding && did.image.Length == 1 && did.image[0].id == imageData.id)
+                if (did.binding == binding && did.image.Length == 1 && did.image[0].id == imageData.id && did.firstComponentOnly == (firstComponentOnly ? 1 : 0) &&
+                    did.sampledAtFirstUvs == (sampledAtFirstUvs ? 1 : 0))
                 {
                     return did;
                 }
@@ -142,7 +154,9 @@ namespace vsgUnity
                 id = _descriptorImageDataCache.Count,
                 binding = binding,
                 image = new ImageData[] { imageData },
-                descriptorCount = 1
+                descriptorCount = 1,
+                firstComponentOnly = firstComponentOnly ? 1 : 0,
+                sampledAtFirstUvs = sampledAtFirstUvs ? 1 : 0
             };
 
             _descriptorImageDataCache[descriptorImage.id] = descriptorImage;
@@ -155,15 +169,19 @@ namespace vsgUnity
         /// </summary>
         /// <param name="imageData"></param>
         /// <param name="binding"></param>
+        /// <param name="packLayers">pack the images into the layers of a single 2D array image</param>
+        /// <param name="packChannels">pack the first component of each image into the components of a single image</param>
+        /// <param name="sampledAtFirstUvs">the shader samples the images at the first uvs as they are</param>
         /// <returns></returns>
 
-        public static DescriptorImageData GetOrCreateDescriptorImageData(ImageData[] imageDatas, int binding)
+        public static DescriptorImageData GetOrCreateDescriptorImageData(ImageData[] imageDatas, int binding, bool packLayers = false, bool packChannels = false, bool sampledAtFirstUvs = false)
         {
             // see if we have one already
             foreach (int idkey in _descriptorImageDataCache.Keys)
             {
                 DescriptorImageData did = _descriptorImageDataCache[idkey];
-                if (did.binding == binding && did.image.Length == imageDatas.Length)
+                if (did.binding == binding && did.image.Length == imageDatas.Length && did.packLayers == (packLayers ? 1 : 0) && did.packChannels == (packChannels ? 1 : 0) &&
+                    did.sampledAtFirstUvs == (sampledAtFirstUvs ? 1 : 0))
                 {
                     bool match = true;
                     for(int i = 0; i < imageDatas.Length; i++)
@@ -183,7 +201,10 @@ namespace vsgUnity
                 id = _descriptorImageDataCache.Count,
                 binding = binding,
                 image = imageDatas,
-                descriptorCount = imageDatas.Length
+                descriptorCount = imageDatas.Length,
+                packLayers = packLayers ? 1 : 0,
+                packChannels = packChannels ? 1 : 0,
+                sampledAtFirstUvs = sampledAtFirstUvs ? 1 : 0
             };
 
             _descriptorImageDataCache[descriptorImage.id] = descriptorImage;
@@ -269,9 +290,10 @@ namespace vsgUnity
         /// Get a material data to match the passed material if one exisits in the cache otherwise create a new one
         /// </summary>
         /// <param name="material"></param>
+        /// <param name="packChannels">pack single channel maps into the components of one texture when the shaders support it</param>
         /// <returns></returns>
 
-        public static MaterialInfo GetOrCreateMaterialData(Material material, ShaderMapping mapping = null)
+        public static MaterialInfo GetOrCreateMaterialData(Material material, ShaderMapping mapping = null, bool packChannels = false)
         {
             if(_materialDataCache.ContainsKey(material.GetInstanceID()))
             {
@@ -279,17 +301,52 @@ namespace vsgUnity
             }
             else
             {
-                return CreateMaterialData(material, mapping);
+                return CreateMaterialData(material, mapping, packChannels);
             }
         }
 
+        /// <summary>
+        /// Do the fragment shaders of a mapping import the defines to read single channel maps from a packed texture
+        /// </summary>
+        /// <param name="mapping"></param>
+        /// <returns></returns>
+
+        public static bool ShadersSupportPackedChannels(ShaderMapping mapping)
+        {
+            bool supported = false;
+            foreach (ShaderResource shader in mapping.shaders)
+            {
+                if ((shader.stages & VkShaderStageFlagBits.VK_SHADER_STAGE_FRAGMENT_BIT) != VkShaderStageFlagBits.VK_SHADER_STAGE_FRAGMENT_BIT) continue;
+
+                if (!_packedChannelSupportCache.ContainsKey(shader.sourceFile))
+                {
+                    bool imports = false;
+                    if (File.Exists(shader.sourceFile))
+                    {
+                        foreach (string line in File.ReadAllLines(shader.sourceFile))
+                        {
+                            if (!line.Contains("#pragma import_defines")) continue;
+                            imports = PackableMapDefines.All(define => line.Contains(PackedMapDefinePrefix + define.Substring("VSG_".Length)));
+                            if (imports) break;
+                        }
+                    }
+                    _packedChannelSupportCache[shader.sourceFile] = imports;
+                }
+
+                if (!_packedChannelSupportCache[shader.sourceFile]) return false;
+                supported = true;
+            }
+            return supported;
+        }
+
         /// <summary>
         /// Create a new material data based off of the pass material also adds the new data to the cache
         /// </summary>
         /// <param name="material"></param>
+        /// <param name="packChannels">pack single channel maps into the components of one texture when the shaders support it</param>
         /// <returns></returns>
 
-        public static MaterialInfo CreateMaterialData(Material material, ShaderMapping mapping = null)
+        public static MaterialInfo CreateMaterialData(Material material, ShaderMapping mapping = null, bool packChannels = false)
         {
             // fetch the shadermapping for this materials shader
             if (mapping == null && material != null)
@@ -310,8 +367,26 @@ namespace vsgUnity
             // process uniforms
             UniformMappedData[] uniformDatas = mapping.GetUniformDatasFromMaterial(material);
 
+            // single channel maps are packed into one texture when there's more than one of them to share it, the standard
+            // shaders sample every map at the first uvs as they are
+            bool standardMaps = ShadersSupportPackedChannels(mapping);
+            List<UniformMappedData> packedUniforms = new List<UniformMappedData>();
+            if (packChannels && standardMaps)
+            {
+                foreach (string define in PackableMapDefines)
+                {
+                    UniformMappedData uniData = uniformDatas.FirstOrDefault(u => u.mapping.uniformType == UniformMapping.UniformType.Texture2DUniform && u.data as Texture != null &&
+                                                                                 u.mapping.vsgDefines != null && u.mapping.vsgDefines.Contains(define) &&
+                                                                                 u.mapping.vsgDefines.Count(d => PackableMapDefines.Contains(d)) == 1);
+                    if (uniData != null) packedUniforms.Add(uniData);
+                }
+                if (packedUniforms.Count < 2) packedUniforms.Clear();
+            }
+
             foreach (UniformMappedData uniData in uniformDatas)
             {
+                if (packedUniforms.Contains(uniData)) continue;
+
                 VkDescriptorType descriptorType = VkDescriptorType.VK_DESCRIPTOR_TYPE_MAX_ENUM;
                 uint descriptorCount = 1;
 
@@ -322,8 +397,10 @@ namespace vsgUnity
 
                     // get imagedata for the texture
                     ImageData imageData = TextureConverter.GetOrCreateImageData(tex);
+                    // single channel maps the shaders only read the first component of can be exported as one component
+                    bool firstComponentOnly = standardMaps && uniData.mapping.vsgDefines != null && uniData.mapping.vsgDefines.Count > 0 && uniData.mapping.vsgDefines.All(d => PackableMapDefines.Contains(d));
                     // get descriptor for the image data
-                    DescriptorImageData descriptorImage = GetOrCreateDescriptorImageData(imageData, uniData.mapping.vsgBindingIndex);
+                    DescriptorImageData descriptorImage = GetOrCreateDescriptorImageData(imageData, uniData.mapping.vsgBindingIndex, firstComponentOnly, standardMaps);
                     matdata.imageDescriptors.Add(descriptorImage);
 
                     descriptorType = VkDescriptorType.VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -395,6 +472,45 @@ namespace vsgUnity
                 matdata.descriptorBindings.Add(descriptorBinding);
             }
 
+            if (packedUniforms.Count > 0)
+            {
+                // the packed maps share one descriptor and their defines are swapped for ones reading the packed components
+                List<ImageData> packedImages = new List<ImageData>();
+                List<string> packedChannels = new List<string>();
+                VkShaderStageFlagBits packedStages = 0;
+                foreach (UniformMappedData uniData in packedUniforms)
+                {
+                    packedImages.Add(TextureConverter.GetOrCreateImageData(uniData.data as Texture));
+                    packedStages |= uniData.mapping.stages;
+                    foreach (string define in uniData.mapping.vsgDefines)
+                    {
+                        if (PackableMapDefines.Contains(define))
+                        {
+                            packedChannels.Add(define);
+                            matdata.customDefines.Add(PackedMapDefinePrefix + define.Substring("VSG_".Length));
+                        }
+                        else
+                        {
+                            matdata.customDefines.Add(define);
+                        }
+                    }
+                }
+                matdata.packedChannels = packedChannels.ToArray();
+
+                DescriptorImageData descriptorImage = GetOrCreateDescriptorImageData(packedImages.ToArray(), PackedMapBinding, false, true, true);
+                matdata.imageDescriptors.Add(descriptorImage);
+
+                VkDescriptorSetLayoutBinding descriptorBinding = new VkDescriptorSetLayoutBinding
+                {
+                    binding = (uint)PackedMapBinding,
+                    descriptorType = VkDescriptorType.VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    descriptorCount = 1,
+                    stageFlags = packedStages,
+                    pImmutableSamplers = System.IntPtr.Zero
+                };
+                matdata.descriptorBindings.Add(descriptorBinding);
+            }
+
             if (material != null)
             {
                 string rendertype = material.GetTag("RenderType", true, "Opaque");
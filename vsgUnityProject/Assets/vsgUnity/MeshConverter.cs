@@ -74,6 +74,9 @@ namespace vsgUnity
         public static Dictionary<int, Dictionary<int, DrawIndexedData>> _drawIndexedDataCache = new Dictionary<int, Dictionary<int, DrawIndexedData>>();
         static int _drawIndexedIDCount = 0;
 
+        // whether a meshes arrays were copied straight into native arrays owned by the export context, if so the data sent for it only needs its id
+        static Dictionary<int, bool> _nativeArraysCache = new Dictionary<int, bool>();
+
         public static void ClearCaches()
         {
             _meshInfoCache.Clear();
@@ -82,6 +85,50 @@ namespace vsgUnity
             _vertexBuffersDataCache.Clear();
             _drawIndexedDataCache.Clear();
             _drawIndexedIDCount = 0;
+            _nativeArraysCache.Clear();
+        }
+
+        public static bool HasNativeArrays(MeshInfo meshInfo)
+        {
+            bool committed;
+            return _nativeArraysCache.TryGetValue(meshInfo.id, out committed) && committed;
+        }
+
+        // copy the meshes arrays into native arrays allocated by the context and commit them, if this fails the data sent for the mesh carries its arrays as before
+        public static bool CommitNativeArrays(IntPtr context, MeshInfo meshInfo)
+        {
+            bool committed;
+            if (_nativeArraysCache.TryGetValue(meshInfo.id, out committed)) return committed;
+
+            // indices are always copied as 32 bit, the native side narrows them to 16 bit if they fit
+            committed = meshInfo.verticies.length > 0 && meshInfo.triangles.length > 0;
+            if (committed)
+            {
+                IntPtr indices = GraphBuilderInterface.unity2vsg_Context_AllocateIndexArray(context, meshInfo.id, (uint)meshInfo.triangles.length, 1);
+                committed = indices != IntPtr.Zero;
+                if (committed) GraphBuilderInterface.unity2vsg_CopyToNativeArray(indices, meshInfo.triangles.data, (uint)(meshInfo.triangles.length * sizeof(int)));
+            }
+            committed = committed && CopyVertexArray(context, meshInfo.id, GeometryAttribute.Vertex, meshInfo.verticies.length, ptr => GraphBuilderInterface.unity2vsg_CopyToNativeArray(ptr, meshInfo.verticies.data, (uint)(meshInfo.verticies.length * 12)));
+            committed = committed && CopyVertexArray(context, meshInfo.id, GeometryAttribute.Normal, meshInfo.normals.length, ptr => GraphBuilderInterface.unity2vsg_CopyToNativeArray(ptr, meshInfo.normals.data, (uint)(meshInfo.normals.length * 12)));
+            committed = committed && CopyVertexArray(context, meshInfo.id, GeometryAttribute.Tangent, meshInfo.tangents.length, ptr => GraphBuilderInterface.unity2vsg_CopyToNativeArray(ptr, meshInfo.tangents.data, (uint)(meshInfo.tangents.length * 16)));
+            committed = committed && CopyVertexArray(context, meshInfo.id, GeometryAttribute.Color, meshInfo.colors.length, ptr => GraphBuilderInterface.unity2vsg_CopyToNativeArray(ptr, meshInfo.colors.data, (uint)(meshInfo.colors.length * 16)));
+            committed = committed && CopyVertexArray(context, meshInfo.id, GeometryAttribute.TexCoord0, meshInfo.uv0.length, ptr => GraphBuilderInterface.unity2vsg_CopyToNativeArray(ptr, meshInfo.uv0.data, (uint)(meshInfo.uv0.length * 8)));
+            committed = committed && CopyVertexArray(context, meshInfo.id, GeometryAttribute.TexCoord1, meshInfo.uv1.length, ptr => GraphBuilderInterface.unity2vsg_CopyToNativeArray(ptr, meshInfo.uv1.data, (uint)(meshInfo.uv1.length * 8)));
+
+            // the native side checks the indices are in range and logs why if not
+            committed = committed && GraphBuilderInterface.unity2vsg_Context_CommitMeshArrays(context, meshInfo.id) == 1;
+
+            _nativeArraysCache[meshInfo.id] = committed;
+            return committed;
+        }
+
+        static bool CopyVertexArray(IntPtr context, int meshId, GeometryAttribute attribute, int length, Action<IntPtr> copy)
+        {
+            if (length == 0) return true;
+            IntPtr ptr = GraphBuilderInterface.unity2vsg_Context_AllocateVertexArray(context, meshId, (uint)attribute, (uint)length);
+            if (ptr == IntPtr.Zero) return false;
+            copy(ptr);
+            return true;
         }
 
         public static MeshInfo GetOrCreateMeshInfo(Mesh mesh)
@@ -163,8 +210,8 @@ namespace vsgUnity
         {
             IndexBufferData indexBufferData = new IndexBufferData();
             indexBufferData.id = meshInfo.id;
-            indexBufferData.triangles = meshInfo.triangles;
             indexBufferData.use32BitIndicies = meshInfo.use32BitIndicies;
+            if (!HasNativeArrays(meshInfo)) indexBufferData.triangles = meshInfo.triangles;
 
             _indexBufferDataCache[meshInfo.id] = indexBufferData;
 
@@ -188,12 +235,15 @@ namespace vsgUnity
             VertexBuffersData vertexBuffers = new VertexBuffersData();
             vertexBuffers.id = meshInfo.id;
 
-            vertexBuffers.verticies = meshInfo.verticies;
-            vertexBuffers.normals = meshInfo.normals;
-            vertexBuffers.tangents = meshInfo.tangents;
-            vertexBuffers.colors = meshInfo.colors;
-            vertexBuffers.uv0 = meshInfo.uv0;
-            vertexBuffers.uv1 = meshInfo.uv1;
+            if (!HasNativeArrays(meshInfo))
+            {
+                vertexBuffers.verticies = meshInfo.verticies;
+                vertexBuffers.normals = meshInfo.normals;
+                vertexBuffers.tangents = meshInfo.tangents;
+                vertexBuffers.colors = meshInfo.colors;
+                vertexBuffers.uv0 = meshInfo.uv0;
+                vertexBuffers.uv1 = meshInfo.uv1;
+            }
 
             _vertexBuffersDataCache[meshInfo.id] = vertexBuffers;
 
@@ -216,15 +266,19 @@ namespace vsgUnity
         {
             VertexIndexDrawData vertexIndexDrawData = new VertexIndexDrawData();
             vertexIndexDrawData.id = meshInfo.id;
-            vertexIndexDrawData.triangles = meshInfo.triangles;
             vertexIndexDrawData.use32BitIndicies = meshInfo.use32BitIndicies;
 
-            vertexIndexDrawData.verticies = meshInfo.verticies;
-            vertexIndexDrawData.normals = meshInfo.normals;
-            vertexIndexDrawData.tangents = meshInfo.tangents;
-            vertexIndexDrawData.colors = meshInfo.colors;
-            vertexIndexDrawData.uv0 = meshInfo.uv0;
-            vertexIndexDrawData.uv1 = meshInfo.uv1;
+            if (!HasNativeArrays(meshInfo))
+            {
+                vertexIndexDrawData.triangles = meshInfo.triangles;
+
+                vertexIndexDrawData.verticies = meshInfo.verticies;
+                vertexIndexDrawData.normals = meshInfo.normals;
+                vertexIndexDrawData.tangents = meshInfo.tangents;
+                vertexIndexDrawData.colors = meshInfo.colors;
+                vertexIndexDrawData.uv0 = meshInfo.uv0;
+                vertexIndexDrawData.uv1 = meshInfo.uv1;
+            }
 
             _vertexIndexDrawDataCache[meshInfo.id] = vertexIndexDrawData;
 
@@ -0,0 +1,498 @@
+﻿/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+using System;
+using System.Runtime.InteropServices;
+using UnityEngine;
+
+namespace vsgUnity.Native
+{
+    // op codes, values match unity2vsg CommandStreamOpCode
+    public enum CommandStreamOpCode : ushort
+    {
+        AddGroupNode = 1,
+        AddTransformNode,
+        AddCullNode,
+        AddCullGroupNode,
+        AddLODNode,
+        AddLODChild,
+        AddStateGroupNode,
+        AddCommandsNode,
+        AddVertexIndexDrawNode,
+        AddStringValue,
+        AddBindGraphicsPipelineCommand,
+        AddBindIndexBufferCommand,
+        AddBindVertexBuffersCommand,
+        AddDrawIndexedCommand,
+        CreateBindDescriptorSetCommand,
+        AddDescriptorImage,
+        AddDescriptorBufferFloat,
+        AddDescriptorBufferFloatArray,
+        AddDescriptorBufferVector,
+        AddDescriptorBufferVectorArray,
+        EndNode
+    }
+
+    //
+    // Packs the same calls as GraphBuilderInterface into a single buffer so a whole export is passed to
+    // the native side with one unity2vsg_SubmitCommandBuffer call, see unity2vsg CommandStream.h for the layout.
+    // Bind pipeline ops can't report failure back, the native side skips the ops following a pipeline that fails
+    // to bind until the node it was added to is closed, so callers encode as if every bind succeeds.
+    //
+
+    public class CommandStreamEncoder
+    {
+        public const uint Magic = 0x53563255; // 'U2VS'
+        public const ushort Version = 6;
+        const int HeaderSize = 16;
+        const int OpHeaderSize = 8;
+
+        byte[] _buffer = new byte[64 * 1024];
+        int _size = 0;
+        int _opStart = 0;
+        uint _opCount = 0;
+
+        public CommandStreamEncoder()
+        {
+            Clear();
+        }
+
+        public int Size { get { return _size; } }
+        public uint OpCount { get { return _opCount; } }
+
+        // reset to an empty stream containing only the header
+        public void Clear()
+        {
+            _size = 0;
+            _opStart = 0;
+            _opCount = 0;
+            WriteUInt(Magic);
+            WriteUShort(Version);
+            WriteUShort(HeaderSize);
+            WriteUInt(0); // op count
+            WriteUInt(0); // reserved
+        }
+
+        // pins the stream and submits it, the returned handle must be freed after unity2vsg_EndExport as the
+        // native side references the array data in the stream rather than copying it
+        public GCHandle Submit(out bool succeeded)
+        {
+            GCHandle handle = GCHandle.Alloc(_buffer, GCHandleType.Pinned);
+            succeeded = GraphBuilderInterface.unity2vsg_SubmitCommandBuffer(handle.AddrOfPinnedObject(), new UIntPtr((uint)_size)) == 1;
+            return handle;
+        }
+
+        public GCHandle Submit(IntPtr context, out bool succeeded)
+        {
+            GCHandle handle = GCHandle.Alloc(_buffer, GCHandleType.Pinned);
+            succeeded = GraphBuilderInterface.unity2vsg_Context_SubmitCommandBuffer(context, handle.AddrOfPinnedObject(), new UIntPtr((uint)_size)) == 1;
+            return handle;
+        }
+
+        //
+        // Nodes
+        //
+
+        public void AddGroupNode()
+        {
+            BeginOp(CommandStreamOpCode.AddGroupNode);
+            EndOp();
+        }
+
+        public void AddTransformNode(TransformData transform)
+        {
+            BeginOp(CommandStreamOpCode.AddTransformNode);
+            WriteArray(transform.matrix.data, transform.matrix.length, sizeof(float));
+            EndOp();
+        }
+
+        public void AddCullNode(CullData cull)
+        {
+            BeginOp(CommandStreamOpCode.AddCullNode);
+            WriteCullData(cull);
+            EndOp();
+        }
+
+        public void AddCullGroupNode(CullData cull)
+        {
+            BeginOp(CommandStreamOpCode.AddCullGroupNode);
+            WriteCullData(cull);
+            EndOp();
+        }
+
+        public void AddLODNode(CullData cull)
+        {
+            BeginOp(CommandStreamOpCode.AddLODNode);
+            WriteCullData(cull);
+            EndOp();
+        }
+
+        public void AddLODChild(LODChildData lodChildData)
+        {
+            BeginOp(CommandStreamOpCode.AddLODChild);
+            WriteFloat(lodChildData.minimumScreenHeightRatio);
+            EndOp();
+        }
+
+        public void AddStateGroupNode()
+        {
+            BeginOp(CommandStreamOpCode.AddStateGroupNode);
+            EndOp();
+        }
+
+        public void AddCommandsNode()
+        {
+            BeginOp(CommandStreamOpCode.AddCommandsNode);
+            EndOp();
+        }
+
+        public void AddVertexIndexDrawNode(VertexIndexDrawData mesh)
+        {
+            BeginOp(CommandStreamOpCode.AddVertexIndexDrawNode);
+            WriteInt(mesh.id);
+            WriteArray(mesh.verticies.data, mesh.verticies.length, 12);
+            WriteArray(mesh.triangles.data, mesh.triangles.length, sizeof(int));
+            WriteArray(mesh.normals.data, mesh.normals.length, 12);
+            WriteArray(mesh.tangents.data, mesh.tangents.length, 16);
+            WriteArray(mesh.colors.data, mesh.colors.length, 16);
+            WriteArray(mesh.uv0.data, mesh.uv0.length, 8);
+            WriteArray(mesh.uv1.data, mesh.uv1.length, 8);
+            WriteInt(mesh.use32BitIndicies);
+            EndOp();
+        }
+
+        //
+        // Meta data
+        //
+
+        public void AddStringValue(string name, string value)
+        {
+            BeginOp(CommandStreamOpCode.AddStringValue);
+            WriteString(name);
+            WriteString(value);
+            EndOp();
+        }
+
+        //
+        // Commands
+        //
+
+        public void AddBindGraphicsPipelineCommand(PipelineData pipeline, int addToStateGroup)
+        {
+            BeginOp(CommandStreamOpCode.AddBindGraphicsPipelineCommand);
+            WriteString(pipeline.id);
+            WriteInt(pipeline.hasNormals);
+            WriteInt(pipeline.hasTangents);
+            WriteInt(pipeline.hasColors);
+            WriteInt(pipeline.uvChannelCount);
+            WriteInt(pipeline.useAlpha);
+
+            // bindings are written field by field, immutable samplers can't be passed through the stream
+            int bindingCount = pipeline.descriptorBindings.data != null ? Math.Min(pipeline.descriptorBindings.length, pipeline.descriptorBindings.data.Length) : 0;
+            WriteInt(bindingCount);
+            for (int i = 0; i < bindingCount; i++)
+            {
+                VkDescriptorSetLayoutBinding binding = pipeline.descriptorBindings.data[i];
+                WriteUInt(binding.binding);
+                WriteUInt((uint)binding.descriptorType);
+                WriteUInt(binding.descriptorCount);
+                WriteUInt((uint)binding.stageFlags);
+            }
+
+            WriteInt(pipeline.shaderStages.id);
+            int stageCount = pipeline.shaderStages.stages != null ? Math.Min(pipeline.shaderStages.stagesCount, pipeline.shaderStages.stages.Length) : 0;
+            WriteInt(stageCount);
+            for (int i = 0; i < stageCount; i++)
+            {
+                ShaderStageData stage = pipeline.shaderStages.stages[i];
+                WriteInt(stage.id);
+                WriteUInt((uint)stage.stages);
+                WriteArray(stage.specializationData, sizeof(uint));
+                WriteString(stage.customDefines);
+                WriteString(stage.source);
+            }
+
+            WriteUInt((uint)addToStateGroup);
+            EndOp();
+        }
+
+        public void AddBindIndexBufferCommand(IndexBufferData data)
+        {
+            BeginOp(CommandStreamOpCode.AddBindIndexBufferCommand);
+            WriteInt(data.id);
+            WriteArray(data.triangles.data, data.triangles.length, sizeof(int));
+            WriteInt(data.use32BitIndicies);
+            EndOp();
+        }
+
+        public void AddBindVertexBuffersCommand(VertexBuffersData data)
+        {
+            BeginOp(CommandStreamOpCode.AddBindVertexBuffersCommand);
+            WriteInt(data.id);
+            WriteArray(data.verticies.data, data.verticies.length, 12);
+            WriteArray(data.normals.data, data.normals.length, 12);
+            WriteArray(data.tangents.data, data.tangents.length, 16);
+            WriteArray(data.colors.data, data.colors.length, 16);
+            WriteArray(data.uv0.data, data.uv0.length, 8);
+            WriteArray(data.uv1.data, data.uv1.length, 8);
+            EndOp();
+        }
+
+        public void AddDrawIndexedCommand(DrawIndexedData data)
+        {
+            BeginOp(CommandStreamOpCode.AddDrawIndexedCommand);
+            WriteInt(data.id);
+            WriteUInt(data.indexCount);
+            WriteUInt(data.firstIndex);
+            WriteUInt(data.vertexOffset);
+            WriteUInt(data.instanceCount);
+            WriteUInt(data.firstInstance);
+            EndOp();
+        }
+
+        public void CreateBindDescriptorSetCommand(int addToStateGroup)
+        {
+            BeginOp(CommandStreamOpCode.CreateBindDescriptorSetCommand);
+            WriteUInt((uint)addToStateGroup);
+            EndOp();
+        }
+
+        //
+        // Descriptors
+        //
+
+        public void AddDescriptorImage(DescriptorImageData texture)
+        {
+            BeginOp(CommandStreamOpCode.AddDescriptorImage);
+            WriteInt(texture.id);
+            WriteInt(texture.binding);
+            WriteInt(texture.packLayers);
+            WriteInt(texture.packChannels);
+            WriteInt(texture.firstComponentOnly);
+            WriteInt(texture.sampledAtFirstUvs);
+
+            int imageCount = texture.image != null ? Math.Min(texture.descriptorCount, texture.image.Length) : 0;
+            WriteInt(imageCount);
+            for (int i = 0; i < imageCount; i++)
+            {
+                ImageData image = texture.image[i];
+                WriteInt(image.id);
+                WriteArray(image.pixels, sizeof(byte));
+                WriteUInt((uint)image.format);
+                WriteInt(image.width);
+                WriteInt(image.height);
+                WriteInt(image.depth);
+                WriteInt(image.anisoLevel);
+                WriteUInt((uint)image.wrapMode);
+                WriteUInt((uint)image.filterMode);
+                WriteUInt((uint)image.mipmapMode);
+                WriteInt(image.mipmapCount);
+                WriteFloat(image.mipmapBias);
+                WriteInt((int)image.mipmapFilter);
+                WriteFloat(image.alphaCutoff);
+            }
+            EndOp();
+        }
+
+        public void AddDescriptorBufferFloat(DescriptorFloatUniformData data)
+        {
+            BeginOp(CommandStreamOpCode.AddDescriptorBufferFloat);
+            WriteInt(data.id);
+            WriteInt(data.binding);
+            WriteFloat(data.value);
+            EndOp();
+        }
+
+        public void AddDescriptorBufferFloatArray(DescriptorFloatArrayUniformData data)
+        {
+            BeginOp(CommandStreamOpCode.AddDescriptorBufferFloatArray);
+            WriteInt(data.id);
+            WriteInt(data.binding);
+            WriteArray(data.value.data, data.value.length, sizeof(float));
+            EndOp();
+        }
+
+        public void AddDescriptorBufferVector(DescriptorVectorUniformData data)
+        {
+            BeginOp(CommandStreamOpCode.AddDescriptorBufferVector);
+            WriteInt(data.id);
+            WriteInt(data.binding);
+            WriteVector(data.value);
+            EndOp();
+        }
+
+        public void AddDescriptorBufferVectorArray(DescriptorVectorArrayUniformData data)
+        {
+            BeginOp(CommandStreamOpCode.AddDescriptorBufferVectorArray);
+            WriteInt(data.id);
+            WriteInt(data.binding);
+            WriteArray(data.value.data, data.value.length, 16);
+            EndOp();
+        }
+
+        public void EndNode()
+        {
+            BeginOp(CommandStreamOpCode.EndNode);
+            EndOp();
+        }
+
+        //
+        // Writing
+        //
+
+        void BeginOp(CommandStreamOpCode code)
+        {
+            _opStart = _size;
+            WriteUShort((ushort)code);
+            WriteUShort(0); // flags
+            WriteUInt(0); // payload size, filled in by EndOp
+        }
+
+        void EndOp()
+        {
+            Pad();
+            PutUInt(_opStart + 4, (uint)(_size - _opStart - OpHeaderSize));
+            _opCount++;
+            PutUInt(8, _opCount);
+        }
+
+        void Reserve(int bytes)
+        {
+            if (_size + bytes <= _buffer.Length) return;
+            int capacity = _buffer.Length * 2;
+            while (capacity < _size + bytes) capacity *= 2;
+            Array.Resize(ref _buffer, capacity);
+        }
+
+        void PutUInt(int offset, uint value)
+        {
+            _buffer[offset] = (byte)value;
+            _buffer[offset + 1] = (byte)(value >> 8);
+            _buffer[offset + 2] = (byte)(value >> 16);
+            _buffer[offset + 3] = (byte)(value >> 24);
+        }
+
+        void WriteUShort(ushort value)
+        {
+            Reserve(2);
+            _buffer[_size] = (byte)value;
+            _buffer[_size + 1] = (byte)(value >> 8);
+            _size += 2;
+        }
+
+        void WriteUInt(uint value)
+        {
+            Reserve(4);
+            PutUInt(_size, value);
+            _size += 4;
+        }
+
+        void WriteInt(int value)
+        {
+            WriteUInt((uint)value);
+        }
+
+        void WriteFloat(float value)
+        {
+            Reserve(4);
+            Buffer.BlockCopy(BitConverter.GetBytes(value), 0, _buffer, _size, 4);
+            _size += 4;
+        }
+
+        void WriteCullData(CullData cull)
+        {
+            WriteFloat(cull.center.x);
+            WriteFloat(cull.center.y);
+            WriteFloat(cull.center.z);
+            WriteFloat(cull.radius);
+        }
+
+        void WriteVector(Vector4 value)
+        {
+            WriteFloat(value.x);
+            WriteFloat(value.y);
+            WriteFloat(value.z);
+            WriteFloat(value.w);
+        }
+
+        void Pad()
+        {
+            Reserve(3);
+            while (_size % 4 != 0) _buffer[_size++] = 0;
+        }
+
+        // managed arrays of blittable structs are pinned and copied as raw bytes
+        void WriteArray(Array array, int length, int elementSize)
+        {
+            int count = array != null ? Math.Min(length, array.Length) : 0;
+            if (count < 0) count = 0;
+            WriteInt(count);
+            if (count > 0)
+            {
+                int bytes = count * elementSize;
+                Reserve(bytes);
+                GCHandle handle = GCHandle.Alloc(array, GCHandleType.Pinned);
+                try
+                {
+                    Marshal.Copy(handle.AddrOfPinnedObject(), _buffer, _size, bytes);
+                }
+                finally
+                {
+                    handle.Free();
+                }
+                _size += bytes;
+            }
+            Pad();
+        }
+
+        void WriteArray(NativeArray array, int elementSize)
+        {
+            int count = array.data != IntPtr.Zero && array.length > 0 ? array.length : 0;
+            WriteInt(count);
+            if (count > 0)
+            {
+                int bytes = count * elementSize;
+                Reserve(bytes);
+                Marshal.Copy(array.data, _buffer, _size, bytes);
+                _size += bytes;
+            }
+            Pad();
+        }
+
+        void WriteString(string str)
+        {
+            byte[] chars = str != null ? System.Text.Encoding.UTF8.GetBytes(str) : new byte[0];
+            WriteInt(chars.Length);
+            Reserve(chars.Length + 1);
+            Buffer.BlockCopy(chars, 0, _buffer, _size, chars.Length);
+            _size += chars.Length;
+            _buffer[_size++] = 0;
+            Pad();
+        }
+
+        // strings already copied to native memory with NativeUtils.ToNative
+        void WriteString(IntPtr str)
+        {
+            int length = 0;
+            if (str != IntPtr.Zero)
+            {
+                while (Marshal.ReadByte(str, length) != 0) length++;
+            }
+            WriteInt(length);
+            Reserve(length + 1);
+            if (length > 0) Marshal.Copy(str, _buffer, _size, length);
+            _size += length;
+            _buffer[_size++] = 0;
+            Pad();
+        }
+    }
+}
@@ -10,7 +10,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+using System;
 using System.Runtime.InteropServices;
+using UnityEngine;
 
 namespace vsgUnity.Native
 {
@@ -22,6 +24,9 @@ namespace vsgUnity.Native
         [DllImport(Library.libraryName, EntryPoint = "unity2vsg_EndExport")]
         public static extern void unity2vsg_EndExport([MarshalAs(UnmanagedType.LPStr)] string saveFileName);
 
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_SetExportSettings")]
+        public static extern void unity2vsg_SetExportSettings(ExportSettingsData settings);
+
         //
         // Nodes
         //
@@ -60,6 +65,35 @@ namespace vsgUnity.Native
         [DllImport(Library.libraryName, EntryPoint = "unity2vsg_AddStringValue")]
         public static extern void unity2vsg_AddStringValue([MarshalAs(UnmanagedType.LPStr)] string name, [MarshalAs(UnmanagedType.LPStr)] string value);
 
+        //
+        // Native mesh arrays, write straight into the returned pointers then commit, Add calls using the same mesh id can then pass empty arrays
+        //
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_AllocateVertexArray")]
+        public static extern IntPtr unity2vsg_AllocateVertexArray(int meshId, uint attribute, uint count);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_AllocateIndexArray")]
+        public static extern IntPtr unity2vsg_AllocateIndexArray(int meshId, uint count, uint use32BitIndicies);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_CommitMeshArrays")]
+        public static extern int unity2vsg_CommitMeshArrays(int meshId);
+
+        // the managed arrays are pinned rather than copied by the marshaller, so this is the only copy made
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_CopyToNativeArray")]
+        public static extern void unity2vsg_CopyToNativeArray(IntPtr dst, [In] int[] src, uint bytes);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_CopyToNativeArray")]
+        public static extern void unity2vsg_CopyToNativeArray(IntPtr dst, [In] Vector2[] src, uint bytes);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_CopyToNativeArray")]
+        public static extern void unity2vsg_CopyToNativeArray(IntPtr dst, [In] Vector3[] src, uint bytes);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_CopyToNativeArray")]
+        public static extern void unity2vsg_CopyToNativeArray(IntPtr dst, [In] Vector4[] src, uint bytes);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_CopyToNativeArray")]
+        public static extern void unity2vsg_CopyToNativeArray(IntPtr dst, [In] Color[] src, uint bytes);
+
         //
         // Commands
         //
@@ -108,6 +142,105 @@ namespace vsgUnity.Native
         [DllImport(Library.libraryName, EntryPoint = "unity2vsg_EndNode")]
         public static extern void unity2vsg_EndNode();
 
+        //
+        // Command streams
+        //
+
+        // the buffer must stay pinned until unity2vsg_EndExport as array data is referenced not copied
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_SubmitCommandBuffer")]
+        public static extern int unity2vsg_SubmitCommandBuffer(IntPtr ops, UIntPtr bytes);
+
+        //
+        // Export contexts, each context is an independent export so separate contexts can be filled from separate threads
+        //
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_CreateExportContext")]
+        public static extern IntPtr unity2vsg_CreateExportContext();
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_DestroyExportContext")]
+        public static extern void unity2vsg_DestroyExportContext(IntPtr context);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_EndExport")]
+        public static extern int unity2vsg_Context_EndExport(IntPtr context, [MarshalAs(UnmanagedType.LPStr)] string saveFileName);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_SetExportSettings")]
+        public static extern void unity2vsg_Context_SetExportSettings(IntPtr context, ExportSettingsData settings);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddGroupNode")]
+        public static extern void unity2vsg_Context_AddGroupNode(IntPtr context);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddTransformNode")]
+        public static extern void unity2vsg_Context_AddTransformNode(IntPtr context, TransformData transform);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddCullNode")]
+        public static extern void unity2vsg_Context_AddCullNode(IntPtr context, CullData cull);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddCullGroupNode")]
+        public static extern void unity2vsg_Context_AddCullGroupNode(IntPtr context, CullData cull);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddLODNode")]
+        public static extern void unity2vsg_Context_AddLODNode(IntPtr context, CullData cull);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddLODChild")]
+        public static extern void unity2vsg_Context_AddLODChild(IntPtr context, LODChildData lodChildData);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddStateGroupNode")]
+        public static extern void unity2vsg_Context_AddStateGroupNode(IntPtr context);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddCommandsNode")]
+        public static extern void unity2vsg_Context_AddCommandsNode(IntPtr context);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddVertexIndexDrawNode")]
+        public static extern void unity2vsg_Context_AddVertexIndexDrawNode(IntPtr context, VertexIndexDrawData mesh);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddStringValue")]
+        public static extern void unity2vsg_Context_AddStringValue(IntPtr context, [MarshalAs(UnmanagedType.LPStr)] string name, [MarshalAs(UnmanagedType.LPStr)] string value);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AllocateVertexArray")]
+        public static extern IntPtr unity2vsg_Context_AllocateVertexArray(IntPtr context, int meshId, uint attribute, uint count);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AllocateIndexArray")]
+        public static extern IntPtr unity2vsg_Context_AllocateIndexArray(IntPtr context, int meshId, uint count, uint use32BitIndicies);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_CommitMeshArrays")]
+        public static extern int unity2vsg_Context_CommitMeshArrays(IntPtr context, int meshId);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddBindGraphicsPipelineCommand")]
+        public static extern int unity2vsg_Context_AddBindGraphicsPipelineCommand(IntPtr context, PipelineData pipeline, int addToStateGroup);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddBindIndexBufferCommand")]
+        public static extern void unity2vsg_Context_AddBindIndexBufferCommand(IntPtr context, IndexBufferData data);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddBindVertexBuffersCommand")]
+        public static extern void unity2vsg_Context_AddBindVertexBuffersCommand(IntPtr context, VertexBuffersData data);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddDrawIndexedCommand")]
+        public static extern void unity2vsg_Context_AddDrawIndexedCommand(IntPtr context, DrawIndexedData data);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_CreateBindDescriptorSetCommand")]
+        public static extern void unity2vsg_Context_CreateBindDescriptorSetCommand(IntPtr context, int addToStateGroup);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddDescriptorImage")]
+        public static extern void unity2vsg_Context_AddDescriptorImage(IntPtr context, DescriptorImageData texture);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddDescriptorBufferFloat")]
+        public static extern void unity2vsg_Context_AddDescriptorBufferFloat(IntPtr context, DescriptorFloatUniformData data);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddDescriptorBufferFloatArray")]
+        public static extern void unity2vsg_Context_AddDescriptorBufferFloatArray(IntPtr context, DescriptorFloatArrayUniformData data);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddDescriptorBufferVector")]
+        public static extern void unity2vsg_Context_AddDescriptorBufferVector(IntPtr context, DescriptorVectorUniformData data);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_AddDescriptorBufferVectorArray")]
+        public static extern void unity2vsg_Context_AddDescriptorBufferVectorArray(IntPtr context, DescriptorVectorArrayUniformData data);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_EndNode")]
+        public static extern void unity2vsg_Context_EndNode(IntPtr context);
+
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_Context_SubmitCommandBuffer")]
+        public static extern int unity2vsg_Context_SubmitCommandBuffer(IntPtr context, IntPtr ops, UIntPtr bytes);
+
         [DllImport(Library.libraryName, EntryPoint = "unity2vsg_LaunchViewer")]
         public static extern void unity2vsg_LaunchViewer([MarshalAs(UnmanagedType.LPStr)] string fileName, int useCamData, CameraData camdata);
     }
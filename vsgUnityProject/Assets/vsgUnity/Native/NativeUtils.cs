@@ -166,6 +166,17 @@ namespace vsgUnity.Native
     // Mesh/Vertex/Draw command types
     //
 
+    // the vertex attributes that can be allocated natively, matches GeometryAttributes in ShaderUtils.h
+    public enum GeometryAttribute : uint
+    {
+        Vertex = 1,
+        Normal = 2,
+        Tangent = 8,
+        Color = 32,
+        TexCoord0 = 128,
+        TexCoord1 = 256
+    }
+
     public struct VertexIndexDrawData : IEquatable<VertexIndexDrawData>
     {
         public int id;
@@ -248,6 +259,12 @@ namespace vsgUnity.Native
     // Image types
     //
 
+    public enum MipmapFilter
+    {
+        Color = 0,
+        Normal = 1
+    }
+
     public struct ImageData : IEquatable<ImageData>
     {
         public int id;
@@ -262,6 +279,8 @@ namespace vsgUnity.Native
         public VkSamplerMipmapMode mipmapMode;
         public int mipmapCount;
         public float mipmapBias;
+        public MipmapFilter mipmapFilter;
+        public float alphaCutoff;
 
         public bool Equals(ImageData b)
         {
@@ -275,6 +294,8 @@ namespace vsgUnity.Native
                 mipmapMode == b.mipmapMode &&
                 mipmapCount == b.mipmapCount &&
                 mipmapBias == b.mipmapBias &&
+                mipmapFilter == b.mipmapFilter &&
+                alphaCutoff == b.alphaCutoff &&
                 pixels.Equals(b.pixels);
         }
     }
@@ -289,10 +310,14 @@ namespace vsgUnity.Native
         public int binding;
         public ImageData[] image;
         public int descriptorCount;
+        public int packLayers; // pack the images into the layers of one 2D array image bound as a single descriptor
+        public int packChannels; // pack the first component of each image into the components of one image bound as a single descriptor
+        public int firstComponentOnly; // the shader only reads the first component so the rest can be dropped
+        public int sampledAtFirstUvs; // the shader samples the images at the first uvs unscaled so their texel density can be measured
 
         public bool Equals(DescriptorImageData b)
         {
-            return binding == b.binding && image.Equals(b.image);
+            return binding == b.binding && packLayers == b.packLayers && packChannels == b.packChannels && firstComponentOnly == b.firstComponentOnly && sampledAtFirstUvs == b.sampledAtFirstUvs && image.Equals(b.image);
         }
     }
 
@@ -433,6 +458,40 @@ namespace vsgUnity.Native
         public float farZ;
     }
 
+    public struct ExportSettingsData
+    {
+        public int interleaveVertexArrays;
+        public int normalEncoding;
+        public int tangentEncoding;
+        public int uvEncoding;
+        public int colorEncoding;
+        public int optimizeMeshes;
+        public int lodLevelCount;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = GraphBuilder.MaxLODLevels)]
+        public float[] lodTriangleRatios;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = GraphBuilder.MaxLODLevels + 1)]
+        public float[] lodScreenHeightRatios;
+        public float lodMaxError;
+        public int staticBatching;
+        public float staticBatchCellSize;
+        public int instancingMinCount;
+        public int flattenGraph;
+        public int bakeTransformsMaxVertices;
+        public int sortState;
+        public int cullHierarchy;
+        public int cullHierarchyMinChildren;
+        public int generateMipmaps;
+        public int textureCompression;
+        public int textureAtlasMaxSize;
+        public int textureAtlasPageSize;
+        public float textureDuplicateTolerance;
+        public int analyzeTextures;
+        public int trimMipmapsScreenHeight;
+        public float trimMipmapsFieldOfView;
+        public float trimMipmapsNearDistance;
+        public int textureMemoryBudget;
+    }
+
     public static class NativeUtils
     {
         public static PipelineData CreatePipelineData(MeshInfo meshData)
@@ -460,6 +519,44 @@ namespace vsgUnity.Native
             return idstr;
         }
 
+        public static ExportSettingsData CreateExportSettingsData(GraphBuilder.ExportSettings settings)
+        {
+            ExportSettingsData data = new ExportSettingsData();
+            data.interleaveVertexArrays = settings.interleaveVertexArrays ? 1 : 0;
+            data.normalEncoding = (int)settings.normalEncoding;
+            data.tangentEncoding = (int)settings.tangentEncoding;
+            data.uvEncoding = (int)settings.uvEncoding;
+            data.colorEncoding = (int)settings.colorEncoding;
+            data.optimizeMeshes = (int)settings.optimizeMeshes;
+
+            // the fixed size arrays have to be allocated in full for marshalling
+            data.lodLevelCount = Math.Min(Math.Max(settings.lodLevelCount, 0), GraphBuilder.MaxLODLevels);
+            data.lodTriangleRatios = new float[GraphBuilder.MaxLODLevels];
+            data.lodScreenHeightRatios = new float[GraphBuilder.MaxLODLevels + 1];
+            if (settings.lodTriangleRatios != null) Array.Copy(settings.lodTriangleRatios, data.lodTriangleRatios, Math.Min(settings.lodTriangleRatios.Length, data.lodTriangleRatios.Length));
+            if (settings.lodScreenHeightRatios != null) Array.Copy(settings.lodScreenHeightRatios, data.lodScreenHeightRatios, Math.Min(settings.lodScreenHeightRatios.Length, data.lodScreenHeightRatios.Length));
+            data.lodMaxError = settings.lodMaxError;
+            data.staticBatching = settings.staticBatching ? 1 : 0;
+            data.staticBatchCellSize = settings.staticBatchCellSize;
+            data.instancingMinCount = settings.gpuInstancing ? Math.Max(2, settings.instancingMinCount) : 0;
+            data.flattenGraph = settings.flattenGraph ? 1 : 0;
+            data.bakeTransformsMaxVertices = settings.bakeTransformsMaxVertices;
+            data.sortState = settings.sortState ? 1 : 0;
+            data.cullHierarchy = (int)settings.cullHierarchy;
+            data.cullHierarchyMinChildren = settings.cullHierarchyMinChildren;
+            data.generateMipmaps = settings.generateMipmaps ? 1 : 0;
+            data.textureCompression = (int)settings.textureCompression;
+            data.textureAtlasMaxSize = settings.textureAtlas ? Math.Max(1, settings.textureAtlasMaxSize) : 0;
+            data.textureAtlasPageSize = settings.textureAtlasPageSize;
+            data.textureDuplicateTolerance = settings.nearDuplicateTextures ? Math.Max(0.0f, settings.textureDuplicateTolerance) : 0.0f;
+            data.analyzeTextures = settings.analyzeTextures ? 1 : 0;
+            data.trimMipmapsScreenHeight = settings.trimMipmaps ? Math.Max(1, settings.trimScreenHeight) : 0;
+            data.trimMipmapsFieldOfView = settings.trimFieldOfView;
+            data.trimMipmapsNearDistance = Math.Max(0.0f, settings.trimNearDistance);
+            data.textureMemoryBudget = settings.limitTextureMemory ? Math.Max(1, settings.textureMemoryBudget) : 0;
+            return data;
+        }
+
         public static CameraData CreateCameraData(Camera camera)
         {
             CameraData camdata = new CameraData();
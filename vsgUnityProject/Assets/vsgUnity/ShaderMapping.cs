@@ -51,6 +51,9 @@ namespace vsgUnity
             foreach(string define in defines)
             {
                 if (dependantDefines.Contains(define)) return true;
+
+                // a map packed into the components of another texture still depends on the same inputs
+                if (define.StartsWith(MaterialConverter.PackedMapDefinePrefix) && dependantDefines.Contains("VSG_" + define.Substring(MaterialConverter.PackedMapDefinePrefix.Length))) return true;
             }
             return false;
         }
@@ -1,5 +1,5 @@
 #version 450
-#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_MATERIAL, VSG_DIFFUSE_MAP, VSG_OPACITY_MAP, VSG_AMBIENT_MAP, VSG_NORMAL_MAP, VSG_SPECULAR_MAP )
+#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_MATERIAL, VSG_DIFFUSE_MAP, VSG_OPACITY_MAP, VSG_AMBIENT_MAP, VSG_NORMAL_MAP, VSG_SPECULAR_MAP, VSG_PACKED_AMBIENT_MAP, VSG_PACKED_SPECULAR_MAP, VSG_PACKED_OPACITY_MAP )
 #extension GL_ARB_separate_shader_objects : enable
 #ifdef VSG_DIFFUSE_MAP
 layout(binding = 0) uniform sampler2D diffuseMap;
@@ -16,6 +16,23 @@ layout(binding = 5) uniform sampler2D normalMap;
 #ifdef VSG_SPECULAR_MAP
 layout(binding = 6) uniform sampler2D specularMap;
 #endif
+#if defined(VSG_PACKED_AMBIENT_MAP) || defined(VSG_PACKED_SPECULAR_MAP) || defined(VSG_PACKED_OPACITY_MAP)
+// single channel maps packed into the components of one texture in the order ambient, specular, opacity
+#define PACKED_MAP
+layout(binding = 7) uniform sampler2D packedMap;
+#ifdef VSG_PACKED_AMBIENT_MAP
+#define PACKED_AMBIENT_INDEX 0
+#define PACKED_SPECULAR_FIRST 1
+#else
+#define PACKED_SPECULAR_FIRST 0
+#endif
+#ifdef VSG_PACKED_SPECULAR_MAP
+#define PACKED_SPECULAR_INDEX PACKED_SPECULAR_FIRST
+#define PACKED_OPACITY_INDEX (PACKED_SPECULAR_FIRST + 1)
+#else
+#define PACKED_OPACITY_INDEX PACKED_SPECULAR_FIRST
+#endif
+#endif
 
 #ifdef VSG_MATERIAL
 layout(binding = 10) uniform MaterialData
@@ -63,11 +80,18 @@ void main()
     vec3 specularColor = vec3(0.3,0.3,0.3);
     float shine = 16.0;
 #endif
+#ifdef PACKED_MAP
+    vec4 packedTexel = texture(packedMap, texCoord0.st);
+#endif
 #ifdef VSG_AMBIENT_MAP
     ambientColor *= texture(ambientMap, texCoord0.st).r;
+#elif defined(VSG_PACKED_AMBIENT_MAP)
+    ambientColor *= packedTexel[PACKED_AMBIENT_INDEX];
 #endif
 #ifdef VSG_SPECULAR_MAP
     specularColor = texture(specularMap, texCoord0.st).rrr;
+#elif defined(VSG_PACKED_SPECULAR_MAP)
+    specularColor = vec3(packedTexel[PACKED_SPECULAR_INDEX]);
 #endif
 #ifdef VSG_LIGHTING
 #ifdef VSG_NORMAL_MAP
@@ -97,6 +121,8 @@ void main()
     outColor = color;
 #ifdef VSG_OPACITY_MAP
     outColor.a *= texture(opacityMap, texCoord0.st).r;
+#elif defined(VSG_PACKED_OPACITY_MAP)
+    outColor.a *= packedTexel[PACKED_OPACITY_INDEX];
 #endif
 
     // crude version of AlphaFunc
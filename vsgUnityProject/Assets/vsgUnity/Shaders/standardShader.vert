@@ -1,5 +1,5 @@
 #version 450
-#pragma import_defines ( VSG_NORMAL, VSG_TANGENT, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_NORMAL_MAP, VSG_BILLBOARD )
+#pragma import_defines ( VSG_NORMAL, VSG_TANGENT, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_NORMAL_MAP, VSG_BILLBOARD, VSG_NORMAL_OCTAHEDRAL, VSG_TANGENT_OCTAHEDRAL, VSG_TRANSLATE, VSG_INSTANCE_MATRIX )
 #extension GL_ARB_separate_shader_objects : enable
 layout(push_constant) uniform PushConstants {
     mat4 projection;
@@ -8,12 +8,20 @@ layout(push_constant) uniform PushConstants {
 } pc;
 layout(location = 0) in vec3 osg_Vertex;
 #ifdef VSG_NORMAL
+#ifdef VSG_NORMAL_OCTAHEDRAL
+layout(location = 1) in vec2 osg_NormalOct;
+#else
 layout(location = 1) in vec3 osg_Normal;
+#endif
 layout(location = 1) out vec3 normalDir;
 #endif
 #ifdef VSG_TANGENT
+#ifdef VSG_TANGENT_OCTAHEDRAL
+layout(location = 2) in vec2 osg_TangentOct;
+#else
 layout(location = 2) in vec4 osg_Tangent;
 #endif
+#endif
 #ifdef VSG_COLOR
 layout(location = 3) in vec4 osg_Color;
 layout(location = 3) out vec4 vertColor;
@@ -22,15 +30,42 @@ layout(location = 3) out vec4 vertColor;
 layout(location = 4) in vec2 osg_MultiTexCoord0;
 layout(location = 4) out vec2 texCoord0;
 #endif
+#ifdef VSG_TRANSLATE
+layout(location = 6) in vec3 vsg_Translate;
+#endif
+#ifdef VSG_INSTANCE_MATRIX
+layout(location = 6) in mat4 vsg_InstanceMatrix;
+#endif
 #ifdef VSG_LIGHTING
 layout(location = 5) out vec3 viewDir;
 layout(location = 6) out vec3 lightDir;
 #endif
 out gl_PerVertex{ vec4 gl_Position; };
 
+#if defined(VSG_NORMAL_OCTAHEDRAL) || defined(VSG_TANGENT_OCTAHEDRAL)
+vec3 octDecode(vec2 e)
+{
+    vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+#endif
+
 void main()
 {
+#ifdef VSG_NORMAL_OCTAHEDRAL
+    vec3 osg_Normal = octDecode(osg_NormalOct);
+#endif
+#ifdef VSG_TANGENT_OCTAHEDRAL
+    vec4 osg_Tangent = vec4(octDecode(vec2(osg_TangentOct.x, abs(osg_TangentOct.y) * 2.0 - 1.0)), osg_TangentOct.y < 0.0 ? -1.0 : 1.0);
+#endif
     mat4 modelView = pc.modelView;
+#ifdef VSG_TRANSLATE
+    modelView = modelView * mat4(1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, vsg_Translate, 1.0);
+#endif
+#ifdef VSG_INSTANCE_MATRIX
+    modelView = modelView * vsg_InstanceMatrix;
+#endif
 
 #ifdef VSG_BILLBOARD
     vec3 lookDir = vec3(-modelView[0][2], -modelView[1][2], -modelView[2][2]);
@@ -6,8 +6,8 @@
 #ifdef VSG_TERRAIN_LAYERS
 layout (constant_id = 0) const uint SPLAT_LAYER_COUNT = 1;
 layout (constant_id = 1) const uint SPLAT_MASK_COUNT = 1;
-layout(set = 0, binding = 0) uniform sampler2D layerDiffuseTextures[SPLAT_LAYER_COUNT];
-layout(set = 0, binding = 1) uniform sampler2D layerMaskTextures[SPLAT_MASK_COUNT];
+layout(set = 0, binding = 0) uniform sampler2DArray layerDiffuseTextures;
+layout(set = 0, binding = 1) uniform sampler2DArray layerMaskTextures;
 
 layout(set = 0, binding = 2) uniform LayerInfoScale
 {
@@ -43,10 +43,10 @@ void main()
 	int layerindex = 0;
 	for(int m = 0; m < SPLAT_MASK_COUNT; m++)
 	{
-		vec4 mask = texture(layerMaskTextures[m], texCoord0.st);
+		vec4 mask = texture(layerMaskTextures, vec3(texCoord0.st, m));
 		for(int i = 0; i < 4 && layerindex < SPLAT_LAYER_COUNT; i++, layerindex++)
 		{
-			vec4 splat = texture(layerDiffuseTextures[layerindex], (texCoord0.st * terrainInfoSize.size.st) * layerInfoScale[layerindex].scale.st);
+			vec4 splat = texture(layerDiffuseTextures, vec3((texCoord0.st * terrainInfoSize.size.st) * layerInfoScale[layerindex].scale.st, layerindex));
 			base = mix(base, splat, mask[i]);
 		}
 	}
@@ -1,5 +1,5 @@
 #version 450
-#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING )
+#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_NORMAL_OCTAHEDRAL )
 #extension GL_ARB_separate_shader_objects : enable
 
 layout(push_constant) uniform PushConstants {
@@ -11,7 +11,11 @@ layout(push_constant) uniform PushConstants {
 layout(location = 0) in vec3 vsg_Vertex;
 
 #ifdef VSG_NORMAL
+#ifdef VSG_NORMAL_OCTAHEDRAL
+layout(location = 1) in vec2 vsg_NormalOct;
+#else
 layout(location = 1) in vec3 vsg_Normal;
+#endif
 layout(location = 1) out vec3 normalDir;
 #endif
 
@@ -27,8 +31,20 @@ layout(location = 6) out vec3 lightDir;
 
 out gl_PerVertex{ vec4 gl_Position; };
 
+#ifdef VSG_NORMAL_OCTAHEDRAL
+vec3 octDecode(vec2 e)
+{
+    vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+#endif
+
 void main()
 {
+#ifdef VSG_NORMAL_OCTAHEDRAL
+    vec3 vsg_Normal = octDecode(vsg_NormalOct);
+#endif
     gl_Position = (pc.projection * pc.modelview) * vec4(vsg_Vertex, 1.0);
 #ifdef VSG_TEXCOORD0
     texCoord0 = vsg_MultiTexCoord0.st;
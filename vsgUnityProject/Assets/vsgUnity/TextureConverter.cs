@@ -13,6 +13,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 using System;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using UnityEditor;
 using UnityEngine;
 using UnityEngine.Rendering;
 
@@ -84,6 +85,7 @@ namespace vsgUnity
                 _convertedTextures.Add(converted);
 
                 texdata = TextureConverter.CreateImageData(converted, false);
+                PopulateMipmapSettings(source, ref texdata); // the converted copy has no importer of its own
                 TextureConverter.AddImageDataToCache(texdata, source.GetInstanceID());
 
                 return texdata;
@@ -237,9 +239,28 @@ namespace vsgUnity
             texdata.mipmapMode = Vulkan.vkSamplerMipmapModeForFilterMode(texture.filterMode);
             texdata.mipmapCount = 1;
             texdata.mipmapBias = 0.0f;
+            PopulateMipmapSettings(texture, ref texdata);
             return true;
         }
 
+        /// <summary>
+        /// Populate how mipmaps should be filtered if the exporter has to generate them, taken from the texture's import settings
+        /// </summary>
+        /// <param name="texture"></param>
+        /// <param name="texdata"></param>
+
+        public static void PopulateMipmapSettings(Texture texture, ref ImageData texdata)
+        {
+            texdata.mipmapFilter = MipmapFilter.Color;
+            texdata.alphaCutoff = 0.0f;
+
+            TextureImporter importer = AssetImporter.GetAtPath(AssetDatabase.GetAssetPath(texture)) as TextureImporter;
+            if (importer == null) return;
+
+            if (importer.textureType == TextureImporterType.NormalMap) texdata.mipmapFilter = MipmapFilter.Normal;
+            if (importer.mipMapsPreserveCoverage) texdata.alphaCutoff = importer.alphaTestReferenceValue;
+        }
+
         private static byte[] Color32ArrayToByteArray(Color32[] colors)
         {
             if (colors == null || colors.Length == 0)